@@ -69,12 +69,18 @@ struct _DockItemDBusInterfaceDBusProxy {
 
 struct _TaskManagerDispatcherPrivate {
     TaskManager* _manager;
+    gchar* epoch;
+    guint generation;
+    guint horizon;
+    GHashTable* changed;
+    GHashTable* removed;
 };
 
 
 struct _TaskIconDispatcherPrivate {
     TaskIcon* icon;
     gchar* _object_path;
+    GHashTable* hints;
 };
 
 struct _Block1Data {
@@ -173,11 +179,16 @@ static void _vala_GValue_free(GValue* self);
 static void __vala_GValue_free0_(gpointer var);
 static char* task_manager_dispatcher_real_awn_register_proxy_item(DockManagerDBusInterface* base, const gchar* desktop_file, const gchar* uri, GError** error);
 static void task_manager_dispatcher_set_manager(TaskManagerDispatcher* self, TaskManager* value);
+static void task_manager_dispatcher_item_removed(TaskManagerDispatcher* self, const gchar* object_path);
+static void task_manager_dispatcher_append_items(TaskManagerDispatcher* self, DBusMessageIter* iter, guint since);
+static void task_icon_dispatcher_append_item(TaskIconDispatcher* self, DBusMessageIter* iter);
 static void task_manager_dispatcher_finalize(GObject* obj);
 void task_manager_dispatcher_dbus_register_object(DBusConnection* connection, const char* path, void* object);
 void _task_manager_dispatcher_dbus_unregister(DBusConnection* connection, void* _user_data_);
 DBusHandlerResult task_manager_dispatcher_dbus_message(DBusConnection* connection, DBusMessage* message, void* object);
 static DBusHandlerResult _dbus_task_manager_dispatcher_introspect(TaskManagerDispatcher* self, DBusConnection* connection, DBusMessage* message);
+static DBusHandlerResult _dbus_task_manager_dispatcher_awn_get_snapshot(TaskManagerDispatcher* self, DBusConnection* connection, DBusMessage* message);
+static DBusHandlerResult _dbus_task_manager_dispatcher_awn_get_changes_since(TaskManagerDispatcher* self, DBusConnection* connection, DBusMessage* message);
 static void _vala_task_manager_dispatcher_get_property(GObject* object, guint property_id, GValue* value, GParamSpec* pspec);
 static void _vala_task_manager_dispatcher_set_property(GObject* object, guint property_id, const GValue* value, GParamSpec* pspec);
 #define TASK_ICON_DISPATCHER_GET_PRIVATE(o) (G_TYPE_INSTANCE_GET_PRIVATE ((o), TYPE_TASK_ICON_DISPATCHER, TaskIconDispatcherPrivate))
@@ -4501,7 +4512,7 @@ static gchar** task_manager_dispatcher_real_get_capabilities(DockManagerDBusInte
     _tmp6_ = g_strdup("menu-item-icon-name");
     _tmp7_ = g_strdup("menu-item-icon-file");
     _tmp8_ = g_strdup("x-awn-set-visibility");
-    _tmp9_ = g_new0(gchar*, 9 + 1);
+    _tmp9_ = g_new0(gchar*, 10 + 1);
     _tmp9_[0] = _tmp0_;
     _tmp9_[1] = _tmp1_;
     _tmp9_[2] = _tmp2_;
@@ -4511,9 +4522,10 @@ static gchar** task_manager_dispatcher_real_get_capabilities(DockManagerDBusInte
     _tmp9_[6] = _tmp6_;
     _tmp9_[7] = _tmp7_;
     _tmp9_[8] = _tmp8_;
+    _tmp9_[9] = g_strdup("x-awn-snapshot");
     capabilities = _tmp9_;
-    capabilities_length1 = 9;
-    _capabilities_size_ = 9;
+    capabilities_length1 = 10;
+    _capabilities_size_ = 10;
     _tmp10_ = capabilities;
     if (result_length1) {
         *result_length1 = capabilities_length1;
@@ -4818,6 +4830,68 @@ static char* task_manager_dispatcher_real_awn_register_proxy_item(DockManagerDBu
 }
 
 
+/*
+ * Every change of an item (added, updated through UpdateDockItem, windows
+ * added or removed) bumps the generation and stamps the item with it, so
+ * AwnGetChangesSince only has to send the items stamped after the client's
+ * generation. Removed items are remembered up to a limit, a client which
+ * is further behind than that gets a full snapshot instead.
+ * Generations only make sense together with the epoch, a random id of this
+ * dispatcher instance that's part of both replies: a client holding the
+ * generation of an earlier dock (or of another dispatcher) gets everything.
+ */
+#define TASK_MANAGER_DISPATCHER_MAX_REMOVED 256
+
+void task_manager_dispatcher_item_changed(TaskManagerDispatcher* self, const gchar* object_path)
+{
+    g_return_if_fail(self != NULL);
+    g_return_if_fail(object_path != NULL);
+    self->priv->generation++;
+    g_hash_table_insert(self->priv->changed, g_strdup(object_path), GUINT_TO_POINTER(self->priv->generation));
+}
+
+
+static void task_manager_dispatcher_item_removed(TaskManagerDispatcher* self, const gchar* object_path)
+{
+    g_return_if_fail(self != NULL);
+    g_return_if_fail(object_path != NULL);
+    self->priv->generation++;
+    g_hash_table_remove(self->priv->changed, object_path);
+    if (g_hash_table_size(self->priv->removed) >= TASK_MANAGER_DISPATCHER_MAX_REMOVED) {
+        g_hash_table_remove_all(self->priv->removed);
+        self->priv->horizon = self->priv->generation - 1;
+    }
+    g_hash_table_insert(self->priv->removed, g_strdup(object_path), GUINT_TO_POINTER(self->priv->generation));
+}
+
+
+/* appends the items changed after @since as a(oa{sv}), all of them for 0 */
+static void task_manager_dispatcher_append_items(TaskManagerDispatcher* self, DBusMessageIter* iter, guint since)
+{
+    DBusMessageIter array;
+    GSList* icon_it;
+    dbus_message_iter_open_container(iter, DBUS_TYPE_ARRAY, "(oa{sv})", &array);
+    for (icon_it = task_manager_get_icons(self->priv->_manager); icon_it != NULL; icon_it = icon_it->next) {
+        GObject* _tmp0_;
+        TaskIconDispatcher* dispatcher;
+        _tmp0_ = task_icon_get_dbus_dispatcher((TaskIcon*) icon_it->data);
+        dispatcher = IS_TASK_ICON_DISPATCHER(_tmp0_) ? ((TaskIconDispatcher*) _tmp0_) : NULL;
+        if (dispatcher == NULL) {
+            continue;
+        }
+        if (since > 0) {
+            guint stamp;
+            stamp = GPOINTER_TO_UINT(g_hash_table_lookup(self->priv->changed, task_icon_dispatcher_get_object_path(dispatcher)));
+            if (stamp <= since) {
+                continue;
+            }
+        }
+        task_icon_dispatcher_append_item(dispatcher, &array);
+    }
+    dbus_message_iter_close_container(iter, &array);
+}
+
+
 TaskManager* task_manager_dispatcher_get_manager(TaskManagerDispatcher* self)
 {
     TaskManager* result;
@@ -4872,6 +4946,11 @@ static void task_manager_dispatcher_dock_manager_dbus_interface_interface_init(D
 static void task_manager_dispatcher_instance_init(TaskManagerDispatcher* self)
 {
     self->priv = TASK_MANAGER_DISPATCHER_GET_PRIVATE(self);
+    self->priv->epoch = g_strdup_printf("%08x%08x", g_random_int(), g_random_int());
+    self->priv->generation = 1;
+    self->priv->horizon = self->priv->generation;
+    self->priv->changed = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
+    self->priv->removed = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
 }
 
 
@@ -4880,6 +4959,9 @@ static void task_manager_dispatcher_finalize(GObject* obj)
     TaskManagerDispatcher* self;
     self = TASK_MANAGER_DISPATCHER(obj);
     _g_object_unref0(self->priv->_manager);
+    _g_free0(self->priv->epoch);
+    _g_hash_table_unref0(self->priv->changed);
+    _g_hash_table_unref0(self->priv->removed);
     G_OBJECT_CLASS(task_manager_dispatcher_parent_class)->finalize(obj);
 }
 
@@ -4899,7 +4981,7 @@ static DBusHandlerResult _dbus_task_manager_dispatcher_introspect(TaskManagerDis
     reply = dbus_message_new_method_return(message);
     dbus_message_iter_init_append(reply, &iter);
     xml_data = g_string_new("<!DOCTYPE node PUBLIC \"-//freedesktop//DTD D-BUS Object Introspection 1.0//EN\" \"http://www.freedesktop.org/standards/dbus/1.0/introspect.dtd\">\n");
-    g_string_append(xml_data, "<node>\n<interface name=\"org.freedesktop.DBus.Introspectable\">\n  <method name=\"Introspect\">\n    <arg name=\"data\" direction=\"out\" type=\"s\"/>\n  </method>\n</interface>\n<interface name=\"org.freedesktop.DBus.Properties\">\n  <method name=\"Get\">\n    <arg name=\"interface\" direction=\"in\" type=\"s\"/>\n    <arg name=\"propname\" direction=\"in\" type=\"s\"/>\n    <arg name=\"value\" direction=\"out\" type=\"v\"/>\n  </method>\n  <method name=\"Set\">\n    <arg name=\"interface\" direction=\"in\" type=\"s\"/>\n    <arg name=\"propname\" direction=\"in\" type=\"s\"/>\n    <arg name=\"value\" direction=\"in\" type=\"v\"/>\n  </method>\n  <method name=\"GetAll\">\n    <arg name=\"interface\" direction=\"in\" type=\"s\"/>\n    <arg name=\"props\" direction=\"out\" type=\"a{sv}\"/>\n  </method>\n</interface>\n<interface name=\"net.launchpad.DockManager\">\n  <method name=\"GetCapabilities\">\n    <arg name=\"result\" type=\"as\" direction=\"out\"/>\n  </method>\n  <method name=\"GetItems\">\n    <arg name=\"result\" type=\"ao\" direction=\"out\"/>\n  </method>\n  <method name=\"GetItemsByName\">\n    <arg name=\"name\" type=\"s\" direction=\"in\"/>\n    <arg name=\"result\" type=\"ao\" direction=\"out\"/>\n  </method>\n  <method name=\"GetItemsByDesktopFile\">\n    <arg name=\"desktop_file\" type=\"s\" direction=\"in\"/>\n    <arg name=\"result\" type=\"ao\" direction=\"out\"/>\n  </method>\n  <method name=\"GetItemsByPid\">\n    <arg name=\"pid\" type=\"i\" direction=\"in\"/>\n    <arg name=\"result\" type=\"ao\" direction=\"out\"/>\n  </method>\n  <method name=\"GetItemByXid\">\n    <arg name=\"xid\" type=\"x\" direction=\"in\"/>\n    <arg name=\"result\" type=\"o\" direction=\"out\"/>\n  </method>\n  <method name=\"AwnSetVisibility\">\n    <arg name=\"win_name\" type=\"s\" direction=\"in\"/>\n    <arg name=\"visible\" type=\"b\" direction=\"in\"/>\n  </method>\n  <method name=\"AwnRegisterProxyItem\">\n    <arg name=\"desktop_file\" type=\"s\" direction=\"in\"/>\n    <arg name=\"uri\" type=\"s\" direction=\"in\"/>\n    <arg name=\"result\" type=\"o\" direction=\"out\"/>\n  </method>\n  <signal name=\"ItemAdded\">\n    <arg name=\"path\" type=\"o\"/>\n  </signal>\n  <signal name=\"ItemRemoved\">\n    <arg name=\"path\" type=\"o\"/>\n  </signal>\n</interface>\n");
+    g_string_append(xml_data, "<node>\n<interface name=\"org.freedesktop.DBus.Introspectable\">\n  <method name=\"Introspect\">\n    <arg name=\"data\" direction=\"out\" type=\"s\"/>\n  </method>\n</interface>\n<interface name=\"org.freedesktop.DBus.Properties\">\n  <method name=\"Get\">\n    <arg name=\"interface\" direction=\"in\" type=\"s\"/>\n    <arg name=\"propname\" direction=\"in\" type=\"s\"/>\n    <arg name=\"value\" direction=\"out\" type=\"v\"/>\n  </method>\n  <method name=\"Set\">\n    <arg name=\"interface\" direction=\"in\" type=\"s\"/>\n    <arg name=\"propname\" direction=\"in\" type=\"s\"/>\n    <arg name=\"value\" direction=\"in\" type=\"v\"/>\n  </method>\n  <method name=\"GetAll\">\n    <arg name=\"interface\" direction=\"in\" type=\"s\"/>\n    <arg name=\"props\" direction=\"out\" type=\"a{sv}\"/>\n  </method>\n</interface>\n<interface name=\"net.launchpad.DockManager\">\n  <method name=\"GetCapabilities\">\n    <arg name=\"result\" type=\"as\" direction=\"out\"/>\n  </method>\n  <method name=\"GetItems\">\n    <arg name=\"result\" type=\"ao\" direction=\"out\"/>\n  </method>\n  <method name=\"GetItemsByName\">\n    <arg name=\"name\" type=\"s\" direction=\"in\"/>\n    <arg name=\"result\" type=\"ao\" direction=\"out\"/>\n  </method>\n  <method name=\"GetItemsByDesktopFile\">\n    <arg name=\"desktop_file\" type=\"s\" direction=\"in\"/>\n    <arg name=\"result\" type=\"ao\" direction=\"out\"/>\n  </method>\n  <method name=\"GetItemsByPid\">\n    <arg name=\"pid\" type=\"i\" direction=\"in\"/>\n    <arg name=\"result\" type=\"ao\" direction=\"out\"/>\n  </method>\n  <method name=\"GetItemByXid\">\n    <arg name=\"xid\" type=\"x\" direction=\"in\"/>\n    <arg name=\"result\" type=\"o\" direction=\"out\"/>\n  </method>\n  <method name=\"AwnSetVisibility\">\n    <arg name=\"win_name\" type=\"s\" direction=\"in\"/>\n    <arg name=\"visible\" type=\"b\" direction=\"in\"/>\n  </method>\n  <method name=\"AwnRegisterProxyItem\">\n    <arg name=\"desktop_file\" type=\"s\" direction=\"in\"/>\n    <arg name=\"uri\" type=\"s\" direction=\"in\"/>\n    <arg name=\"result\" type=\"o\" direction=\"out\"/>\n  </method>\n  <method name=\"AwnGetSnapshot\">\n    <arg name=\"epoch\" type=\"s\" direction=\"out\"/>\n    <arg name=\"generation\" type=\"u\" direction=\"out\"/>\n    <arg name=\"items\" type=\"a(oa{sv})\" direction=\"out\"/>\n  </method>\n  <method name=\"AwnGetChangesSince\">\n    <arg name=\"epoch\" type=\"s\" direction=\"in\"/>\n    <arg name=\"since\" type=\"u\" direction=\"in\"/>\n    <arg name=\"epoch\" type=\"s\" direction=\"out\"/>\n    <arg name=\"generation\" type=\"u\" direction=\"out\"/>\n    <arg name=\"full\" type=\"b\" direction=\"out\"/>\n    <arg name=\"changed\" type=\"a(oa{sv})\" direction=\"out\"/>\n    <arg name=\"removed\" type=\"ao\" direction=\"out\"/>\n  </method>\n  <signal name=\"ItemAdded\">\n    <arg name=\"path\" type=\"o\"/>\n  </signal>\n  <signal name=\"ItemRemoved\">\n    <arg name=\"path\" type=\"o\"/>\n  </signal>\n</interface>\n");
     dbus_connection_list_registered(connection, g_object_get_data((GObject*) self, "dbus_object_path"), &children);
     for (i = 0; children[i]; i++) {
         g_string_append_printf(xml_data, "<node name=\"%s\"/>\n", children[i]);
@@ -4918,12 +5000,95 @@ static DBusHandlerResult _dbus_task_manager_dispatcher_introspect(TaskManagerDis
 }
 
 
+static DBusHandlerResult _dbus_task_manager_dispatcher_awn_get_snapshot(TaskManagerDispatcher* self, DBusConnection* connection, DBusMessage* message)
+{
+    DBusMessageIter iter;
+    DBusMessage* reply;
+    dbus_uint32_t generation;
+    const char* epoch;
+    if (strcmp(dbus_message_get_signature(message), "")) {
+        return DBUS_HANDLER_RESULT_NOT_YET_HANDLED;
+    }
+    reply = dbus_message_new_method_return(message);
+    dbus_message_iter_init_append(reply, &iter);
+    epoch = self->priv->epoch;
+    generation = self->priv->generation;
+    dbus_message_iter_append_basic(&iter, DBUS_TYPE_STRING, &epoch);
+    dbus_message_iter_append_basic(&iter, DBUS_TYPE_UINT32, &generation);
+    task_manager_dispatcher_append_items(self, &iter, 0);
+    if (reply) {
+        dbus_connection_send(connection, reply, NULL);
+        dbus_message_unref(reply);
+        return DBUS_HANDLER_RESULT_HANDLED;
+    } else {
+        return DBUS_HANDLER_RESULT_NOT_YET_HANDLED;
+    }
+}
+
+
+static DBusHandlerResult _dbus_task_manager_dispatcher_awn_get_changes_since(TaskManagerDispatcher* self, DBusConnection* connection, DBusMessage* message)
+{
+    DBusMessageIter iter;
+    DBusMessageIter _tmp0_;
+    DBusMessage* reply;
+    const char* client_epoch;
+    const char* epoch;
+    dbus_uint32_t since;
+    dbus_uint32_t generation;
+    dbus_bool_t full;
+    GHashTableIter removed_it;
+    gpointer path, stamp;
+    if (strcmp(dbus_message_get_signature(message), "su")) {
+        return DBUS_HANDLER_RESULT_NOT_YET_HANDLED;
+    }
+    dbus_message_iter_init(message, &iter);
+    dbus_message_iter_get_basic(&iter, &client_epoch);
+    dbus_message_iter_next(&iter);
+    dbus_message_iter_get_basic(&iter, &since);
+    epoch = self->priv->epoch;
+    generation = self->priv->generation;
+    /* from another instance, or too old: the removals might be forgotten */
+    full = strcmp(client_epoch, epoch) != 0 ||
+           since < self->priv->horizon || since > generation;
+    reply = dbus_message_new_method_return(message);
+    dbus_message_iter_init_append(reply, &iter);
+    dbus_message_iter_append_basic(&iter, DBUS_TYPE_STRING, &epoch);
+    dbus_message_iter_append_basic(&iter, DBUS_TYPE_UINT32, &generation);
+    dbus_message_iter_append_basic(&iter, DBUS_TYPE_BOOLEAN, &full);
+    task_manager_dispatcher_append_items(self, &iter, full ? 0 : since);
+    dbus_message_iter_open_container(&iter, DBUS_TYPE_ARRAY, "o", &_tmp0_);
+    if (!full) {
+        g_hash_table_iter_init(&removed_it, self->priv->removed);
+        while (g_hash_table_iter_next(&removed_it, &path, &stamp)) {
+            const char* _tmp1_;
+            if (GPOINTER_TO_UINT(stamp) <= since) {
+                continue;
+            }
+            _tmp1_ = (const char*) path;
+            dbus_message_iter_append_basic(&_tmp0_, DBUS_TYPE_OBJECT_PATH, &_tmp1_);
+        }
+    }
+    dbus_message_iter_close_container(&iter, &_tmp0_);
+    if (reply) {
+        dbus_connection_send(connection, reply, NULL);
+        dbus_message_unref(reply);
+        return DBUS_HANDLER_RESULT_HANDLED;
+    } else {
+        return DBUS_HANDLER_RESULT_NOT_YET_HANDLED;
+    }
+}
+
+
 DBusHandlerResult task_manager_dispatcher_dbus_message(DBusConnection* connection, DBusMessage* message, void* object)
 {
     DBusHandlerResult result;
     result = DBUS_HANDLER_RESULT_NOT_YET_HANDLED;
     if (dbus_message_is_method_call(message, "org.freedesktop.DBus.Introspectable", "Introspect")) {
         result = _dbus_task_manager_dispatcher_introspect(object, connection, message);
+    } else if (dbus_message_is_method_call(message, "net.launchpad.DockManager", "AwnGetSnapshot")) {
+        result = _dbus_task_manager_dispatcher_awn_get_snapshot(object, connection, message);
+    } else if (dbus_message_is_method_call(message, "net.launchpad.DockManager", "AwnGetChangesSince")) {
+        result = _dbus_task_manager_dispatcher_awn_get_changes_since(object, connection, message);
     }
     if (result == DBUS_HANDLER_RESULT_HANDLED) {
         return result;
@@ -5063,12 +5228,24 @@ static void task_icon_dispatcher_emit_item_added(TaskIconDispatcher* self)
         char* _tmp2_;
         _tmp1_ = g_strdup(self->priv->_object_path);
         _tmp2_ = _tmp1_;
+        task_manager_dispatcher_item_changed(proxy, _tmp2_);
         g_signal_emit_by_name((DockManagerDBusInterface*) proxy, "item-added", _tmp2_);
         _g_free0(_tmp2_);
     }
 }
 
 
+void task_icon_dispatcher_mark_changed(TaskIconDispatcher* self)
+{
+    TaskManagerDispatcher* proxy;
+    g_return_if_fail(self != NULL);
+    proxy = task_icon_dispatcher_get_manager_proxy(self);
+    if (proxy != NULL) {
+        task_manager_dispatcher_item_changed(proxy, self->priv->_object_path);
+    }
+}
+
+
 static Block1Data* block1_data_ref(Block1Data* _data1_)
 {
     g_atomic_int_inc(&_data1_->_ref_count_);
@@ -5251,39 +5428,36 @@ static void task_icon_dispatcher_real_remove_menu_item(DockItemDBusInterface* ba
 static void task_icon_dispatcher_real_update_dock_item(DockItemDBusInterface* base, GHashTable* hints, GError** error)
 {
     TaskIconDispatcher* self;
+    GSList* _tmp0_ = NULL;
+    GSList* items;
     GHashTableIter iter = {0};
-    const gchar* key = NULL;
-    GValue* value = NULL;
+    gpointer key, value;
     self = (TaskIconDispatcher*) base;
     g_return_if_fail(hints != NULL);
+    /* remember the latest hints for AwnGetSnapshot */
     g_hash_table_iter_init(&iter, hints);
-    while (TRUE) {
-        gconstpointer _tmp0_ = NULL;
-        gconstpointer _tmp1_ = NULL;
-        gboolean _tmp2_;
-        GSList* _tmp3_ = NULL;
-        GSList* items;
-        _tmp2_ = g_hash_table_iter_next(&iter, &_tmp0_, &_tmp1_);
-        key = _tmp0_;
-        value = _tmp1_;
-        if (!_tmp2_) {
-            break;
-        }
-        _tmp3_ = task_icon_get_items(self->priv->icon);
-        items = _tmp3_;
-        {
-            GSList* item_collection;
-            GSList* item_it;
-            item_collection = items;
-            for (item_it = item_collection; item_it != NULL; item_it = item_it->next) {
-                TaskItem* item;
-                item = (TaskItem*) item_it->data;
-                {
-                    if (TASK_IS_LAUNCHER(item)) {
-                        continue;
-                    }
-                    task_item_update_overlay(item, key, value);
+    while (g_hash_table_iter_next(&iter, &key, &value)) {
+        GValue* copy;
+        copy = g_new0(GValue, 1);
+        g_value_init(copy, G_VALUE_TYPE((GValue*) value));
+        g_value_copy((GValue*) value, copy);
+        g_hash_table_insert(self->priv->hints, g_strdup((const gchar*) key), copy);
+    }
+    task_icon_dispatcher_mark_changed(self);
+    _tmp0_ = task_icon_get_items(self->priv->icon);
+    items = _tmp0_;
+    {
+        GSList* item_collection;
+        GSList* item_it;
+        item_collection = items;
+        for (item_it = item_collection; item_it != NULL; item_it = item_it->next) {
+            TaskItem* item;
+            item = (TaskItem*) item_it->data;
+            {
+                if (TASK_IS_LAUNCHER(item)) {
+                    continue;
                 }
+                task_item_update_overlays(item, hints);
             }
         }
     }
@@ -5415,6 +5589,159 @@ static gchar* task_icon_dispatcher_real_get_uri(DockItemDBusInterface* base)
 }
 
 
+static void _dbus_dict_open_entry(DBusMessageIter* dict, const char* key, const char* signature, DBusMessageIter* entry, DBusMessageIter* variant)
+{
+    dbus_message_iter_open_container(dict, DBUS_TYPE_DICT_ENTRY, NULL, entry);
+    dbus_message_iter_append_basic(entry, DBUS_TYPE_STRING, &key);
+    dbus_message_iter_open_container(entry, DBUS_TYPE_VARIANT, signature, variant);
+}
+
+
+static void _dbus_dict_close_entry(DBusMessageIter* dict, DBusMessageIter* entry, DBusMessageIter* variant)
+{
+    dbus_message_iter_close_container(entry, variant);
+    dbus_message_iter_close_container(dict, entry);
+}
+
+
+static void _dbus_dict_append_string(DBusMessageIter* dict, const char* key, const char* value)
+{
+    DBusMessageIter entry, variant;
+    _dbus_dict_open_entry(dict, key, "s", &entry, &variant);
+    dbus_message_iter_append_basic(&variant, DBUS_TYPE_STRING, &value);
+    _dbus_dict_close_entry(dict, &entry, &variant);
+}
+
+
+static void _dbus_dict_append_fixed_array(DBusMessageIter* dict, const char* key, int type, GArray* values)
+{
+    DBusMessageIter entry, variant, array;
+    char signature[3] = { DBUS_TYPE_ARRAY, (char) type, '\0' };
+    gconstpointer data;
+    data = values->data;
+    _dbus_dict_open_entry(dict, key, signature, &entry, &variant);
+    dbus_message_iter_open_container(&variant, DBUS_TYPE_ARRAY, signature + 1, &array);
+    dbus_message_iter_append_fixed_array(&array, type, &data, values->len);
+    dbus_message_iter_close_container(&variant, &array);
+    _dbus_dict_close_entry(dict, &entry, &variant);
+}
+
+
+/* hints come in as basic types, anything else is skipped */
+static void _dbus_dict_append_value(DBusMessageIter* dict, const char* key, const GValue* value)
+{
+    DBusMessageIter entry, variant;
+    union {
+        const char* s;
+        dbus_bool_t b;
+        guint8 y;
+        dbus_int32_t i;
+        dbus_uint32_t u;
+        dbus_int64_t x;
+        dbus_uint64_t t;
+        double d;
+    } v;
+    int type;
+    switch (G_VALUE_TYPE(value)) {
+    case G_TYPE_STRING:
+        type = DBUS_TYPE_STRING;
+        v.s = g_value_get_string(value) ? g_value_get_string(value) : "";
+        break;
+    case G_TYPE_BOOLEAN:
+        type = DBUS_TYPE_BOOLEAN;
+        v.b = g_value_get_boolean(value);
+        break;
+    case G_TYPE_UCHAR:
+        type = DBUS_TYPE_BYTE;
+        v.y = g_value_get_uchar(value);
+        break;
+    case G_TYPE_INT:
+        type = DBUS_TYPE_INT32;
+        v.i = g_value_get_int(value);
+        break;
+    case G_TYPE_UINT:
+        type = DBUS_TYPE_UINT32;
+        v.u = g_value_get_uint(value);
+        break;
+    case G_TYPE_INT64:
+        type = DBUS_TYPE_INT64;
+        v.x = g_value_get_int64(value);
+        break;
+    case G_TYPE_UINT64:
+        type = DBUS_TYPE_UINT64;
+        v.t = g_value_get_uint64(value);
+        break;
+    case G_TYPE_DOUBLE:
+        type = DBUS_TYPE_DOUBLE;
+        v.d = g_value_get_double(value);
+        break;
+    default:
+        return;
+    }
+    {
+        char signature[2] = { (char) type, '\0' };
+        _dbus_dict_open_entry(dict, key, signature, &entry, &variant);
+        dbus_message_iter_append_basic(&variant, type, &v);
+        _dbus_dict_close_entry(dict, &entry, &variant);
+    }
+}
+
+
+/*
+ * Appends the item as (oa{sv}): desktop-file, uri, pids, xids and the
+ * latest value of every hint set through UpdateDockItem (badge, progress,
+ * message, icon-file...).
+ */
+static void task_icon_dispatcher_append_item(TaskIconDispatcher* self, DBusMessageIter* iter)
+{
+    DBusMessageIter item, dict;
+    const char* path;
+    gchar* desktop_file;
+    gchar* uri;
+    GArray* pids;
+    GArray* xids;
+    GSList* item_it;
+    GHashTableIter hint_it;
+    gpointer key, value;
+    g_return_if_fail(self != NULL);
+    path = self->priv->_object_path;
+    dbus_message_iter_open_container(iter, DBUS_TYPE_STRUCT, NULL, &item);
+    dbus_message_iter_append_basic(&item, DBUS_TYPE_OBJECT_PATH, &path);
+    dbus_message_iter_open_container(&item, DBUS_TYPE_ARRAY, "{sv}", &dict);
+    desktop_file = dock_item_dbus_interface_get_desktop_file((DockItemDBusInterface*) self);
+    _dbus_dict_append_string(&dict, "desktop-file", desktop_file);
+    _g_free0(desktop_file);
+    uri = dock_item_dbus_interface_get_uri((DockItemDBusInterface*) self);
+    _dbus_dict_append_string(&dict, "uri", uri);
+    _g_free0(uri);
+    pids = g_array_new(FALSE, FALSE, sizeof(dbus_int32_t));
+    xids = g_array_new(FALSE, FALSE, sizeof(dbus_int64_t));
+    for (item_it = task_icon_get_items(self->priv->icon); item_it != NULL; item_it = item_it->next) {
+        TaskWindow* window;
+        dbus_int32_t pid;
+        dbus_int64_t xid;
+        if (!TASK_IS_WINDOW(item_it->data)) {
+            continue;
+        }
+        window = (TaskWindow*) item_it->data;
+        pid = task_window_get_pid(window);
+        xid = task_window_get_xid(window);
+        g_array_append_val(pids, pid);
+        g_array_append_val(xids, xid);
+    }
+    _dbus_dict_append_fixed_array(&dict, "pids", DBUS_TYPE_INT32, pids);
+    _dbus_dict_append_fixed_array(&dict, "xids", DBUS_TYPE_INT64, xids);
+    g_array_free(pids, TRUE);
+    g_array_free(xids, TRUE);
+    g_hash_table_iter_init(&hint_it, self->priv->hints);
+    while (g_hash_table_iter_next(&hint_it, &key, &value)) {
+        _dbus_dict_append_value(&dict, (const char*) key, (const GValue*) value);
+    }
+    dbus_message_iter_close_container(&item, &dict);
+    dbus_message_iter_close_container(iter, &item);
+}
+
+
 static void task_icon_dispatcher_class_init(TaskIconDispatcherClass* klass)
 {
     task_icon_dispatcher_parent_class = g_type_class_peek_parent(klass);
@@ -5440,6 +5767,7 @@ static void task_icon_dispatcher_dock_item_dbus_interface_interface_init(DockIte
 static void task_icon_dispatcher_instance_init(TaskIconDispatcher* self)
 {
     self->priv = TASK_ICON_DISPATCHER_GET_PRIVATE(self);
+    self->priv->hints = g_hash_table_new_full(g_str_hash, g_str_equal, _g_free0_, __vala_GValue_free0_);
 }
 
 
@@ -5456,10 +5784,12 @@ static void task_icon_dispatcher_finalize(GObject* obj)
         char* _tmp2_;
         _tmp1_ = g_strdup(self->priv->_object_path);
         _tmp2_ = _tmp1_;
+        task_manager_dispatcher_item_removed(proxy, _tmp2_);
         g_signal_emit_by_name((DockManagerDBusInterface*) proxy, "item-removed", _tmp2_);
         _g_free0(_tmp2_);
     }
     _g_free0(self->priv->_object_path);
+    _g_hash_table_unref0(self->priv->hints);
     G_OBJECT_CLASS(task_icon_dispatcher_parent_class)->finalize(obj);
 }
 
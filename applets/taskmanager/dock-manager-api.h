@@ -116,11 +116,13 @@ GType task_manager_dispatcher_get_type(void) G_GNUC_CONST;
 TaskManagerDispatcher* task_manager_dispatcher_new(TaskManager* manager);
 TaskManagerDispatcher* task_manager_dispatcher_construct(GType object_type, TaskManager* manager);
 TaskManager* task_manager_dispatcher_get_manager(TaskManagerDispatcher* self);
+void task_manager_dispatcher_item_changed(TaskManagerDispatcher* self, const gchar* object_path);
 GType task_icon_dispatcher_get_type(void) G_GNUC_CONST;
 TaskIconDispatcher* task_icon_dispatcher_new(TaskIcon* icon);
 TaskIconDispatcher* task_icon_dispatcher_construct(GType object_type, TaskIcon* icon);
 const gchar* task_icon_dispatcher_get_object_path(TaskIconDispatcher* self);
 void task_icon_dispatcher_set_object_path(TaskIconDispatcher* self, const gchar* value);
+void task_icon_dispatcher_mark_changed(TaskIconDispatcher* self);
 
 #ifdef __cplusplus
 } // extern "C"
@@ -48,6 +48,7 @@
 #include "task-icon.h"
 #include "task-icon-build-context-menus.h"
 #include "task-icon-private.h"
+#include "task-menu-template.h"
 
 #include "config.h"
 
@@ -63,12 +64,7 @@
 #define STOCK_MINIMIZE "wnck-stock-minimize"
 #define MAX_MENU_ITEM_CHARS 55
 
-static void menu_parse_start_element(GMarkupParseContext* context,
-                                     const gchar*         element_name,
-                                     const gchar**        attribute_names,
-                                     const gchar**        attribute_values,
-                                     gpointer            user_data,
-                                     GError**             error);
+static void task_icon_menu_run_ops(TaskIcon* icon, GtkWidget* menu, const GPtrArray* ops);
 
 static GtkWidget* task_icon_get_submenu_action_menu(TaskIcon* icon, WnckWindow* win);
 
@@ -1276,212 +1272,25 @@ task_icon_insert_plugin_menu_items(TaskIcon* icon, GtkMenu* menu)
     }
 }
 
-typedef enum {
-    DBUS_SIGNAL,
-    EXTERNAL_COMMAND,
-    INTERNAL_ABOUT,
-    INTERNAL_ADD_TO_LAUNCHER_LIST,
-    INTERNAL_CLOSE_ACTIVE,
-    INTERNAL_CLOSE_ALL,
-    INTERNAL_CUSTOMIZE_ICON,
-    INTERNAL_DOCK_PREFS,
-    INTERNAL_INLINE_ACTION_MENU_ACTIVE,
-    INTERNAL_INLINE_PLUGINS,
-    INTERNAL_INLINE_SUBMENUS_ACTION_MENU_INACTIVES,
-    INTERNAL_LAUNCH,
-    INTERNAL_MAXIMIZE_ALL,
-    INTERNAL_MINIMIZE_ALL,
-    INTERNAL_REMOVE_CUSTOMIZED_ICON,
-    INTERNAL_REMOVE_FROM_LAUNCHER_LIST,
-    INTERNAL_SEPARATOR,
-    INTERNAL_SMART_WNCK_MENU,
-    INTERNAL_SMART_WNCK_SIMPLE_MENU,
-    INTERNAL_UNMAXIMIZE_ALL,
-    INTERNAL_UNMINIMIZE_ALL,
-    MENU,
-    SUBMENU,
-    UNKNOWN_ITEM_TYPE
-} MenuType;
-
-typedef struct {
-    MenuType  context_menu_item_type;
-    const gchar*      value;
-} ContextMenuItemType;
-
-static GtkWidget* lastitem = NULL;
-
-const ContextMenuItemType context_menu_item_type_list[] = {
-    { DBUS_SIGNAL, "Dbus-Signal"},
-    { EXTERNAL_COMMAND, "External-Command"},
-    { INTERNAL_ABOUT, "Internal-About"},
-    { INTERNAL_ADD_TO_LAUNCHER_LIST, "Internal-Add-To-Launcher-List"},
-    { INTERNAL_CLOSE_ACTIVE, "Internal-Close-Active"},
-    { INTERNAL_CLOSE_ALL, "Internal-Close-All"},
-    { INTERNAL_CUSTOMIZE_ICON, "Internal-Customize-Icon"},
-    { INTERNAL_DOCK_PREFS, "Internal-Dock-Prefs"},
-    { INTERNAL_INLINE_ACTION_MENU_ACTIVE, "Internal-Inline-Action-Menu-Active"},
-    { INTERNAL_INLINE_SUBMENUS_ACTION_MENU_INACTIVES, "Internal-Inline-Submenus-Action-Menu-Inactives"},
-    { INTERNAL_INLINE_PLUGINS, "Internal-Inline-Plugins"},
-    { INTERNAL_LAUNCH, "Internal-Launch"},
-    { INTERNAL_MAXIMIZE_ALL, "Internal-Maximize-All"},
-    { INTERNAL_MINIMIZE_ALL, "Internal-Minimize-All"},
-    { INTERNAL_REMOVE_CUSTOMIZED_ICON, "Internal-Remove-Customized-Icon"},
-    { INTERNAL_REMOVE_FROM_LAUNCHER_LIST, "Internal-Remove-From-Launcher-List"},
-    { INTERNAL_SEPARATOR, "Internal-Separator"},
-    { INTERNAL_SMART_WNCK_MENU, "Internal-Smart-Wnck-Menu"},
-    { INTERNAL_SMART_WNCK_SIMPLE_MENU, "Internal-Smart-Wnck-Simple-Menu"},
-    { INTERNAL_UNMAXIMIZE_ALL, "Internal-Unmaximize-All"},
-    { INTERNAL_UNMINIMIZE_ALL, "Internal-Unminimize-All"},
-    { UNKNOWN_ITEM_TYPE, NULL}
-};
-
-
-#if !GLIB_CHECK_VERSION (2,18,0)
-GtkWidget* _smenu = NULL;
-#endif
-
-/* Called for close tags </foo> */
-static void
-menu_parse_end_element(GMarkupParseContext* context,
-                       const gchar*         element_name,
-                       gpointer             user_data,
-                       GError**             error)
-{
-    if (g_strcmp0(element_name, "submenu") == 0) {
-#if GLIB_CHECK_VERSION (2,18,0)
-        g_markup_parse_context_pop(context);
-#else
-        _smenu = NULL;
-#endif
-    }
-}
-
-/* Called for character data */
-/* text is not nul-terminated */
-static void
-menu_parse_text(GMarkupParseContext* context,
-                const gchar*         text,
-                gsize                text_len,
-                gpointer             user_data,
-                GError**             error)
-{
-    if (text && text_len && lastitem) {
-        gchar* s = g_strdup(text);
-        s = g_strstrip(s);
-        if ((strlen(s))) {
-#if GTK_CHECK_VERSION (2,16,0)
-            gtk_menu_item_set_label(GTK_MENU_ITEM(lastitem), text);
-#else
-            GtkWidget* menu_label = gtk_bin_get_child(GTK_BIN(lastitem));
-            gtk_label_set_text(GTK_LABEL(menu_label), text);
-#endif
-
-
-        }
-    }
-}
-
-/* Called on error, including one set by other
-   * methods in the vtable. The GError should not be freed.
-   */
-static void menu_parse_error(GMarkupParseContext* context,
-                             GError*              error,
-                             gpointer             user_data)
-{
-//  g_debug ("%s:",__func__);
-}
-
-GMarkupParser sub_markup_parser = {menu_parse_start_element,
-                                   menu_parse_end_element,
-                                   menu_parse_text,
-                                   NULL,
-                                   menu_parse_error
-                                  };
-
 static void
-menu_parse_start_element(GMarkupParseContext* context,
-                         const gchar*         element_name,
-                         const gchar**        attribute_names,
-                         const gchar**        attribute_values,
-                         gpointer            user_data,
-                         GError**             error)
+task_icon_menu_run_op(TaskIcon* icon, GtkWidget* menu, const TaskMenuOp* op)
 {
-    const gchar** name_iter = attribute_names;
-    const gchar** value_iter = attribute_values;
     GtkWidget* menuitem = NULL;
-    GtkWidget* menu = user_data;
-    TaskIcon* icon = NULL;
     TaskIconPrivate* priv = NULL;
-    MenuType item_type = UNKNOWN_ITEM_TYPE;
-    const gchar* cmd_value = NULL;
-    const gchar* icon_value = NULL;
-    const gchar* args_value = NULL;
-    const gchar* text_value = NULL;
-    const gchar* shell_value = NULL;
+    const gchar* cmd_value = op->cmd;
+    const gchar* icon_value = op->icon;
+    const gchar* text_value = op->text;
+    const gchar* shell_value = op->shell;
     const gchar* custom_name = NULL;
     GtkWidget* submenu = NULL;
     AwnApplet* applet = NULL;
-    gint height;
-    gint width;
 
-#if !GLIB_CHECK_VERSION (2,18,0)
-    if (_smenu) {
-        menu = _smenu;
-    }
-#endif
-    g_return_if_fail(GTK_IS_MENU(menu));
-    icon =  g_object_get_qdata(G_OBJECT(menu), g_quark_from_static_string("ICON"));
-    g_assert(TASK_IS_ICON(icon));
-
-    lastitem = NULL;
     g_object_get(icon,
                  "applet", &applet,
                  NULL);
     priv = icon->priv;
-    gtk_icon_size_lookup(GTK_ICON_SIZE_MENU, &width, &height);
-    if (g_strcmp0(element_name, "menuitem") == 0) {
-        for (; *name_iter && *value_iter; name_iter++, value_iter++) {
-            const gchar* name = *name_iter;
-            const gchar* value = *value_iter;
-            if (g_strcmp0(name, "type") == 0) {
-                guint i;
-                item_type = UNKNOWN_ITEM_TYPE;
-                for (i = 0; i < (sizeof(context_menu_item_type_list) / sizeof(ContextMenuItemType)); i++) {
-                    const ContextMenuItemType* ctx_item = &context_menu_item_type_list[i];
-                    if (g_strcmp0(value, ctx_item->value) == 0) {
-                        item_type = ctx_item->context_menu_item_type;
-                        break;
-                    }
-                }
-            } else if (g_strcmp0(name, "args") == 0) {
-                args_value = value;
-            } else if (g_strcmp0(name, "icon") == 0) {
-                icon_value = value;
-            } else if (g_strcmp0(name, "cmd") == 0) {
-                cmd_value = value;
-            } else if (g_strcmp0(name, "text") == 0) {
-                text_value = value;
-            } else if (g_strcmp0(name, "shell") == 0) {
-                shell_value = value;
-            }
-        }
-    } else if (g_strcmp0(element_name, "submenu") == 0) {
-        item_type = SUBMENU;
-        for (; *name_iter && *value_iter; name_iter++, value_iter++) {
-            const gchar* name = *name_iter;
-            const gchar* value = *value_iter;
-            if (g_strcmp0(name, "icon") == 0) {
-                icon_value = value;
-            } else if (g_strcmp0(name, "text") == 0) {
-                text_value = value;
-            }
-        }
-    } else if (g_strcmp0(element_name, "menu") == 0) {
-        item_type = MENU;
-    }
 
-    menuitem = NULL;
-    switch (item_type) {
+    switch (op->type) {
     case DBUS_SIGNAL:
         g_warning("%s: stub... plugin support not present", __func__);
         break;
@@ -1688,32 +1497,12 @@ menu_parse_start_element(GMarkupParseContext* context,
     case MENU:
         break;
     case SUBMENU:
-#if GLIB_CHECK_VERSION (2,18,0)
         menuitem = gtk_image_menu_item_new_with_label(text_value ? text_value : "");
         submenu = gtk_menu_new();
-        g_object_set_qdata(G_OBJECT(submenu), g_quark_from_static_string("ICON"), icon);
         gtk_menu_item_set_submenu(GTK_MENU_ITEM(menuitem), submenu);
+        task_icon_menu_run_ops(icon, submenu, op->children);
         gtk_widget_show_all(menuitem);
-        g_markup_parse_context_push(context, &sub_markup_parser, submenu);
-#else
-        if (_smenu) {
-            g_critical("%s: Error parsing context menu xml. Only one submenu level is allowed with GLIB < 2.18.0", __func__);
-        }
-        menuitem = gtk_image_menu_item_new_with_label(text_value ? text_value : "");
-        submenu = gtk_menu_new();
-        g_object_set_qdata(G_OBJECT(submenu), g_quark_from_static_string("ICON"), icon);
-        gtk_menu_item_set_submenu(GTK_MENU_ITEM(menuitem), submenu);
-        gtk_widget_show_all(menuitem);
-        _smenu = submenu;
-#endif
         break;
-    case UNKNOWN_ITEM_TYPE: {
-        gint line_number;
-        gint char_number;
-        g_markup_parse_context_get_position(context, &line_number, &char_number);
-        g_warning("%s: Unknown item type, element_name = %s, line = %d", __func__, element_name, line_number);
-    }
-    break;
     default:
         g_assert_not_reached();
         break;
@@ -1728,22 +1517,32 @@ menu_parse_start_element(GMarkupParseContext* context,
         }
         gtk_menu_shell_append(GTK_MENU_SHELL(menu), menuitem);
     }
-    lastitem = menuitem;
+    if (menuitem && op->label) {
+#if GTK_CHECK_VERSION (2,16,0)
+        gtk_menu_item_set_label(GTK_MENU_ITEM(menuitem), op->label);
+#else
+        GtkWidget* menu_label = gtk_bin_get_child(GTK_BIN(menuitem));
+        gtk_label_set_text(GTK_LABEL(menu_label), op->label);
+#endif
+    }
+}
+
+static void
+task_icon_menu_run_ops(TaskIcon* icon, GtkWidget* menu, const GPtrArray* ops)
+{
+    guint i;
+
+    for (i = 0; i < ops->len; i++) {
+        task_icon_menu_run_op(icon, menu, (const TaskMenuOp*) g_ptr_array_index(ops, i));
+    }
 }
 
 GtkWidget*
 task_icon_build_context_menu(TaskIcon* icon)
 {
     GError* err = NULL;
-    gchar* contents = NULL;
     static gboolean done_once = FALSE;
-    GMarkupParseContext* markup_parser_context = NULL;
-    GMarkupParser markup_parser = {menu_parse_start_element,
-                                   menu_parse_end_element,
-                                   menu_parse_text,
-                                   NULL,
-                                   menu_parse_error
-                                  };
+    const GPtrArray* ops;
     gchar* base_menu_filename = NULL;
     gchar* menu_filename = NULL;
     GtkWidget* menu = gtk_menu_new();
@@ -1761,8 +1560,6 @@ task_icon_build_context_menu(TaskIcon* icon)
         }
     }
 
-    g_object_set_qdata(G_OBJECT(menu), g_quark_from_static_string("ICON"), icon);
-
     gtk_widget_show_all(menu);
     g_object_get(icon,
                  "menu_filename", &base_menu_filename,
@@ -1775,44 +1572,35 @@ task_icon_build_context_menu(TaskIcon* icon)
 //    menu_filename = g_strdup_printf ("/usr/local/share/avant-window-navigator/applets/taskmanager/menus/%s",base_menu_filename);
     }
     g_free(base_menu_filename);
-    if (g_file_get_contents(menu_filename, &contents, NULL, &err)) {
-        markup_parser_context = g_markup_parse_context_new(&markup_parser, 0, menu, (GDestroyNotify) NULL);
-    }
+
+    /* compiled once per file, the file is only read again after it changed */
+    ops = task_menu_template_get(menu_filename, &err);
     if (err) {
         g_warning("%s: error loading menu file %s.  %s", __func__, menu_filename, err->message);
         g_error_free(err);
         err = NULL;
         g_warning("%s: Attempting to load standard.xml", __func__);
+        g_free(menu_filename);
         menu_filename = g_strdup_printf("%s/taskmanager/menus/standard.xml", APPLETDATADIR);
-        if (g_file_get_contents(menu_filename, &contents, NULL, &err)) {
-            markup_parser_context = g_markup_parse_context_new(&markup_parser, 0, menu, (GDestroyNotify) NULL);
-        }
+        ops = task_menu_template_get(menu_filename, &err);
         if (err) {
             g_warning("%s: error loading menu file %s.  %s", __func__, menu_filename, err->message);
             g_error_free(err);
-            err = NULL;
+            g_free(menu_filename);
             return menu; //return empty menu.
         }
     }
-    if (markup_parser_context) {
-        g_markup_parse_context_parse(markup_parser_context, contents, strlen(contents), &err);
-        if (err) {
-            g_message("%s: error parsing menu file %s.  %s", __func__, menu_filename, err->message);
-            g_error_free(err);
-            err = NULL;
-        }
-        g_markup_parse_context_free(markup_parser_context);
-    }
-
     g_free(menu_filename);
 
+    task_icon_menu_run_ops(icon, menu, ops);
+
     GList* children = gtk_container_get_children(GTK_CONTAINER(menu));
-    if (GTK_IS_SEPARATOR_MENU_ITEM(g_list_last(children)->data)) {
+    if (children && GTK_IS_SEPARATOR_MENU_ITEM(g_list_last(children)->data)) {
         gtk_widget_hide(GTK_WIDGET(g_list_last(children)->data));
     }
-    if (GTK_IS_SEPARATOR_MENU_ITEM(g_list_first(children)->data)) {
+    if (children && GTK_IS_SEPARATOR_MENU_ITEM(g_list_first(children)->data)) {
         gtk_widget_hide(GTK_WIDGET(g_list_first(children)->data));
     }
+    g_list_free(children);
     return menu;
 }
-
@@ -79,7 +79,8 @@ struct _TaskIconPrivate {
     guint  max_indicators;
     guint  txt_indicator_threshold;
 
-    gint update_geometry_id;
+    /* the window minimize targets need to be published again */
+    gboolean geometry_dirty;
 
     /*Keep track if TaskLauncher was added through desktop file lookup
      FIXME _should_ be able to dump this by setting the task launcher visibility to false for ephemeral launchers.
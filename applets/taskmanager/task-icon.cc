@@ -167,7 +167,6 @@ static void      task_icon_dest_drag_data_received(GtkWidget*      widget,
 static void     task_icon_size_allocate(TaskIcon* icon,
                                         GtkAllocation* alloc,
                                         gpointer user_data);
-static gboolean task_icon_refresh_geometry(TaskIcon* icon);
 static void     task_icon_refresh_visible(TaskIcon* icon);
 static void     task_icon_search_main_item(TaskIcon* icon, TaskItem* main_item);
 static void     task_icon_active_window_changed(WnckScreen* screen,
@@ -407,10 +406,6 @@ task_icon_finalize(GObject* object)
         g_free(priv->menu_filename);
     }
 
-    if (priv->update_geometry_id) {
-        g_source_remove(priv->update_geometry_id);
-    }
-
     g_free(priv->custom_name);
 
     g_signal_handlers_disconnect_by_func(wnck_screen_get_default(),
@@ -591,38 +586,49 @@ task_icon_size_allocate(TaskIcon* icon, GtkAllocation* alloc,
 }
 
 /**
- * Set the icon geometry of the windows in a task-icon.
+ * Collect the icon geometry of the windows in a task-icon.
  * This equals to the minimize position of the window.
+ * The position is computed from the allocations, relative to the applet
+ * which is at origin_x, origin_y on the screen. Only the windows whose
+ * geometry changed since it was last published are appended to xids/rects.
  */
-static gboolean
-task_icon_refresh_geometry(TaskIcon* icon)
+void
+task_icon_collect_geometry(TaskIcon* icon,
+                           gint      origin_x,
+                           gint      origin_y,
+                           GArray*   xids,
+                           GArray*   rects)
 {
     TaskIconPrivate* priv;
     GtkWidget* widget;
     GtkAllocation alloc;
     GtkPositionType pos_type;
-    GdkWindow* win;
     GSList*    w;
     gint      base_x, base_y, x, y, size, offset, panel_size;
     gint      stripe_size, width, height;
     gint      len = 0;
 
-    g_return_val_if_fail(TASK_IS_ICON(icon), FALSE);
+    g_return_if_fail(TASK_IS_ICON(icon));
 
     priv = icon->priv;
     widget = GTK_WIDGET(icon);
 
-    priv->update_geometry_id = 0;
+    if (!priv->geometry_dirty) {
+        return;
+    }
+    priv->geometry_dirty = FALSE;
 
     if (!gtk_widget_is_drawable(GTK_WIDGET(widget))) {
-        return FALSE;
+        return;
     }
 
-    win = gtk_widget_get_window(widget);
-    g_return_val_if_fail(win != NULL, FALSE);
-
-    // get the position of the widget
-    gdk_window_get_origin(win, &base_x, &base_y);
+    // get the position of the widget inside the applet
+    if (!gtk_widget_translate_coordinates(widget, GTK_WIDGET(priv->applet),
+                                          0, 0, &base_x, &base_y)) {
+        return;
+    }
+    base_x += origin_x;
+    base_y += origin_y;
 
     gtk_widget_get_allocation(GTK_WIDGET(icon), &alloc);
 
@@ -689,8 +695,13 @@ task_icon_refresh_geometry(TaskIcon* icon)
             }
 
             TaskWindow* window = TASK_WINDOW(w->data);
+            GdkRectangle rect = { x, y, width, height };
 
-            task_window_set_icon_geometry(window, x, y, width, height);
+            if (task_window_update_icon_geometry(window, &rect)) {
+                gulong xid = task_window_get_xid(window);
+                g_array_append_val(xids, xid);
+                g_array_append_val(rects, rect);
+            }
 
             // shift the stripe
             if (pos_type == GTK_POS_LEFT || pos_type == GTK_POS_RIGHT) {
@@ -700,9 +711,12 @@ task_icon_refresh_geometry(TaskIcon* icon)
             }
         }
     }
-    return FALSE;
 }
 
+/**
+ * Mark the icon geometry of the windows as outdated, the TaskManager
+ * publishes the geometries of all the icons at once.
+ */
 void
 task_icon_schedule_geometry_refresh(TaskIcon* icon)
 {
@@ -710,9 +724,9 @@ task_icon_schedule_geometry_refresh(TaskIcon* icon)
 
     TaskIconPrivate* priv = icon->priv;
 
-    if (priv->update_geometry_id == 0) {
-        GSourceFunc func = (GSourceFunc)task_icon_refresh_geometry;
-        priv->update_geometry_id = g_idle_add(func, icon);
+    priv->geometry_dirty = TRUE;
+    if (TASK_IS_MANAGER(priv->applet)) {
+        task_manager_queue_icon_geometry(TASK_MANAGER(priv->applet));
     }
 }
 
@@ -922,7 +936,7 @@ task_icon_init(TaskIcon* icon)
     priv->drag_tag = 0;
     priv->drag_motion = FALSE;
     priv->gets_dragged = FALSE;
-    priv->update_geometry_id = 0;
+    priv->geometry_dirty = FALSE;
     priv->shown_items = 0;
     priv->needs_attention = 0;
     priv->is_active = 0;
@@ -1185,6 +1199,9 @@ _destroyed_task_item(TaskIcon* icon, TaskItem* old_item)
     priv = icon->priv;
 
     priv->items = g_slist_remove(priv->items, old_item);
+    if (priv->dbus_proxy) {
+        task_icon_dispatcher_mark_changed(priv->dbus_proxy);
+    }
 
     if (old_item == priv->main_item && priv->items) {
         task_icon_search_main_item(icon, NULL);
@@ -2003,6 +2020,9 @@ task_icon_append_item(TaskIcon*      icon,
 
     task_item_set_task_icon(item, icon);
     task_icon_refresh_visible(icon);
+    if (priv->dbus_proxy) {
+        task_icon_dispatcher_mark_changed(priv->dbus_proxy);
+    }
 
     /* Connect item signals */
     g_signal_connect(item, "visible-changed",
@@ -2096,7 +2116,7 @@ task_icon_configure_event(GtkWidget*          widget,
     priv->old_width = event->width;
     priv->old_height = event->height;
 
-    g_idle_add((GSourceFunc)task_icon_refresh_geometry, TASK_ICON(widget));
+    task_icon_schedule_geometry_refresh(TASK_ICON(widget));
 
     return TRUE;
 }
@@ -132,6 +132,12 @@ void            task_icon_set_inhibit_focus_loss(TaskIcon* icon, gboolean val);
 
 void            task_icon_schedule_geometry_refresh(TaskIcon* icon);
 
+void            task_icon_collect_geometry(TaskIcon* icon,
+        gint      origin_x,
+        gint      origin_y,
+        GArray*   xids,
+        GArray*   rects);
+
 void            task_icon_moving_item(TaskIcon* dest, TaskIcon* src, TaskItem* item);
 
 const TaskItem* task_icon_get_main_item(TaskIcon* icon);
@@ -24,6 +24,8 @@
 #include <libawn/libawn.h>
 
 #define TASK_ITEM_ICON_SCALE 0.65
+/* DockItem hints are applied at most once per this many ms */
+#define TASK_ITEM_HINTS_INTERVAL 40
 
 G_DEFINE_ABSTRACT_TYPE(TaskItem, task_item, GTK_TYPE_BUTTON)
 
@@ -39,8 +41,27 @@ struct _TaskItemPrivate {
     TaskIcon* task_icon;
     AwnApplet* applet;
     gboolean  ignore_wm_client_name;
+
+    /* coalesced overlay hints (TaskItemHint*) in the order they arrived,
+     * a key sent again replaces its old value and moves to the end */
+    GQueue*    pending_hints;
+    guint      hints_source;
+    GTimeVal   hints_applied;
 };
 
+typedef struct {
+    gchar* key;
+    GValue value;
+} TaskItemHint;
+
+static void
+task_item_free_hint(TaskItemHint* hint)
+{
+    g_free(hint->key);
+    g_value_unset(&hint->value);
+    g_slice_free(TaskItemHint, hint);
+}
+
 enum {
     PROP_0,
     PROP_APPLET,
@@ -140,6 +161,16 @@ task_item_dispose(GObject* object)
         g_object_unref(priv->proxy);
         priv->proxy = NULL;
     }
+    if (priv->hints_source) {
+        g_source_remove(priv->hints_source);
+        priv->hints_source = 0;
+    }
+    if (priv->pending_hints) {
+        g_queue_foreach(priv->pending_hints, (GFunc)task_item_free_hint, NULL);
+        g_queue_free(priv->pending_hints);
+        priv->pending_hints = NULL;
+    }
+
     // this removes the overlays from the associated TaskIcon
     task_item_set_task_icon(item, NULL);
 
@@ -552,13 +583,18 @@ task_item_set_task_icon(TaskItem* item, TaskIcon* icon)
     }
 }
 
-void
-task_item_update_overlay(TaskItem* item, const gchar* key, GValue* value)
+/*
+ * Applies a single hint, returns TRUE if a new overlay was created
+ * (ie. the set of overlays changed and TaskIcon needs to pick it up).
+ * Values which didn't change aren't set again to avoid useless redraws.
+ */
+static gboolean
+task_item_apply_overlay_hint(TaskItem* item, const gchar* key, GValue* value)
 {
-    g_return_if_fail(TASK_IS_ITEM(item));
+    gboolean created = FALSE;
 
     if (strcmp("icon-file", key) == 0) {
-        g_return_if_fail(G_VALUE_HOLDS_STRING(value));
+        g_return_val_if_fail(G_VALUE_HOLDS_STRING(value), FALSE);
 
         if (item->icon_overlay == NULL) {
             item->icon_overlay = awn_overlay_pixbuf_file_new(NULL);
@@ -569,20 +605,26 @@ task_item_update_overlay(TaskItem* item, const gchar* key, GValue* value)
             AwnOverlayable* over = AWN_OVERLAYABLE(image);
             awn_overlayable_add_overlay(over,
                                         AWN_OVERLAY(item->icon_overlay));
+            created = TRUE;
         }
 
         const gchar* filename = g_value_get_string(value);
-        g_object_set(G_OBJECT(item->icon_overlay),
-                     "active", filename && filename[0] != '\0', NULL);
-        if (filename && filename[0] != '\0') {
+        gboolean active = filename && filename[0] != '\0';
+        gboolean was_active;
+        gchar* current = NULL;
+
+        g_object_get(G_OBJECT(item->icon_overlay), "active", &was_active,
+                     "file-name", &current, NULL);
+        if (was_active != active) {
+            g_object_set(G_OBJECT(item->icon_overlay), "active", active, NULL);
+        }
+        if (active && g_strcmp0(current, filename) != 0) {
             g_object_set_property(G_OBJECT(item->icon_overlay),
                                   "file-name", value);
         }
-
-        // this refreshes the overlays on TaskIcon
-        task_item_set_task_icon(item, task_item_get_task_icon(item));
+        g_free(current);
     } else if (strcmp("progress", key) == 0) {
-        g_return_if_fail(G_VALUE_HOLDS_INT(value));
+        g_return_val_if_fail(G_VALUE_HOLDS_INT(value), FALSE);
 
         if (item->progress_overlay == NULL) {
             item->progress_overlay = awn_overlay_progress_circle_new();
@@ -593,27 +635,51 @@ task_item_update_overlay(TaskItem* item, const gchar* key, GValue* value)
             AwnOverlayable* over = AWN_OVERLAYABLE(image);
             awn_overlayable_add_overlay(over,
                                         AWN_OVERLAY(item->progress_overlay));
+            created = TRUE;
         }
 
-        g_object_set(G_OBJECT(item->progress_overlay),
-                     "active", g_value_get_int(value) != -1, NULL);
-        if (g_value_get_int(value) != -1) {
+        gint percent = g_value_get_int(value);
+        gboolean was_active;
+        gdouble current = -1.0;
+
+        g_object_get(G_OBJECT(item->progress_overlay), "active", &was_active,
+                     "percent-complete", &current, NULL);
+        if (was_active != (percent != -1)) {
+            g_object_set(G_OBJECT(item->progress_overlay),
+                         "active", percent != -1, NULL);
+        }
+        if (percent != -1 && current != percent) {
             g_object_set_property(G_OBJECT(item->progress_overlay),
                                   "percent-complete", value);
         }
-
-        // this refreshes the overlays on TaskIcon
-        task_item_set_task_icon(item, task_item_get_task_icon(item));
     } else if (strcmp("message", key) == 0 || strcmp("badge", key) == 0) {
-        g_return_if_fail(G_VALUE_HOLDS_STRING(value));
+        g_return_val_if_fail(G_VALUE_HOLDS_STRING(value), FALSE);
 
         if (item->text_overlay == NULL) {
             item->text_overlay = awn_overlay_text_new();
             GtkWidget* image = task_item_get_image_widget(item);
             AwnOverlayable* over = AWN_OVERLAYABLE(image);
             awn_overlayable_add_overlay(over, AWN_OVERLAY(item->text_overlay));
+            created = TRUE;
+        }
+
+        const gchar* text = g_value_get_string(value);
+        gboolean active = text && text[0] != '\0';
+        gboolean was_active;
+        gchar* current = NULL;
+
+        g_object_get(G_OBJECT(item->text_overlay), "active", &was_active,
+                     "text", &current, NULL);
+        if (!active) {
+            // just hide it, keep the style of whatever was shown
+            if (was_active) {
+                g_object_set(G_OBJECT(item->text_overlay), "active", FALSE, NULL);
+            }
+            g_free(current);
+            return created;
         }
 
+        g_object_freeze_notify(G_OBJECT(item->text_overlay));
         if (strcmp("badge", key) == 0) {
             g_object_set(G_OBJECT(item->text_overlay),
                          "font-sizing", AWN_FONT_SIZE_MEDIUM,
@@ -630,20 +696,138 @@ task_item_update_overlay(TaskItem* item, const gchar* key, GValue* value)
                          "y-adj", 0.0, NULL);
         }
 
-        const gchar* text = g_value_get_string(value);
-        g_object_set(G_OBJECT(item->text_overlay),
-                     "active", text && text[0] != '\0', NULL);
-        if (text && text[0] != '\0') {
+        if (!was_active) {
+            g_object_set(G_OBJECT(item->text_overlay), "active", TRUE, NULL);
+        }
+        if (g_strcmp0(current, text) != 0) {
             g_object_set_property(G_OBJECT(item->text_overlay), "text", value);
         }
-
-        // this refreshes the overlays on TaskIcon
-        task_item_set_task_icon(item, task_item_get_task_icon(item));
+        g_free(current);
+        g_object_thaw_notify(G_OBJECT(item->text_overlay));
     } else if (strcmp("visible", key) == 0) {
         // we do support this key, though not here
     } else {
         g_debug("TaskItem doesn't support key: \"%s\"", key);
     }
+
+    return created;
+}
+
+static gboolean
+task_item_flush_overlay_hints(TaskItem* item)
+{
+    TaskItemPrivate* priv = TASK_ITEM_GET_PRIVATE(item);
+    TaskItemHint* hint;
+    gboolean created = FALSE;
+
+    priv->hints_source = 0;
+    g_get_current_time(&priv->hints_applied);
+
+    if (priv->pending_hints == NULL) {
+        return FALSE;
+    }
+
+    // in arrival order, "badge" and "message" share the text overlay
+    while ((hint = (TaskItemHint*)g_queue_pop_head(priv->pending_hints))) {
+        created |= task_item_apply_overlay_hint(item, hint->key, &hint->value);
+        task_item_free_hint(hint);
+    }
+
+    if (created) {
+        // this refreshes the overlays on TaskIcon
+        task_item_set_task_icon(item, task_item_get_task_icon(item));
+    }
+
+    return FALSE;
+}
+
+static void
+task_item_queue_overlay_hint(TaskItem* item, const gchar* key, GValue* value)
+{
+    TaskItemPrivate* priv = TASK_ITEM_GET_PRIVATE(item);
+    TaskItemHint* hint;
+
+    if (priv->pending_hints == NULL) {
+        priv->pending_hints = g_queue_new();
+    }
+
+    for (GList* l = priv->pending_hints->head; l; l = l->next) {
+        hint = (TaskItemHint*)l->data;
+        if (strcmp(hint->key, key) == 0) {
+            g_queue_delete_link(priv->pending_hints, l);
+            task_item_free_hint(hint);
+            break;
+        }
+    }
+
+    hint = g_slice_new0(TaskItemHint);
+    hint->key = g_strdup(key);
+    g_value_init(&hint->value, G_VALUE_TYPE(value));
+    g_value_copy(value, &hint->value);
+    g_queue_push_tail(priv->pending_hints, hint);
+}
+
+static void
+task_item_schedule_overlay_hints(TaskItem* item)
+{
+    TaskItemPrivate* priv = TASK_ITEM_GET_PRIVATE(item);
+    GTimeVal now;
+    glong elapsed;
+
+    if (priv->hints_source) {
+        return;
+    }
+
+    g_get_current_time(&now);
+    elapsed = (now.tv_sec - priv->hints_applied.tv_sec) * 1000 +
+              (now.tv_usec - priv->hints_applied.tv_usec) / 1000;
+    elapsed = CLAMP(elapsed, 0, TASK_ITEM_HINTS_INTERVAL);
+
+    // run before the redraw, so the frame picks up all the changes
+    priv->hints_source =
+        g_timeout_add_full(GDK_PRIORITY_REDRAW - 1,
+                           TASK_ITEM_HINTS_INTERVAL - elapsed,
+                           (GSourceFunc)task_item_flush_overlay_hints,
+                           item, NULL);
+}
+
+/**
+ * task_item_update_overlay:
+ *
+ * Queues a DockItem hint, hints for the same key which arrive before the
+ * next flush replace each other, so the overlays are updated at most once
+ * per TASK_ITEM_HINTS_INTERVAL no matter how often the client sends them.
+ */
+void
+task_item_update_overlay(TaskItem* item, const gchar* key, GValue* value)
+{
+    g_return_if_fail(TASK_IS_ITEM(item));
+    g_return_if_fail(key && value);
+
+    task_item_queue_overlay_hint(item, key, value);
+    task_item_schedule_overlay_hints(item);
+}
+
+/**
+ * task_item_update_overlays:
+ * @hints: a (key -> GValue*) hash table as received by UpdateDockItem
+ *
+ * Bulk version of task_item_update_overlay.
+ */
+void
+task_item_update_overlays(TaskItem* item, GHashTable* hints)
+{
+    GHashTableIter iter;
+    gpointer key, value;
+
+    g_return_if_fail(TASK_IS_ITEM(item));
+    g_return_if_fail(hints);
+
+    g_hash_table_iter_init(&iter, hints);
+    while (g_hash_table_iter_next(&iter, &key, &value)) {
+        task_item_queue_overlay_hint(item, (const gchar*)key, (GValue*)value);
+    }
+    task_item_schedule_overlay_hints(item);
 }
 
 TaskIcon*
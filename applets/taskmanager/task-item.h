@@ -112,6 +112,9 @@ void          task_item_update_overlay(TaskItem* item,
                                        const gchar* key,
                                        GValue* value);
 
+void          task_item_update_overlays(TaskItem* item,
+                                        GHashTable* hints);
+
 GtkWidget*    task_item_get_image_widget(TaskItem* item);
 
 //TODO: 2nd round: implement
@@ -41,6 +41,7 @@
 #include <libawn/awn-pixbuf-cache.h>
 
 #include "task-launcher.h"
+#include "task-manager.h"
 #include "task-window.h"
 
 #include "task-settings.h"
@@ -59,6 +60,9 @@ extern "C" {
   TASK_TYPE_LAUNCHER, \
   TaskLauncherPrivate))
 
+/* added to the score of a launcher that started an ancestor of the window */
+#define LAUNCH_HINT_BONUS 4
+
 struct _TaskLauncherPrivate {
     gchar* path;
     DesktopAgnosticFDODesktopEntry* entry;
@@ -669,6 +673,24 @@ _is_visible(TaskItem* item)
     return TRUE;
 }
 
+/*
+ Returns a reference to the TaskManager the launcher belongs to, or NULL.
+ */
+static TaskManager*
+_get_manager(TaskLauncher* launcher)
+{
+    AwnApplet* applet = NULL;
+
+    g_object_get(launcher,
+                 "applet", &applet,
+                 NULL);
+    if (applet && !TASK_IS_MANAGER(applet)) {
+        g_object_unref(applet);
+        applet = NULL;
+    }
+    return applet ? TASK_MANAGER(applet) : NULL;
+}
+
 /**
  * Match the launcher with the provided window.
  * The higher the number it returns the more it matches the window.
@@ -698,8 +720,6 @@ _match(TaskItem* item,
     gchar* id = NULL;
 
     glibtop_proc_args buf;
-    glibtop_proc_uid buf_proc_uid;
-    glibtop_proc_uid ppid_buf_proc_uid;
     glong   timestamp;
     GTimeVal timeval;
     gint    result = 0;
@@ -709,6 +729,9 @@ _match(TaskItem* item,
     gchar* startup_wm_class = NULL;
 
     gboolean ignore_wm_client_name;
+    TaskManager* manager;
+    TaskLauncher* owner = NULL;
+    gboolean exact = FALSE;
 
     g_return_val_if_fail(TASK_IS_LAUNCHER(item), 0);
 
@@ -722,6 +745,21 @@ _match(TaskItem* item,
     priv->timestamp = 0;
     window = TASK_WINDOW(item_to_match);
 
+    /*
+     Windows carrying our startup id or belonging to a process started from
+     the dock are resolved through the launch table, no need to guess.
+     A launch only found through the window's ancestors (or WM_CLASS) just
+     tips the scales below.
+     */
+    manager = _get_manager(launcher);
+    if (manager) {
+        owner = task_manager_lookup_launch(manager, window, &exact);
+        g_object_unref(manager);
+        if (owner && exact) {
+            return owner == launcher ? 100 : 0;
+        }
+    }
+
     g_object_get(item,
                  "ignore_wm_client_name", &ignore_wm_client_name,
                  NULL);
@@ -748,8 +786,6 @@ _match(TaskItem* item,
     }
 
     pid = task_window_get_pid(window);
-    glibtop_get_proc_uid(&buf_proc_uid, pid);
-    glibtop_get_proc_uid(&ppid_buf_proc_uid, buf_proc_uid.ppid);
     g_get_current_time(&timeval);
     cmd = glibtop_get_proc_args(&buf, pid, 1024);
     full_cmd = get_full_cmd_from_pid(pid);
@@ -802,34 +838,8 @@ _match(TaskItem* item,
     }
 
     /*
-     Check the parent PID also
-     */
-    /*
-     Removing to test if they're resulting in some incorrect matches*/
-    /*
-    #ifdef DEBUG
-    g_debug ("ppid of window pid = %d, launch pid = %d",buf_proc_uid.ppid,priv->pid);
-    #endif
-    if (pid && buf_proc_uid.ppid)
-    {
-      if ( buf_proc_uid.ppid == priv->pid)
-      {
-        result = 92;
-        goto finished;
-      }
-
-
-    #ifdef DEBUG
-    g_debug ("ppid of parent pid = %d, launch pid = %d",ppid_buf_proc_uid.ppid,priv->pid);
-    #endif
-    if (pid && buf_proc_uid.ppid && ppid_buf_proc_uid.ppid)
-    {
-      if ( ppid_buf_proc_uid.ppid == priv->pid)
-      {
-        result = 91;
-        goto finished;
-      }
-    }
+     Children of a launched process only get a bonus on top of the other
+     checks (see finished below).
      */
 
     if (desktop_agnostic_fdo_desktop_entry_key_exists(priv->entry, "StartupWMClass")) {
@@ -837,7 +847,8 @@ _match(TaskItem* item,
         if (g_strcmp0(startup_wm_class, "Wine") != 0) {
             if ((g_strcmp0(startup_wm_class, res_name) == 0) || (g_strcmp0(startup_wm_class, class_name) == 0)) {
                 g_free(startup_wm_class);
-                return 94;
+                result = 94;
+                goto finished;
             }
         }
         g_free(startup_wm_class);
@@ -929,6 +940,9 @@ _match(TaskItem* item,
     }
 
 finished:
+    if (result && result < 99 && owner == launcher) {
+        result = MIN(result + LAUNCH_HINT_BONUS, 99);
+    }
     g_free(res_name);
     g_free(class_name);
     g_free(res_name_lower);
@@ -946,7 +960,8 @@ _left_click(TaskItem* item, GdkEventButton* event)
     TaskLauncher* launcher;
     GError* error = NULL;
     GTimeVal timeval;
-    gboolean startup_set = FALSE;
+    gchar* startup_id = NULL;
+    TaskManager* manager;
 
     g_return_if_fail(TASK_IS_LAUNCHER(item));
 
@@ -958,7 +973,7 @@ _left_click(TaskItem* item, GdkEventButton* event)
         GStrv tokens1;
         GStrv tokens2;
         gchar* screen_name = NULL;
-        gchar* id = g_strdup_printf("awn_task_manager_%u_TIME%u", getpid(), event ? event->time : gtk_get_current_event_time());
+        gchar* id = startup_id = g_strdup_printf("awn_task_manager_%u_TIME%u", getpid(), event ? event->time : gtk_get_current_event_time());
         gchar* display_name = gdk_screen_make_display_name(gdk_screen_get_default());
         tokens1 = g_strsplit(display_name, ":", 2);
         if (tokens1 && tokens1[1]) {
@@ -988,18 +1003,32 @@ _left_click(TaskItem* item, GdkEventButton* event)
                 NULL);
         //                                               "PID",pid,
         g_setenv("DESKTOP_STARTUP_ID", id, TRUE);
-        startup_set = TRUE;
-        g_free(id);
         g_free(screen_name);
     }
     priv->pid = desktop_agnostic_fdo_desktop_entry_launch(priv->entry,
                 0, NULL, &error);
-    if (startup_set) {
+    if (startup_id) {
         g_unsetenv("DESKTOP_STARTUP_ID");
     }
     g_get_current_time(&timeval);
     priv->timestamp = timeval.tv_sec;
 
+    manager = _get_manager(launcher);
+    if (manager && priv->pid > 0) {
+        gchar* startup_wm_class = NULL;
+
+        if (desktop_agnostic_fdo_desktop_entry_key_exists(priv->entry, "StartupWMClass")) {
+            startup_wm_class = desktop_agnostic_fdo_desktop_entry_get_string(priv->entry, "StartupWMClass");
+        }
+        task_manager_register_launch(manager, launcher, priv->pid,
+                                     startup_id, startup_wm_class);
+        g_free(startup_wm_class);
+    }
+    if (manager) {
+        g_object_unref(manager);
+    }
+    g_free(startup_id);
+
 #ifdef DEBUG
     g_debug("%s: current time = %ld", __func__, timeval.tv_sec);
     g_debug("%s: launch pid = %d", __func__, priv->pid);
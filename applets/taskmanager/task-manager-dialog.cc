@@ -22,6 +22,7 @@
 #include "task-manager-dialog.h"
 #include "task-window.h"
 #include "task-launcher.h"
+#include "task-thumbnailer.h"
 
 G_DEFINE_TYPE(TaskManagerDialog, task_manager_dialog, AWN_TYPE_DIALOG)
 
@@ -54,11 +55,19 @@ struct _TaskManagerDialogPrivate {
     GtkWidget* items_box;
 
     GList* children;
+
+    /* previews drawn by TaskThumbnailer instead of the WM */
+    gboolean thumbnails;
+    GHashTable* watched;
+    gulong thumbnail_changed_id;
 };
 
 static void
 task_manager_dialog_analyze_wm(TaskManagerDialog* dialog);
 
+static void
+task_manager_dialog_unwatch_all(TaskManagerDialog* dialog);
+
 static void
 task_manager_dialog_get_property(GObject* object, guint property_id,
                                  GValue* value, GParamSpec* pspec)
@@ -113,6 +122,16 @@ task_manager_dialog_dispose(GObject* object)
         g_signal_handler_disconnect(wnck_screen_get_default(), priv->wm_change_id);
         priv->wm_change_id = 0;
     }
+    if (priv->thumbnail_changed_id) {
+        g_signal_handler_disconnect(task_thumbnailer_get_default(),
+                                    priv->thumbnail_changed_id);
+        priv->thumbnail_changed_id = 0;
+    }
+    if (priv->watched) {
+        task_manager_dialog_unwatch_all(TASK_MANAGER_DIALOG(object));
+        g_hash_table_destroy(priv->watched);
+        priv->watched = NULL;
+    }
 
     G_OBJECT_CLASS(task_manager_dialog_parent_class)->dispose(object);
 }
@@ -213,6 +232,118 @@ task_manager_dialog_class_init(TaskManagerDialogClass* klass)
 }
 
 
+static void
+task_manager_dialog_watch(TaskManagerDialog* dialog, TaskWindow* window,
+                          gint width, gint height)
+{
+    TaskManagerDialogPrivate* priv = GET_PRIVATE(dialog);
+    TaskThumbnailer* thumbnailer = task_thumbnailer_get_default();
+    gulong xid = task_window_get_xid(window);
+
+    if (!xid) {
+        return;
+    }
+    if (!g_hash_table_lookup(priv->watched, GSIZE_TO_POINTER(xid))) {
+        task_thumbnailer_watch(thumbnailer, xid);
+        g_hash_table_insert(priv->watched, GSIZE_TO_POINTER(xid), window);
+    }
+    task_thumbnailer_set_size(thumbnailer, xid, width, height);
+    task_thumbnailer_set_visible(thumbnailer, xid, TRUE);
+}
+
+static void
+task_manager_dialog_unwatch(TaskManagerDialog* dialog, TaskWindow* window)
+{
+    TaskManagerDialogPrivate* priv = GET_PRIVATE(dialog);
+    GHashTableIter iter;
+    gpointer key, value;
+
+    if (!priv->watched) {
+        return;
+    }
+    // the xid is gone already if the window was closed
+    g_hash_table_iter_init(&iter, priv->watched);
+    while (g_hash_table_iter_next(&iter, &key, &value)) {
+        if (value == window) {
+            task_thumbnailer_unwatch(task_thumbnailer_get_default(),
+                                     GPOINTER_TO_SIZE(key));
+            g_hash_table_iter_remove(&iter);
+            break;
+        }
+    }
+}
+
+static void
+task_manager_dialog_unwatch_all(TaskManagerDialog* dialog)
+{
+    TaskManagerDialogPrivate* priv = GET_PRIVATE(dialog);
+    GHashTableIter iter;
+    gpointer key;
+
+    if (!priv->watched) {
+        return;
+    }
+    g_hash_table_iter_init(&iter, priv->watched);
+    while (g_hash_table_iter_next(&iter, &key, NULL)) {
+        task_thumbnailer_unwatch(task_thumbnailer_get_default(),
+                                 GPOINTER_TO_SIZE(key));
+    }
+    g_hash_table_remove_all(priv->watched);
+}
+
+static void
+task_manager_dialog_thumbnail_changed(TaskThumbnailer* thumbnailer,
+                                      gulong xid,
+                                      TaskManagerDialog* dialog)
+{
+    TaskManagerDialogPrivate* priv = GET_PRIVATE(dialog);
+    GtkWidget* window;
+
+    window = (GtkWidget*)g_hash_table_lookup(priv->watched,
+             GSIZE_TO_POINTER(xid));
+    if (window && gtk_widget_is_drawable(window)) {
+        gtk_widget_queue_draw(window);
+    }
+}
+
+/* runs after the children were drawn, same place as the KDE previews */
+static gboolean
+task_manager_dialog_expose_thumbnails(GtkWidget* dialog, GdkEventExpose* event,
+                                      gpointer nul)
+{
+    TaskManagerDialogPrivate* priv = GET_PRIVATE(dialog);
+    TaskThumbnailer* thumbnailer = task_thumbnailer_get_default();
+    GHashTableIter iter;
+    gpointer key, value;
+    cairo_t* cr;
+
+    if (!priv->thumbnails || priv->current_dialog_mode != 2) {
+        return FALSE;
+    }
+
+    cr = gdk_cairo_create(event->window);
+    gdk_cairo_region(cr, event->region);
+    cairo_clip(cr);
+
+    g_hash_table_iter_init(&iter, priv->watched);
+    while (g_hash_table_iter_next(&iter, &key, &value)) {
+        cairo_surface_t* thumb;
+        GtkAllocation allocation;
+
+        thumb = task_thumbnailer_get_thumbnail(thumbnailer,
+                                               GPOINTER_TO_SIZE(key));
+        if (!thumb || !gtk_widget_get_visible(GTK_WIDGET(value))) {
+            continue;
+        }
+        gtk_widget_get_allocation(GTK_WIDGET(value), &allocation);
+        cairo_set_source_surface(cr, thumb, allocation.x + 4, allocation.y + 4);
+        cairo_paint(cr);
+    }
+    cairo_destroy(cr);
+
+    return FALSE;
+}
+
 static void
 task_manager_dalog_disp_preview(TaskManagerDialog* dialog)
 {
@@ -317,6 +448,10 @@ scaled_down:
                 height = ((float)win_height) / ((float)win_width) * width;
                 gtk_widget_set_size_request(GTK_WIDGET(iter->data), width, height);
             }
+            if (priv->thumbnails) {
+                task_manager_dialog_watch(dialog, TASK_WINDOW(iter->data),
+                                          width - 8, height - 8);
+            }
             priv->data[i * 6 + 1] = (long) 5;
             priv->data[i * 6 + 2] = (long) task_window_get_xid(TASK_WINDOW(iter->data));
             priv->data[i * 6 + 3] = (long) allocation.x + 4;
@@ -327,19 +462,32 @@ scaled_down:
         }
     }
 
-    gdk_property_change((GTK_WIDGET(dialog))->window,
-                        priv->kde_a,
-                        priv->kde_a,
-                        32,
-                        GDK_PROP_MODE_REPLACE,
-                        (guchar*) priv->data,
-                        data_length);
+    if (!priv->thumbnails) {
+        gdk_property_change((GTK_WIDGET(dialog))->window,
+                            priv->kde_a,
+                            priv->kde_a,
+                            32,
+                            GDK_PROP_MODE_REPLACE,
+                            (guchar*) priv->data,
+                            data_length);
+    }
 }
 
 static void
 task_manager_dialog_hide(GtkWidget* dialog, gpointer nul)
 {
     TaskManagerDialogPrivate* priv = GET_PRIVATE(dialog);
+    GHashTableIter iter;
+    gpointer key;
+
+    // also called from GtkWidget's dispose, after ours
+    if (priv->watched) {
+        g_hash_table_iter_init(&iter, priv->watched);
+        while (g_hash_table_iter_next(&iter, &key, NULL)) {
+            task_thumbnailer_set_visible(task_thumbnailer_get_default(),
+                                         GPOINTER_TO_SIZE(key), FALSE);
+        }
+    }
 
     if (priv->data) {
         g_free(priv->data);
@@ -369,6 +517,7 @@ task_manager_dialog_expose(GtkWidget* dialog, GdkEventExpose* event, gpointer nu
         task_manager_dalog_disp_preview(TASK_MANAGER_DIALOG(dialog));
         break;
     default:
+        task_manager_dialog_unwatch_all(TASK_MANAGER_DIALOG(dialog));
         if (priv->data) {
             g_free(priv->data);
             priv->data = g_new0(long, 1);
@@ -403,8 +552,13 @@ task_manager_dialog_init(TaskManagerDialog* self)
     priv->analyzed = FALSE;
     priv->wm_change_id = 0;
     priv->kde_a = gdk_atom_intern_static_string("_KDE_WINDOW_PREVIEW");
+    priv->thumbnails = FALSE;
+    priv->watched = g_hash_table_new(g_direct_hash, g_direct_equal);
+    priv->thumbnail_changed_id = 0;
 
     g_signal_connect(self, "expose-event", G_CALLBACK(task_manager_dialog_expose), NULL);
+    g_signal_connect_after(self, "expose-event",
+                           G_CALLBACK(task_manager_dialog_expose_thumbnails), NULL);
     g_signal_connect(self, "hide", G_CALLBACK(task_manager_dialog_hide), NULL);
 
 }
@@ -438,6 +592,9 @@ void
 task_manager_dialog_remove(TaskManagerDialog* dialog, TaskItem* item)
 {
     TaskManagerDialogPrivate* priv = GET_PRIVATE(dialog);
+    if (TASK_IS_WINDOW(item)) {
+        task_manager_dialog_unwatch(dialog, TASK_WINDOW(item));
+    }
     gtk_container_remove(GTK_CONTAINER(awn_dialog_get_content_area(AWN_DIALOG(dialog))), GTK_WIDGET(item));
     priv->children = g_list_remove(priv->children, item);
 }
@@ -522,6 +679,8 @@ task_manager_dialog_analyze_wm(TaskManagerDialog* dialog)
     gint wm = WM_UNKNOWN;
 
     const gchar* wm_name = wnck_screen_get_window_manager_name(wnck_screen);
+    gboolean wm_previews = FALSE;
+    TaskThumbnailer* thumbnailer = task_thumbnailer_get_default();
 //  g_debug ("%s:  %s",__func__,wm_name);
     for (int i = 0; wm_strings[i].wm_code != WM_END ; i++) {
 //    g_debug ("comp:%d  '%s', '%s'",i,wm_strings[i].wm_name,wm_name);
@@ -529,6 +688,7 @@ task_manager_dialog_analyze_wm(TaskManagerDialog* dialog)
             wm = wm_strings[i].wm_code;
 //     g_message ("WM = %s, code = %d",wm_name,wm);
             if (wm_strings[i].live_previews(dialog)) {
+                wm_previews = TRUE;
                 if ((priv->dialog_mode == 0) || (priv->dialog_mode == 2)) {
                     priv->current_dialog_mode = 2;
                 }
@@ -538,5 +698,22 @@ task_manager_dialog_analyze_wm(TaskManagerDialog* dialog)
             break;
         }
     }
+
+    /* no previews from the WM, draw them ourselves if the X server lets us */
+    priv->thumbnails = FALSE;
+    if (!wm_previews && task_thumbnailer_is_supported(thumbnailer) &&
+            ((priv->dialog_mode == 0) || (priv->dialog_mode == 2))) {
+        priv->current_dialog_mode = 2;
+        priv->thumbnails = TRUE;
+        if (!priv->thumbnail_changed_id) {
+            priv->thumbnail_changed_id =
+                g_signal_connect(thumbnailer, "thumbnail-changed",
+                                 G_CALLBACK(task_manager_dialog_thumbnail_changed),
+                                 dialog);
+        }
+    }
+    if (!priv->thumbnails) {
+        task_manager_dialog_unwatch_all(dialog);
+    }
     priv->analyzed = TRUE;
 }
@@ -42,8 +42,12 @@ extern "C" {
 #include <fcntl.h>
 
 
+#include <errno.h>
+#include <signal.h>
+
 #undef G_DISABLE_SINGLE_INCLUDES
 #include <glibtop/procargs.h>
+#include <glibtop/procuid.h>
 
 #include "libawn/gseal-transition.h"
 
@@ -74,6 +78,11 @@ extern "C" {
 
 #define DESKTOP_CACHE_FILENAME ".desktop_cache"
 
+/* launches are kept at least this long (s), after that only while alive */
+#define LAUNCH_TIMEOUT 60
+/* how far up the process tree a window's pid is followed */
+#define LAUNCH_MAX_ANCESTORS 4
+
 static GQuark win_quark = 0;
 
 static const GtkTargetEntry drop_types[] = {
@@ -84,6 +93,15 @@ static const GtkTargetEntry drop_types[] = {
 };
 static const gint n_drop_types = G_N_ELEMENTS(drop_types);
 
+/* a process started by one of our launchers */
+typedef struct {
+    TaskLauncher* launcher;     /* weak */
+    GPid          pid;
+    gchar*        startup_id;
+    gchar*        wm_class;
+    glong         time;
+} TaskLaunch;
+
 
 typedef struct {
     DesktopAgnosticConfigClient* panel_instance_client;
@@ -122,7 +140,7 @@ struct _TaskManagerPrivate {
     /*
      Used during grouping configuration changes for optimization purposes
      */
-    GList* grouping_list;
+    GHashTable* grouped;  /* TaskItems already placed */
     /* Properties */
     GValueArray* launcher_paths;
 
@@ -147,6 +165,28 @@ struct _TaskManagerPrivate {
     GtkWidget* add_icon;
     guint       add_icon_source;
 
+    /* batched publication of the windows' icon geometries */
+    guint       geometry_source;
+    gboolean    origin_known;
+    gint        origin_x;
+    gint        origin_y;
+
+    /* launch tracking, see task_manager_register_launch() */
+    GHashTable* launches;           /* pid -> TaskLaunch, owns them */
+    GHashTable* launches_by_id;     /* startup id -> TaskLaunch */
+    GHashTable* launches_by_class;  /* lower case WM_CLASS -> TaskLaunch */
+    GHashTable* launch_pids;        /* window pid -> ancestor TaskLaunch or NULL */
+
+    /* workspace switches, see on_workspace_changed() */
+    gboolean    switching_workspace;
+    GHashTable* switch_pending;     /* icons whose visibility may change, */
+    GSList*     switch_opening;     /* icons to animate on the next frame, */
+    GSList*     switch_closing;     /* all hold a reference */
+    guint       switch_effects_source;
+#ifdef DEBUG
+    guint       switch_allocations; /* size-allocate passes since the switch */
+    guint       switch_report_source;
+#endif
 };
 
 typedef struct {
@@ -185,8 +225,18 @@ enum {
 static guint32 _taskman_signals[LAST_SIGNAL] = { 0 };
 
 /* Forwards */
+static void task_launch_free(TaskLaunch* launch);
 static void update_icon_visible(TaskManager*   manager,
                                 TaskIcon*      icon);
+static gboolean task_manager_get_icon_visible(TaskManager*   manager,
+        TaskIcon*      icon,
+        gboolean*      do_hide_animation);
+static gboolean task_manager_start_switch_effects(TaskManager* manager);
+#ifdef DEBUG
+static gboolean task_manager_report_switch(TaskManager* manager);
+static void on_box_size_allocate(TaskManager*   manager,
+                                 GtkAllocation* alloc);
+#endif
 static void on_icon_visible_changed(TaskManager*   manager,
                                     TaskIcon*      icon);
 static void on_icon_effects_ends(TaskIcon*      icon,
@@ -762,6 +812,15 @@ task_manager_init(TaskManager* manager)
     priv->add_icon_source = 0;
     priv->add_icon = NULL;
 
+    priv->launches = g_hash_table_new_full(g_direct_hash, g_direct_equal, NULL,
+                                           (GDestroyNotify)task_launch_free);
+    priv->launches_by_id = g_hash_table_new(g_str_hash, g_str_equal);
+    priv->launches_by_class = g_hash_table_new(g_str_hash, g_str_equal);
+    priv->launch_pids = g_hash_table_new(g_direct_hash, g_direct_equal);
+
+    priv->switch_pending = g_hash_table_new_full(g_direct_hash, g_direct_equal,
+                                                 g_object_unref, NULL);
+
     wnck_set_client_type(WNCK_CLIENT_TYPE_PAGER);
 
     win_quark = g_quark_from_string("task-window-quark");
@@ -771,6 +830,10 @@ task_manager_init(TaskManager* manager)
     priv->box = awn_icon_box_new_for_applet(AWN_APPLET(manager));
     gtk_container_add(GTK_CONTAINER(manager), priv->box);
     gtk_widget_show(priv->box);
+#ifdef DEBUG
+    g_signal_connect_swapped(priv->box, "size-allocate",
+                             G_CALLBACK(on_box_size_allocate), manager);
+#endif
 
     /* Create drag indicator */
     priv->drag_indicator = TASK_DRAG_INDICATOR(task_drag_indicator_new());
@@ -881,6 +944,9 @@ static void task_manager_origin_changed(AwnApplet* applet,
 #ifdef DEBUG
     g_debug("Got origin-changed, updating icon geometries...");
 #endif
+    priv->origin_x = rect->x;
+    priv->origin_y = rect->y;
+    priv->origin_known = TRUE;
 
     for (i = priv->icons; i; i = i->next) {
         TaskIcon* icon = i->data;
@@ -891,6 +957,274 @@ static void task_manager_origin_changed(AwnApplet* applet,
     }
 }
 
+/*
+ * Publishes the minimize targets of all icons that asked for it in one go,
+ * after the layout and redraw of the current frame are done.
+ */
+static gboolean
+task_manager_publish_icon_geometry(TaskManager* manager)
+{
+    TaskManagerPrivate* priv = manager->priv;
+    GArray* xids;
+    GArray* rects;
+    GSList* i;
+
+    priv->geometry_source = 0;
+
+    if (!priv->origin_known) {
+        GdkWindow* win = gtk_widget_get_window(GTK_WIDGET(manager));
+        if (!win) {
+            return FALSE;
+        }
+        // only until the panel tells us where we are
+        gdk_window_get_origin(win, &priv->origin_x, &priv->origin_y);
+    }
+
+    xids = g_array_new(FALSE, FALSE, sizeof(gulong));
+    rects = g_array_new(FALSE, FALSE, sizeof(GdkRectangle));
+
+    for (i = priv->icons; i; i = i->next) {
+        if (TASK_IS_ICON(i->data)) {
+            task_icon_collect_geometry(TASK_ICON(i->data),
+                                       priv->origin_x, priv->origin_y,
+                                       xids, rects);
+        }
+    }
+
+    if (xids->len) {
+        xutils_set_icon_geometries((gulong*)xids->data,
+                                   (GdkRectangle*)rects->data, xids->len);
+    }
+
+    g_array_free(xids, TRUE);
+    g_array_free(rects, TRUE);
+
+    return FALSE;
+}
+
+void
+task_manager_queue_icon_geometry(TaskManager* manager)
+{
+    g_return_if_fail(TASK_IS_MANAGER(manager));
+
+    TaskManagerPrivate* priv = manager->priv;
+
+    if (priv->geometry_source == 0) {
+        priv->geometry_source =
+            g_idle_add_full(GDK_PRIORITY_REDRAW + 10,
+                            (GSourceFunc)task_manager_publish_icon_geometry,
+                            manager, NULL);
+    }
+}
+
+/*
+ * Launch tracking.
+ * Every process started from a launcher is registered here, so its windows
+ * can be resolved directly (through _NET_STARTUP_ID, the pid or one of its
+ * ancestors) instead of running the launchers' heuristics on them.
+ */
+static void
+task_launch_free(TaskLaunch* launch)
+{
+    if (launch->launcher) {
+        g_object_remove_weak_pointer(G_OBJECT(launch->launcher),
+                                     (gpointer*)&launch->launcher);
+    }
+    g_free(launch->startup_id);
+    g_free(launch->wm_class);
+    g_slice_free(TaskLaunch, launch);
+}
+
+static gboolean
+task_launch_expired(gpointer key, TaskLaunch* launch, glong* now)
+{
+    if (!launch->launcher) {
+        return TRUE;
+    }
+    if (*now - launch->time < LAUNCH_TIMEOUT) {
+        return FALSE;
+    }
+    return kill(launch->pid, 0) != 0 && errno == ESRCH;
+}
+
+static void
+task_manager_index_launch(gpointer key, TaskLaunch* launch, TaskManagerPrivate* priv)
+{
+    if (launch->startup_id) {
+        g_hash_table_insert(priv->launches_by_id, launch->startup_id, launch);
+    }
+    if (launch->wm_class) {
+        TaskLaunch* other = g_hash_table_lookup(priv->launches_by_class,
+                                                launch->wm_class);
+        /* the most recent launch wins */
+        if (!other || other->time <= launch->time) {
+            g_hash_table_insert(priv->launches_by_class, launch->wm_class, launch);
+        }
+    }
+}
+
+/*
+ Drops the launches that are gone and rebuilds the indices (the tables are
+ tiny, launches happen on clicks).
+ */
+static void
+task_manager_prune_launches(TaskManager* manager)
+{
+    TaskManagerPrivate* priv = manager->priv;
+    GTimeVal timeval;
+
+    g_get_current_time(&timeval);
+
+    g_hash_table_remove_all(priv->launches_by_id);
+    g_hash_table_remove_all(priv->launches_by_class);
+    g_hash_table_remove_all(priv->launch_pids);
+    g_hash_table_foreach_remove(priv->launches, (GHRFunc)task_launch_expired,
+                                &timeval.tv_sec);
+    g_hash_table_foreach(priv->launches, (GHFunc)task_manager_index_launch, priv);
+}
+
+void
+task_manager_register_launch(TaskManager*  manager,
+                             TaskLauncher* launcher,
+                             GPid          pid,
+                             const gchar*  startup_id,
+                             const gchar*  wm_class)
+{
+    TaskManagerPrivate* priv;
+    TaskLaunch* launch;
+    GTimeVal timeval;
+
+    g_return_if_fail(TASK_IS_MANAGER(manager));
+    g_return_if_fail(TASK_IS_LAUNCHER(launcher));
+    g_return_if_fail(pid > 0);
+
+    priv = manager->priv;
+    if (!priv->launches) {
+        return;
+    }
+
+    g_get_current_time(&timeval);
+
+    launch = g_slice_new0(TaskLaunch);
+    launch->launcher = launcher;
+    g_object_add_weak_pointer(G_OBJECT(launcher), (gpointer*)&launch->launcher);
+    launch->pid = pid;
+    launch->startup_id = g_strdup(startup_id);
+    launch->wm_class = wm_class && *wm_class ? g_utf8_strdown(wm_class, -1) : NULL;
+    launch->time = timeval.tv_sec;
+
+    g_hash_table_replace(priv->launches, GINT_TO_POINTER(pid), launch);
+    task_manager_prune_launches(manager);
+}
+
+/*
+ Follows pid up the process tree until it hits a registered launch. This is
+ only a hint: anything started from a dock-launched terminal or file manager
+ descends from that launch.
+ */
+static TaskLaunch*
+task_manager_find_launch_for_ancestor(TaskManager* manager, GPid pid)
+{
+    TaskManagerPrivate* priv = manager->priv;
+    gpointer cached;
+    TaskLaunch* launch = NULL;
+    GPid ancestor = pid;
+
+    if (g_hash_table_lookup_extended(priv->launch_pids, GINT_TO_POINTER(pid),
+                                     NULL, &cached)) {
+        return (TaskLaunch*)cached;
+    }
+
+    for (gint i = 0; i < LAUNCH_MAX_ANCESTORS && ancestor > 1; i++) {
+        glibtop_proc_uid buf;
+
+        glibtop_get_proc_uid(&buf, ancestor);
+        ancestor = buf.ppid;
+        launch = g_hash_table_lookup(priv->launches, GINT_TO_POINTER(ancestor));
+        if (launch) {
+            break;
+        }
+    }
+
+    g_hash_table_insert(priv->launch_pids, GINT_TO_POINTER(pid), launch);
+    return launch;
+}
+
+/*
+ Returns the launcher window was started from, NULL if it's not one of ours
+ (or we can't tell). exact is set to TRUE if the window carries the startup
+ id of the launch or belongs to the launched process itself; a launcher only
+ found through an ancestor process or the expected WM_CLASS is just a hint.
+ */
+TaskLauncher*
+task_manager_lookup_launch(TaskManager* manager,
+                           TaskWindow*  window,
+                           gboolean*    exact)
+{
+    TaskManagerPrivate* priv;
+    TaskLaunch* launch = NULL;
+    const gchar* startup_id;
+    GPid pid;
+
+    g_return_val_if_fail(TASK_IS_MANAGER(manager), NULL);
+    g_return_val_if_fail(TASK_IS_WINDOW(window), NULL);
+    g_return_val_if_fail(exact, NULL);
+
+    *exact = FALSE;
+    priv = manager->priv;
+    if (!priv->launches || g_hash_table_size(priv->launches) == 0) {
+        return NULL;
+    }
+
+    startup_id = task_window_get_startup_id(window);
+    if (startup_id) {
+        launch = g_hash_table_lookup(priv->launches_by_id, startup_id);
+    }
+
+    pid = task_window_get_pid(window);
+    if ((!launch || !launch->launcher) && pid > 0) {
+        launch = g_hash_table_lookup(priv->launches, GINT_TO_POINTER(pid));
+    }
+
+    if (launch && launch->launcher) {
+        *exact = TRUE;
+        return launch->launcher;
+    }
+
+    if (pid > 0) {
+        launch = task_manager_find_launch_for_ancestor(manager, pid);
+    }
+
+    /*
+     Processes that hand over to another one (and exit) only leave their
+     expected WM_CLASS behind.
+     */
+    if ((!launch || !launch->launcher) &&
+            g_hash_table_size(priv->launches_by_class) > 0) {
+        gchar* res_name = NULL;
+        gchar* class_name = NULL;
+        GTimeVal timeval;
+
+        g_get_current_time(&timeval);
+        task_window_get_wm_class(window, &res_name, &class_name);
+        for (gint i = 0; i < 2 && (!launch || !launch->launcher); i++) {
+            gchar* name = i == 0 ? res_name : class_name;
+            if (name) {
+                gchar* lower = g_utf8_strdown(name, -1);
+                launch = g_hash_table_lookup(priv->launches_by_class, lower);
+                if (launch && timeval.tv_sec - launch->time >= LAUNCH_TIMEOUT) {
+                    launch = NULL;
+                }
+                g_free(lower);
+            }
+        }
+        g_free(res_name);
+        g_free(class_name);
+    }
+
+    return launch ? launch->launcher : NULL;
+}
+
 static void
 task_manager_dispose(GObject* object)
 {
@@ -901,6 +1235,37 @@ task_manager_dispose(GObject* object)
     desktop_agnostic_config_client_unbind_all_for_object(priv->client,
             object,
             NULL);
+    if (priv->geometry_source) {
+        g_source_remove(priv->geometry_source);
+        priv->geometry_source = 0;
+    }
+    if (priv->switch_effects_source) {
+        g_source_remove(priv->switch_effects_source);
+        priv->switch_effects_source = 0;
+    }
+#ifdef DEBUG
+    if (priv->switch_report_source) {
+        g_source_remove(priv->switch_report_source);
+        priv->switch_report_source = 0;
+    }
+#endif
+    if (priv->switch_pending) {
+        g_hash_table_destroy(priv->switch_pending);
+        priv->switch_pending = NULL;
+    }
+    g_slist_foreach(priv->switch_opening, (GFunc)g_object_unref, NULL);
+    g_slist_free(priv->switch_opening);
+    priv->switch_opening = NULL;
+    g_slist_foreach(priv->switch_closing, (GFunc)g_object_unref, NULL);
+    g_slist_free(priv->switch_closing);
+    priv->switch_closing = NULL;
+    if (priv->launches) {
+        g_hash_table_destroy(priv->launch_pids);
+        g_hash_table_destroy(priv->launches_by_class);
+        g_hash_table_destroy(priv->launches_by_id);
+        g_hash_table_destroy(priv->launches);
+        priv->launches = NULL;
+    }
     if (priv->connection) {
         if (priv->proxy) {
             g_object_unref(priv->proxy);
@@ -1096,6 +1461,9 @@ on_active_window_changed(WnckScreen*    screen,
  * When the property 'show_all_windows' is False,
  * workspace switches are monitored. Whenever one happens
  * all TaskWindows are notified.
+ * The icons' visibility changes are collected while the windows are
+ * updated and applied in one pass afterwards, so the box is laid out
+ * once per switch. The animations start together on the next frame.
  */
 static void
 on_workspace_changed(TaskManager* manager)  /*... has more arguments*/
@@ -1103,12 +1471,31 @@ on_workspace_changed(TaskManager* manager)  /*... has more arguments*/
     TaskManagerPrivate* priv;
     GSList*             w;
     WnckWorkspace*      space;
+    GHashTableIter      iter;
+    gpointer            key;
+#ifdef DEBUG
+    guint               shown = 0;
+    guint               hidden = 0;
+#endif
 
     g_return_if_fail(TASK_IS_MANAGER(manager));
 
     priv = manager->priv;
     space = wnck_screen_get_active_workspace(priv->screen);
 
+    /* the previous switch is still waiting for its frame */
+    if (priv->switch_effects_source) {
+        g_source_remove(priv->switch_effects_source);
+        task_manager_start_switch_effects(manager);
+    }
+#ifdef DEBUG
+    if (priv->switch_report_source) {
+        g_source_remove(priv->switch_report_source);
+        task_manager_report_switch(manager);
+    }
+#endif
+
+    priv->switching_workspace = TRUE;
     for (w = priv->windows; w; w = w->next) {
         TaskWindow* window = w->data;
 
@@ -1118,46 +1505,171 @@ on_workspace_changed(TaskManager* manager)  /*... has more arguments*/
 
         task_window_set_active_workspace(window, space);
     }
+    priv->switching_workspace = FALSE;
+
+#ifdef DEBUG
+    priv->switch_allocations = 0;
+#endif
+    g_hash_table_iter_init(&iter, priv->switch_pending);
+    while (g_hash_table_iter_next(&iter, &key, NULL)) {
+        TaskIcon* icon = TASK_ICON(key);
+        gboolean do_hide_animation;
+        gboolean visible = task_manager_get_icon_visible(manager, icon,
+                                                         &do_hide_animation);
+
+        if (visible && !gtk_widget_get_visible(GTK_WIDGET(icon))) {
+            gtk_widget_show(GTK_WIDGET(icon));
+            priv->switch_opening = g_slist_prepend(priv->switch_opening,
+                                                   g_object_ref(icon));
+#ifdef DEBUG
+            shown++;
+#endif
+        } else if (!visible) {
+            if (do_hide_animation) {
+                priv->switch_closing = g_slist_prepend(priv->switch_closing,
+                                                       g_object_ref(icon));
+            } else {
+                gtk_widget_hide(GTK_WIDGET(icon));
+            }
+#ifdef DEBUG
+            hidden++;
+#endif
+        }
+    }
+    g_hash_table_remove_all(priv->switch_pending);
+
+#ifdef DEBUG
+    g_debug("%s: %u icons shown, %u hidden", __func__, shown, hidden);
+
+    /* once the box has been laid out (and painted) */
+    priv->switch_report_source =
+        g_idle_add_full(GDK_PRIORITY_REDRAW + 2,
+                        (GSourceFunc)task_manager_report_switch,
+                        manager, NULL);
+#endif
+
+    if (priv->switch_opening || priv->switch_closing) {
+        /* after the relayout and the redraw */
+        priv->switch_effects_source =
+            g_idle_add_full(GDK_PRIORITY_REDRAW + 1,
+                            (GSourceFunc)task_manager_start_switch_effects,
+                            manager, NULL);
+    }
 }
 
+static gboolean
+task_manager_start_switch_effects(TaskManager* manager)
+{
+    TaskManagerPrivate* priv = manager->priv;
+    GSList* i;
+
+    /* the icons may have changed again before this frame */
+    for (i = priv->switch_opening; i; i = i->next) {
+        if (gtk_widget_get_visible(GTK_WIDGET(i->data))) {
+            awn_effects_start_ex(awn_overlayable_get_effects(AWN_OVERLAYABLE(i->data)),
+                                 AWN_EFFECT_OPENING, 1, FALSE, FALSE);
+        }
+        g_object_unref(i->data);
+    }
+    for (i = priv->switch_closing; i; i = i->next) {
+        gboolean do_hide_animation;
+        if (!task_manager_get_icon_visible(manager, TASK_ICON(i->data),
+                                           &do_hide_animation)) {
+            awn_effects_start_ex(awn_overlayable_get_effects(AWN_OVERLAYABLE(i->data)),
+                                 AWN_EFFECT_CLOSING, 1, FALSE, TRUE);
+        }
+        g_object_unref(i->data);
+    }
+    g_slist_free(priv->switch_opening);
+    g_slist_free(priv->switch_closing);
+    priv->switch_opening = NULL;
+    priv->switch_closing = NULL;
+
+    priv->switch_effects_source = 0;
+    return FALSE;
+}
+
+#ifdef DEBUG
+static gboolean
+task_manager_report_switch(TaskManager* manager)
+{
+    TaskManagerPrivate* priv = manager->priv;
+
+    g_debug("%s: workspace switch took %u size-allocate passes",
+            __func__, priv->switch_allocations);
+
+    priv->switch_report_source = 0;
+    return FALSE;
+}
+
+static void
+on_box_size_allocate(TaskManager* manager, GtkAllocation* alloc)
+{
+    manager->priv->switch_allocations++;
+}
+#endif
+
 /*
  * TASK_ICON CALLBACKS
  */
 
 /*
- TODO:  needs some cleanup.
+ Whether @icon should be shown, and whether hiding it plays the closing
+ animation.
  */
-static void
-update_icon_visible(TaskManager* manager, TaskIcon* icon)
+static gboolean
+task_manager_get_icon_visible(TaskManager* manager, TaskIcon* icon,
+                              gboolean* do_hide_animation)
 {
-    TaskManagerPrivate* priv;
+    TaskManagerPrivate* priv = manager->priv;
     gboolean visible = FALSE;
-    /*if show_all_windows config key is false then we show/hide different
-     icons on workspace switches.  We don't want to play closing
-     animations on them, opening animations are played as it seems to provide
-     a better visual cue of what has changed*/
-    gboolean do_hide_animation = FALSE;
 
-
-    g_return_if_fail(TASK_IS_MANAGER(manager));
-
-    priv = manager->priv;
     if (task_icon_is_visible(icon) &&
             (!priv->only_show_launchers || !task_icon_is_ephemeral(icon))
        ) {
         visible = TRUE;
     }
 
+    /*if show_all_windows config key is false then we show/hide different
+     icons on workspace switches.  We don't want to play closing
+     animations on them, opening animations are played as it seems to provide
+     a better visual cue of what has changed*/
+    *do_hide_animation = FALSE;
     if (!task_icon_contains_launcher(icon)) {
         if (task_icon_count_items(icon) == 0) {
-            do_hide_animation = TRUE;
+            *do_hide_animation = TRUE;
         }
     } else {
         if (!task_icon_count_tasklist_windows(icon)) {
-            do_hide_animation = TRUE;
+            *do_hide_animation = TRUE;
         }
     }
 
+    return visible;
+}
+
+/*
+ TODO:  needs some cleanup.
+ */
+static void
+update_icon_visible(TaskManager* manager, TaskIcon* icon)
+{
+    TaskManagerPrivate* priv;
+    gboolean visible;
+    gboolean do_hide_animation;
+
+    g_return_if_fail(TASK_IS_MANAGER(manager));
+
+    priv = manager->priv;
+    if (priv->switching_workspace) {
+        /* applied once all windows know about the new workspace */
+        if (!g_hash_table_lookup(priv->switch_pending, icon)) {
+            g_hash_table_insert(priv->switch_pending, g_object_ref(icon), icon);
+        }
+        return;
+    }
+
+    visible = task_manager_get_icon_visible(manager, icon, &do_hide_animation);
 
     if (visible && !gtk_widget_get_visible(GTK_WIDGET(icon))) {
         gtk_widget_show(GTK_WIDGET(icon));
@@ -1861,108 +2373,134 @@ task_manager_intellihide_change_cb(const char* group,
     *user_data = g_value_get_int(value);
 }
 
+/*
+ Creates the TaskIcon for a launcher from the launcher list, NULL if the
+ desktop file can't be used.
+ */
+static GtkWidget*
+task_manager_add_launcher_icon(TaskManager* manager, const gchar* path)
+{
+    TaskManagerPrivate* priv = manager->priv;
+    TaskItem*  launcher = NULL;
+    GtkWidget* icon;
+
+    if (!usable_desktop_file_from_path(path)) {
+        g_debug("%s: Bad desktop file '%s'", __func__, path);
+        return NULL;
+    }
+    launcher = task_launcher_new_for_desktop_file(AWN_APPLET(manager), path);
+    if (!launcher) {
+        return NULL;
+    }
+
+    icon = task_icon_new(AWN_APPLET(manager));
+    g_object_set(G_OBJECT(launcher),
+                 "proxy", task_icon_get_proxy(TASK_ICON(icon)),
+                 NULL);
+    task_icon_append_item(TASK_ICON(icon), launcher);
+    gtk_container_add(GTK_CONTAINER(priv->box), icon);
+
+    g_object_weak_ref(G_OBJECT(icon), (GWeakNotify)icon_closed, manager);
+    g_signal_connect_swapped(icon,
+                             "visible-changed",
+                             G_CALLBACK(on_icon_visible_changed),
+                             manager);
+    g_signal_connect_swapped(awn_overlayable_get_effects(AWN_OVERLAYABLE(icon)),
+                             "animation-end",
+                             G_CALLBACK(on_icon_effects_ends),
+                             icon);
+
+    update_icon_visible(manager, TASK_ICON(icon));
+
+    /* reordening through D&D */
+    if (priv->drag_and_drop) {
+        _drag_add_signals(manager, icon);
+    }
+
+    return icon;
+}
+
 /*
  * Checks when launchers got added/removed in the list in gconf/file.
  * It removes the launchers from the task-icons and add those
  * that aren't already on the bar.
+ * The icons are indexed by desktop path once, the launchers from the list
+ * come first in list order followed by the other icons in their current
+ * order, and only the icons that are out of place get moved.
  */
 static void
 task_manager_refresh_launcher_paths(TaskManager* manager, GValueArray* list)
 {
     TaskManagerPrivate* priv;
-    gboolean ephemeral = TRUE;
+    GHashTable* icon_by_path;  /* desktop path -> first TaskIcon with it */
+    GHashTable* listed;        /* TaskIcons in the launcher list */
+    GHashTable* list_paths;    /* desktop paths in the launcher list */
+    GPtrArray* order;
+    GSList* icons = NULL;
+    GSList* demote = NULL;     /* launchers that become ephemeral */
+#ifdef DEBUG
+    guint moved;
+#endif
 
     g_return_if_fail(TASK_IS_MANAGER(manager));
     priv = manager->priv;
 
     task_manager_add_icon_hide(manager);
+
+    icon_by_path = g_hash_table_new(g_str_hash, g_str_equal);
+    listed = g_hash_table_new(g_direct_hash, g_direct_equal);
+    list_paths = g_hash_table_new(g_str_hash, g_str_equal);
+    order = g_ptr_array_sized_new(g_slist_length(priv->icons) + list->n_values);
+
+    for (GSList* icon_iter = priv->icons;
+            icon_iter != NULL;
+            icon_iter = icon_iter->next) {
+        for (GSList* item_iter = task_icon_get_items(TASK_ICON(icon_iter->data));
+                item_iter != NULL;
+                item_iter = item_iter->next) {
+            const gchar* path;
+
+            if (!TASK_IS_LAUNCHER(item_iter->data)) {
+                continue;
+            }
+            path = task_launcher_get_desktop_path(TASK_LAUNCHER(item_iter->data));
+            if (path && !g_hash_table_lookup(icon_by_path, path)) {
+                g_hash_table_insert(icon_by_path, (gpointer)path, icon_iter->data);
+            }
+        }
+    }
+
     /*
      Find launchers in the the launcher list do not yet have a TaskIcon and
      add them
      */
     for (guint idx = 0; idx < list->n_values; idx++) {
-        gchar* path;
-        gboolean found;
-
-        path = g_value_dup_string(g_value_array_get_nth(list, idx));
-        found = FALSE;
-
-        for (GSList* icon_iter = priv->icons;
-                icon_iter != NULL;
-                icon_iter = icon_iter->next) {
-            GSList* items = task_icon_get_items(TASK_ICON(icon_iter->data));
-            TaskItem*  launcher = NULL;
+        const gchar* path = g_value_get_string(g_value_array_get_nth(list, idx));
+        GtkWidget* icon;
 
-            for (GSList* item_iter = items;
-                    item_iter != NULL;
-                    item_iter = item_iter->next) {
-                TaskItem* item = item_iter->data;
+        if (!path || g_hash_table_lookup(list_paths, path)) {
+            continue;
+        }
+        g_hash_table_insert(list_paths, (gpointer)path, (gpointer)path);
 
-                if (TASK_IS_LAUNCHER(item) &&
-                        g_strcmp0(task_launcher_get_desktop_path(TASK_LAUNCHER(item)),
-                                  path) == 0) {
-                    gint cur_pos;
-                    launcher = item;
-                    found = TRUE;
-                    cur_pos = g_slist_position(priv->icons, icon_iter);
-                    if (cur_pos != (gint)idx) {
-                        TaskIcon* icon = icon_iter->data;
-                        priv->icons = g_slist_remove_link(priv->icons, icon_iter);
-                        priv->icons = g_slist_insert(priv->icons, icon, idx);
-                        gtk_box_reorder_child(GTK_BOX(priv->box), GTK_WIDGET(icon), idx);
-                    }
-                    break;
-                }
+        icon = (GtkWidget*)g_hash_table_lookup(icon_by_path, path);
+        if (icon) {
+            if (g_hash_table_lookup(listed, icon)) {
+                continue;
             }
-            if (found && launcher) {
-                ephemeral = task_icon_is_ephemeral(icon_iter->data);
-                if (ephemeral) { /*then it shouldn't be*/
-                    g_object_set(G_OBJECT(task_icon_get_launcher(icon_iter->data)),
-                                 "proxy", task_icon_get_proxy(icon_iter->data),
-                                 NULL);
-                    icon_iter = priv->icons;
-                }
-                break;
+            if (task_icon_is_ephemeral(TASK_ICON(icon))) { /*then it shouldn't be*/
+                g_object_set(G_OBJECT(task_icon_get_launcher(TASK_ICON(icon))),
+                             "proxy", task_icon_get_proxy(TASK_ICON(icon)),
+                             NULL);
             }
-        }
-        if (!found) {
-            GtkWidget* icon;
-
-            if (usable_desktop_file_from_path(path)) {
-                TaskItem*  launcher = NULL;
-                launcher = task_launcher_new_for_desktop_file(AWN_APPLET(manager), path);
-                if (launcher) {
-                    icon = task_icon_new(AWN_APPLET(manager));
-                    g_object_set(G_OBJECT(launcher),
-                                 "proxy", task_icon_get_proxy(TASK_ICON(icon)),
-                                 NULL);
-                    task_icon_append_item(TASK_ICON(icon), launcher);
-                    gtk_container_add(GTK_CONTAINER(priv->box), icon);
-                    gtk_box_reorder_child(GTK_BOX(priv->box), icon, idx);
-                    priv->icons = g_slist_insert(priv->icons, icon, idx);
-
-                    g_object_weak_ref(G_OBJECT(icon), (GWeakNotify)icon_closed, manager);
-                    g_signal_connect_swapped(icon,
-                                             "visible-changed",
-                                             G_CALLBACK(on_icon_visible_changed),
-                                             manager);
-                    g_signal_connect_swapped(awn_overlayable_get_effects(AWN_OVERLAYABLE(icon)),
-                                             "animation-end",
-                                             G_CALLBACK(on_icon_effects_ends),
-                                             icon);
-
-                    update_icon_visible(manager, TASK_ICON(icon));
-
-                    /* reordening through D&D */
-                    if (priv->drag_and_drop) {
-                        _drag_add_signals(manager, icon);
-                    }
-                }
-            } else {
-                g_debug("%s: Bad desktop file '%s'", __func__, path);
+        } else {
+            icon = task_manager_add_launcher_icon(manager, path);
+            if (!icon) {
+                continue;
             }
         }
-        g_free(path);
+        g_hash_table_insert(listed, icon, icon);
+        g_ptr_array_add(order, icon);
     }
 
     /*
@@ -1973,31 +2511,49 @@ task_manager_refresh_launcher_paths(TaskManager* manager, GValueArray* list)
     for (GSList* icon_iter = priv->icons;
             icon_iter != NULL;
             icon_iter = icon_iter->next) {
-        TaskLauncher* launcher = TASK_LAUNCHER(task_icon_get_launcher(icon_iter->data));
-        gboolean found;
-        const gchar* launcher_name = NULL;
-        found = FALSE;
-        if (launcher) {
-            launcher_name = task_launcher_get_desktop_path(launcher);
-            for (guint idx = 0; idx < list->n_values; idx++) {
-                gchar* path;
-                path = g_value_dup_string(g_value_array_get_nth(list, idx));
-                if (g_strcmp0(launcher_name, path) == 0) {
-                    found = TRUE;
-                }
-                g_free(path);
-            }
+        TaskIcon* icon = TASK_ICON(icon_iter->data);
+        const TaskItem* launcher;
+
+        if (g_hash_table_lookup(listed, icon)) {
+            continue;
         }
-        if (launcher && !found) {
-            ephemeral = task_icon_is_ephemeral(icon_iter->data);
-            if (!ephemeral) { /*then it should be*/
-                g_object_set(G_OBJECT(task_icon_get_launcher(icon_iter->data)),
-                             "proxy", NULL,
-                             NULL);
-                icon_iter = priv->icons;
-            }
+        g_ptr_array_add(order, icon);
+
+        launcher = task_icon_get_launcher(icon);
+        if (launcher &&
+                !g_hash_table_lookup(list_paths,
+                                     task_launcher_get_desktop_path(TASK_LAUNCHER(launcher))) &&
+                !task_icon_is_ephemeral(icon)) { /*then it should be*/
+            demote = g_slist_prepend(demote, (gpointer)launcher);
         }
     }
+
+    for (guint i = order->len; i > 0; i--) {
+        icons = g_slist_prepend(icons, g_ptr_array_index(order, i - 1));
+    }
+    g_slist_free(priv->icons);
+    priv->icons = icons;
+
+#ifdef DEBUG
+    moved = awn_utils_reorder_box_children(GTK_BOX(priv->box), order);
+    g_debug("%s: %u launchers, %u icons, %u moved", __func__,
+            list->n_values, order->len, moved);
+#else
+    awn_utils_reorder_box_children(GTK_BOX(priv->box), order);
+#endif
+
+    /* an ephemeral launcher's icon may go away, so the list is done first */
+    for (GSList* i = demote; i; i = i->next) {
+        g_object_set(G_OBJECT(i->data),
+                     "proxy", NULL,
+                     NULL);
+    }
+    g_slist_free(demote);
+
+    g_ptr_array_free(order, TRUE);
+    g_hash_table_destroy(list_paths);
+    g_hash_table_destroy(listed);
+    g_hash_table_destroy(icon_by_path);
 }
 
 static void
@@ -2041,179 +2597,148 @@ task_manager_set_drag_and_drop(TaskManager* manager,
     }
 }
 
+/*
+ Moves the windows of src that aren't grouped yet into dest.
+ */
 static void
-task_manager_regroup_launcher_icon(TaskManager* manager, TaskIcon* grouping_icon)
+task_manager_regroup_move_items(TaskManager* manager, TaskIcon* dest, TaskIcon* src)
 {
-    g_assert(TASK_IS_ICON(grouping_icon));
-    g_assert(TASK_IS_MANAGER(manager));
-
-    GSList* i;
-    GSList* j;
     TaskManagerPrivate* priv = manager->priv;
-    GtkWidget* grouping_launcher = GTK_WIDGET(task_icon_get_launcher(grouping_icon));
+    GSList* items = g_slist_copy(task_icon_get_items(src));
 
-    g_assert(grouping_launcher);
-    for (i = task_icon_get_items(grouping_icon); i; i = i->next) {
+    for (GSList* i = items; i; i = i->next) {
         TaskItem* item = i->data;
         if (TASK_IS_LAUNCHER(item)) {
             continue;
         }
-        if (g_list_find(priv->grouping_list, item)) {
+        if (g_hash_table_lookup(priv->grouped, item)) {
             continue;
         }
-        priv->grouping_list = g_list_prepend(priv->grouping_list, item);
+        task_icon_moving_item(dest, src, item);
+        g_hash_table_insert(priv->grouped, item, item);
     }
-    for (i = priv->icons; i; i = i->next) {
-        GtkWidget* launcher;
-        TaskIcon*   icon;
-        icon = i->data;
-        if (icon == grouping_icon) {
+    g_slist_free(items);
+}
+
+static void
+task_manager_regroup_mark_items(TaskManager* manager, TaskIcon* icon)
+{
+    for (GSList* i = task_icon_get_items(icon); i; i = i->next) {
+        g_hash_table_insert(manager->priv->grouped, i->data, i->data);
+    }
+}
+
+/*
+ The first icon with a launcher for a desktop file collects the windows of
+ the ephemeral launchers for the same desktop file.  One pass, the icons
+ are looked up by desktop path.
+ */
+static void
+task_manager_regroup_launcher_icons(TaskManager* manager)
+{
+    TaskManagerPrivate* priv = manager->priv;
+    GHashTable* target_by_path = g_hash_table_new(g_str_hash, g_str_equal);
+    GSList* icons = g_slist_copy(priv->icons);
+
+    for (GSList* i = icons; i; i = i->next) {
+        TaskIcon* icon = i->data;
+        const TaskItem* launcher = task_icon_get_launcher(icon);
+        const gchar* path;
+        TaskIcon* target;
+
+        if (!launcher) { /* no launcher...  need to do matches on these eventually TODO */
             continue;
         }
-        launcher = GTK_WIDGET(task_icon_get_launcher(icon));
-        if (!launcher) { /* no launcher...  need to do matches on these eventually TODO */
+        path = task_launcher_get_desktop_path(TASK_LAUNCHER(launcher));
+        if (!path) {
             continue;
         }
-        /* Is i an existing permanent launcher... if so then ignore.*/
-        else if (!task_icon_is_ephemeral(icon)) {
+        target = (TaskIcon*)g_hash_table_lookup(target_by_path, path);
+        if (!target) {
+            g_hash_table_insert(target_by_path, (gpointer)path, icon);
+            task_manager_regroup_mark_items(manager, icon);
             continue;
         }
-        /*ok... non-permanent launcher check if the desktop file paths match.*/
-        if (g_strcmp0(task_launcher_get_desktop_path(TASK_LAUNCHER(grouping_launcher)),
-                      task_launcher_get_desktop_path(TASK_LAUNCHER(launcher))) == 0) {
-            for (j = task_icon_get_items(icon); j; j ? j = j->next : j) {
-
-                TaskItem* item = j->data;
-                if (TASK_IS_LAUNCHER(item)) {
-                    continue;
-                }
-                if (g_list_find(priv->grouping_list, item)) {
-                    continue;
-                }
-                task_icon_moving_item(grouping_icon, icon, item);
-                priv->grouping_list = g_list_prepend(priv->grouping_list, item);
-                j = task_icon_get_items(icon);
-            }
+        /* Is i an existing permanent launcher... if so then ignore.*/
+        if (!task_icon_is_ephemeral(icon)) {
+            continue;
         }
+        task_manager_regroup_move_items(manager, target, icon);
     }
+
+    g_slist_free(icons);
+    g_hash_table_destroy(target_by_path);
 }
 
+/*
+ Icons without a launcher are merged into the earlier icon their windows
+ match best.  Every window is matched once against the other icons, instead
+ of once per icon.
+ */
 static void
-task_manager_regroup_nonlauncher_icon(TaskManager* manager, TaskIcon* grouping_icon)
+task_manager_regroup_nonlauncher_icons(TaskManager* manager)
 {
-    g_assert(TASK_IS_ICON(grouping_icon));
-    g_assert(TASK_IS_MANAGER(manager));
-
-    GSList* i;
-    GSList* j;
-    GSList* w;
-    GSList* k;
     TaskManagerPrivate* priv = manager->priv;
-    for (i = task_icon_get_items(grouping_icon); i; i = i->next) {
-        TaskItem* item = i->data;
-        if (g_list_find(priv->grouping_list, item)) {
-            continue;
+    GPtrArray* candidates = g_ptr_array_new();
+
+    for (GSList* i = priv->icons; i; i = i->next) {
+        /*optimization....  if the icon we're checking against has a launcher
+         then the item would have been grouped with it on open if it could have
+         been*/
+        if (!task_icon_contains_launcher(TASK_ICON(i->data))) {
+            g_ptr_array_add(candidates, i->data);
         }
-        priv->grouping_list = g_list_prepend(priv->grouping_list, item);
     }
 
-    for (i = priv->icons; i; i = i->next) {
-        TaskIcon*   icon;
-        icon = i->data;
-        if (icon == grouping_icon) {
-            continue;
-        }
-        if (task_icon_contains_launcher(icon)) {
-            continue;
-        }
-        for (j = task_icon_get_items(icon); j; j ? j = j->next : j) {
-            gint match_score = 0;
-            gint max_match_score = 0;
-            TaskIcon* match = NULL;
+    for (guint idx = 0; idx < candidates->len; idx++) {
+        TaskIcon* icon = (TaskIcon*)g_ptr_array_index(candidates, idx);
+
+        for (GSList* j = task_icon_get_items(icon); j; j = j->next) {
             TaskItem* item = j->data;
-            if (g_list_find(priv->grouping_list, item)) {
+            guint max_match_score = 0;
+            guint match = 0;
+
+            if (g_hash_table_lookup(priv->grouped, item)) {
                 continue;
             }
-            for (w = priv->icons; w; w = w->next) {
-                TaskIcon* taskicon = w->data;
-                /*optimization....  if the icon we're checking against has a launcher
-                 then the item would have been grouped with it on open if it could have
-                 been*/
-                if (task_icon_contains_launcher(taskicon)) {
-                    continue;
-                }
-                match_score = task_icon_match_item(taskicon, item);
+            /* ties go to the earlier icon */
+            for (guint w = 0; w < candidates->len; w++) {
+                guint match_score;
+                match_score = task_icon_match_item(TASK_ICON(g_ptr_array_index(candidates, w)),
+                                                   item);
                 if (match_score > max_match_score) {
                     max_match_score = match_score;
-                    match = taskicon;
+                    match = w;
                 }
             }
-            if (
-                match && (match == grouping_icon)
-                &&
-                (priv->grouping || ((task_icon_count_items(match) == 1) && (task_icon_contains_launcher(match))))
-                &&
-                (max_match_score > 99 - priv->match_strength)) {
-                /*we have one match in this icon.  dump all the other items in also and
-                 get the hell out of the inner loop.  3 nested loops nasty... short
-                 circuiting as much as possible*/
-                task_icon_moving_item(grouping_icon, icon, item);
-                priv->grouping_list = g_list_prepend(priv->grouping_list, item);
-                for (k = task_icon_get_items(icon); k; k = k->next) {
-                    if (g_list_find(priv->grouping_list, k->data)) {
-                        continue;
-                    }
-                    task_icon_moving_item(grouping_icon, icon, k->data);
-                    priv->grouping_list = g_list_prepend(priv->grouping_list, k->data);
-                }
-                j = NULL;
+            if (max_match_score && match < idx && priv->grouping &&
+                    ((gint)max_match_score > 99 - priv->match_strength)) {
+                /*we have one match in this icon.  dump all the other items in
+                 also and get out of the loop*/
+                task_manager_regroup_move_items(manager,
+                                                TASK_ICON(g_ptr_array_index(candidates, match)),
+                                                icon);
+                break;
             }
         }
+        task_manager_regroup_mark_items(manager, icon);
     }
+
+    g_ptr_array_free(candidates, TRUE);
 }
 
 static void
 task_manager_regroup(TaskManager* manager)
 {
-    GSList* i;
-
     TaskManagerPrivate* priv = manager->priv;
-    /*
-     find the permanent Launchers and regroup them*/
-    for (i = priv->icons; i; i = i->next) {
-        GtkWidget* launcher;
-        TaskIcon*   icon;
-        icon = i->data;
-        launcher = GTK_WIDGET(task_icon_get_launcher(icon));
-
-        if (launcher) {
-            task_manager_regroup_launcher_icon(manager, icon);
-        }
-    }
 
-    /* Find the ephemeral launchers and regroup them */
-    for (i = priv->icons; i; i = i->next) {
-        GtkWidget* launcher;
-        TaskIcon*   icon;
-        icon = i->data;
-        launcher = GTK_WIDGET(task_icon_get_launcher(icon));
-        if (launcher) {
-            task_manager_regroup_launcher_icon(manager, icon);
-        }
-    }
+    priv->grouped = g_hash_table_new(g_direct_hash, g_direct_equal);
+    /* find the Launchers and regroup them */
+    task_manager_regroup_launcher_icons(manager);
     /* Find the icons that do not have a launcher. */
-    for (i = priv->icons; i; i = i->next) {
-        TaskIcon*   icon;
-        icon = i->data;
-        if (!task_icon_contains_launcher(icon)) {
-            GSList* items = task_icon_get_items(icon);
-            if (items) {
-                task_manager_regroup_nonlauncher_icon(manager, icon);
-            }
-        }
-    }
-    g_list_free(priv->grouping_list);
-    priv->grouping_list = NULL;
+    task_manager_regroup_nonlauncher_icons(manager);
+    g_hash_table_destroy(priv->grouped);
+    priv->grouped = NULL;
 }
 
 static void
@@ -2759,9 +3284,29 @@ task_manager_win_closed_cb(WnckScreen* screen, WnckWindow* window, TaskManager*
     WnckWindow*          win;
     WnckApplication*     app;
     WnckWorkspace*       space;
+    gint                 pid;
 
     g_return_if_fail(TASK_IS_MANAGER(manager));
     priv = manager->priv;
+
+    /*
+     Forget the cached ancestry of a process with its last window, the pid
+     may be reused once it exits.
+     */
+    pid = wnck_window_get_pid(window);
+    if (pid > 0 && priv->launch_pids &&
+            g_hash_table_lookup_extended(priv->launch_pids, GINT_TO_POINTER(pid),
+                                         NULL, NULL)) {
+        gboolean last = TRUE;
+
+        for (GList* l = wnck_screen_get_windows(screen); l && last; l = l->next) {
+            last = l->data == window || wnck_window_get_pid(WNCK_WINDOW(l->data)) != pid;
+        }
+        if (last) {
+            g_hash_table_remove(priv->launch_pids, GINT_TO_POINTER(pid));
+        }
+    }
+
     win = wnck_screen_get_active_window(priv->screen);
     if (!win) {
         return;
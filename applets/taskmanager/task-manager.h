@@ -107,6 +107,17 @@ GSList* task_manager_get_icons_by_pid(TaskManager* manager, int pid);
 gboolean task_manager_get_show_all_windows(TaskManager* manager);
 const TaskIcon* task_manager_get_icon_by_xid(TaskManager* manager, gint64 xid);
 
+void task_manager_queue_icon_geometry(TaskManager* manager);
+
+void task_manager_register_launch(TaskManager*  manager,
+                                  TaskLauncher* launcher,
+                                  GPid          pid,
+                                  const gchar*  startup_id,
+                                  const gchar*  wm_class);
+TaskLauncher* task_manager_lookup_launch(TaskManager* manager,
+                                         TaskWindow*  window,
+                                         gboolean*    exact);
+
 void task_manager_add_icon_show(TaskManager* taskman);
 
 gboolean
@@ -0,0 +1,341 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301  USA.
+ *
+ */
+
+#include <string.h>
+
+#include <libdesktop-agnostic/vfs.h>
+
+#include "task-menu-template.h"
+
+typedef struct {
+    GPtrArray*                      ops;
+    DesktopAgnosticVFSFile*         file_vfs;
+    DesktopAgnosticVFSFileMonitor*  monitor_vfs;
+} TaskMenuTemplate;
+
+typedef struct {
+    const gchar*  value;
+    MenuType      type;
+} MenuTypeName;
+
+static const MenuTypeName menu_type_names[] = {
+    { "Dbus-Signal", DBUS_SIGNAL },
+    { "External-Command", EXTERNAL_COMMAND },
+    { "Internal-About", INTERNAL_ABOUT },
+    { "Internal-Add-To-Launcher-List", INTERNAL_ADD_TO_LAUNCHER_LIST },
+    { "Internal-Close-Active", INTERNAL_CLOSE_ACTIVE },
+    { "Internal-Close-All", INTERNAL_CLOSE_ALL },
+    { "Internal-Customize-Icon", INTERNAL_CUSTOMIZE_ICON },
+    { "Internal-Dock-Prefs", INTERNAL_DOCK_PREFS },
+    { "Internal-Inline-Action-Menu-Active", INTERNAL_INLINE_ACTION_MENU_ACTIVE },
+    { "Internal-Inline-Submenus-Action-Menu-Inactives", INTERNAL_INLINE_SUBMENUS_ACTION_MENU_INACTIVES },
+    { "Internal-Inline-Plugins", INTERNAL_INLINE_PLUGINS },
+    { "Internal-Launch", INTERNAL_LAUNCH },
+    { "Internal-Maximize-All", INTERNAL_MAXIMIZE_ALL },
+    { "Internal-Minimize-All", INTERNAL_MINIMIZE_ALL },
+    { "Internal-Remove-Customized-Icon", INTERNAL_REMOVE_CUSTOMIZED_ICON },
+    { "Internal-Remove-From-Launcher-List", INTERNAL_REMOVE_FROM_LAUNCHER_LIST },
+    { "Internal-Separator", INTERNAL_SEPARATOR },
+    { "Internal-Smart-Wnck-Menu", INTERNAL_SMART_WNCK_MENU },
+    { "Internal-Smart-Wnck-Simple-Menu", INTERNAL_SMART_WNCK_SIMPLE_MENU },
+    { "Internal-Unmaximize-All", INTERNAL_UNMAXIMIZE_ALL },
+    { "Internal-Unminimize-All", INTERNAL_UNMINIMIZE_ALL },
+    { NULL, UNKNOWN_ITEM_TYPE }
+};
+
+/* filename -> TaskMenuTemplate */
+static GHashTable* templates = NULL;
+
+typedef struct {
+    GSList*      stack;  /* of GPtrArray, the innermost (sub)menu first */
+    TaskMenuOp*  last;   /* the op the element content belongs to */
+} CompileState;
+
+static void task_menu_ops_free(GPtrArray* ops);
+
+static void
+task_menu_op_free(TaskMenuOp* op)
+{
+    g_free(op->text);
+    g_free(op->icon);
+    g_free(op->cmd);
+    g_free(op->args);
+    g_free(op->shell);
+    g_free(op->label);
+    if (op->children) {
+        task_menu_ops_free(op->children);
+    }
+    g_slice_free(TaskMenuOp, op);
+}
+
+static void
+task_menu_ops_free(GPtrArray* ops)
+{
+    g_ptr_array_foreach(ops, (GFunc) task_menu_op_free, NULL);
+    g_ptr_array_free(ops, TRUE);
+}
+
+static void
+task_menu_template_free(TaskMenuTemplate* tmpl)
+{
+    if (tmpl->monitor_vfs) {
+        g_object_unref(tmpl->monitor_vfs);
+    }
+    if (tmpl->file_vfs) {
+        g_object_unref(tmpl->file_vfs);
+    }
+    task_menu_ops_free(tmpl->ops);
+    g_slice_free(TaskMenuTemplate, tmpl);
+}
+
+static MenuType
+menu_type_from_name(const gchar* value)
+{
+    const MenuTypeName* i;
+
+    for (i = menu_type_names; i->value; i++) {
+        if (g_strcmp0(value, i->value) == 0) {
+            return i->type;
+        }
+    }
+    return UNKNOWN_ITEM_TYPE;
+}
+
+static void
+compile_start_element(GMarkupParseContext* context,
+                      const gchar*         element_name,
+                      const gchar**        attribute_names,
+                      const gchar**        attribute_values,
+                      gpointer             user_data,
+                      GError**             error)
+{
+    CompileState* state = (CompileState*) user_data;
+    const gchar** name_iter = attribute_names;
+    const gchar** value_iter = attribute_values;
+    TaskMenuOp* op;
+
+    state->last = NULL;
+    if (g_strcmp0(element_name, "menu") == 0) {
+        return;
+    }
+
+    op = g_slice_new0(TaskMenuOp);
+    op->type = UNKNOWN_ITEM_TYPE;
+    if (g_strcmp0(element_name, "menuitem") == 0) {
+        for (; *name_iter && *value_iter; name_iter++, value_iter++) {
+            const gchar* name = *name_iter;
+            const gchar* value = *value_iter;
+            if (g_strcmp0(name, "type") == 0) {
+                op->type = menu_type_from_name(value);
+            } else if (g_strcmp0(name, "args") == 0) {
+                op->args = g_strdup(value);
+            } else if (g_strcmp0(name, "icon") == 0) {
+                op->icon = g_strdup(value);
+            } else if (g_strcmp0(name, "cmd") == 0) {
+                op->cmd = g_strdup(value);
+            } else if (g_strcmp0(name, "text") == 0) {
+                op->text = g_strdup(value);
+            } else if (g_strcmp0(name, "shell") == 0) {
+                op->shell = g_strdup(value);
+            }
+        }
+    } else if (g_strcmp0(element_name, "submenu") == 0) {
+        op->type = SUBMENU;
+        for (; *name_iter && *value_iter; name_iter++, value_iter++) {
+            const gchar* name = *name_iter;
+            const gchar* value = *value_iter;
+            if (g_strcmp0(name, "icon") == 0) {
+                op->icon = g_strdup(value);
+            } else if (g_strcmp0(name, "text") == 0) {
+                op->text = g_strdup(value);
+            }
+        }
+    }
+
+    if (op->type == UNKNOWN_ITEM_TYPE) {
+        gint line_number;
+        gint char_number;
+        g_markup_parse_context_get_position(context, &line_number, &char_number);
+        g_warning("%s: Unknown item type, element_name = %s, line = %d", __func__, element_name, line_number);
+        task_menu_op_free(op);
+        return;
+    }
+
+    g_ptr_array_add((GPtrArray*) state->stack->data, op);
+    if (op->type == SUBMENU) {
+        op->children = g_ptr_array_new();
+        state->stack = g_slist_prepend(state->stack, op->children);
+    }
+    state->last = op;
+}
+
+/* Called for close tags </foo> */
+static void
+compile_end_element(GMarkupParseContext* context,
+                    const gchar*         element_name,
+                    gpointer             user_data,
+                    GError**             error)
+{
+    CompileState* state = (CompileState*) user_data;
+
+    if (g_strcmp0(element_name, "submenu") == 0 && state->stack->next) {
+        state->stack = g_slist_delete_link(state->stack, state->stack);
+    }
+}
+
+/* Called for character data, text is not nul-terminated */
+static void
+compile_text(GMarkupParseContext* context,
+             const gchar*         text,
+             gsize                text_len,
+             gpointer             user_data,
+             GError**             error)
+{
+    CompileState* state = (CompileState*) user_data;
+    gchar* s;
+
+    if (!text || !text_len || !state->last) {
+        return;
+    }
+    s = g_strstrip(g_strndup(text, text_len));
+    if (strlen(s)) {
+        g_free(state->last->label);
+        state->last->label = s;
+    } else {
+        g_free(s);
+    }
+}
+
+static GPtrArray*
+task_menu_template_compile(const gchar* filename, GError** error)
+{
+    GMarkupParser parser = {compile_start_element,
+                            compile_end_element,
+                            compile_text,
+                            NULL,
+                            NULL
+                           };
+    GMarkupParseContext* context;
+    CompileState state;
+    GError* err = NULL;
+    gchar* contents = NULL;
+    gsize length;
+    GPtrArray* ops;
+
+    if (!g_file_get_contents(filename, &contents, &length, error)) {
+        return NULL;
+    }
+
+    ops = g_ptr_array_new();
+    state.stack = g_slist_prepend(NULL, ops);
+    state.last = NULL;
+    context = g_markup_parse_context_new(&parser, (GMarkupParseFlags) 0, &state, NULL);
+    if (!g_markup_parse_context_parse(context, contents, length, &err) ||
+            !g_markup_parse_context_end_parse(context, &err)) {
+        /* keep whatever was compiled before the error, like the menus always did */
+        g_message("%s: error parsing menu file %s.  %s", __func__, filename, err->message);
+        g_error_free(err);
+    }
+    g_markup_parse_context_free(context);
+    g_slist_free(state.stack);
+    g_free(contents);
+
+    return ops;
+}
+
+static void
+_menu_file_changed(DesktopAgnosticVFSFileMonitor* monitor,
+                   DesktopAgnosticVFSFile* self,
+                   DesktopAgnosticVFSFile* other,
+                   DesktopAgnosticVFSFileMonitorEvent event,
+                   gchar* filename)
+{
+    task_menu_template_invalidate(filename);
+}
+
+/**
+ * task_menu_template_get:
+ * @filename: path of the menu xml.
+ * @error: return location for a read error.
+ *
+ * Returns the compiled items of @filename, reading and parsing the file only
+ * the first time and after it has been changed. The array is owned by the
+ * cache and only valid until the next return to the main loop.
+ *
+ * Returns: the top level #TaskMenuOp items, or NULL if the file can't be read.
+ */
+const GPtrArray*
+task_menu_template_get(const gchar* filename, GError** error)
+{
+    TaskMenuTemplate* tmpl;
+    GPtrArray* ops;
+    GError* err = NULL;
+    gchar* key;
+
+    g_return_val_if_fail(filename, NULL);
+
+    if (!templates) {
+        templates = g_hash_table_new_full(g_str_hash, g_str_equal, g_free,
+                                          (GDestroyNotify) task_menu_template_free);
+    }
+
+    tmpl = (TaskMenuTemplate*) g_hash_table_lookup(templates, filename);
+    if (tmpl) {
+        return tmpl->ops;
+    }
+
+    ops = task_menu_template_compile(filename, error);
+    if (!ops) {
+        return NULL;
+    }
+
+    key = g_strdup(filename);
+    tmpl = g_slice_new0(TaskMenuTemplate);
+    tmpl->ops = ops;
+    tmpl->file_vfs = desktop_agnostic_vfs_file_new_for_path(filename, &err);
+    if (err) {
+        g_warning("Unable to Monitor %s: %s", filename, err->message);
+        g_error_free(err);
+    } else {
+        tmpl->monitor_vfs = desktop_agnostic_vfs_file_monitor(tmpl->file_vfs);
+        g_signal_connect(G_OBJECT(tmpl->monitor_vfs), "changed",
+                         G_CALLBACK(_menu_file_changed), key);
+    }
+    g_hash_table_insert(templates, key, tmpl);
+
+    return tmpl->ops;
+}
+
+/**
+ * task_menu_template_invalidate:
+ * @filename: path of the menu xml, or NULL for all of them.
+ *
+ * Drops the compiled template(s), the next task_menu_template_get() reads
+ * the file again.
+ */
+void
+task_menu_template_invalidate(const gchar* filename)
+{
+    if (!templates) {
+        return;
+    }
+    if (filename) {
+        g_hash_table_remove(templates, filename);
+    } else {
+        g_hash_table_remove_all(templates);
+    }
+}
@@ -0,0 +1,78 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301  USA.
+ *
+ */
+
+/* task-menu-template.h */
+
+/*
+ * The context menu xml files compiled to a list of items, once per file.
+ * Compiled templates are kept until the file changes on disk.
+ */
+
+#ifndef _TASK_MENU_TEMPLATE_H_
+#define _TASK_MENU_TEMPLATE_H_
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+typedef enum {
+    DBUS_SIGNAL,
+    EXTERNAL_COMMAND,
+    INTERNAL_ABOUT,
+    INTERNAL_ADD_TO_LAUNCHER_LIST,
+    INTERNAL_CLOSE_ACTIVE,
+    INTERNAL_CLOSE_ALL,
+    INTERNAL_CUSTOMIZE_ICON,
+    INTERNAL_DOCK_PREFS,
+    INTERNAL_INLINE_ACTION_MENU_ACTIVE,
+    INTERNAL_INLINE_PLUGINS,
+    INTERNAL_INLINE_SUBMENUS_ACTION_MENU_INACTIVES,
+    INTERNAL_LAUNCH,
+    INTERNAL_MAXIMIZE_ALL,
+    INTERNAL_MINIMIZE_ALL,
+    INTERNAL_REMOVE_CUSTOMIZED_ICON,
+    INTERNAL_REMOVE_FROM_LAUNCHER_LIST,
+    INTERNAL_SEPARATOR,
+    INTERNAL_SMART_WNCK_MENU,
+    INTERNAL_SMART_WNCK_SIMPLE_MENU,
+    INTERNAL_UNMAXIMIZE_ALL,
+    INTERNAL_UNMINIMIZE_ALL,
+    MENU,
+    SUBMENU,
+    UNKNOWN_ITEM_TYPE
+} MenuType;
+
+typedef struct _TaskMenuOp TaskMenuOp;
+
+struct _TaskMenuOp {
+    MenuType    type;
+    gchar*      text;      /* "text" attribute */
+    gchar*      icon;
+    gchar*      cmd;
+    gchar*      args;
+    gchar*      shell;
+    gchar*      label;     /* element content, overrides the item's label */
+    GPtrArray*  children;  /* of TaskMenuOp, SUBMENU only */
+};
+
+const GPtrArray* task_menu_template_get(const gchar* filename, GError** error);
+
+void             task_menu_template_invalidate(const gchar* filename);
+
+G_END_DECLS
+
+#endif
@@ -0,0 +1,631 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor Boston, MA 02110-1301,  USA
+ *
+ */
+
+/* task-thumbnailer.c */
+
+/*
+ Window thumbnails for the task manager dialog when the window manager
+ doesn't do previews for us (_KDE_WINDOW_PREVIEW).
+
+ Windows are redirected with XComposite and tracked with XDamage only while
+ their thumbnail is on screen in a dialog.  The thumbnails are server side
+ surfaces, only the damaged parts of a window are scaled down again, at most
+ every THUMBNAIL_FRAME_INTERVAL.  Hidden thumbnails keep their last contents
+ and are brought up to date when they're shown again.
+
+ There's one thumbnailer shared by all the TaskIcons.
+ */
+
+#include <math.h>
+
+#include <gdk/gdkx.h>
+#include <cairo/cairo-xlib.h>
+#include <X11/extensions/Xcomposite.h>
+#include <X11/extensions/Xdamage.h>
+#include <X11/extensions/Xfixes.h>
+
+#include "task-thumbnailer.h"
+
+G_DEFINE_TYPE(TaskThumbnailer, task_thumbnailer, G_TYPE_OBJECT)
+
+#define GET_PRIVATE(o) \
+  (G_TYPE_INSTANCE_GET_PRIVATE ((o), TASK_TYPE_THUMBNAILER, TaskThumbnailerPrivate))
+
+/* ms */
+#define THUMBNAIL_FRAME_INTERVAL 40
+
+typedef struct _TaskThumbnailerPrivate TaskThumbnailerPrivate;
+
+typedef struct {
+    Window   xid;
+    gint     refs;
+    gboolean visible;
+    /* we asked for StructureNotify, the window's owner didn't */
+    gboolean selected_structure;
+
+    Damage   damage;
+    Pixmap   pixmap;
+    gint     win_width;
+    gint     win_height;
+    cairo_surface_t* source;
+
+    gint     width;
+    gint     height;
+    cairo_surface_t* thumb;
+
+    /* in window coordinates, not scaled down yet */
+    GdkRegion* damaged;
+    gboolean   full_update;
+} TaskThumbnail;
+
+struct _TaskThumbnailerPrivate {
+    Display*    display;
+    gboolean    supported;
+    gint        damage_event;
+
+    GHashTable* thumbnails;
+    guint       update_source;
+};
+
+enum {
+    THUMBNAIL_CHANGED,
+
+    LAST_SIGNAL
+};
+
+static guint _thumbnailer_signals[LAST_SIGNAL] = { 0 };
+
+static GdkFilterReturn task_thumbnailer_filter(GdkXEvent* xevent,
+        GdkEvent* event,
+        TaskThumbnailer* thumbnailer);
+
+static void
+task_thumbnail_release_pixmap(TaskThumbnail* thumb, Display* display)
+{
+    if (thumb->source) {
+        cairo_surface_destroy(thumb->source);
+        thumb->source = NULL;
+    }
+    if (thumb->pixmap) {
+        XFreePixmap(display, thumb->pixmap);
+        thumb->pixmap = None;
+    }
+}
+
+static void
+task_thumbnail_track(TaskThumbnail* thumb, Display* display)
+{
+    if (thumb->damage) {
+        return;
+    }
+
+    gdk_error_trap_push();
+    XCompositeRedirectWindow(display, thumb->xid, CompositeRedirectAutomatic);
+    thumb->damage = XDamageCreate(display, thumb->xid, XDamageReportNonEmpty);
+    gdk_flush();
+    gdk_error_trap_pop();
+
+    // we didn't see what happened to the window meanwhile
+    thumb->full_update = TRUE;
+}
+
+static void
+task_thumbnail_untrack(TaskThumbnail* thumb, Display* display)
+{
+    if (!thumb->damage) {
+        return;
+    }
+
+    gdk_error_trap_push();
+    task_thumbnail_release_pixmap(thumb, display);
+    XDamageDestroy(display, thumb->damage);
+    XCompositeUnredirectWindow(display, thumb->xid, CompositeRedirectAutomatic);
+    gdk_flush();
+    gdk_error_trap_pop();
+
+    thumb->damage = None;
+    gdk_region_destroy(thumb->damaged);
+    thumb->damaged = gdk_region_new();
+}
+
+static void
+task_thumbnail_free(TaskThumbnail* thumb, Display* display)
+{
+    task_thumbnail_untrack(thumb, display);
+
+    if (thumb->selected_structure) {
+        XWindowAttributes attrs;
+
+        // leave the rest of the mask to whoever changed it meanwhile
+        gdk_error_trap_push();
+        if (XGetWindowAttributes(display, thumb->xid, &attrs)) {
+            XSelectInput(display, thumb->xid,
+                         attrs.your_event_mask & ~StructureNotifyMask);
+        }
+        gdk_flush();
+        gdk_error_trap_pop();
+    }
+
+    if (thumb->thumb) {
+        cairo_surface_destroy(thumb->thumb);
+    }
+    gdk_region_destroy(thumb->damaged);
+    g_slice_free(TaskThumbnail, thumb);
+}
+
+/*
+ The pixmap is only valid while the window is mapped, and a new one is
+ allocated when the window is resized.
+ */
+static gboolean
+task_thumbnail_ensure_pixmap(TaskThumbnail* thumb, Display* display)
+{
+    XWindowAttributes attrs;
+    Status status;
+
+    if (thumb->source) {
+        return TRUE;
+    }
+
+    gdk_error_trap_push();
+    status = XGetWindowAttributes(display, thumb->xid, &attrs);
+    if (status && attrs.map_state == IsViewable) {
+        thumb->pixmap = XCompositeNameWindowPixmap(display, thumb->xid);
+    }
+    XSync(display, False);
+    if (gdk_error_trap_pop() || !status || !thumb->pixmap) {
+        thumb->pixmap = None;
+        return FALSE;
+    }
+
+    thumb->win_width = attrs.width + 2 * attrs.border_width;
+    thumb->win_height = attrs.height + 2 * attrs.border_width;
+    thumb->source = cairo_xlib_surface_create(display, thumb->pixmap,
+                    attrs.visual,
+                    thumb->win_width,
+                    thumb->win_height);
+    return TRUE;
+}
+
+/*
+ Scales the damaged region (or everything) of the window into the thumbnail.
+ Returns FALSE if there's nothing to scale from (the window is unmapped).
+ */
+static gboolean
+task_thumbnail_render(TaskThumbnail* thumb, Display* display)
+{
+    cairo_t* cr;
+    gdouble sx, sy;
+
+    if (thumb->width <= 0 || thumb->height <= 0 ||
+            !task_thumbnail_ensure_pixmap(thumb, display)) {
+        // MapNotify or set_size will ask for a full update again
+        gdk_region_destroy(thumb->damaged);
+        thumb->damaged = gdk_region_new();
+        return FALSE;
+    }
+
+    if (!thumb->thumb) {
+        thumb->thumb = cairo_surface_create_similar(thumb->source,
+                       cairo_surface_get_content(thumb->source),
+                       thumb->width, thumb->height);
+        thumb->full_update = TRUE;
+    }
+
+    sx = (gdouble)thumb->width / thumb->win_width;
+    sy = (gdouble)thumb->height / thumb->win_height;
+
+    cr = cairo_create(thumb->thumb);
+
+    if (!thumb->full_update) {
+        GdkRectangle* rects;
+        gint n_rects;
+
+        gdk_region_get_rectangles(thumb->damaged, &rects, &n_rects);
+        for (gint i = 0; i < n_rects; i++) {
+            /* one extra pixel for the filter to pick up the neighbours */
+            gint x1 = floor(rects[i].x * sx) - 1;
+            gint y1 = floor(rects[i].y * sy) - 1;
+            gint x2 = ceil((rects[i].x + rects[i].width) * sx) + 1;
+            gint y2 = ceil((rects[i].y + rects[i].height) * sy) + 1;
+            cairo_rectangle(cr, x1, y1, x2 - x1, y2 - y1);
+        }
+        g_free(rects);
+        cairo_clip(cr);
+    }
+
+    cairo_scale(cr, sx, sy);
+    cairo_set_source_surface(cr, thumb->source, 0, 0);
+    cairo_pattern_set_filter(cairo_get_source(cr), CAIRO_FILTER_GOOD);
+    cairo_set_operator(cr, CAIRO_OPERATOR_SOURCE);
+    cairo_paint(cr);
+    cairo_destroy(cr);
+
+    gdk_region_destroy(thumb->damaged);
+    thumb->damaged = gdk_region_new();
+    thumb->full_update = FALSE;
+    return TRUE;
+}
+
+static gboolean
+task_thumbnail_is_pending(TaskThumbnail* thumb)
+{
+    return thumb->full_update || !gdk_region_empty(thumb->damaged);
+}
+
+static gboolean
+task_thumbnailer_update(TaskThumbnailer* thumbnailer)
+{
+    TaskThumbnailerPrivate* priv = GET_PRIVATE(thumbnailer);
+    GHashTableIter iter;
+    gpointer value;
+    GSList* changed = NULL;
+
+    // damage events queue the next update, there's nothing to poll
+    priv->update_source = 0;
+
+    g_hash_table_iter_init(&iter, priv->thumbnails);
+    while (g_hash_table_iter_next(&iter, NULL, &value)) {
+        TaskThumbnail* thumb = (TaskThumbnail*)value;
+
+        // hidden ones are brought up to date when shown again
+        if (!thumb->visible || !task_thumbnail_is_pending(thumb)) {
+            continue;
+        }
+
+        if (task_thumbnail_render(thumb, priv->display)) {
+            changed = g_slist_prepend(changed, GSIZE_TO_POINTER(thumb->xid));
+        }
+    }
+
+    // handlers might unwatch windows
+    for (GSList* l = changed; l; l = l->next) {
+        g_signal_emit(thumbnailer, _thumbnailer_signals[THUMBNAIL_CHANGED], 0,
+                      (gulong)GPOINTER_TO_SIZE(l->data));
+    }
+    g_slist_free(changed);
+
+    return FALSE;
+}
+
+static void
+task_thumbnailer_queue_update(TaskThumbnailer* thumbnailer)
+{
+    TaskThumbnailerPrivate* priv = GET_PRIVATE(thumbnailer);
+
+    if (!priv->update_source) {
+        priv->update_source = g_timeout_add(THUMBNAIL_FRAME_INTERVAL,
+                                            (GSourceFunc)task_thumbnailer_update,
+                                            thumbnailer);
+    }
+}
+
+static GdkFilterReturn
+task_thumbnailer_filter(GdkXEvent* xevent, GdkEvent* event,
+                        TaskThumbnailer* thumbnailer)
+{
+    TaskThumbnailerPrivate* priv = GET_PRIVATE(thumbnailer);
+    XEvent* xe = (XEvent*)xevent;
+    TaskThumbnail* thumb;
+
+    if (xe->type == priv->damage_event + XDamageNotify) {
+        XDamageNotifyEvent* de = (XDamageNotifyEvent*)xe;
+        XserverRegion parts;
+        XRectangle* rects;
+        gint n_rects;
+
+        thumb = (TaskThumbnail*)g_hash_table_lookup(priv->thumbnails,
+                GSIZE_TO_POINTER(de->drawable));
+        if (!thumb) {
+            return GDK_FILTER_CONTINUE;
+        }
+        // queued before the damage was destroyed, on untrack or with the window
+        if (!thumb->damage || de->damage != thumb->damage) {
+            return GDK_FILTER_REMOVE;
+        }
+
+        gdk_error_trap_push();
+        parts = XFixesCreateRegion(priv->display, NULL, 0);
+        XDamageSubtract(priv->display, de->damage, None, parts);
+        rects = XFixesFetchRegion(priv->display, parts, &n_rects);
+        XFixesDestroyRegion(priv->display, parts);
+        gdk_flush();
+        if (gdk_error_trap_pop()) {
+            if (rects) {
+                XFree(rects);
+            }
+            return GDK_FILTER_REMOVE;
+        }
+
+        for (gint i = 0; i < n_rects; i++) {
+            GdkRectangle rect = { rects[i].x, rects[i].y,
+                                  rects[i].width, rects[i].height
+                                };
+            gdk_region_union_with_rect(thumb->damaged, &rect);
+        }
+        if (rects) {
+            XFree(rects);
+        }
+
+        task_thumbnailer_queue_update(thumbnailer);
+        return GDK_FILTER_REMOVE;
+    }
+
+    switch (xe->type) {
+    case ConfigureNotify:
+        thumb = (TaskThumbnail*)g_hash_table_lookup(priv->thumbnails,
+                GSIZE_TO_POINTER(xe->xconfigure.window));
+        if (thumb && (xe->xconfigure.width != thumb->win_width ||
+                      xe->xconfigure.height != thumb->win_height)) {
+            task_thumbnail_release_pixmap(thumb, priv->display);
+            thumb->full_update = TRUE;
+            task_thumbnailer_queue_update(thumbnailer);
+        }
+        break;
+    case MapNotify:
+    case UnmapNotify:
+        thumb = (TaskThumbnail*)g_hash_table_lookup(priv->thumbnails,
+                GSIZE_TO_POINTER(xe->xany.window));
+        if (thumb) {
+            // keep the old thumbnail of unmapped (minimized) windows
+            task_thumbnail_release_pixmap(thumb, priv->display);
+            if (xe->type == MapNotify) {
+                thumb->full_update = TRUE;
+                task_thumbnailer_queue_update(thumbnailer);
+            }
+        }
+        break;
+    default:
+        break;
+    }
+
+    return GDK_FILTER_CONTINUE;
+}
+
+static void
+task_thumbnailer_dispose(GObject* object)
+{
+    TaskThumbnailerPrivate* priv = GET_PRIVATE(object);
+
+    if (priv->update_source) {
+        g_source_remove(priv->update_source);
+        priv->update_source = 0;
+    }
+    if (priv->supported) {
+        gdk_window_remove_filter(NULL,
+                                 (GdkFilterFunc)task_thumbnailer_filter,
+                                 object);
+        priv->supported = FALSE;
+    }
+    if (priv->thumbnails) {
+        GHashTableIter iter;
+        gpointer value;
+
+        g_hash_table_iter_init(&iter, priv->thumbnails);
+        while (g_hash_table_iter_next(&iter, NULL, &value)) {
+            task_thumbnail_free((TaskThumbnail*)value, priv->display);
+        }
+        g_hash_table_destroy(priv->thumbnails);
+        priv->thumbnails = NULL;
+    }
+
+    G_OBJECT_CLASS(task_thumbnailer_parent_class)->dispose(object);
+}
+
+static void
+task_thumbnailer_class_init(TaskThumbnailerClass* klass)
+{
+    GObjectClass* object_class = G_OBJECT_CLASS(klass);
+
+    object_class->dispose = task_thumbnailer_dispose;
+
+    _thumbnailer_signals[THUMBNAIL_CHANGED] =
+        g_signal_new("thumbnail-changed",
+                     G_OBJECT_CLASS_TYPE(object_class),
+                     G_SIGNAL_RUN_LAST,
+                     G_STRUCT_OFFSET(TaskThumbnailerClass, thumbnail_changed),
+                     NULL, NULL,
+                     g_cclosure_marshal_VOID__ULONG,
+                     G_TYPE_NONE,
+                     1, G_TYPE_ULONG);
+
+    g_type_class_add_private(klass, sizeof(TaskThumbnailerPrivate));
+}
+
+static void
+task_thumbnailer_init(TaskThumbnailer* self)
+{
+    TaskThumbnailerPrivate* priv = GET_PRIVATE(self);
+    gint event_base, error_base;
+    gint major = 0, minor = 2;
+
+    priv->display = GDK_DISPLAY_XDISPLAY(gdk_display_get_default());
+    priv->thumbnails = g_hash_table_new(g_direct_hash, g_direct_equal);
+    priv->update_source = 0;
+
+    /* NameWindowPixmap needs Composite 0.2 */
+    priv->supported =
+        XCompositeQueryExtension(priv->display, &event_base, &error_base) &&
+        XCompositeQueryVersion(priv->display, &major, &minor) &&
+        (major > 0 || minor >= 2) &&
+        XFixesQueryExtension(priv->display, &event_base, &error_base) &&
+        XDamageQueryExtension(priv->display, &priv->damage_event, &error_base);
+
+    if (priv->supported) {
+        gdk_window_add_filter(NULL, (GdkFilterFunc)task_thumbnailer_filter,
+                              self);
+    }
+}
+
+TaskThumbnailer*
+task_thumbnailer_get_default(void)
+{
+    static TaskThumbnailer* thumbnailer = NULL;
+
+    if (!thumbnailer) {
+        thumbnailer = (TaskThumbnailer*)g_object_new(TASK_TYPE_THUMBNAILER,
+                      NULL);
+    }
+    return thumbnailer;
+}
+
+gboolean
+task_thumbnailer_is_supported(TaskThumbnailer* thumbnailer)
+{
+    g_return_val_if_fail(TASK_IS_THUMBNAILER(thumbnailer), FALSE);
+
+    return GET_PRIVATE(thumbnailer)->supported;
+}
+
+/**
+ * Starts keeping a thumbnail of the window, calls need to be balanced
+ * with task_thumbnailer_unwatch.
+ */
+void
+task_thumbnailer_watch(TaskThumbnailer* thumbnailer, gulong xid)
+{
+    TaskThumbnailerPrivate* priv;
+    TaskThumbnail* thumb;
+    XWindowAttributes attrs;
+
+    g_return_if_fail(TASK_IS_THUMBNAILER(thumbnailer));
+    priv = GET_PRIVATE(thumbnailer);
+    g_return_if_fail(priv->supported);
+
+    thumb = (TaskThumbnail*)g_hash_table_lookup(priv->thumbnails,
+            GSIZE_TO_POINTER(xid));
+    if (thumb) {
+        thumb->refs++;
+        return;
+    }
+
+    thumb = g_slice_new0(TaskThumbnail);
+    thumb->xid = xid;
+    thumb->refs = 1;
+    thumb->damaged = gdk_region_new();
+    thumb->full_update = TRUE;
+
+    gdk_error_trap_push();
+    // keep whatever wnck selected on the window
+    if (XGetWindowAttributes(priv->display, xid, &attrs) &&
+            !(attrs.your_event_mask & StructureNotifyMask)) {
+        XSelectInput(priv->display, xid,
+                     attrs.your_event_mask | StructureNotifyMask);
+        thumb->selected_structure = TRUE;
+    }
+    gdk_flush();
+    if (gdk_error_trap_pop()) {
+        thumb->selected_structure = FALSE;
+    }
+
+    g_hash_table_insert(priv->thumbnails, GSIZE_TO_POINTER(xid), thumb);
+}
+
+void
+task_thumbnailer_unwatch(TaskThumbnailer* thumbnailer, gulong xid)
+{
+    TaskThumbnailerPrivate* priv;
+    TaskThumbnail* thumb;
+
+    g_return_if_fail(TASK_IS_THUMBNAILER(thumbnailer));
+    priv = GET_PRIVATE(thumbnailer);
+
+    thumb = (TaskThumbnail*)g_hash_table_lookup(priv->thumbnails,
+            GSIZE_TO_POINTER(xid));
+    g_return_if_fail(thumb);
+
+    if (--thumb->refs > 0) {
+        return;
+    }
+
+    g_hash_table_remove(priv->thumbnails, GSIZE_TO_POINTER(xid));
+    task_thumbnail_free(thumb, priv->display);
+}
+
+void
+task_thumbnailer_set_size(TaskThumbnailer* thumbnailer, gulong xid,
+                          gint width, gint height)
+{
+    TaskThumbnailerPrivate* priv;
+    TaskThumbnail* thumb;
+
+    g_return_if_fail(TASK_IS_THUMBNAILER(thumbnailer));
+    priv = GET_PRIVATE(thumbnailer);
+
+    thumb = (TaskThumbnail*)g_hash_table_lookup(priv->thumbnails,
+            GSIZE_TO_POINTER(xid));
+    g_return_if_fail(thumb);
+
+    if (thumb->width == width && thumb->height == height) {
+        return;
+    }
+
+    thumb->width = width;
+    thumb->height = height;
+    if (thumb->thumb) {
+        cairo_surface_destroy(thumb->thumb);
+        thumb->thumb = NULL;
+    }
+    thumb->full_update = TRUE;
+    task_thumbnailer_queue_update(thumbnailer);
+}
+
+/**
+ * Only visible thumbnails follow their window, the window is redirected
+ * while its thumbnail is visible.
+ */
+void
+task_thumbnailer_set_visible(TaskThumbnailer* thumbnailer, gulong xid,
+                             gboolean visible)
+{
+    TaskThumbnailerPrivate* priv;
+    TaskThumbnail* thumb;
+
+    g_return_if_fail(TASK_IS_THUMBNAILER(thumbnailer));
+    priv = GET_PRIVATE(thumbnailer);
+
+    thumb = (TaskThumbnail*)g_hash_table_lookup(priv->thumbnails,
+            GSIZE_TO_POINTER(xid));
+    g_return_if_fail(thumb);
+
+    thumb->visible = visible;
+    if (visible) {
+        task_thumbnail_track(thumb, priv->display);
+        task_thumbnailer_queue_update(thumbnailer);
+    } else {
+        task_thumbnail_untrack(thumb, priv->display);
+    }
+}
+
+/**
+ * Returns: the thumbnail of the window or NULL if there's none yet.  The
+ * surface is owned by the thumbnailer.
+ */
+cairo_surface_t*
+task_thumbnailer_get_thumbnail(TaskThumbnailer* thumbnailer, gulong xid)
+{
+    TaskThumbnailerPrivate* priv;
+    TaskThumbnail* thumb;
+
+    g_return_val_if_fail(TASK_IS_THUMBNAILER(thumbnailer), NULL);
+    priv = GET_PRIVATE(thumbnailer);
+
+    thumb = (TaskThumbnail*)g_hash_table_lookup(priv->thumbnails,
+            GSIZE_TO_POINTER(xid));
+
+    return thumb ? thumb->thumb : NULL;
+}
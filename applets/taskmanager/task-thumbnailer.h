@@ -0,0 +1,72 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor Boston, MA 02110-1301,  USA
+ *
+ */
+
+/* task-thumbnailer.h */
+
+#ifndef _TASK_THUMBNAILER
+#define _TASK_THUMBNAILER
+
+#include <glib-object.h>
+#include <cairo.h>
+
+#define TASK_TYPE_THUMBNAILER task_thumbnailer_get_type()
+
+#define TASK_THUMBNAILER(obj) \
+  (G_TYPE_CHECK_INSTANCE_CAST ((obj), TASK_TYPE_THUMBNAILER, TaskThumbnailer))
+
+#define TASK_THUMBNAILER_CLASS(klass) \
+  (G_TYPE_CHECK_CLASS_CAST ((klass), TASK_TYPE_THUMBNAILER, TaskThumbnailerClass))
+
+#define TASK_IS_THUMBNAILER(obj) \
+  (G_TYPE_CHECK_INSTANCE_TYPE ((obj), TASK_TYPE_THUMBNAILER))
+
+#define TASK_IS_THUMBNAILER_CLASS(klass) \
+  (G_TYPE_CHECK_CLASS_TYPE ((klass), TASK_TYPE_THUMBNAILER))
+
+#define TASK_THUMBNAILER_GET_CLASS(obj) \
+  (G_TYPE_INSTANCE_GET_CLASS ((obj), TASK_TYPE_THUMBNAILER, TaskThumbnailerClass))
+
+typedef struct {
+    GObject parent;
+} TaskThumbnailer;
+
+typedef struct {
+    GObjectClass parent_class;
+
+    void (*thumbnail_changed)(TaskThumbnailer* thumbnailer, gulong xid);
+} TaskThumbnailerClass;
+
+GType task_thumbnailer_get_type(void);
+
+TaskThumbnailer* task_thumbnailer_get_default(void);
+
+gboolean task_thumbnailer_is_supported(TaskThumbnailer* thumbnailer);
+
+void task_thumbnailer_watch(TaskThumbnailer* thumbnailer, gulong xid);
+
+void task_thumbnailer_unwatch(TaskThumbnailer* thumbnailer, gulong xid);
+
+void task_thumbnailer_set_size(TaskThumbnailer* thumbnailer, gulong xid,
+                               gint width, gint height);
+
+void task_thumbnailer_set_visible(TaskThumbnailer* thumbnailer, gulong xid,
+                                  gboolean visible);
+
+cairo_surface_t* task_thumbnailer_get_thumbnail(TaskThumbnailer* thumbnailer,
+        gulong xid);
+
+#endif /* _TASK_THUMBNAILER */
@@ -78,6 +78,9 @@ struct _TaskWindowPrivate {
     gboolean is_active;
     gboolean highlighted;
 
+    /* last published minimize target */
+    GdkRectangle icon_geometry;
+
     gint     use_win_icon;
 
     gint     activate_behavior;
@@ -94,6 +97,10 @@ struct _TaskWindowPrivate {
     guint     icon_changes;
 
     gchar*     client_name;
+
+    /* _NET_STARTUP_ID, read once */
+    gchar*     startup_id;
+    gboolean   startup_id_read;
 };
 
 enum {
@@ -254,6 +261,8 @@ task_window_constructed(GObject* object)
         return;
     }
     priv->client_name = NULL;
+    priv->startup_id = NULL;
+    priv->startup_id_read = FALSE;
 }
 
 static void
@@ -291,6 +300,7 @@ task_window_finalize(GObject* object)
                                          G_CALLBACK(_active_window_changed),
                                          object);
     g_free(priv->client_name);
+    g_free(priv->startup_id);
     g_free(priv->special_id);
     g_free(priv->message);
     g_signal_handlers_disconnect_by_func(G_OBJECT(gtk_icon_theme_get_default()),
@@ -760,6 +770,31 @@ task_window_get_client_name(TaskWindow* window)
     return priv->client_name;
 }
 
+/*
+ The startup notification id the window was mapped with, falls back to the
+ one of its application (set on the group leader).
+ */
+const gchar*
+task_window_get_startup_id(TaskWindow* window)
+{
+    TaskWindowPrivate* priv;
+
+    g_return_val_if_fail(TASK_IS_WINDOW(window), NULL);
+    priv = window->priv;
+
+    if (!priv->startup_id_read && WNCK_IS_WINDOW(priv->window)) {
+        WnckApplication* app;
+
+        _wnck_get_startup_id(wnck_window_get_xid(priv->window), &priv->startup_id);
+        app = wnck_window_get_application(priv->window);
+        if (!priv->startup_id && app && wnck_application_get_startup_id(app)) {
+            priv->startup_id = g_strdup(wnck_application_get_startup_id(app));
+        }
+        priv->startup_id_read = TRUE;
+    }
+    return priv->startup_id;
+}
+
 
 /*
  return the total number of icon changes
@@ -1136,25 +1171,37 @@ task_window_popup_context_menu(TaskWindow*     window,
     return priv->menu;
 }
 
-void
-task_window_set_icon_geometry(TaskWindow*    window,
-                              gint           x,
-                              gint           y,
-                              gint           width,
-                              gint           height)
+/*
+ * Remembers the minimize target of the window, returns TRUE if it differs
+ * from the one which was published last and needs to be written out
+ * (see xutils_set_icon_geometries).
+ */
+gboolean
+task_window_update_icon_geometry(TaskWindow*    window,
+                                 GdkRectangle*  rect)
 {
     TaskWindowPrivate* priv;
 
-    g_return_if_fail(TASK_IS_WINDOW(window));
+    g_return_val_if_fail(TASK_IS_WINDOW(window), FALSE);
+    g_return_val_if_fail(rect, FALSE);
     priv = window->priv;
 
     /* FIXME: Do something interesting like dividing the width by the number of
      * WnckWindows so the user can scrub through them
      */
-    if (WNCK_IS_WINDOW(priv->window)) {
-        wnck_window_set_icon_geometry(priv->window, x, y, width, height);
+    if (!WNCK_IS_WINDOW(priv->window)) {
+        return FALSE;
     }
 
+    if (priv->icon_geometry.x == rect->x &&
+            priv->icon_geometry.y == rect->y &&
+            priv->icon_geometry.width == rect->width &&
+            priv->icon_geometry.height == rect->height) {
+        return FALSE;
+    }
+
+    priv->icon_geometry = *rect;
+    return TRUE;
 }
 
 gboolean
@@ -129,11 +129,8 @@ void            task_window_close(TaskWindow*    window,
 GtkWidget*      task_window_popup_context_menu(TaskWindow*     window,
         GdkEventButton* event);
 
-void            task_window_set_icon_geometry(TaskWindow*     window,
-        gint            x,
-        gint            y,
-        gint            width,
-        gint            height);
+gboolean        task_window_update_icon_geometry(TaskWindow*     window,
+        GdkRectangle*   rect);
 
 gboolean        task_window_get_is_running(TaskWindow*     window);
 
@@ -151,6 +148,8 @@ void            task_window_set_highlighted(TaskWindow* window, gboolean highlig
 
 const gchar*    task_window_get_client_name(TaskWindow* window);
 
+const gchar*    task_window_get_startup_id(TaskWindow* window);
+
 gboolean        task_window_get_icon_is_fallback(TaskWindow* window);
 
 #ifdef __cplusplus
@@ -965,3 +965,69 @@ xutils_get_named_icon(const gchar* icon_name,
 {
     return get_icon(icon_name, width);
 }
+
+/* Writes _NET_WM_ICON_GEOMETRY of a bunch of windows, unlike
+ * wnck_window_set_icon_geometry this syncs with the X server only once.
+ */
+void
+xutils_set_icon_geometries(const gulong*       xwindows,
+                           const GdkRectangle* rects,
+                           guint               n_windows)
+{
+    Display* display = _wnck_get_default_display();
+    Atom atom = _wnck_atom_get("_NET_WM_ICON_GEOMETRY");
+
+    _wnck_error_trap_push();
+    for (guint i = 0; i < n_windows; i++) {
+        gulong data[4];
+
+        data[0] = rects[i].x;
+        data[1] = rects[i].y;
+        data[2] = rects[i].width;
+        data[3] = rects[i].height;
+
+        XChangeProperty(display, xwindows[i], atom, XA_CARDINAL, 32,
+                        PropModeReplace, (guchar*)data, 4);
+    }
+    _wnck_error_trap_pop();
+}
+
+/*
+ * Reads _NET_STARTUP_ID, the startup notification id the window was
+ * launched with (if the toolkit sets it).
+ */
+void
+_wnck_get_startup_id(Window xwindow, char** startup_id)
+{
+    Atom type;
+    int format;
+    gulong nitems;
+    gulong bytes_after;
+    guchar* data = NULL;
+    int err, result;
+
+    *startup_id = NULL;
+
+    _wnck_error_trap_push();
+    type = None;
+    result = XGetWindowProperty(_wnck_get_default_display(), xwindow,
+                                _wnck_atom_get("_NET_STARTUP_ID"),
+                                0, G_MAXLONG,
+                                False, _wnck_atom_get("UTF8_STRING"),
+                                &type, &format, &nitems,
+                                &bytes_after, (void*) &data);
+    err = _wnck_error_trap_pop();
+
+    if (err != Success || result != Success) {
+        return;
+    }
+
+    if (type == _wnck_atom_get("UTF8_STRING") && format == 8 && nitems > 0 &&
+            g_utf8_validate((gchar*)data, nitems, NULL)) {
+        *startup_id = g_strndup((gchar*)data, nitems);
+    }
+
+    if (data) {
+        XFree(data);
+    }
+}
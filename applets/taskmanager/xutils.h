@@ -39,6 +39,10 @@ void
 _wnck_get_client_name(Window xwindow,
                       char** client_name);
 
+void
+_wnck_get_startup_id(Window xwindow,
+                     char** startup_id);
+
 GdkPixbuf*
 _wnck_get_icon_at_size(WnckWindow* window,
                        gint        width,
@@ -49,4 +53,9 @@ xutils_get_named_icon(const gchar* icon_name,
                       gint         width,
                       gint         height);
 
+void
+xutils_set_icon_geometries(const gulong*       xwindows,
+                           const GdkRectangle* rects,
+                           guint               n_windows);
+
 #endif /* WNCK_XUTILS_H */
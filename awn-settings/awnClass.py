@@ -27,6 +27,7 @@ import time
 import urllib
 import cairo
 import array
+import mmap
 from ConfigParser import ConfigParser
 try:
     from cStringIO import StringIO
@@ -1631,9 +1632,19 @@ class awnThemeCustomize(awnBzr):
         panel = bus.get_object('org.awnproject.Awn',
                                '/org/awnproject/Awn/Panel%d' % (panel_id),
                                'org.awnproject.Awn.Panel')
-        data = panel.GetSnapshot(byte_arrays=True)
-        width, height, rowstride, has_alpha, bits_per_sample, n_channels, pixels = data
-        pixels = array.array('c', pixels)
+        try:
+            # only the part we use, mapped straight from the dock's buffer
+            width, height, rowstride, fd = panel.GetSnapshotFd(0, 0, 150, 0)
+            fd = fd.take()
+            try:
+                pixels = mmap.mmap(fd, max(rowstride * height, 1),
+                                   mmap.MAP_SHARED, mmap.PROT_READ | mmap.PROT_WRITE)
+            finally:
+                os.close(fd)
+        except (dbus.DBusException, AttributeError, EnvironmentError):
+            data = panel.GetSnapshot(byte_arrays=True)
+            width, height, rowstride, has_alpha, bits_per_sample, n_channels, pixels = data
+            pixels = array.array('c', pixels)
         surface = cairo.ImageSurface.create_for_data(pixels, cairo.FORMAT_ARGB32, width, height, rowstride)
         # get only a subimage
         newsurface = surface.create_similar(cairo.CONTENT_COLOR_ALPHA, 150, height)
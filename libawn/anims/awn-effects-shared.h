@@ -86,6 +86,10 @@ struct _AwnEffectsPrivate {
 
     guint timer_id;
     gboolean already_exposed;
+
+    gint64 trace_start; /* of the frame being painted, see awn-trace.h */
+
+    cairo_surface_t* spotlight_asset; /* shared, see awn-effects-ops-new.cc */
 };
 
 typedef enum {
@@ -21,6 +21,8 @@
 #include "config.h"
 #endif
 
+#include <string.h>
+
 #include "awn-config.h"
 
 /**
@@ -40,6 +42,32 @@
 /* The config client cache. */
 static GData* awn_config_clients = NULL;
 
+/* Writes queued by awn_config_set_value() inside a transaction. */
+typedef struct {
+    gchar* group;
+    gchar* key;
+    GValue value;
+} AwnConfigWrite;
+
+/* The transaction and update state of one config client. The pending
+ * objects wait for their grouped update, GObject* -> AwnConfigUpdateFunc. */
+typedef struct {
+    GObject*    client;
+    guint       depth;
+    GPtrArray*  writes;
+    GHashTable* pending;
+    GHashTable* delivering;
+    guint       update_id;
+} AwnConfigBatch;
+
+#define AWN_CONFIG_BATCH_KEY "awn-config-batch"
+
+static guint awn_config_updates_queued = 0;
+static guint awn_config_updates_delivered = 0;
+
+static void awn_config_schedule_updates(AwnConfigBatch* batch);
+static void on_pending_finalized(gpointer data, GObject* where_the_object_was);
+
 
 static void
 on_config_destroy(gpointer data)
@@ -111,6 +139,7 @@ awn_config_get_default(gint panel_id, GError** error)
 void
 awn_config_free(void)
 {
+    /* the update state goes away with the clients */
     g_datalist_clear(&awn_config_clients);
 }
 
@@ -233,3 +262,311 @@ awn_config_get_default_for_applet_by_info(const gchar*  name,
     g_free(instance_id);
     return client;
 }
+
+
+static void
+awn_config_write_free(AwnConfigWrite* write)
+{
+    g_free(write->group);
+    g_free(write->key);
+    g_value_unset(&write->value);
+    g_slice_free(AwnConfigWrite, write);
+}
+
+static void
+awn_config_drop_updates(AwnConfigBatch* batch, GHashTable* updates)
+{
+    GHashTableIter iter;
+    gpointer object;
+
+    g_hash_table_iter_init(&iter, updates);
+    while (g_hash_table_iter_next(&iter, &object, NULL)) {
+        g_object_weak_unref(G_OBJECT(object), on_pending_finalized, batch);
+    }
+    g_hash_table_destroy(updates);
+}
+
+static void
+awn_config_batch_free(gpointer data)
+{
+    AwnConfigBatch* batch = (AwnConfigBatch*)data;
+
+    if (batch->update_id) {
+        g_source_remove(batch->update_id);
+    }
+    if (batch->pending) {
+        awn_config_drop_updates(batch, batch->pending);
+    }
+    if (batch->delivering) {
+        awn_config_drop_updates(batch, batch->delivering);
+    }
+    g_ptr_array_foreach(batch->writes, (GFunc)awn_config_write_free, NULL);
+    g_ptr_array_free(batch->writes, TRUE);
+    g_slice_free(AwnConfigBatch, batch);
+}
+
+static AwnConfigBatch*
+awn_config_get_batch(DesktopAgnosticConfigClient* client, gboolean create)
+{
+    AwnConfigBatch* batch;
+
+    batch = (AwnConfigBatch*)g_object_get_data(G_OBJECT(client),
+            AWN_CONFIG_BATCH_KEY);
+    if (batch == NULL && create) {
+        batch = g_slice_new0(AwnConfigBatch);
+        batch->client = G_OBJECT(client);
+        batch->writes = g_ptr_array_new();
+        g_object_set_data_full(G_OBJECT(client), AWN_CONFIG_BATCH_KEY, batch,
+                               awn_config_batch_free);
+    }
+    return batch;
+}
+
+
+/**
+ * awn_config_begin_update:
+ * @client: The configuration client.
+ *
+ * Starts a transaction on @client. Until the matching
+ * awn_config_end_update(), values set with awn_config_set_value() are only
+ * collected (the last one per key wins) and grouped updates queued on
+ * @client with awn_config_queue_update() are held back. Other clients are
+ * not affected. Transactions can be nested.
+ */
+void
+awn_config_begin_update(DesktopAgnosticConfigClient* client)
+{
+    g_return_if_fail(DESKTOP_AGNOSTIC_CONFIG_IS_CLIENT(client));
+
+    awn_config_get_batch(client, TRUE)->depth++;
+}
+
+
+/**
+ * awn_config_end_update:
+ * @client: The configuration client.
+ * @error: The address of the #GError object, if an error occurs.
+ *
+ * Ends a transaction started with awn_config_begin_update(). Ending the
+ * outermost one writes all the collected values in one pass, and the bound
+ * objects get a single grouped update each once the main loop is idle.
+ * If several writes fail, only the first error is reported.
+ */
+void
+awn_config_end_update(DesktopAgnosticConfigClient* client, GError** error)
+{
+    AwnConfigBatch* batch;
+    GPtrArray* writes;
+
+    g_return_if_fail(DESKTOP_AGNOSTIC_CONFIG_IS_CLIENT(client));
+
+    batch = awn_config_get_batch(client, FALSE);
+    g_return_if_fail(batch != NULL && batch->depth > 0);
+
+    batch->depth--;
+    if (batch->depth > 0) {
+        return;
+    }
+
+    /* writing may notify synchronously and start another transaction */
+    writes = batch->writes;
+    batch->writes = g_ptr_array_new();
+
+    for (guint i = 0; i < writes->len; i++) {
+        AwnConfigWrite* write = (AwnConfigWrite*)g_ptr_array_index(writes, i);
+        GError* write_error = NULL;
+
+        desktop_agnostic_config_client_set_value(client, write->group,
+                write->key, &write->value,
+                &write_error);
+        if (write_error) {
+            if (error && *error == NULL) {
+                g_propagate_error(error, write_error);
+            } else {
+                g_error_free(write_error);
+            }
+        }
+        awn_config_write_free(write);
+    }
+    g_ptr_array_free(writes, TRUE);
+
+    awn_config_schedule_updates(batch);
+}
+
+
+/**
+ * awn_config_set_value:
+ * @client: The configuration client.
+ * @group: The name of the config group.
+ * @key: The name of the config key.
+ * @value: The new value.
+ * @error: The address of the #GError object, if an error occurs.
+ *
+ * Sets a configuration value. Inside a transaction the value is only
+ * written when the transaction ends, errors are then reported by
+ * awn_config_end_update(). Otherwise it's written right away, like
+ * desktop_agnostic_config_client_set_value().
+ */
+void
+awn_config_set_value(DesktopAgnosticConfigClient* client,
+                     const gchar*                 group,
+                     const gchar*                 key,
+                     const GValue*                value,
+                     GError**                     error)
+{
+    AwnConfigBatch* batch;
+    AwnConfigWrite* write = NULL;
+
+    g_return_if_fail(DESKTOP_AGNOSTIC_CONFIG_IS_CLIENT(client));
+    g_return_if_fail(group != NULL && key != NULL && value != NULL);
+
+    batch = awn_config_get_batch(client, FALSE);
+    if (batch == NULL || batch->depth == 0) {
+        desktop_agnostic_config_client_set_value(client, group, key,
+                (GValue*)value, error);
+        return;
+    }
+
+    for (guint i = 0; i < batch->writes->len; i++) {
+        AwnConfigWrite* queued = (AwnConfigWrite*)g_ptr_array_index(batch->writes, i);
+
+        if (strcmp(queued->key, key) == 0 && strcmp(queued->group, group) == 0) {
+            write = queued;
+            g_value_unset(&write->value);
+            break;
+        }
+    }
+    if (write == NULL) {
+        write = g_slice_new0(AwnConfigWrite);
+        write->group = g_strdup(group);
+        write->key = g_strdup(key);
+        g_ptr_array_add(batch->writes, write);
+    }
+    g_value_init(&write->value, G_VALUE_TYPE(value));
+    g_value_copy(value, &write->value);
+}
+
+
+static void
+on_pending_finalized(gpointer data, GObject* where_the_object_was)
+{
+    AwnConfigBatch* batch = (AwnConfigBatch*)data;
+
+    if (batch->pending) {
+        g_hash_table_remove(batch->pending, where_the_object_was);
+    }
+    if (batch->delivering) {
+        g_hash_table_remove(batch->delivering, where_the_object_was);
+    }
+}
+
+static gboolean
+awn_config_deliver_updates(gpointer data)
+{
+    AwnConfigBatch* batch = (AwnConfigBatch*)data;
+    GObject* client;
+
+    batch->update_id = 0;
+
+    /* a transaction was started after we got scheduled, its end reschedules */
+    if (batch->depth > 0 || batch->pending == NULL) {
+        return FALSE;
+    }
+
+    /* an update might drop the last reference to the client and its batch */
+    client = (GObject*)g_object_ref(batch->client);
+
+    /* updates queued while delivering wait for the next idle */
+    batch->delivering = batch->pending;
+    batch->pending = NULL;
+
+    while (g_hash_table_size(batch->delivering) > 0) {
+        GHashTableIter iter;
+        gpointer object, func;
+
+        g_hash_table_iter_init(&iter, batch->delivering);
+        g_hash_table_iter_next(&iter, &object, &func);
+        g_hash_table_iter_remove(&iter);
+
+        g_object_weak_unref(G_OBJECT(object), on_pending_finalized, batch);
+        ((AwnConfigUpdateFunc)func)(G_OBJECT(object));
+        awn_config_updates_delivered++;
+    }
+
+    g_hash_table_destroy(batch->delivering);
+    batch->delivering = NULL;
+    g_object_unref(client);
+
+    return FALSE;
+}
+
+static void
+awn_config_schedule_updates(AwnConfigBatch* batch)
+{
+    if (batch->update_id == 0 && batch->depth == 0 && batch->pending != NULL) {
+        /* before the resize and redraw idles of gtk */
+        batch->update_id = g_idle_add_full(G_PRIORITY_HIGH_IDLE,
+                                           awn_config_deliver_updates,
+                                           batch, NULL);
+    }
+}
+
+
+/**
+ * awn_config_queue_update:
+ * @client: The configuration client @object is bound to.
+ * @object: The object whose bound settings changed.
+ * @func: Applies the changes, eg. redraws @object.
+ *
+ * Meant to be called from the property setters of objects bound to
+ * configuration keys, instead of redrawing right away. However many keys
+ * change within one main loop iteration, or within a transaction on
+ * @client, @func is called only once for @object, after the last change.
+ * If @object is finalized before that, the update is dropped.
+ */
+void
+awn_config_queue_update(DesktopAgnosticConfigClient* client,
+                        GObject*                     object,
+                        AwnConfigUpdateFunc          func)
+{
+    AwnConfigBatch* batch;
+
+    g_return_if_fail(DESKTOP_AGNOSTIC_CONFIG_IS_CLIENT(client));
+    g_return_if_fail(G_IS_OBJECT(object));
+    g_return_if_fail(func != NULL);
+
+    awn_config_updates_queued++;
+
+    batch = awn_config_get_batch(client, TRUE);
+    if (batch->pending == NULL) {
+        batch->pending = g_hash_table_new(g_direct_hash, g_direct_equal);
+    }
+    if (g_hash_table_lookup(batch->pending, object) == NULL) {
+        g_object_weak_ref(object, on_pending_finalized, batch);
+    }
+    g_hash_table_insert(batch->pending, object, (gpointer)func);
+
+    awn_config_schedule_updates(batch);
+}
+
+
+/**
+ * awn_config_get_update_stats:
+ * @queued: Return location for the number of changes queued with
+ * awn_config_queue_update(), or %NULL.
+ * @delivered: Return location for the number of grouped updates delivered,
+ * or %NULL.
+ *
+ * Gets the counters of the update coalescing, the difference between the two
+ * is the work saved.
+ */
+void
+awn_config_get_update_stats(guint* queued, guint* delivered)
+{
+    if (queued) {
+        *queued = awn_config_updates_queued;
+    }
+    if (delivered) {
+        *delivered = awn_config_updates_delivered;
+    }
+}
@@ -33,6 +33,21 @@ DesktopAgnosticConfigClient* awn_config_get_default_for_applet(AwnApplet* applet
 DesktopAgnosticConfigClient* awn_config_get_default_for_applet_by_info(const gchar* name, const gchar* uid, GError** error);
 void                         awn_config_free(void);
 
+/**
+ * AwnConfigUpdateFunc:
+ * @object: the object whose bound settings changed.
+ *
+ * Applies all the changes queued for @object since its last update, see
+ * awn_config_queue_update().
+ */
+typedef void (*AwnConfigUpdateFunc)(GObject* object);
+
+void                         awn_config_begin_update(DesktopAgnosticConfigClient* client);
+void                         awn_config_end_update(DesktopAgnosticConfigClient* client, GError** error);
+void                         awn_config_set_value(DesktopAgnosticConfigClient* client, const gchar* group, const gchar* key, const GValue* value, GError** error);
+void                         awn_config_queue_update(DesktopAgnosticConfigClient* client, GObject* object, AwnConfigUpdateFunc func);
+void                         awn_config_get_update_stats(guint* queued, guint* delivered);
+
 #ifdef __cplusplus
 } // extern "C"
 #endif
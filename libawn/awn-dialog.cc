@@ -36,6 +36,7 @@
 #include "awn-defines.h"
 #include "awn-utils.h"
 #include "awn-overlayable.h"
+#include "awn-shape.h"
 
 #include "gseal-transition.h"
 
@@ -148,10 +149,9 @@ _on_composited_changed(GtkWidget* widget, gpointer data)
 {
     GtkAllocation alloc;
 
-    if (gtk_widget_is_composited(widget)) {
-        gtk_widget_shape_combine_mask(widget, NULL, 0, 0);
-    } else {
-        gtk_widget_input_shape_combine_mask(widget, NULL, 0, 0);
+    if (gtk_widget_get_window(widget)) {
+        awn_shape_apply(gtk_widget_get_window(widget),
+                        !gtk_widget_is_composited(widget), NULL);
     }
 
     gtk_widget_get_allocation(widget, &alloc);
@@ -607,36 +607,27 @@ _on_active_changed(GObject* dialog, GParamSpec* spec, gpointer null)
 static void
 awn_dialog_set_masks(GtkWidget* widget, gint width, gint height)
 {
-    GdkBitmap* shaped_bitmap;
-    shaped_bitmap = (GdkBitmap*) gdk_pixmap_new(NULL, width, height, 1);
+    GdkWindow* window = gtk_widget_get_window(widget);
+    cairo_surface_t* scratch;
+    cairo_t* cr;
+    GdkRegion* region;
 
-    if (shaped_bitmap) {
-        cairo_t* cr = gdk_cairo_create(shaped_bitmap);
+    if (!window) {
+        return;
+    }
 
-        cairo_set_operator(cr, CAIRO_OPERATOR_CLEAR);
-        cairo_paint(cr);
+    /* only the path is needed, it's never painted */
+    scratch = cairo_image_surface_create(CAIRO_FORMAT_A1, 1, 1);
+    cr = cairo_create(scratch);
 
-        cairo_set_operator(cr, CAIRO_OPERATOR_OVER);
-        cairo_set_source_rgb(cr, 1.0, 1.0, 1.0);
-        cairo_translate(cr, 0.5, 0.5);
-        awn_dialog_paint_border_path(AWN_DIALOG(widget), cr, width, height);
+    awn_dialog_paint_border_path(AWN_DIALOG(widget), cr, width, height);
+    region = awn_shape_region_from_outline(cr);
 
-        cairo_fill_preserve(cr);
-        cairo_set_line_width(cr, 1.0);
-        cairo_stroke(cr);
-
-        cairo_destroy(cr);
-
-        if (gtk_widget_is_composited(widget)) {
-            gtk_widget_input_shape_combine_mask(widget, NULL, 0, 0);
-            gtk_widget_input_shape_combine_mask(widget, shaped_bitmap, 0, 0);
-        } else {
-            gtk_widget_shape_combine_mask(widget, NULL, 0, 0);
-            gtk_widget_shape_combine_mask(widget, shaped_bitmap, 0, 0);
-        }
+    cairo_destroy(cr);
+    cairo_surface_destroy(scratch);
 
-        g_object_unref(shaped_bitmap);
-    }
+    awn_shape_apply(window, gtk_widget_is_composited(widget), region);
+    gdk_region_destroy(region);
 }
 
 static gboolean
@@ -20,6 +20,7 @@
  */
 
 #include "awn-effects-ops-helpers.h"
+#include "awn-trace.h"
 
 
 void
@@ -220,6 +221,7 @@ lighten_surface(cairo_surface_t* src,
 
     g_return_if_fail(src);
 
+    awn_trace_count(AWN_TRACE_SURFACES_CREATED);
     temp_srfc = cairo_surface_create_similar(src,
                 CAIRO_CONTENT_COLOR_ALPHA,
                 surface_width, surface_height);
@@ -277,6 +279,7 @@ blur_surface_shadow_rgba(cairo_surface_t* src,
     g_return_if_fail(src);
 
     /* the original stuff */
+    awn_trace_count(AWN_TRACE_SURFACES_CREATED);
     temp_srfc = cairo_image_surface_create(CAIRO_FORMAT_ARGB32,
                                            surface_width, surface_height);
     temp_ctx = cairo_create(temp_srfc);
@@ -285,6 +288,7 @@ blur_surface_shadow_rgba(cairo_surface_t* src,
     cairo_paint(temp_ctx);
 
     /* the stuff we draw to */
+    awn_trace_count(AWN_TRACE_SURFACES_CREATED);
     temp_srfc_dest = cairo_image_surface_create(CAIRO_FORMAT_ARGB32,
                      surface_width, surface_height);
     temp_ctx_dest = cairo_create(temp_srfc_dest);
@@ -440,6 +444,7 @@ surface_saturate_and_pixelate(cairo_surface_t* src,
     g_return_if_fail(cairo_xlib_surface_get_width(src) ==
                      cairo_xlib_surface_get_width(dest));
 
+    awn_trace_count(AWN_TRACE_SURFACES_CREATED);
     temp_dest_srfc = cairo_image_surface_create(CAIRO_FORMAT_ARGB32,
                      cairo_xlib_surface_get_width(dest),
                      cairo_xlib_surface_get_height(dest)
@@ -453,6 +458,7 @@ surface_saturate_and_pixelate(cairo_surface_t* src,
     if (src == dest) {
         temp_src_srfc = temp_dest_srfc;
     } else {
+        awn_trace_count(AWN_TRACE_SURFACES_CREATED);
         temp_src_srfc = cairo_image_surface_create(CAIRO_FORMAT_ARGB32,
                         cairo_xlib_surface_get_width(src),
                         cairo_xlib_surface_get_height(src)
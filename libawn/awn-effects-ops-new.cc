@@ -18,9 +18,12 @@
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <string.h>
+
 #include "awn-effects-ops-new.h"
 #include "awn-effects-ops-helpers.h"
 #include "awn-cairo-utils.h"
+#include "awn-trace.h"
 
 #include "anims/awn-effects-shared.h"
 
@@ -34,6 +37,229 @@ cairo_surface_t* awn_effects_quark_to_surface(AwnEffects* fx, GQuark quark)
     return surface;
 }
 
+/*
+ * Effect assets are surfaces derived from the effect images which depend
+ * only on the icon size and orientation (eg. the spotlight scaled and
+ * rotated for the icon), so they're shared by all AwnEffects instances of
+ * the process. They're immutable once built. The registry holds a
+ * reference to each of them and an AwnEffects instance holds another one
+ * while it's at that size; assets nobody holds anymore are dropped
+ * whenever a new one is built.
+ */
+typedef struct {
+    GQuark          asset;
+    gint            width;
+    gint            height;
+    GtkPositionType orientation;
+    guint32         color;      /* RGBA, 0 for untinted assets */
+} AwnEffectsAssetKey;
+
+typedef void (*AwnEffectsAssetBuildFunc)(cairo_t*                  cr,
+        const AwnEffectsAssetKey* key,
+        cairo_surface_t*          source);
+
+static GHashTable* effect_assets = NULL;
+static guint effect_asset_hits = 0;
+static guint effect_asset_misses = 0;
+
+static guint
+asset_key_hash(gconstpointer data)
+{
+    const AwnEffectsAssetKey* key = (const AwnEffectsAssetKey*)data;
+
+    return key->asset ^ (key->width << 20) ^ (key->height << 8) ^
+           (key->orientation << 28) ^ key->color;
+}
+
+static gboolean
+asset_key_equal(gconstpointer a, gconstpointer b)
+{
+    return memcmp(a, b, sizeof(AwnEffectsAssetKey)) == 0;
+}
+
+static void
+asset_key_free(gpointer data)
+{
+    g_slice_free(AwnEffectsAssetKey, data);
+}
+
+static gboolean
+asset_is_unused(gpointer key, gpointer value, gpointer user_data)
+{
+    return cairo_surface_get_reference_count((cairo_surface_t*)value) == 1;
+}
+
+/* returns a borrowed reference to the asset, building it if needed */
+static cairo_surface_t*
+awn_effects_get_asset(const AwnEffectsAssetKey* key,
+                      AwnEffectsAssetBuildFunc build,
+                      cairo_surface_t* source)
+{
+    cairo_surface_t* asset;
+    cairo_t* cr;
+
+    if (!effect_assets) {
+        effect_assets = g_hash_table_new_full(asset_key_hash, asset_key_equal,
+                                              asset_key_free,
+                                              (GDestroyNotify)cairo_surface_destroy);
+    }
+
+    asset = (cairo_surface_t*)g_hash_table_lookup(effect_assets, key);
+    if (asset) {
+        effect_asset_hits++;
+        return asset;
+    }
+    effect_asset_misses++;
+
+    g_hash_table_foreach_remove(effect_assets, asset_is_unused, NULL);
+
+    awn_trace_count(AWN_TRACE_SURFACES_CREATED);
+    asset = cairo_image_surface_create(CAIRO_FORMAT_ARGB32,
+                                       key->width, key->height);
+    cr = cairo_create(asset);
+    build(cr, key, source);
+    cairo_destroy(cr);
+    cairo_surface_flush(asset);
+
+    g_hash_table_insert(effect_assets, g_slice_dup(AwnEffectsAssetKey, key),
+                        asset);
+    return asset;
+}
+
+/**
+ * awn_effects_get_asset_stats:
+ * @hits: Return location for the number of lookups of an already built
+ * asset, or %NULL.
+ * @misses: Return location for the number of assets built, or %NULL.
+ *
+ * Gets the counters of the process-wide effect asset registry.
+ */
+void
+awn_effects_get_asset_stats(guint* hits, guint* misses)
+{
+    if (hits) {
+        *hits = effect_asset_hits;
+    }
+    if (misses) {
+        *misses = effect_asset_misses;
+    }
+}
+
+static void
+build_spotlight(cairo_t* cr, const AwnEffectsAssetKey* key,
+                cairo_surface_t* srfc)
+{
+    float srfc_width = cairo_image_surface_get_width(srfc);
+    float srfc_height = cairo_image_surface_get_height(srfc);
+
+    /* same transformation as painting the image right into the window */
+    switch (key->orientation) {
+    case GTK_POS_TOP:
+        cairo_translate(cr, key->width, key->height);
+        cairo_scale(cr, key->width / srfc_width, key->height / srfc_height);
+        cairo_rotate(cr, M_PI);
+        break;
+    case GTK_POS_RIGHT:
+        cairo_translate(cr, 0, key->height);
+        cairo_scale(cr, key->width / srfc_height, key->height / srfc_width);
+        cairo_rotate(cr, -M_PI / 2);
+        break;
+    case GTK_POS_LEFT:
+        cairo_translate(cr, key->width, 0);
+        cairo_scale(cr, key->width / srfc_height, key->height / srfc_width);
+        cairo_rotate(cr, M_PI / 2);
+        break;
+    default: /* GTK_POS_BOTTOM: */
+        cairo_scale(cr, key->width / srfc_width, key->height / srfc_height);
+        break;
+    }
+
+    cairo_set_source_surface(cr, srfc, 0, 0);
+    cairo_paint(cr);
+}
+
+/*
+ * Returns the spotlight scaled and rotated for the current size and
+ * position, and where it goes in the window. @fx keeps a reference to it.
+ */
+static cairo_surface_t*
+awn_effects_get_spotlight(AwnEffects* fx, gint* x, gint* y)
+{
+    AwnEffectsPrivate* priv = fx->priv;
+    AwnEffectsAssetKey key;
+    cairo_surface_t* srfc;
+    cairo_surface_t* asset;
+    /* the spotlight is 5/4 of the icon high, 1/12 of it is below the icon */
+    gint length = priv->icon_height * 5 / 4;
+    gint base = priv->icon_height - priv->icon_height / 12 + fx->icon_offset;
+
+    srfc = awn_effects_quark_to_surface(fx, fx->spotlight_icon);
+    if (!srfc || length <= 0) {
+        return NULL;
+    }
+
+    key.asset = fx->spotlight_icon;
+    key.orientation = fx->position;
+    key.color = 0;
+    switch (fx->position) {
+    case GTK_POS_TOP:
+        *x = 0;
+        *y = base - length;
+        key.width = priv->window_width;
+        key.height = length;
+        break;
+    case GTK_POS_RIGHT:
+        *x = priv->window_width - base;
+        *y = 0;
+        key.width = length;
+        key.height = priv->window_height;
+        break;
+    case GTK_POS_BOTTOM:
+        *x = 0;
+        *y = priv->window_height - base;
+        key.width = priv->window_width;
+        key.height = length;
+        break;
+    case GTK_POS_LEFT:
+        *x = base - length;
+        *y = 0;
+        key.width = length;
+        key.height = priv->window_height;
+        break;
+    default:
+        return NULL;
+    }
+    if (key.width <= 0 || key.height <= 0) {
+        return NULL;
+    }
+
+    asset = awn_effects_get_asset(&key, build_spotlight, srfc);
+    if (asset != priv->spotlight_asset) {
+        if (priv->spotlight_asset) {
+            cairo_surface_destroy(priv->spotlight_asset);
+        }
+        priv->spotlight_asset = cairo_surface_reference(asset);
+    }
+    return asset;
+}
+
+/**
+ * awn_effects_warm_assets:
+ * @fx: #AwnEffects instance.
+ *
+ * Builds the assets of @fx for its current size ahead of the next
+ * animation. Only assets which @fx has used before are built.
+ */
+void
+awn_effects_warm_assets(AwnEffects* fx)
+{
+    gint x, y;
+
+    if (fx->priv->spotlight_asset) {
+        awn_effects_get_spotlight(fx, &x, &y);
+    }
+}
+
 /* returns top left coordinates of the icon (without clipping and offsets) */
 void
 awn_effects_get_base_coords(AwnEffects* fx, double* x, double* y)
@@ -538,6 +764,7 @@ gboolean awn_effects_post_op_depth(AwnEffects* fx,
         /* FIXME: we really could use the GtkAllocation here for optimization
          * copy current surface look into temp one
          */
+        awn_trace_count(AWN_TRACE_SURFACES_CREATED);
         cairo_surface_t* srfc = cairo_surface_create_similar(cairo_get_target(cr),
                                 CAIRO_CONTENT_COLOR_ALPHA,
                                 priv->window_width,
@@ -596,6 +823,7 @@ gboolean awn_effects_post_op_shadow(AwnEffects* fx,
         cairo_t* blur_ctx;
 
         int w = priv->window_width, h = priv->window_height;
+        awn_trace_count(AWN_TRACE_SURFACES_CREATED);
         blur_srfc = cairo_surface_create_similar(cairo_get_target(cr),
                     CAIRO_CONTENT_COLOR_ALPHA,
                     w,
@@ -634,56 +862,15 @@ gboolean awn_effects_post_op_spotlight(AwnEffects* fx,
     AwnEffectsPrivate* priv = fx->priv;
 
     if (priv->spotlight && priv->spotlight_alpha > 0) {
-        cairo_surface_t* srfc =
-            awn_effects_quark_to_surface(fx, fx->spotlight_icon);
+        gint x, y;
+        cairo_surface_t* srfc = awn_effects_get_spotlight(fx, &x, &y);
         if (!srfc) {
             return FALSE;
         }
 
-        float srfc_width = cairo_image_surface_get_width(srfc);
-        float srfc_height = cairo_image_surface_get_height(srfc);
-
         cairo_save(cr);
-        double x, y, rotate = 0;
-        switch (fx->position) {
-        case GTK_POS_TOP:
-            x = priv->window_width;
-            y = priv->icon_height - priv->icon_height / 12;
-            y += fx->icon_offset;
-            rotate = M_PI;
-            break;
-        case GTK_POS_RIGHT:
-            x = priv->window_width - priv->icon_height + priv->icon_height / 12;
-            x -= fx->icon_offset;
-            y = priv->window_height;
-            rotate = -M_PI / 2;
-            break;
-        case GTK_POS_BOTTOM:
-            x = 0;
-            y = priv->window_height - priv->icon_height + priv->icon_height / 12;
-            y -= fx->icon_offset;
-            break;
-        case GTK_POS_LEFT:
-            x = priv->icon_height - priv->icon_height / 12;
-            x += fx->icon_offset;
-            y = 0;
-            rotate = M_PI / 2;
-            break;
-        default:
-            return FALSE;
-        }
-        cairo_translate(cr, x, y);
-        if (fx->position == GTK_POS_TOP ||
-                fx->position == GTK_POS_BOTTOM) {
-            cairo_scale(cr, priv->window_width / srfc_width,
-                        priv->icon_height * 5 / 4 / srfc_height);
-        } else {
-            cairo_scale(cr, priv->icon_height * 5 / 4 / srfc_height,
-                        priv->window_height / srfc_width);
-        }
-        cairo_rotate(cr, rotate);
 
-        cairo_set_source_surface(cr, srfc, 0, 0);
+        cairo_set_source_surface(cr, srfc, x, y);
         cairo_set_operator(cr, CAIRO_OPERATOR_DEST_OVER);
         cairo_paint_with_alpha(cr, priv->spotlight_alpha);
         cairo_set_operator(cr, CAIRO_OPERATOR_OVER);
@@ -730,6 +917,7 @@ gboolean awn_effects_post_op_reflection(AwnEffects* fx,
         int dx = priv->window_width - fx->icon_offset * 2 - fx->refl_offset;
         int dy = priv->window_height - fx->icon_offset * 2 - fx->refl_offset;
 
+        awn_trace_count(AWN_TRACE_SURFACES_CREATED);
         cairo_surface_t* srfc = cairo_surface_create_similar(cairo_get_target(cr),
                                 CAIRO_CONTENT_COLOR_ALPHA,
                                 priv->window_width,
@@ -23,6 +23,10 @@
 
 void awn_effects_get_base_coords(AwnEffects* fx, double* x, double* y);
 
+void awn_effects_warm_assets(AwnEffects* fx);
+
+void awn_effects_get_asset_stats(guint* hits, guint* misses);
+
 gboolean awn_effects_pre_op_clear(AwnEffects* fx,
                                   cairo_t* cr,
                                   GtkAllocation* ds,
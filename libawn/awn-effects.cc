@@ -32,6 +32,7 @@
 #include <cairo/cairo-xlib.h>
 
 #include "gseal-transition.h"
+#include "awn-trace.h"
 
 #include "anims/awn-effects-shared.h"
 
@@ -164,6 +165,11 @@ awn_effects_finalize(GObject* object)
         fx->priv->effect_queue = NULL;
     }
 
+    if (fx->priv->spotlight_asset) {
+        cairo_surface_destroy(fx->priv->spotlight_asset);
+        fx->priv->spotlight_asset = NULL;
+    }
+
     G_OBJECT_CLASS(awn_effects_parent_class)->finalize(object);
 }
 
@@ -453,12 +459,24 @@ awn_effects_set_property(GObject*      object,
     }
 }
 
+static void
+awn_effects_config_changed(GObject* object)
+{
+    awn_effects_redraw(AWN_EFFECTS(object));
+}
+
 static void
 awn_effects_prop_changed(GObject* object, GParamSpec* pspec)
 {
-    AwnEffects* fx = AWN_EFFECTS(object);
+    DesktopAgnosticConfigClient* client;
 
-    awn_effects_redraw(fx);
+    /* many properties are bound to config keys, redraw once per change set */
+    client = awn_config_get_default(AWN_PANEL_ID_DEFAULT, NULL);
+    if (client) {
+        awn_config_queue_update(client, object, awn_effects_config_changed);
+    } else {
+        awn_effects_config_changed(object);
+    }
 }
 
 /**
@@ -1375,6 +1393,7 @@ cairo_t* awn_effects_cairo_create_clipped(AwnEffects* fx,
     cairo_t* cr;
     GtkAllocation alloc;
 
+    priv->trace_start = awn_trace_begin();
     cr = gdk_cairo_create(gtk_widget_get_window(fx->widget));
     g_return_val_if_fail(cairo_status(cr) == CAIRO_STATUS_SUCCESS, NULL);
     fx->window_ctx = cr;
@@ -1385,8 +1404,13 @@ cairo_t* awn_effects_cairo_create_clipped(AwnEffects* fx,
      * which seems to work just fine.
      */
     gtk_widget_get_allocation(fx->widget, &alloc);
-    priv->window_width = alloc.width;
-    priv->window_height = alloc.height;
+    if (alloc.width != priv->window_width ||
+            alloc.height != priv->window_height) {
+        priv->window_width = alloc.width;
+        priv->window_height = alloc.height;
+        /* size changed, get the assets ready before the next animation */
+        awn_effects_warm_assets(fx);
+    }
 
     if (event) {
         /* clip the region */
@@ -1422,6 +1446,7 @@ cairo_t* awn_effects_cairo_create_clipped(AwnEffects* fx,
     if (fx->indirect_paint) {
         cairo_surface_t* targetSurface = cairo_get_target(cr);
         /* we'll give to user virtual context and later paint everything on real one */
+        awn_trace_count(AWN_TRACE_SURFACES_CREATED);
         targetSurface = cairo_surface_create_similar(targetSurface,
                         CAIRO_CONTENT_COLOR_ALPHA,
                         priv->window_width,
@@ -1538,6 +1563,9 @@ void awn_effects_cairo_destroy(AwnEffects* fx)
 
     fx->window_ctx = NULL;
     fx->virtual_ctx = NULL;
+
+    awn_trace_end(AWN_TRACE_EFFECT_FRAME, fx->priv->trace_start);
+    fx->priv->trace_start = 0;
 }
 
 /**
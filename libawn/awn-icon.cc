@@ -24,6 +24,8 @@
 #include "awn-icon.h"
 #include "awn-utils.h"
 #include "awn-overlayable.h"
+#include "awn-tooltip-pool.h"
+#include "awn-trace.h"
 
 #include "gseal-transition.h"
 
@@ -45,6 +47,8 @@ extern "C" {
 
 struct _AwnIconPrivate {
     AwnEffects*   effects;
+    /* only created when someone asks for a dedicated tooltip,
+     * otherwise the icon is served by the shared tooltip pool */
     GtkWidget*    tooltip;
 
     gboolean bind_effects;
@@ -469,6 +473,8 @@ awn_icon_dispose(GObject* object)
 
     if (priv->tooltip) {
         gtk_widget_destroy(priv->tooltip);
+    } else {
+        awn_tooltip_pool_detach(GTK_WIDGET(object));
     }
     priv->tooltip = NULL;
 
@@ -623,7 +629,8 @@ awn_icon_init(AwnIcon* icon)
     priv->size = 50;
     priv->icon_width = 0;
     priv->icon_height = 0;
-    priv->tooltip = awn_tooltip_new_for_widget(GTK_WIDGET(icon));
+    priv->tooltip = NULL;
+    awn_tooltip_pool_attach(GTK_WIDGET(icon));
 
     priv->effects = awn_effects_new_for_widget(GTK_WIDGET(icon));
     gtk_widget_add_events(GTK_WIDGET(icon), GDK_ALL_EVENTS_MASK);
@@ -683,8 +690,13 @@ awn_icon_update_tooltip_pos(AwnIcon* icon)
         break;
     }
 
-    awn_tooltip_set_position_hint(AWN_TOOLTIP(priv->tooltip),
-                                  priv->position, tooltip_offset);
+    if (priv->tooltip) {
+        awn_tooltip_set_position_hint(AWN_TOOLTIP(priv->tooltip),
+                                      priv->position, tooltip_offset);
+    } else {
+        awn_tooltip_pool_set_position_hint(GTK_WIDGET(icon),
+                                           priv->position, tooltip_offset);
+    }
 }
 
 /**
@@ -859,16 +871,32 @@ awn_icon_get_effects(AwnOverlayable* icon)
  * awn_icon_get_tooltip:
  * @icon: an #AwnIcon.
  *
- * Gets the #AwnTooltip associated with this icon.
+ * Gets the #AwnTooltip associated with this icon. Icons share a single
+ * tooltip window by default, calling this function gives the icon its own
+ * dedicated tooltip which can be customized freely.
  *
  * Returns: tooltip widget.
  */
 AwnTooltip*
 awn_icon_get_tooltip(AwnIcon* icon)
 {
+    AwnIconPrivate* priv;
+
     g_return_val_if_fail(AWN_IS_ICON(icon), NULL);
+    priv = icon->priv;
 
-    return AWN_TOOLTIP(icon->priv->tooltip);
+    if (priv->tooltip == NULL) {
+        GtkWidget* widget = GTK_WIDGET(icon);
+
+        priv->tooltip = awn_tooltip_new_for_widget(widget);
+        awn_tooltip_set_text(AWN_TOOLTIP(priv->tooltip),
+                             awn_tooltip_pool_get_text(widget));
+        awn_tooltip_pool_detach(widget);
+
+        awn_icon_update_tooltip_pos(icon);
+    }
+
+    return AWN_TOOLTIP(priv->tooltip);
 }
 
 /*
@@ -887,38 +915,138 @@ free_existing_icon(AwnIcon* icon)
     priv->icon_srfc = NULL;
 }
 
+/*
+ * Converted (premultiplied) icon surfaces are shared between all icons
+ * showing the same image, keyed by the size and a hash of the pixel data.
+ * The table doesn't hold a reference, the entry goes away together with
+ * the surface when the last icon drops it.
+ */
+typedef struct {
+    gint    width;
+    gint    height;
+    gboolean has_alpha;
+    guint64 hash;
+} AwnIconSurfaceKey;
+
+static GHashTable* icon_surfaces = NULL;
+static const cairo_user_data_key_t icon_surface_key = { 0 };
+
+static guint
+awn_icon_surface_key_hash(gconstpointer key)
+{
+    const AwnIconSurfaceKey* k = (const AwnIconSurfaceKey*)key;
+    return (guint)(k->hash ^ (k->hash >> 32));
+}
+
+static gboolean
+awn_icon_surface_key_equal(gconstpointer a, gconstpointer b)
+{
+    const AwnIconSurfaceKey* ka = (const AwnIconSurfaceKey*)a;
+    const AwnIconSurfaceKey* kb = (const AwnIconSurfaceKey*)b;
+
+    return ka->hash == kb->hash && ka->width == kb->width &&
+           ka->height == kb->height && ka->has_alpha == kb->has_alpha;
+}
+
+static void
+awn_icon_surface_key_init(AwnIconSurfaceKey* key, GdkPixbuf* pixbuf)
+{
+    const guchar* pixels = gdk_pixbuf_get_pixels(pixbuf);
+    gint rowstride = gdk_pixbuf_get_rowstride(pixbuf);
+    gint row_len;
+    /* FNV-1a, cheap compared to the conversion it saves */
+    guint64 hash = G_GUINT64_CONSTANT(14695981039346656037);
+
+    key->width = gdk_pixbuf_get_width(pixbuf);
+    key->height = gdk_pixbuf_get_height(pixbuf);
+    key->has_alpha = gdk_pixbuf_get_has_alpha(pixbuf);
+    row_len = key->width * gdk_pixbuf_get_n_channels(pixbuf);
+
+    for (gint y = 0; y < key->height; y++) {
+        const guchar* row = pixels + y * rowstride;
+        for (gint x = 0; x < row_len; x++) {
+            hash ^= row[x];
+            hash *= G_GUINT64_CONSTANT(1099511628211);
+        }
+    }
+    key->hash = hash;
+}
+
+static void
+awn_icon_surface_destroyed(gpointer data)
+{
+    AwnIconSurfaceKey* key = (AwnIconSurfaceKey*)data;
+
+    if (icon_surfaces) {
+        g_hash_table_remove(icon_surfaces, key);
+    }
+    g_free(key);
+}
+
+static cairo_surface_t*
+awn_icon_get_surface_for_pixbuf(GdkPixbuf* pixbuf)
+{
+    AwnIconSurfaceKey  lookup;
+    AwnIconSurfaceKey* key;
+    cairo_surface_t*   surface;
+    cairo_t*           temp_cr;
+
+    if (!icon_surfaces) {
+        icon_surfaces = g_hash_table_new(awn_icon_surface_key_hash,
+                                         awn_icon_surface_key_equal);
+    }
+
+    awn_icon_surface_key_init(&lookup, pixbuf);
+    surface = (cairo_surface_t*)g_hash_table_lookup(icon_surfaces, &lookup);
+    if (surface) {
+        return cairo_surface_reference(surface);
+    }
+
+    /* Render the pixbuf into a image surface */
+    awn_trace_count(AWN_TRACE_SURFACES_CREATED);
+    surface = cairo_image_surface_create(CAIRO_FORMAT_ARGB32,
+                                         lookup.width, lookup.height);
+    temp_cr = cairo_create(surface);
+
+    gdk_cairo_set_source_pixbuf(temp_cr, pixbuf, 0, 0);
+    cairo_paint(temp_cr);
+
+    cairo_destroy(temp_cr);
+
+    if (cairo_surface_status(surface) != CAIRO_STATUS_SUCCESS) {
+        return surface;
+    }
+
+    key = (AwnIconSurfaceKey*)g_memdup(&lookup, sizeof(AwnIconSurfaceKey));
+    cairo_surface_set_user_data(surface, &icon_surface_key, key,
+                                awn_icon_surface_destroyed);
+    g_hash_table_insert(icon_surfaces, key, surface);
+
+    return surface;
+}
+
 /**
  * awn_icon_set_from_pixbuf:
  * @icon: an #AwnIcon.
  * @pixbuf: a #GdkPixbuf.
  *
- * Sets the icon from the given pixbuf. Note that a copy of the pixbuf is made.
+ * Sets the icon from the given pixbuf. Note that a copy of the pixbuf is made,
+ * which is shared with other icons showing identical pixel data.
  */
 void
 awn_icon_set_from_pixbuf(AwnIcon* icon, GdkPixbuf* pixbuf)
 {
     AwnIconPrivate*  priv;
-    cairo_t*         temp_cr;
-    gint             width, height;
+    cairo_surface_t* surface;
 
     g_return_if_fail(AWN_IS_ICON(icon));
     g_return_if_fail(GDK_IS_PIXBUF(pixbuf));
     priv = icon->priv;
 
+    /* looked up first, the old surface might be the one we need */
+    surface = awn_icon_get_surface_for_pixbuf(pixbuf);
     free_existing_icon(icon);
-
-    /* Render the pixbuf into a image surface */
-    width = gdk_pixbuf_get_width(pixbuf);
-    height = gdk_pixbuf_get_height(pixbuf);
-
-    priv->icon_srfc = cairo_image_surface_create(CAIRO_FORMAT_ARGB32,
-                      width, height);
-    temp_cr = cairo_create(priv->icon_srfc);
-
-    gdk_cairo_set_source_pixbuf(temp_cr, pixbuf, 0, 0);
-    cairo_paint(temp_cr);
-
-    cairo_destroy(temp_cr);
+    priv->icon_srfc = surface;
 
     /* Queue a redraw */
     update_widget_size(icon);
@@ -1029,7 +1157,11 @@ awn_icon_set_tooltip_text(AwnIcon*     icon,
 {
     g_return_if_fail(AWN_IS_ICON(icon));
 
-    awn_tooltip_set_text(AWN_TOOLTIP(icon->priv->tooltip), text);
+    if (icon->priv->tooltip) {
+        awn_tooltip_set_text(AWN_TOOLTIP(icon->priv->tooltip), text);
+    } else {
+        awn_tooltip_pool_set_text(GTK_WIDGET(icon), text);
+    }
 }
 
 /**
@@ -1046,7 +1178,11 @@ awn_icon_get_tooltip_text(AwnIcon* icon)
 {
     g_return_val_if_fail(AWN_IS_ICON(icon), NULL);
 
-    return awn_tooltip_get_text(AWN_TOOLTIP(icon->priv->tooltip));
+    if (icon->priv->tooltip) {
+        return awn_tooltip_get_text(AWN_TOOLTIP(icon->priv->tooltip));
+    }
+
+    return g_strdup(awn_tooltip_pool_get_text(GTK_WIDGET(icon)));
 }
 
 /**
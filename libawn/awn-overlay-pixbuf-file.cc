@@ -48,6 +48,7 @@
 #include <math.h>
 
 #include "awn-overlay-pixbuf-file.h"
+#include "awn-pixbuf-cache.h"
 
 extern "C" {
     G_DEFINE_TYPE(AwnOverlayPixbufFile, awn_overlay_pixbuf_file, AWN_TYPE_OVERLAY_PIXBUF)
@@ -216,8 +217,6 @@ awn_overlay_pixbuf_file_new(gchar* file_name)
  FIXME
 
  This function needs a little bit of work.  It can be cleaner.
-
- Also need to decide if it merits pixbuf caching... probably a good idea
  */
 
 static void
@@ -295,10 +294,11 @@ awn_overlay_pixbuf_file_load(AwnOverlayPixbufFile* overlay,
                            scaled_width /
                            priv->icon_width);
 
-    pixbuf = gdk_pixbuf_new_from_file_at_scale(file_name,
-             scaled_width,
-             scaled_height,
-             TRUE, NULL);
+    /* clients tend to flip between a couple of files, keep them decoded */
+    pixbuf = awn_pixbuf_cache_load_file(awn_pixbuf_cache_get_default(),
+                                        file_name,
+                                        scaled_width,
+                                        scaled_height);
     if (pixbuf) {
         g_object_set(overlay,
                      "pixbuf", pixbuf,
@@ -46,6 +46,7 @@
 #include <math.h>
 
 #include "awn-overlay-pixbuf.h"
+#include "awn-trace.h"
 
 enum {
     PROP_0,
@@ -283,6 +284,7 @@ _awn_overlay_pixbuf_render(AwnOverlay* _overlay,
             g_object_ref(priv->pixbuf);
             priv->scaled_pixbuf = priv->pixbuf;
         } else {
+            awn_trace_count(AWN_TRACE_PIXBUFS_SCALED);
             priv->scaled_pixbuf = gdk_pixbuf_scale_simple(priv->pixbuf,
                                   scaled_width,
                                   scaled_height,
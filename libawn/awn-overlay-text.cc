@@ -36,12 +36,15 @@
 
 /* awn-overlay-text.c */
 
+#include <string.h>
+#include <math.h>
 #include <gtk/gtk.h>
 #include <pango/pangocairo.h>
 
 #include "awn-config.h"
 #include "awn-overlay-text.h"
 #include "awn-cairo-utils.h"
+#include "awn-trace.h"
 
 extern "C" {
     G_DEFINE_TYPE(AwnOverlayText, awn_overlay_text, AWN_TYPE_OVERLAY)
@@ -64,6 +67,29 @@ struct _AwnOverlayTextPrivate {
     gdouble                text_outline_width;
 
     DesktopAgnosticConfigClient* client;
+
+    /* shaped layout, valid for layout_size while layout_dirty is FALSE */
+    PangoLayout*           layout;
+    gboolean               layout_dirty;
+    gint                   layout_size;
+    gint                   layout_width;
+    gint                   layout_height;
+
+    /* pre-rasterized text (and outline), offset from the layout origin */
+    cairo_surface_t*       text_srfc;
+    gboolean               srfc_dirty;
+    gint                   srfc_x;
+    gint                   srfc_y;
+    gdouble                srfc_frac_x; /* subpixel offset of the text */
+    gdouble                srfc_frac_y;
+    gdouble                srfc_colors[8];
+
+    /* last awn_overlay_text_get_size query */
+    PangoLayout*           size_layout;
+    gchar*                 size_text;
+    gint                   size_size;
+    gint                   size_width;
+    gint                   size_height;
 };
 
 enum {
@@ -91,6 +117,19 @@ _awn_overlay_text_render(AwnOverlay* overlay,
                          gint width,
                          gint height);
 
+static void
+awn_overlay_text_invalidate(AwnOverlayText* overlay, gboolean reshape)
+{
+    AwnOverlayTextPrivate* priv = AWN_OVERLAY_TEXT_GET_PRIVATE(overlay);
+
+    if (reshape) {
+        priv->layout_dirty = TRUE;
+        g_free(priv->size_text);
+        priv->size_text = NULL;
+    }
+    priv->srfc_dirty = TRUE;
+}
+
 static void
 awn_overlay_text_get_property(GObject* object, guint property_id,
                               GValue* value, GParamSpec* pspec)
@@ -138,10 +177,15 @@ awn_overlay_text_set_property(GObject* object, guint property_id,
     switch (property_id) {
     case PROP_FONT_SIZING:
         priv->font_sizing = g_value_get_double(value);
+        awn_overlay_text_invalidate(AWN_OVERLAY_TEXT(object), TRUE);
         break;
     case PROP_TEXT:
+        if (g_strcmp0(priv->text, g_value_get_string(value)) == 0) {
+            break;
+        }
         g_free(priv->text);
         priv->text = g_value_dup_string(value);
+        awn_overlay_text_invalidate(AWN_OVERLAY_TEXT(object), TRUE);
         break;
     case PROP_TEXT_COLOR:
         if (priv->text_color) {
@@ -165,9 +209,11 @@ awn_overlay_text_set_property(GObject* object, guint property_id,
         break;
     case PROP_FONT_MODE:
         priv->font_mode = g_value_get_int(value);
+        awn_overlay_text_invalidate(AWN_OVERLAY_TEXT(object), FALSE);
         break;
     case PROP_TEXT_OUTLINE_WIDTH:
         priv->text_outline_width = g_value_get_double(value);
+        awn_overlay_text_invalidate(AWN_OVERLAY_TEXT(object), FALSE);
         break;
     default:
         G_OBJECT_WARN_INVALID_PROPERTY_ID(object, property_id, pspec);
@@ -192,6 +238,19 @@ awn_overlay_text_dispose(GObject* object)
         priv->text_outline_color = NULL;
     }
 
+    if (priv->layout) {
+        g_object_unref(priv->layout);
+        priv->layout = NULL;
+    }
+    if (priv->size_layout) {
+        g_object_unref(priv->size_layout);
+        priv->size_layout = NULL;
+    }
+    if (priv->text_srfc) {
+        cairo_surface_destroy(priv->text_srfc);
+        priv->text_srfc = NULL;
+    }
+
     G_OBJECT_CLASS(awn_overlay_text_parent_class)->dispose(object);
 }
 
@@ -217,6 +276,8 @@ awn_overlay_text_finalize(GObject* object)
         g_free(priv->text_outline_color_astr);
     }
 
+    g_free(priv->size_text);
+
     G_OBJECT_CLASS(awn_overlay_text_parent_class)->finalize(object);
 }
 
@@ -392,6 +453,12 @@ awn_overlay_text_init(AwnOverlayText* self)
     priv = AWN_OVERLAY_TEXT_GET_PRIVATE(self);
 
     priv->text = NULL;
+    priv->layout = NULL;
+    priv->layout_dirty = TRUE;
+    priv->text_srfc = NULL;
+    priv->srfc_dirty = TRUE;
+    priv->size_layout = NULL;
+    priv->size_text = NULL;
     // default for text is to not apply effects to it
     awn_overlay_set_apply_effects(AWN_OVERLAY(self), FALSE);
 }
@@ -416,20 +483,167 @@ void awn_overlay_text_get_size(AwnOverlayText* overlay,
                                gint size,
                                gint* width, gint* height)
 {
-    PangoLayout* layout;
     if (size < 1) {
         size = 48;
     }
     g_return_if_fail(AWN_IS_OVERLAY_TEXT(overlay));
     AwnOverlayTextPrivate* priv = AWN_OVERLAY_TEXT_GET_PRIVATE(overlay);
+    const gchar* query = text ? text : priv->text;
+
+    /* repeated size queries for the same text and size are answered from
+     * the last result, the layout itself is kept around as well */
+    if (priv->size_text == NULL || priv->size_size != size ||
+            g_strcmp0(priv->size_text, query) != 0) {
+        if (!priv->size_layout) {
+            priv->size_layout = gtk_widget_create_pango_layout(widget, NULL);
+        }
+
+        pango_font_description_set_absolute_size(priv->font_description,
+                priv->font_sizing * PANGO_SCALE * size / 48.0);
+        pango_layout_set_font_description(priv->size_layout,
+                                          priv->font_description);
+        pango_layout_set_text(priv->size_layout, query, -1);
+        pango_layout_get_pixel_size(priv->size_layout,
+                                    &priv->size_width, &priv->size_height);
+
+        g_free(priv->size_text);
+        priv->size_text = g_strdup(query ? query : "");
+        priv->size_size = size;
+    }
+
+    if (width) {
+        *width = priv->size_width;
+    }
+    if (height) {
+        *height = priv->size_height;
+    }
+}
+
+static void
+awn_overlay_text_ensure_layout(AwnOverlayText* overlay, cairo_t* cr,
+                               gint height)
+{
+    AwnOverlayTextPrivate* priv = AWN_OVERLAY_TEXT_GET_PRIVATE(overlay);
+
+    if (!priv->layout) {
+        priv->layout = pango_cairo_create_layout(cr);
+        priv->layout_dirty = TRUE;
+    }
+
+    if (!priv->layout_dirty && priv->layout_size == height) {
+        return;
+    }
 
-    layout = gtk_widget_create_pango_layout(widget, NULL);
     pango_font_description_set_absolute_size(priv->font_description,
-            priv->font_sizing * PANGO_SCALE * size / 48.0);
-    pango_layout_set_font_description(layout, priv->font_description);
-    pango_layout_set_text(layout, text ? text : priv->text, -1);
-    pango_layout_get_pixel_size(layout, width, height);
-    g_object_unref(layout);
+            priv->font_sizing * PANGO_SCALE * height / 48.0);
+    pango_layout_set_font_description(priv->layout, priv->font_description);
+    pango_layout_set_text(priv->layout, priv->text, -1);
+    pango_layout_get_pixel_size(priv->layout,
+                                &priv->layout_width, &priv->layout_height);
+
+    priv->layout_size = height;
+    priv->layout_dirty = FALSE;
+    priv->srfc_dirty = TRUE;
+}
+
+static void
+awn_overlay_text_paint_layout(AwnOverlayTextPrivate* priv,
+                              cairo_t* cr,
+                              DesktopAgnosticColor* text_colour,
+                              DesktopAgnosticColor* text_outline_colour,
+                              gint height)
+{
+    switch (priv->font_mode) {
+    default:
+    case FONT_MODE_SOLID:
+        awn_cairo_set_source_color(cr, text_colour);
+        pango_cairo_show_layout(cr, priv->layout);
+        break;
+    case FONT_MODE_OUTLINE:
+    case FONT_MODE_OUTLINE_REVERSED:
+        cairo_save(cr);
+
+        cairo_set_line_width(cr, priv->text_outline_width * height / 48.0);
+        // first paint the outline
+        /*conditional operator*/
+        awn_cairo_set_source_color(cr, priv->font_mode == FONT_MODE_OUTLINE ?
+                                   text_outline_colour : text_colour);
+        cairo_set_line_join(cr, CAIRO_LINE_JOIN_ROUND);
+        pango_cairo_layout_path(cr, priv->layout);
+        cairo_stroke_preserve(cr);
+
+        // now the text itself
+        /*conditional operator*/
+        awn_cairo_set_source_color(cr, priv->font_mode == FONT_MODE_OUTLINE ?
+                                   text_colour : text_outline_colour);
+        cairo_fill(cr);
+
+        cairo_restore(cr);
+        break;
+    }
+}
+
+static void
+awn_overlay_text_ensure_surface(AwnOverlayText* overlay, cairo_t* cr,
+                                DesktopAgnosticColor* text_colour,
+                                DesktopAgnosticColor* text_outline_colour,
+                                gint height,
+                                gdouble frac_x,
+                                gdouble frac_y)
+{
+    AwnOverlayTextPrivate* priv = AWN_OVERLAY_TEXT_GET_PRIVATE(overlay);
+    gdouble colors[8];
+    PangoRectangle ink, logical;
+    gint pad, x0, y0, x1, y1;
+    cairo_t* srfc_cr;
+
+    desktop_agnostic_color_get_cairo_color(text_colour, &colors[0], &colors[1],
+                                           &colors[2], &colors[3]);
+    desktop_agnostic_color_get_cairo_color(text_outline_colour, &colors[4],
+                                           &colors[5], &colors[6], &colors[7]);
+
+    if (priv->text_srfc && !priv->srfc_dirty &&
+            frac_x == priv->srfc_frac_x && frac_y == priv->srfc_frac_y &&
+            memcmp(colors, priv->srfc_colors, sizeof(colors)) == 0) {
+        return;
+    }
+
+    if (priv->text_srfc) {
+        cairo_surface_destroy(priv->text_srfc);
+        priv->text_srfc = NULL;
+    }
+
+    pango_layout_get_pixel_extents(priv->layout, &ink, &logical);
+
+    pad = 1;
+    if (priv->font_mode != FONT_MODE_SOLID) {
+        pad += (gint)ceil(priv->text_outline_width * height / 48.0 / 2.0);
+    }
+
+    x0 = MIN(ink.x, logical.x) - pad;
+    y0 = MIN(ink.y, logical.y) - pad;
+    x1 = MAX(ink.x + ink.width, logical.x + logical.width) + pad;
+    y1 = MAX(ink.y + ink.height, logical.y + logical.height) + pad;
+
+    awn_trace_count(AWN_TRACE_SURFACES_CREATED);
+    priv->text_srfc = cairo_surface_create_similar(cairo_get_target(cr),
+                      CAIRO_CONTENT_COLOR_ALPHA,
+                      MAX(x1 - x0, 1) + 1, MAX(y1 - y0, 1) + 1);
+    priv->srfc_x = x0;
+    priv->srfc_y = y0;
+    priv->srfc_frac_x = frac_x;
+    priv->srfc_frac_y = frac_y;
+
+    /* rasterize at the same subpixel offset as painting it directly would */
+    srfc_cr = cairo_create(priv->text_srfc);
+    cairo_move_to(srfc_cr, -x0 + frac_x, -y0 + frac_y);
+    pango_cairo_update_layout(srfc_cr, priv->layout);
+    awn_overlay_text_paint_layout(priv, srfc_cr,
+                                  text_colour, text_outline_colour, height);
+    cairo_destroy(srfc_cr);
+
+    memcpy(priv->srfc_colors, colors, sizeof(colors));
+    priv->srfc_dirty = FALSE;
 }
 
 static void
@@ -443,9 +657,8 @@ _awn_overlay_text_render(AwnOverlay* _overlay,
     DesktopAgnosticColor* text_colour = NULL;
     DesktopAgnosticColor* text_outline_colour = NULL;
     AwnOverlayTextPrivate* priv;
-    gint layout_width;
-    gint layout_height;
-    PangoLayout* layout;
+    AwnOverlayCoord coord;
+    cairo_matrix_t matrix;
 
     priv =  AWN_OVERLAY_TEXT_GET_PRIVATE(overlay);
 
@@ -468,46 +681,36 @@ _awn_overlay_text_render(AwnOverlay* _overlay,
         text_outline_colour = desktop_agnostic_color_new(&widget->style->bg[GTK_STATE_NORMAL], G_MAXUSHORT);
     }
 
-    layout = pango_cairo_create_layout(cr);
-    pango_font_description_set_absolute_size(priv->font_description,
-            priv->font_sizing * PANGO_SCALE * height / 48.0);
-    pango_layout_set_font_description(layout, priv->font_description);
-    pango_layout_set_text(layout, priv->text, -1);
-    pango_layout_get_pixel_size(layout, &layout_width, &layout_height);
-    awn_overlay_move_to(_overlay, cr,  width, height, layout_width, layout_height, NULL);
-
+    awn_overlay_text_ensure_layout(overlay, cr, height);
+    awn_overlay_move_to(_overlay, cr, width, height,
+                        priv->layout_width, priv->layout_height, &coord);
 
-    switch (priv->font_mode) {
-    default:
-    case FONT_MODE_SOLID:
-        awn_cairo_set_source_color(cr, text_colour);
-        pango_cairo_show_layout(cr, layout);
-        break;
-    case FONT_MODE_OUTLINE:
-    case FONT_MODE_OUTLINE_REVERSED:
-        cairo_save(cr);
+    cairo_get_matrix(cr, &matrix);
 
-        cairo_set_line_width(cr, priv->text_outline_width * height / 48.0);
-        // first paint the outline
-        /*conditional operator*/
-        awn_cairo_set_source_color(cr, priv->font_mode == FONT_MODE_OUTLINE ?
-                                   text_outline_colour : text_colour);
-        cairo_set_line_join(cr, CAIRO_LINE_JOIN_ROUND);
-        pango_cairo_layout_path(cr, layout);
-        cairo_stroke_preserve(cr);
+    if (matrix.xx == 1.0 && matrix.yy == 1.0 &&
+            matrix.xy == 0.0 && matrix.yx == 0.0) {
+        /* unscaled target, just blit the pre-rasterized text, at whole
+         * device pixels so it isn't filtered */
+        gdouble frac_x = matrix.x0 + coord.x - floor(matrix.x0 + coord.x);
+        gdouble frac_y = matrix.y0 + coord.y - floor(matrix.y0 + coord.y);
 
-        // now the text itself
-        awn_overlay_move_to(_overlay, cr, width, height,
-                            layout_width, layout_height, NULL);
-        /*conditional operator*/
-        awn_cairo_set_source_color(cr, priv->font_mode == FONT_MODE_OUTLINE ?
-                                   text_colour : text_outline_colour);
-        cairo_fill(cr);
+        awn_overlay_text_ensure_surface(overlay, cr, text_colour,
+                                        text_outline_colour, height,
+                                        frac_x, frac_y);
 
+        cairo_save(cr);
+        cairo_set_source_surface(cr, priv->text_srfc,
+                                 coord.x - frac_x + priv->srfc_x,
+                                 coord.y - frac_y + priv->srfc_y);
+        cairo_paint(cr);
         cairo_restore(cr);
-        break;
+    } else {
+        /* effects are scaling the icon, the shaped layout is still reused */
+        pango_cairo_update_layout(cr, priv->layout);
+        awn_overlay_text_paint_layout(priv, cr, text_colour,
+                                      text_outline_colour, height);
     }
+
     g_object_unref(text_colour);
     g_object_unref(text_outline_colour);
-    g_object_unref(layout);
 }
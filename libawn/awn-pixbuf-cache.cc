@@ -34,6 +34,7 @@
 #define MAX_PRUNE_FREQ 60
 
 #include "glib.h"
+#include <glib/gstdio.h>
 
 #include "awn-pixbuf-cache.h"
 
@@ -59,6 +60,8 @@ struct _AwnPixbufCachePrivate {
     guint               num_pixbufs;
     guint               max_cache_size;
     GTimeVal        last_prune;
+    /* "path::WxH" -> the pixbufs key of the file's current version */
+    GHashTable*   file_keys;
 };
 
 static void
@@ -97,6 +100,10 @@ awn_pixbuf_cache_dispose(GObject* object)
         g_hash_table_destroy(priv->pixbufs);
         priv->pixbufs = NULL;
     }
+    if (priv->file_keys) {
+        g_hash_table_destroy(priv->file_keys);
+        priv->file_keys = NULL;
+    }
     if (priv->accessed) {
         /* The list does not own any references to the data*/
         g_list_free(priv->accessed);
@@ -160,6 +167,8 @@ awn_pixbuf_cache_init(AwnPixbufCache* self)
     priv->accessed = NULL;
     priv->num_pixbufs = 0;
     g_get_current_time(&priv->last_prune);
+    priv->file_keys = g_hash_table_new_full(g_str_hash, g_str_equal,
+                                            g_free, g_free);
 }
 
 /**
@@ -447,9 +456,86 @@ awn_pixbuf_cache_invalidate(AwnPixbufCache* pixbuf_cache)
     AwnPixbufCachePrivate* priv = GET_PRIVATE(pixbuf_cache);
 
     g_hash_table_remove_all(priv->pixbufs);
+    g_hash_table_remove_all(priv->file_keys);
     g_list_free(priv->accessed);
     priv->accessed = NULL;
     priv->num_pixbufs = 0;
     g_get_current_time(&priv->last_prune);
 }
 
+
+/**
+ * awn_pixbuf_cache_load_file:
+ * @pixbuf_cache: A pointer to an #AwnPixbufCache object.
+ * @filename: Path of the image file.
+ * @width: Width the image should be scaled to (keeping the aspect ratio).
+ * @height: Height the image should be scaled to (keeping the aspect ratio).
+ *
+ * Loads the image file scaled to fit the requested size, reusing a previously
+ * decoded pixbuf if the file didn't change since (the cache is keyed by the
+ * path, modification time, file size and the requested size).  When the
+ * file changes, the pixbuf of its old version is dropped.  Failed loads
+ * aren't cached.
+ * Returns: a new reference to the pixbuf or NULL if the file can't be loaded.
+ */
+
+GdkPixbuf*
+awn_pixbuf_cache_load_file(AwnPixbufCache* pixbuf_cache,
+                           const gchar* filename,
+                           gint width,
+                           gint height)
+{
+    AwnPixbufCachePrivate* priv;
+    struct stat st;
+    gchar* key;
+    gchar* file_key;
+    const gchar* old_key;
+    gpointer pixbuf = NULL;
+
+    g_return_val_if_fail(AWN_IS_PIXBUF_CACHE(pixbuf_cache), NULL);
+    g_return_val_if_fail(filename, NULL);
+
+    priv = GET_PRIVATE(pixbuf_cache);
+
+    if (g_stat(filename, &st) != 0) {
+        return NULL;
+    }
+
+    key = g_strdup_printf("__FILE__::%ld::%ld::%s::%dx%d",
+                          (glong)st.st_mtime, (glong)st.st_size,
+                          filename, width, height);
+
+    pixbuf = g_hash_table_lookup(priv->pixbufs, key);
+    if (pixbuf) {
+        g_free(key);
+        return GDK_PIXBUF(g_object_ref(pixbuf));
+    }
+
+    /* drop the pixbuf of the file's previous version */
+    file_key = g_strdup_printf("%s::%dx%d", filename, width, height);
+    old_key = (const gchar*)g_hash_table_lookup(priv->file_keys, file_key);
+    if (old_key) {
+        gpointer old = g_hash_table_lookup(priv->pixbufs, old_key);
+        if (old && g_list_find(priv->accessed, old)) {
+            priv->accessed = g_list_remove(priv->accessed, old);
+            priv->num_pixbufs--;
+        }
+        g_hash_table_remove(priv->pixbufs, old_key);
+        g_hash_table_remove(priv->file_keys, file_key);
+    }
+
+    pixbuf = gdk_pixbuf_new_from_file_at_scale(filename, width, height,
+             TRUE, NULL);
+    if (pixbuf == NULL) {
+        g_free(file_key);
+        g_free(key);
+        return NULL;
+    }
+
+    g_hash_table_insert(priv->file_keys, file_key, g_strdup(key));
+    /* the hash table takes over the key (and a ref of the pixbuf) */
+    g_hash_table_insert(priv->pixbufs, key, g_object_ref(pixbuf));
+    awn_pixbuf_cache_check(pixbuf_cache, GDK_PIXBUF(pixbuf));
+
+    return GDK_PIXBUF(pixbuf);
+}
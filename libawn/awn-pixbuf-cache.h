@@ -86,6 +86,11 @@ void awn_pixbuf_cache_insert_pixbuf_simple_key(AwnPixbufCache* pixbuf_cache,
         GdkPixbuf* pbuf,
         const gchar* simple_key);
 
+GdkPixbuf* awn_pixbuf_cache_load_file(AwnPixbufCache* pixbuf_cache,
+                                      const gchar* filename,
+                                      gint width,
+                                      gint height);
+
 
 GType awn_pixbuf_cache_get_type(void);
 
@@ -0,0 +1,316 @@
+/*
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <math.h>
+#include <string.h>
+
+#include "awn-shape.h"
+
+typedef struct {
+    GdkRegion* region;   /* NULL means the shape is unset */
+} AwnShapeState;
+
+static GQuark input_quark = 0;
+static GQuark bounding_quark = 0;
+
+static void
+awn_shape_state_free(AwnShapeState* state)
+{
+    if (state->region) {
+        gdk_region_destroy(state->region);
+    }
+    g_slice_free(AwnShapeState, state);
+}
+
+static void
+add_polygon(GdkRegion* region, GArray* points, GdkFillRule rule)
+{
+    GdkRegion* polygon;
+
+    if (points->len >= 3) {
+        polygon = gdk_region_polygon((GdkPoint*)points->data, points->len,
+                                     rule);
+        if (rule == GDK_EVEN_ODD_RULE) {
+            gdk_region_xor(region, polygon);
+        } else {
+            gdk_region_union(region, polygon);
+        }
+        gdk_region_destroy(polygon);
+    }
+    g_array_set_size(points, 0);
+}
+
+/**
+ * awn_shape_region_from_path:
+ * @cr: a cairo context with the outline of the shape as its current path.
+ *
+ * Turns the current path of @cr (in device space) into a region, without
+ * rasterizing it. Curves are flattened to polygons using the context's
+ * tolerance. The path is left untouched.
+ *
+ * Returns: a new #GdkRegion.
+ */
+GdkRegion*
+awn_shape_region_from_path(cairo_t* cr)
+{
+    GdkRegion* region = gdk_region_new();
+    GdkFillRule rule;
+    GArray* points;
+    cairo_path_t* path;
+
+    rule = cairo_get_fill_rule(cr) == CAIRO_FILL_RULE_EVEN_ODD ?
+           GDK_EVEN_ODD_RULE : GDK_WINDING_RULE;
+    points = g_array_new(FALSE, FALSE, sizeof(GdkPoint));
+    path = cairo_copy_path_flat(cr);
+
+    for (gint i = 0; i < path->num_data; i += path->data[i].header.length) {
+        cairo_path_data_t* data = &path->data[i];
+        GdkPoint point;
+        gdouble x, y;
+
+        switch (data->header.type) {
+        case CAIRO_PATH_MOVE_TO:
+            add_polygon(region, points, rule);
+        /* fall through */
+        case CAIRO_PATH_LINE_TO:
+            x = data[1].point.x;
+            y = data[1].point.y;
+            cairo_user_to_device(cr, &x, &y);
+            point.x = (gint) floor(x + 0.5);
+            point.y = (gint) floor(y + 0.5);
+            g_array_append_val(points, point);
+            break;
+        case CAIRO_PATH_CLOSE_PATH:
+            add_polygon(region, points, rule);
+            break;
+        default:
+            /* flat paths don't contain curves */
+            break;
+        }
+    }
+    add_polygon(region, points, rule);
+
+    cairo_path_destroy(path);
+    g_array_free(points, TRUE);
+
+    return region;
+}
+
+/**
+ * awn_shape_mask_new:
+ * @width: width of the mask.
+ * @height: height of the mask.
+ *
+ * Creates a cleared client-side 1-bit surface for callers which can only
+ * paint their shape, use awn_shape_region_from_mask() to turn it into a
+ * region afterwards.
+ *
+ * Returns: a new A1 image surface.
+ */
+cairo_surface_t*
+awn_shape_mask_new(gint width, gint height)
+{
+    return cairo_image_surface_create(CAIRO_FORMAT_A1,
+                                      MAX(width, 1), MAX(height, 1));
+}
+
+static inline gboolean
+mask_get_bit(const guint32* row, gint x)
+{
+#if G_BYTE_ORDER == G_LITTLE_ENDIAN
+    return (row[x >> 5] >> (x & 31)) & 1;
+#else
+    return (row[x >> 5] >> (31 - (x & 31))) & 1;
+#endif
+}
+
+/* collects the runs of set pixels on a row as (start, end) pairs */
+static void
+mask_get_spans(const guint32* row, gint width, GArray* spans)
+{
+    gint x = 0;
+
+    g_array_set_size(spans, 0);
+    while (x < width) {
+        gint start;
+
+        /* skip whole empty words */
+        if ((x & 31) == 0 && row[x >> 5] == 0) {
+            x += 32;
+            continue;
+        }
+        if (!mask_get_bit(row, x)) {
+            x++;
+            continue;
+        }
+        start = x;
+        while (x < width && mask_get_bit(row, x)) {
+            x++;
+        }
+        g_array_append_val(spans, start);
+        g_array_append_val(spans, x);
+    }
+}
+
+static void
+add_band(GdkRegion* region, GArray* spans, gint y, gint height)
+{
+    for (guint i = 0; i + 1 < spans->len; i += 2) {
+        GdkRectangle rect;
+
+        rect.x = g_array_index(spans, gint, i);
+        rect.width = g_array_index(spans, gint, i + 1) - rect.x;
+        rect.y = y;
+        rect.height = height;
+        gdk_region_union_with_rect(region, &rect);
+    }
+}
+
+/**
+ * awn_shape_region_from_mask:
+ * @mask: an A1 image surface, see awn_shape_mask_new().
+ *
+ * Converts the set pixels of @mask to a region. Consecutive rows with the
+ * same runs become a single band, so a typical panel shape ends up as a
+ * handful of rectangles.
+ *
+ * Returns: a new #GdkRegion.
+ */
+GdkRegion*
+awn_shape_region_from_mask(cairo_surface_t* mask)
+{
+    GdkRegion* region = gdk_region_new();
+    GArray* band, *spans, *tmp;
+    const guchar* data;
+    gint width, height, stride;
+    gint band_y = 0;
+
+    g_return_val_if_fail(cairo_image_surface_get_format(mask) ==
+                         CAIRO_FORMAT_A1, region);
+
+    cairo_surface_flush(mask);
+    data = cairo_image_surface_get_data(mask);
+    width = cairo_image_surface_get_width(mask);
+    height = cairo_image_surface_get_height(mask);
+    stride = cairo_image_surface_get_stride(mask);
+
+    band = g_array_new(FALSE, FALSE, sizeof(gint));
+    spans = g_array_new(FALSE, FALSE, sizeof(gint));
+
+    for (gint y = 0; y < height; y++) {
+        mask_get_spans((const guint32*)(data + y * stride), width, spans);
+
+        if (spans->len == band->len &&
+                memcmp(spans->data, band->data, spans->len * sizeof(gint)) == 0) {
+            continue;
+        }
+
+        add_band(region, band, band_y, y - band_y);
+        tmp = band;
+        band = spans;
+        spans = tmp;
+        band_y = y;
+    }
+    add_band(region, band, band_y, height - band_y);
+
+    g_array_free(band, TRUE);
+    g_array_free(spans, TRUE);
+
+    return region;
+}
+
+/**
+ * awn_shape_region_from_outline:
+ * @cr: a cairo context with the outline of the shape as its current path.
+ *
+ * Like awn_shape_region_from_path(), but for outlines that get a 1px border
+ * stroked on the pixel centers: the region of the path is grown by one pixel
+ * to the right and bottom, so it covers the fill and the whole border like
+ * the old painted mask did. Nothing is rasterized. The path of @cr is left
+ * untouched.
+ *
+ * Returns: a new #GdkRegion.
+ */
+GdkRegion*
+awn_shape_region_from_outline(cairo_t* cr)
+{
+    GdkRegion* region = awn_shape_region_from_path(cr);
+    static const GdkPoint offsets[] = { { 1, 0 }, { 0, 1 }, { 1, 1 } };
+    GdkRegion* outline = gdk_region_copy(region);
+
+    for (guint i = 0; i < G_N_ELEMENTS(offsets); i++) {
+        gdk_region_offset(region, offsets[i].x, offsets[i].y);
+        gdk_region_union(outline, region);
+        gdk_region_offset(region, -offsets[i].x, -offsets[i].y);
+    }
+    gdk_region_destroy(region);
+
+    return outline;
+}
+
+/**
+ * awn_shape_apply:
+ * @window: a #GdkWindow.
+ * @input: whether to set the input shape (or the bounding shape).
+ * @region: the new shape, NULL to unset it.
+ *
+ * Sets the shape of @window (which ends up as XShapeCombineRectangles),
+ * unless it's the same as the one set last time.
+ *
+ * Returns: TRUE if the shape was changed.
+ */
+gboolean
+awn_shape_apply(GdkWindow* window, gboolean input, const GdkRegion* region)
+{
+    AwnShapeState* state;
+    GQuark quark;
+
+    g_return_val_if_fail(GDK_IS_WINDOW(window), FALSE);
+
+    if (!input_quark) {
+        input_quark = g_quark_from_static_string("awn-shape-input");
+        bounding_quark = g_quark_from_static_string("awn-shape-bounding");
+    }
+    quark = input ? input_quark : bounding_quark;
+
+    state = (AwnShapeState*) g_object_get_qdata(G_OBJECT(window), quark);
+    if (state) {
+        if (state->region == NULL && region == NULL) {
+            return FALSE;
+        }
+        if (state->region && region &&
+                gdk_region_equal(state->region, region)) {
+            return FALSE;
+        }
+    } else {
+        state = g_slice_new0(AwnShapeState);
+        g_object_set_qdata_full(G_OBJECT(window), quark, state,
+                                (GDestroyNotify) awn_shape_state_free);
+    }
+
+    if (state->region) {
+        gdk_region_destroy(state->region);
+    }
+    state->region = region ? gdk_region_copy(region) : NULL;
+
+    if (input) {
+        gdk_window_input_shape_combine_region(window, state->region, 0, 0);
+    } else {
+        gdk_window_shape_combine_region(window, state->region, 0, 0);
+    }
+
+    return TRUE;
+}
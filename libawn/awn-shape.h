@@ -0,0 +1,48 @@
+/*
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/*
+ * Window shapes as rectangle lists, private to awn. Shapes are built
+ * client-side (no 1-bit pixmaps) and only sent to the X server when they
+ * differ from the last shape applied to the window.
+ */
+
+#ifndef __AWN_SHAPE_H__
+#define __AWN_SHAPE_H__
+
+#include <gtk/gtk.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+GdkRegion*  awn_shape_region_from_path(cairo_t* cr);
+
+GdkRegion*  awn_shape_region_from_mask(cairo_surface_t* mask);
+
+GdkRegion*  awn_shape_region_from_outline(cairo_t* cr);
+
+cairo_surface_t* awn_shape_mask_new(gint width, gint height);
+
+gboolean    awn_shape_apply(GdkWindow*       window,
+                            gboolean         input,
+                            const GdkRegion* region);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif
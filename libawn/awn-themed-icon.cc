@@ -41,6 +41,7 @@
 #include "libawn.h"
 
 #include "gseal-transition.h"
+#include "awn-trace.h"
 
 #if !GTK_CHECK_VERSION(2,14,0)
 #define GTK_ICON_LOOKUP_FORCE_SIZE 0
@@ -883,6 +884,7 @@ get_pixbuf_at_size(AwnThemedIcon* icon, gint size, const gchar* state)
                         width = gdk_pixbuf_get_width(temp);
                         height = gdk_pixbuf_get_height(temp);
 
+                        awn_trace_count(AWN_TRACE_PIXBUFS_SCALED);
                         pixbuf = gdk_pixbuf_scale_simple(temp, width * size / height, size,
                                                          GDK_INTERP_HYPER);
                         g_object_unref(temp);
@@ -0,0 +1,51 @@
+/*
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/* Per-process tooltip pool, private to libawn. */
+
+#ifndef __AWN_TOOLTIP_POOL_H__
+#define __AWN_TOOLTIP_POOL_H__
+
+#include <gtk/gtk.h>
+
+#include "awn-tooltip.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void          awn_tooltip_pool_attach(GtkWidget* widget);
+
+void          awn_tooltip_pool_detach(GtkWidget* widget);
+
+void          awn_tooltip_pool_set_text(GtkWidget*   widget,
+                                        const gchar* text);
+
+const gchar*  awn_tooltip_pool_get_text(GtkWidget* widget);
+
+void          awn_tooltip_pool_set_position_hint(GtkWidget*      widget,
+        GtkPositionType position,
+        gint            size);
+
+AwnTooltip*   awn_tooltip_pool_get_shared(void);
+
+guint         awn_tooltip_pool_get_n_targets(void);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif
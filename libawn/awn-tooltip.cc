@@ -28,9 +28,11 @@
 #include <gdk/gdkx.h>
 
 #include "awn-tooltip.h"
+#include "awn-tooltip-pool.h"
 
 #include "awn-cairo-utils.h"
 #include "awn-config.h"
+#include "awn-shape.h"
 
 #include "gseal-transition.h"
 
@@ -78,6 +80,11 @@ struct _AwnTooltipPrivate {
 
     gulong enter_id, leave_id, press_id;
     gint old_w, old_h;
+
+    /* pooled tooltips don't own signal handlers on their focus widget */
+    gboolean  pooled;
+    /* bumped whenever the font changes, invalidates cached markup */
+    guint     style_serial;
 };
 
 enum {
@@ -160,33 +167,25 @@ static void
 awn_tooltip_set_mask(AwnTooltip* tooltip, gint width, gint height)
 {
     GtkWidget* widget = GTK_WIDGET(tooltip);
+    GdkWindow* window = gtk_widget_get_window(widget);
 
-    if (gtk_widget_is_composited(widget) == FALSE) {
-        GdkBitmap* shaped_bitmap;
-        shaped_bitmap = (GdkBitmap*) gdk_pixmap_new(NULL, width, height, 1);
-
-        if (shaped_bitmap) {
-            cairo_t* cr = gdk_cairo_create(shaped_bitmap);
-
-            cairo_set_operator(cr, CAIRO_OPERATOR_CLEAR);
-            cairo_paint(cr);
-
-            cairo_set_operator(cr, CAIRO_OPERATOR_OVER);
-            cairo_set_source_rgb(cr, 1.0, 1.0, 1.0);
-            cairo_translate(cr, 0.5, 0.5);
-
+    if (window && gtk_widget_is_composited(widget) == FALSE) {
+        cairo_surface_t* scratch;
+        cairo_t* cr;
+        GdkRegion* region;
 
-            awn_cairo_rounded_rect(cr, 0, 0, width, height,
-                                   TOOLTIP_ROUND_RADIUS, ROUND_ALL);
-            cairo_fill(cr);
+        scratch = cairo_image_surface_create(CAIRO_FORMAT_A1, 1, 1);
+        cr = cairo_create(scratch);
 
-            cairo_destroy(cr);
+        awn_cairo_rounded_rect(cr, 0, 0, width, height,
+                               TOOLTIP_ROUND_RADIUS, ROUND_ALL);
+        region = awn_shape_region_from_path(cr);
 
-            gtk_widget_shape_combine_mask(widget, NULL, 0, 0);
-            gtk_widget_shape_combine_mask(widget, shaped_bitmap, 0, 0);
+        cairo_destroy(cr);
+        cairo_surface_destroy(scratch);
 
-            g_object_unref(shaped_bitmap);
-        }
+        awn_shape_apply(window, FALSE, region);
+        gdk_region_destroy(region);
     }
 }
 
@@ -215,8 +214,8 @@ _on_composited_changed(GtkWidget* widget)
 
         gtk_widget_get_allocation(widget, &alloc);
         awn_tooltip_set_mask(AWN_TOOLTIP(widget), alloc.width, alloc.height);
-    } else {
-        gtk_widget_shape_combine_mask(widget, NULL, 0, 0);
+    } else if (gtk_widget_get_window(widget)) {
+        awn_shape_apply(gtk_widget_get_window(widget), FALSE, NULL);
     }
 }
 
@@ -405,12 +404,12 @@ awn_tooltip_dispose(GObject* obj)
     desktop_agnostic_config_client_unbind_all_for_object(priv->client,
             obj, NULL);
 
-    if (priv->focus) {
+    if (priv->focus && !priv->pooled) {
         g_signal_handler_disconnect(priv->focus, priv->enter_id);
         g_signal_handler_disconnect(priv->focus, priv->leave_id);
         g_signal_handler_disconnect(priv->focus, priv->press_id);
-        priv->focus = NULL;
     }
+    priv->focus = NULL;
 
     if (priv->show_timer_id) {
         g_source_remove(priv->show_timer_id);
@@ -688,38 +687,59 @@ awn_tooltip_position_and_show(AwnTooltip* tooltip)
 
 
 /* PUBLIC FUNCS */
-static void
-ensure_tooltip(AwnTooltip* tooltip)
+static gchar*
+awn_tooltip_build_markup(AwnTooltipPrivate* priv, const gchar* text)
 {
-    AwnTooltipPrivate* priv = tooltip->priv;
     gchar* normal = NULL;
     GdkColor clr;
     gchar* color = NULL;
     gchar* markup = NULL;
 
-    if (priv->text == NULL || priv->font_color == NULL) {
-        return;
+    if (text == NULL || priv->font_color == NULL) {
+        return NULL;
     }
 
-    normal = g_markup_escape_text(priv->text, -1);
+    normal = g_markup_escape_text(text, -1);
     desktop_agnostic_color_get_color(priv->font_color, &clr);
     color = gdk_color_to_string(&clr);
     markup = g_strdup_printf("<span foreground='%s' font_desc='%s'>%s</span>",
                              color, priv->font_name, normal);
 
+    g_free(normal);
+    g_free(color);
+
+    return markup;
+}
+
+static void
+awn_tooltip_apply_markup(AwnTooltip* tooltip, const gchar* markup)
+{
+    AwnTooltipPrivate* priv = tooltip->priv;
+
     gtk_label_set_max_width_chars(GTK_LABEL(priv->label), 120);
     gtk_label_set_ellipsize(GTK_LABEL(priv->label), PANGO_ELLIPSIZE_END);
     gtk_label_set_markup(GTK_LABEL(priv->label), markup);
 
-    g_free(normal);
-    g_free(color);
-    g_free(markup);
-
     if (gtk_widget_get_mapped(GTK_WIDGET(tooltip)) && GTK_IS_WIDGET(priv->focus)) {
         awn_tooltip_update_position(tooltip);
     }
 }
 
+static void
+ensure_tooltip(AwnTooltip* tooltip)
+{
+    gchar* markup = awn_tooltip_build_markup(tooltip->priv,
+                    tooltip->priv->text);
+
+    if (markup == NULL) {
+        return;
+    }
+
+    awn_tooltip_apply_markup(tooltip, markup);
+
+    g_free(markup);
+}
+
 void
 awn_tooltip_set_text(AwnTooltip*  tooltip,
                      const gchar* text)
@@ -922,6 +942,7 @@ awn_tooltip_set_font_name(AwnTooltip* tooltip,
     }
 
     priv->font_name = g_strdup(font_name);
+    priv->style_serial++;
 
     ensure_tooltip(tooltip);
 }
@@ -945,6 +966,7 @@ awn_tooltip_set_font_color(AwnTooltip*           tooltip,
         /* use default, (opaque) white. */
         priv->font_color = desktop_agnostic_color_new_from_string("white", NULL);
     }
+    priv->style_serial++;
 
     ensure_tooltip(tooltip);
 }
@@ -1029,3 +1051,285 @@ awn_tooltip_set_position_hint(AwnTooltip* tooltip,
         awn_tooltip_update_position(tooltip);
     }
 }
+
+/* POOL
+ *
+ * Icons don't need a toplevel window each, only one tooltip can be visible
+ * at a time anyway. Every attached widget gets a light-weight target entry
+ * (text, cached markup and position hint) and a single realized AwnTooltip
+ * is re-targeted on enter-notify-event.
+ */
+typedef struct _AwnTooltipTarget AwnTooltipTarget;
+
+struct _AwnTooltipTarget {
+    GtkWidget* widget;
+
+    gchar*    text;
+    gchar*    markup;
+    guint     markup_serial;
+
+    GtkPositionType position;
+    gint      size;
+
+    gulong enter_id, leave_id, press_id;
+};
+
+static AwnTooltip* shared_tooltip = NULL;
+static GHashTable* pool_targets = NULL;
+
+static void
+awn_tooltip_target_free(AwnTooltipTarget* target)
+{
+    g_signal_handler_disconnect(target->widget, target->enter_id);
+    g_signal_handler_disconnect(target->widget, target->leave_id);
+    g_signal_handler_disconnect(target->widget, target->press_id);
+
+    g_free(target->text);
+    g_free(target->markup);
+    g_slice_free(AwnTooltipTarget, target);
+}
+
+static AwnTooltip*
+awn_tooltip_pool_ensure_shared(void)
+{
+    if (shared_tooltip == NULL) {
+        shared_tooltip = AWN_TOOLTIP(g_object_new(AWN_TYPE_TOOLTIP,
+                                     "type", GTK_WINDOW_POPUP,
+                                     "decorated", FALSE,
+                                     "skip-pager-hint", TRUE,
+                                     "skip-taskbar-hint", TRUE,
+                                     NULL));
+        shared_tooltip->priv->pooled = TRUE;
+        /* keep the shared window alive for the lifetime of the process */
+        g_object_ref_sink(shared_tooltip);
+    }
+
+    return shared_tooltip;
+}
+
+static const gchar*
+awn_tooltip_target_get_markup(AwnTooltip* tooltip, AwnTooltipTarget* target)
+{
+    AwnTooltipPrivate* priv = tooltip->priv;
+
+    if (target->markup == NULL || target->markup_serial != priv->style_serial) {
+        g_free(target->markup);
+        target->markup = awn_tooltip_build_markup(priv, target->text);
+        target->markup_serial = priv->style_serial;
+    }
+
+    return target->markup;
+}
+
+static void
+awn_tooltip_pool_retarget(AwnTooltip* tooltip, AwnTooltipTarget* target)
+{
+    AwnTooltipPrivate* priv = tooltip->priv;
+    const gchar* markup;
+
+    if (priv->focus == target->widget) {
+        return;
+    }
+
+    if (priv->show_timer_id) {
+        g_source_remove(priv->show_timer_id);
+        priv->show_timer_id = 0;
+    }
+
+    /* moving straight from one icon to another keeps the window mapped,
+     * it is just moved and relabelled */
+    if (priv->hide_timer_id) {
+        g_source_remove(priv->hide_timer_id);
+        priv->hide_timer_id = 0;
+    }
+
+    priv->focus = target->widget;
+    priv->inhibit_show = FALSE;
+    priv->position = target->position;
+    priv->size = target->size;
+
+    g_free(priv->text);
+    priv->text = g_strdup(target->text);
+
+    markup = awn_tooltip_target_get_markup(tooltip, target);
+
+    if (markup) {
+        awn_tooltip_apply_markup(tooltip, markup);
+    } else if (gtk_widget_get_visible(GTK_WIDGET(tooltip))) {
+        gtk_widget_hide(GTK_WIDGET(tooltip));
+    }
+}
+
+static gboolean
+awn_tooltip_pool_enter(GtkWidget* widget, GdkEventCrossing* event,
+                       AwnTooltipTarget* target)
+{
+    AwnTooltip* tooltip = awn_tooltip_pool_ensure_shared();
+
+    awn_tooltip_pool_retarget(tooltip, target);
+
+    return awn_tooltip_show(tooltip, event, widget);
+}
+
+static gboolean
+awn_tooltip_pool_leave(GtkWidget* widget, GdkEventCrossing* event,
+                       AwnTooltipTarget* target)
+{
+    if (shared_tooltip == NULL || shared_tooltip->priv->focus != widget) {
+        return FALSE;
+    }
+
+    return awn_tooltip_hide(shared_tooltip, event, widget);
+}
+
+static gboolean
+awn_tooltip_pool_press(GtkWidget* widget, GdkEventCrossing* event,
+                       AwnTooltipTarget* target)
+{
+    AwnTooltip* tooltip = awn_tooltip_pool_ensure_shared();
+
+    awn_tooltip_pool_retarget(tooltip, target);
+
+    return on_button_press(widget, event, tooltip);
+}
+
+static AwnTooltipTarget*
+awn_tooltip_pool_lookup(GtkWidget* widget)
+{
+    if (pool_targets == NULL) {
+        return NULL;
+    }
+
+    return (AwnTooltipTarget*)g_hash_table_lookup(pool_targets, widget);
+}
+
+void
+awn_tooltip_pool_attach(GtkWidget* widget)
+{
+    AwnTooltipTarget* target;
+
+    g_return_if_fail(GTK_IS_WIDGET(widget));
+
+    if (pool_targets == NULL) {
+        pool_targets = g_hash_table_new_full(g_direct_hash, g_direct_equal,
+                                             NULL,
+                                             (GDestroyNotify)awn_tooltip_target_free);
+    }
+
+    if (g_hash_table_lookup(pool_targets, widget)) {
+        return;
+    }
+
+    target = g_slice_new0(AwnTooltipTarget);
+    target->widget = widget;
+    target->position = GTK_POS_BOTTOM;
+    target->size = 50;
+
+    target->enter_id = g_signal_connect(widget, "enter-notify-event",
+                                        G_CALLBACK(awn_tooltip_pool_enter),
+                                        target);
+    target->leave_id = g_signal_connect(widget, "leave-notify-event",
+                                        G_CALLBACK(awn_tooltip_pool_leave),
+                                        target);
+    target->press_id = g_signal_connect(widget, "button-press-event",
+                                        G_CALLBACK(awn_tooltip_pool_press),
+                                        target);
+
+    g_hash_table_insert(pool_targets, widget, target);
+}
+
+void
+awn_tooltip_pool_detach(GtkWidget* widget)
+{
+    if (awn_tooltip_pool_lookup(widget) == NULL) {
+        return;
+    }
+
+    if (shared_tooltip && shared_tooltip->priv->focus == widget) {
+        AwnTooltipPrivate* priv = shared_tooltip->priv;
+
+        if (priv->show_timer_id) {
+            g_source_remove(priv->show_timer_id);
+            priv->show_timer_id = 0;
+        }
+        if (priv->hide_timer_id) {
+            g_source_remove(priv->hide_timer_id);
+            priv->hide_timer_id = 0;
+        }
+
+        gtk_widget_hide(GTK_WIDGET(shared_tooltip));
+        priv->focus = NULL;
+    }
+
+    g_hash_table_remove(pool_targets, widget);
+}
+
+void
+awn_tooltip_pool_set_text(GtkWidget* widget, const gchar* text)
+{
+    AwnTooltipTarget* target = awn_tooltip_pool_lookup(widget);
+
+    g_return_if_fail(target);
+
+    if (g_strcmp0(target->text, text) == 0) {
+        return;
+    }
+
+    g_free(target->text);
+    target->text = g_strdup(text);
+
+    g_free(target->markup);
+    target->markup = NULL;
+
+    if (shared_tooltip && shared_tooltip->priv->focus == widget) {
+        AwnTooltipPrivate* priv = shared_tooltip->priv;
+        const gchar* markup;
+
+        g_free(priv->text);
+        priv->text = g_strdup(text);
+
+        markup = awn_tooltip_target_get_markup(shared_tooltip, target);
+        if (markup) {
+            awn_tooltip_apply_markup(shared_tooltip, markup);
+        }
+    }
+}
+
+const gchar*
+awn_tooltip_pool_get_text(GtkWidget* widget)
+{
+    AwnTooltipTarget* target = awn_tooltip_pool_lookup(widget);
+
+    g_return_val_if_fail(target, NULL);
+
+    return target->text;
+}
+
+void
+awn_tooltip_pool_set_position_hint(GtkWidget* widget,
+                                   GtkPositionType position,
+                                   gint size)
+{
+    AwnTooltipTarget* target = awn_tooltip_pool_lookup(widget);
+
+    g_return_if_fail(target);
+
+    target->position = position;
+    target->size = size;
+
+    if (shared_tooltip && shared_tooltip->priv->focus == widget) {
+        awn_tooltip_set_position_hint(shared_tooltip, position, size);
+    }
+}
+
+AwnTooltip*
+awn_tooltip_pool_get_shared(void)
+{
+    return shared_tooltip;
+}
+
+guint
+awn_tooltip_pool_get_n_targets(void)
+{
+    return pool_targets ? g_hash_table_size(pool_targets) : 0;
+}
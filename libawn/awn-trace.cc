@@ -0,0 +1,155 @@
+/*
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <string.h>
+#include <unistd.h>
+
+#include "awn-trace.h"
+
+typedef struct {
+    gint64  start;     /* us */
+    guint32 duration;  /* us */
+    guint32 span;
+    guint32 counters[AWN_TRACE_N_COUNTERS];
+} AwnTraceEntry;
+
+static const gchar* span_names[AWN_TRACE_N_SPANS] = {
+    "expose",
+    "effect-frame",
+    "background-draw",
+    "mask-update",
+    "size-negotiation"
+};
+
+static const gchar* counter_names[AWN_TRACE_N_COUNTERS] = {
+    "surfaces-created",
+    "pixbufs-scaled"
+};
+
+gboolean awn_trace_enabled = FALSE;
+
+static AwnTraceEntry* ring = NULL;
+static guint ring_next = 0;
+static guint ring_len = 0;
+static guint32 counters[AWN_TRACE_N_COUNTERS];
+
+gint64
+awn_trace_now(void)
+{
+    GTimeVal now;
+
+    g_get_current_time(&now);
+
+    return (gint64) now.tv_sec * G_USEC_PER_SEC + now.tv_usec;
+}
+
+/**
+ * awn_trace_record:
+ * @span: what happened.
+ * @start: the time it started, as returned by awn_trace_begin().
+ *
+ * Adds a span ending now to the ring buffer, overwriting the oldest one
+ * if it's full. Use awn_trace_end(), which skips this when tracing was
+ * disabled at the start of the span.
+ */
+void
+awn_trace_record(AwnTraceSpan span, gint64 start)
+{
+    AwnTraceEntry* entry;
+
+    if (!ring) {
+        return;
+    }
+
+    entry = &ring[ring_next];
+    entry->start = start;
+    entry->duration = (guint32) MAX(awn_trace_now() - start, 0);
+    entry->span = span;
+    memcpy(entry->counters, counters, sizeof(counters));
+
+    ring_next = (ring_next + 1) % AWN_TRACE_RING_SIZE;
+    ring_len = MIN(ring_len + 1, AWN_TRACE_RING_SIZE);
+}
+
+void
+awn_trace_counter_add(AwnTraceCounter counter)
+{
+    counters[counter]++;
+}
+
+/**
+ * awn_trace_set_enabled:
+ * @enabled: whether to record.
+ *
+ * Starts or stops recording. Starting again clears the spans and counters
+ * of the previous run, stopping keeps them for awn_trace_to_json().
+ */
+void
+awn_trace_set_enabled(gboolean enabled)
+{
+    if (enabled && !awn_trace_enabled) {
+        if (!ring) {
+            ring = g_new(AwnTraceEntry, AWN_TRACE_RING_SIZE);
+        }
+        ring_next = 0;
+        ring_len = 0;
+        memset(counters, 0, sizeof(counters));
+    }
+    awn_trace_enabled = enabled;
+}
+
+/**
+ * awn_trace_to_json:
+ *
+ * Serializes the recorded spans, oldest first, as complete ("X") events
+ * and the counters at the end of every expose as counter ("C") events.
+ *
+ * Returns: a newly allocated Chrome trace event JSON document.
+ */
+gchar*
+awn_trace_to_json(void)
+{
+    GString* json = g_string_new("{\"traceEvents\":[");
+    pid_t pid = getpid();
+    guint first = (ring_next + AWN_TRACE_RING_SIZE - ring_len) % AWN_TRACE_RING_SIZE;
+
+    for (guint i = 0; i < ring_len; i++) {
+        const AwnTraceEntry* entry = &ring[(first + i) % AWN_TRACE_RING_SIZE];
+
+        g_string_append_printf(json,
+                               "%s\n{\"name\":\"%s\",\"cat\":\"awn\",\"ph\":\"X\","
+                               "\"ts\":%" G_GINT64_FORMAT ",\"dur\":%u,"
+                               "\"pid\":%d,\"tid\":%d}",
+                               i ? "," : "", span_names[entry->span],
+                               entry->start, entry->duration, pid, pid);
+
+        if (entry->span != AWN_TRACE_EXPOSE) {
+            continue;
+        }
+        for (guint c = 0; c < AWN_TRACE_N_COUNTERS; c++) {
+            g_string_append_printf(json,
+                                   ",\n{\"name\":\"%s\",\"cat\":\"awn\",\"ph\":\"C\","
+                                   "\"ts\":%" G_GINT64_FORMAT ","
+                                   "\"pid\":%d,\"args\":{\"value\":%u}}",
+                                   counter_names[c],
+                                   entry->start + entry->duration, pid,
+                                   entry->counters[c]);
+        }
+    }
+    g_string_append(json, "\n],\"displayTimeUnit\":\"ms\"}\n");
+
+    return g_string_free(json, FALSE);
+}
@@ -0,0 +1,83 @@
+/*
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/*
+ * Frame tracing, private to awn. The last AWN_TRACE_RING_SIZE spans
+ * (expose, effect frame, ...) are kept in a ring buffer together with a
+ * few counters, and can be exported in the Chrome trace event format
+ * (chrome://tracing). While tracing is disabled every trace point is a
+ * single test of awn_trace_enabled.
+ */
+
+#ifndef __AWN_TRACE_H__
+#define __AWN_TRACE_H__
+
+#include <glib.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define AWN_TRACE_RING_SIZE 8192
+
+typedef enum {
+    AWN_TRACE_EXPOSE,
+    AWN_TRACE_EFFECT_FRAME,
+    AWN_TRACE_BACKGROUND_DRAW,
+    AWN_TRACE_MASK_UPDATE,
+    AWN_TRACE_SIZE_NEGOTIATION,
+    AWN_TRACE_N_SPANS
+} AwnTraceSpan;
+
+typedef enum {
+    AWN_TRACE_SURFACES_CREATED,
+    AWN_TRACE_PIXBUFS_SCALED,
+    AWN_TRACE_N_COUNTERS
+} AwnTraceCounter;
+
+extern gboolean awn_trace_enabled;
+
+/* start = awn_trace_begin(); ... awn_trace_end(AWN_TRACE_EXPOSE, start); */
+#define awn_trace_begin() \
+    (G_UNLIKELY(awn_trace_enabled) ? awn_trace_now() : 0)
+
+#define awn_trace_end(span, start) G_STMT_START { \
+    if (G_UNLIKELY(start)) { \
+        awn_trace_record((span), (start)); \
+    } \
+} G_STMT_END
+
+#define awn_trace_count(counter) G_STMT_START { \
+    if (G_UNLIKELY(awn_trace_enabled)) { \
+        awn_trace_counter_add(counter); \
+    } \
+} G_STMT_END
+
+gint64      awn_trace_now(void);
+
+void        awn_trace_record(AwnTraceSpan span, gint64 start);
+
+void        awn_trace_counter_add(AwnTraceCounter counter);
+
+void        awn_trace_set_enabled(gboolean enabled);
+
+gchar*      awn_trace_to_json(void);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif
@@ -299,3 +299,97 @@ void awn_utils_menu_set_position_widget_relative(GtkMenu* menu,
     }
 }
 
+/*
+ * Marks in keep the indices (into seq) of a longest strictly increasing
+ * subsequence of seq, O(n log n).
+ */
+static void
+mark_longest_increasing(const gint* seq, guint n, gboolean* keep)
+{
+    gint* tails = g_new(gint, n);   /* index of the smallest tail per length */
+    gint* prev = g_new(gint, n);
+    guint len = 0;
+
+    for (guint i = 0; i < n; i++) {
+        guint lo = 0, hi = len;
+
+        while (lo < hi) {
+            guint mid = (lo + hi) / 2;
+            if (seq[tails[mid]] < seq[i]) {
+                lo = mid + 1;
+            } else {
+                hi = mid;
+            }
+        }
+        prev[i] = lo > 0 ? tails[lo - 1] : -1;
+        tails[lo] = i;
+        if (lo == len) {
+            len++;
+        }
+        keep[i] = FALSE;
+    }
+
+    for (gint i = len > 0 ? tails[len - 1] : -1; i >= 0; i = prev[i]) {
+        keep[i] = TRUE;
+    }
+
+    g_free(prev);
+    g_free(tails);
+}
+
+guint
+awn_utils_reorder_box_children(GtkBox* box, GPtrArray* order)
+{
+    GList* children;
+    GHashTable* positions;
+    gint* seq;
+    gboolean* keep;
+    gint pos = 0;
+    guint moved = 0;
+
+    g_return_val_if_fail(GTK_IS_BOX(box), 0);
+    g_return_val_if_fail(order, 0);
+
+    if (order->len == 0) {
+        return 0;
+    }
+
+    children = gtk_container_get_children(GTK_CONTAINER(box));
+    positions = g_hash_table_new(g_direct_hash, g_direct_equal);
+    seq = g_new(gint, order->len);
+    keep = g_new(gboolean, order->len);
+
+    for (GList* l = children; l; l = l->next) {
+        g_hash_table_insert(positions, l->data, GINT_TO_POINTER(pos++));
+    }
+    for (guint i = 0; i < order->len; i++) {
+        seq[i] = GPOINTER_TO_INT(g_hash_table_lookup(positions,
+                                 g_ptr_array_index(order, i)));
+    }
+
+    mark_longest_increasing(seq, order->len, keep);
+
+    for (guint i = 0; i < order->len; i++) {
+        GtkWidget* widget = GTK_WIDGET(g_ptr_array_index(order, i));
+        gint target = 0;
+
+        if (keep[i]) {
+            continue;
+        }
+
+        children = g_list_remove(children, widget);
+        if (i > 0) {
+            target = g_list_index(children, g_ptr_array_index(order, i - 1)) + 1;
+        }
+        children = g_list_insert(children, widget, target);
+        gtk_box_reorder_child(box, widget, target);
+        moved++;
+    }
+
+    g_free(keep);
+    g_free(seq);
+    g_hash_table_destroy(positions);
+    g_list_free(children);
+
+    return moved;
+}
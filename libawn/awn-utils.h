@@ -115,6 +115,20 @@ void awn_utils_menu_set_position_widget_relative(GtkMenu* menu,
         gboolean* push_in,
         gpointer data);
 
+/**
+ * awn_utils_reorder_box_children:
+ * @box: a #GtkBox.
+ * @order: the children of @box in the wanted order.
+ *
+ * Brings the children listed in @order in that order with the fewest
+ * gtk_box_reorder_child() calls: the ones already in the right relative
+ * order stay where they are, the others are moved behind their predecessor.
+ * Children that aren't listed keep their place.
+ *
+ * Returns: the number of children moved.
+ */
+guint awn_utils_reorder_box_children(GtkBox* box, GPtrArray* order);
+
 #ifdef __cplusplus
 } // extern "C"
 #endif
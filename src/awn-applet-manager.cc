@@ -21,6 +21,8 @@
 
 #include "config.h"
 
+#include <string.h>
+
 #include <libawn/libawn.h>
 #include <libawn/awn-utils.h>
 #include "libawn/gseal-transition.h"
@@ -35,6 +37,26 @@
 
 #define MAX_UA_LIST_ENTRIES 50
 
+/* seconds after which an applet that didn't embed frees its launch slot */
+#define APPLET_LAUNCH_TIMEOUT 15
+/* seconds the last known applet sizes are written after they changed */
+#define APPLET_SIZES_SAVE_DELAY 5
+#define APPLET_SIZES_GROUP "sizes"
+#define APPLET_SIZES_PANEL_GROUP "panel"
+
+/* startup bookkeeping of an AwnAppletProxy */
+typedef struct {
+    AwnAppletManager* manager;
+    GtkWidget* applet;  /* owns the launch */
+    gchar*   uid;
+    gboolean native;    /* not a Python/Mono applet */
+    gboolean visible;   /* expected to be placed on screen */
+    gboolean running;   /* spawned, but not embedded yet */
+    guint    timeout_id;
+    gdouble  queued;
+    gdouble  spawned;
+} AwnAppletLaunch;
+
 G_DEFINE_TYPE(AwnAppletManager, awn_applet_manager, AWN_TYPE_BOX)
 
 #define AWN_APPLET_MANAGER_GET_PRIVATE(obj) (G_TYPE_INSTANCE_GET_PRIVATE (obj, \
@@ -64,8 +86,20 @@ struct _AwnAppletManagerPrivate {
     GHashTable*      applets;
     GHashTable*      extra_widgets;
     GQuark           touch_quark;
+    guint            touch_serial;
     GQuark           visibility_quark;
     GQuark           shape_mask_quark;
+
+    /* applet launch scheduler */
+    GQueue*          launch_queue;
+    guint            launch_id;
+    gint             launches_running;
+    gint             launch_limit;
+    GTimer*          launch_timer;
+    GQuark           launch_quark;
+    GHashTable*      applet_sizes;  /* uid -> last known size */
+    gint             applet_sizes_panel_size; /* the size they were taken at */
+    guint            applet_sizes_id;
 };
 
 enum {
@@ -78,7 +112,8 @@ enum {
     PROP_APPLET_LIST,
     PROP_UA_LIST,
     PROP_UA_ACTIVE_LIST,
-    PROP_EXPANDS
+    PROP_EXPANDS,
+    PROP_LAUNCH_LIMIT
 };
 
 enum {
@@ -104,6 +139,13 @@ static void on_icon_size_alloc(GtkWidget* widget,
                                GtkAllocation* alloc,
                                AwnAppletManager* manager);
 static void free_list(GSList** list);
+static void schedule_launches(AwnAppletManager* manager);
+static void finish_launch(AwnAppletManager* manager, GtkWidget* applet,
+                          const gchar* result);
+static void load_applet_sizes(AwnAppletManager* manager);
+static void update_placeholder_size(gpointer key, GtkWidget* applet,
+                                    AwnAppletManager* manager);
+static gboolean save_applet_sizes(AwnAppletManager* manager);
 
 /*
  * GOBJECT CODE
@@ -149,6 +191,11 @@ awn_applet_manager_constructed(GObject* object)
                                         object, "ua_active_list", TRUE,
                                         DESKTOP_AGNOSTIC_CONFIG_BIND_METHOD_FALLBACK,
                                         NULL);
+    desktop_agnostic_config_client_bind(priv->client,
+                                        AWN_GROUP_PANELS, AWN_PANELS_LAUNCH_LIMIT,
+                                        object, "launch-limit", TRUE,
+                                        DESKTOP_AGNOSTIC_CONFIG_BIND_METHOD_FALLBACK,
+                                        NULL);
     /*
     ua_active_list should be empty when awn starts...
      */
@@ -195,6 +242,9 @@ awn_applet_manager_get_property(GObject*    object,
     case PROP_EXPANDS:
         g_value_set_boolean(value, awn_applet_manager_get_expands(AWN_APPLET_MANAGER(object)));
         break;
+    case PROP_LAUNCH_LIMIT:
+        g_value_set_int(value, priv->launch_limit);
+        break;
     default:
         G_OBJECT_WARN_INVALID_PROPERTY_ID(object, prop_id, pspec);
     }
@@ -256,6 +306,10 @@ awn_applet_manager_set_property(GObject*      object,
         set_list_property(value, &priv->ua_active_list);
         awn_applet_manager_refresh_applets(manager);
         break;
+    case PROP_LAUNCH_LIMIT:
+        priv->launch_limit = g_value_get_int(value);
+        schedule_launches(manager);
+        break;
     default:
         G_OBJECT_WARN_INVALID_PROPERTY_ID(object, prop_id, pspec);
     }
@@ -267,11 +321,36 @@ awn_applet_manager_dispose(GObject* object)
 {
     AwnAppletManagerPrivate* priv = AWN_APPLET_MANAGER_GET_PRIVATE(object);
 
+    if (priv->launch_id) {
+        g_source_remove(priv->launch_id);
+        priv->launch_id = 0;
+    }
+
+    if (priv->applet_sizes_id) {
+        g_source_remove(priv->applet_sizes_id);
+        save_applet_sizes(AWN_APPLET_MANAGER(object));
+    }
+
     if (priv->applets) {
         g_hash_table_destroy(priv->applets);
         priv->applets = NULL;
     }
 
+    if (priv->applet_sizes) {
+        g_hash_table_destroy(priv->applet_sizes);
+        priv->applet_sizes = NULL;
+    }
+
+    if (priv->launch_queue) {
+        g_queue_free(priv->launch_queue);
+        priv->launch_queue = NULL;
+    }
+
+    if (priv->launch_timer) {
+        g_timer_destroy(priv->launch_timer);
+        priv->launch_timer = NULL;
+    }
+
     if (priv->extra_widgets) {
         g_hash_table_destroy(priv->extra_widgets);
         priv->extra_widgets = NULL;
@@ -365,6 +444,15 @@ awn_applet_manager_class_init(AwnAppletManagerClass* klass)
                                             FALSE,
                                             G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
 
+    g_object_class_install_property(obj_class,
+                                    PROP_LAUNCH_LIMIT,
+                                    g_param_spec_int("launch-limit",
+                                            "Launch limit",
+                                            "Maximum number of applets starting at the same time (0 = no limit)",
+                                            0, G_MAXINT, 8,
+                                            G_PARAM_READWRITE | G_PARAM_CONSTRUCT |
+                                            G_PARAM_STATIC_STRINGS));
+
     /* Class signals */
     _applet_manager_signals[APPLET_EMBEDDED] =
         g_signal_new("applet-embedded",
@@ -415,10 +503,17 @@ awn_applet_manager_init(AwnAppletManager* manager)
     priv->touch_quark = g_quark_from_string("applets-touch-quark");
     priv->visibility_quark = g_quark_from_string("visibility-quark");
     priv->shape_mask_quark = g_quark_from_string("shape-mask-quark");
+    priv->launch_quark = g_quark_from_string("applet-launch-quark");
     priv->applets = g_hash_table_new_full(g_str_hash, g_str_equal,
                                           g_free, NULL);
     priv->extra_widgets = g_hash_table_new(g_direct_hash, g_direct_equal);
 
+    priv->launch_queue = g_queue_new();
+    priv->launch_timer = g_timer_new();
+    priv->applet_sizes = g_hash_table_new_full(g_str_hash, g_str_equal,
+                                               g_free, NULL);
+    load_applet_sizes(manager);
+
     gtk_widget_show_all(GTK_WIDGET(manager));
 }
 
@@ -481,6 +576,7 @@ awn_applet_manager_set_applet_flags(AwnAppletManager* manager,
             priv->expander_count++;
 
             g_hash_table_replace(priv->applets, g_strdup(uid), image);
+            finish_launch(manager, GTK_WIDGET(applet), "replaced");
             gtk_widget_destroy(GTK_WIDGET(applet));
             applet = NULL;
 
@@ -493,6 +589,7 @@ awn_applet_manager_set_applet_flags(AwnAppletManager* manager,
             gtk_box_pack_start(GTK_BOX(manager), image, FALSE, TRUE, 0);
 
             g_hash_table_replace(priv->applets, g_strdup(uid), image);
+            finish_launch(manager, GTK_WIDGET(applet), "replaced");
             gtk_widget_destroy(GTK_WIDGET(applet));
             applet = NULL;
 
@@ -567,6 +664,9 @@ awn_applet_manager_set_size(AwnAppletManager* manager,
     /* update size on all running applets (if they'd crash) */
     g_hash_table_foreach(priv->applets,
                          (GHFunc)awn_manager_set_applets_size, manager);
+    /* the last known sizes don't fit the throbbers anymore */
+    g_hash_table_foreach(priv->applets,
+                         (GHFunc)update_placeholder_size, manager);
 }
 
 static void
@@ -639,6 +739,380 @@ free_list(GSList** list)
     *list = NULL;
 }
 
+/*
+ * LAUNCH SCHEDULER
+ *
+ * All applets are spawned right away (up to launch-limit at a time) instead
+ * of one per main loop iteration, native ones first as the Python and Mono
+ * ones take much longer to come up anyway. The throbbers standing in for
+ * them get the size the applets had last time.
+ */
+static gchar*
+get_applet_sizes_filename(void)
+{
+    return g_build_filename(g_get_user_cache_dir(), "awn", "applet-sizes", NULL);
+}
+
+static void
+load_applet_sizes(AwnAppletManager* manager)
+{
+    AwnAppletManagerPrivate* priv = manager->priv;
+    GKeyFile* keyfile = g_key_file_new();
+    gchar* filename = get_applet_sizes_filename();
+    gchar** uids;
+
+    if (g_key_file_load_from_file(keyfile, filename, G_KEY_FILE_NONE, NULL)) {
+        uids = g_key_file_get_keys(keyfile, APPLET_SIZES_GROUP, NULL, NULL);
+        for (gint i = 0; uids && uids[i]; i++) {
+            gint size = g_key_file_get_integer(keyfile, APPLET_SIZES_GROUP,
+                                               uids[i], NULL);
+            if (size > 0) {
+                g_hash_table_insert(priv->applet_sizes, g_strdup(uids[i]),
+                                    GINT_TO_POINTER(size));
+            }
+        }
+        g_strfreev(uids);
+        priv->applet_sizes_panel_size =
+            g_key_file_get_integer(keyfile, APPLET_SIZES_PANEL_GROUP, "size",
+                                   NULL);
+    }
+
+    g_free(filename);
+    g_key_file_free(keyfile);
+}
+
+static gboolean
+save_applet_sizes(AwnAppletManager* manager)
+{
+    AwnAppletManagerPrivate* priv = manager->priv;
+    GKeyFile* keyfile = g_key_file_new();
+    gchar* filename = get_applet_sizes_filename();
+    gchar* dirname = g_path_get_dirname(filename);
+    gchar* data;
+    gsize length;
+    GHashTableIter iter;
+    gpointer key, value;
+
+    priv->applet_sizes_id = 0;
+
+    g_key_file_set_integer(keyfile, APPLET_SIZES_PANEL_GROUP, "size",
+                           priv->applet_sizes_panel_size);
+    g_hash_table_iter_init(&iter, priv->applet_sizes);
+    while (g_hash_table_iter_next(&iter, &key, &value)) {
+        /* forget the applets that were removed */
+        if (priv->applets && g_hash_table_lookup(priv->applets, key)) {
+            g_key_file_set_integer(keyfile, APPLET_SIZES_GROUP,
+                                   (gchar*)key, GPOINTER_TO_INT(value));
+        }
+    }
+
+    data = g_key_file_to_data(keyfile, &length, NULL);
+    if (g_mkdir_with_parents(dirname, 0755) == 0) {
+        g_file_set_contents(filename, data, length, NULL);
+    }
+
+    g_free(data);
+    g_free(dirname);
+    g_free(filename);
+    g_key_file_free(keyfile);
+
+    return FALSE;
+}
+
+static void
+on_applet_size_alloc(GtkWidget* applet, GtkAllocation* alloc,
+                     AwnAppletManager* manager)
+{
+    AwnAppletManagerPrivate* priv = manager->priv;
+    AwnAppletLaunch* launch;
+    gint size;
+
+    if (!gtk_socket_get_plug_window(GTK_SOCKET(applet))) {
+        return;
+    }
+
+    launch = (AwnAppletLaunch*)g_object_get_qdata(G_OBJECT(applet),
+             priv->launch_quark);
+    if (!launch) {
+        return;
+    }
+
+    size = priv->position == GTK_POS_LEFT || priv->position == GTK_POS_RIGHT ?
+           alloc->height : alloc->width;
+
+    if (size <= 1) {
+        return;
+    }
+    /* the sizes taken at another panel size are of no use anymore */
+    if (priv->applet_sizes_panel_size != priv->size) {
+        g_hash_table_remove_all(priv->applet_sizes);
+        priv->applet_sizes_panel_size = priv->size;
+    }
+    if (GPOINTER_TO_INT(g_hash_table_lookup(priv->applet_sizes, launch->uid)) != size) {
+        g_hash_table_replace(priv->applet_sizes, g_strdup(launch->uid),
+                             GINT_TO_POINTER(size));
+        if (!priv->applet_sizes_id) {
+            priv->applet_sizes_id =
+                g_timeout_add_seconds(APPLET_SIZES_SAVE_DELAY,
+                                      (GSourceFunc)save_applet_sizes, manager);
+        }
+    }
+}
+
+/*
+ * The size the applet had last time, or 0 if it isn't known at the current
+ * panel size.
+ */
+static gint
+get_placeholder_size(AwnAppletManager* manager, const gchar* uid)
+{
+    AwnAppletManagerPrivate* priv = manager->priv;
+
+    if (priv->applet_sizes_panel_size != priv->size) {
+        return 0;
+    }
+    return GPOINTER_TO_INT(g_hash_table_lookup(priv->applet_sizes, uid));
+}
+
+static void
+update_placeholder_size(gpointer key, GtkWidget* applet,
+                        AwnAppletManager* manager)
+{
+    AwnAppletLaunch* launch;
+
+    if (!AWN_IS_APPLET_PROXY(applet) ||
+            gtk_socket_get_plug_window(GTK_SOCKET(applet))) {
+        return;
+    }
+    launch = (AwnAppletLaunch*)g_object_get_qdata(G_OBJECT(applet),
+             manager->priv->launch_quark);
+    if (launch) {
+        awn_applet_proxy_set_placeholder_size(AWN_APPLET_PROXY(applet),
+                                              get_placeholder_size(manager,
+                                                                   launch->uid));
+    }
+}
+
+static void
+awn_applet_launch_free(AwnAppletLaunch* launch)
+{
+    if (launch->timeout_id) {
+        g_source_remove(launch->timeout_id);
+    }
+    g_free(launch->uid);
+    g_slice_free(AwnAppletLaunch, launch);
+}
+
+static gboolean
+applet_is_native(const gchar* path)
+{
+    GKeyFile* keyfile = g_key_file_new();
+    gboolean native = TRUE;
+
+    if (g_key_file_load_from_file(keyfile, path, G_KEY_FILE_NONE, NULL)) {
+        gchar* type = g_key_file_get_string(keyfile, G_KEY_FILE_DESKTOP_GROUP,
+                                            "X-AWN-AppletType", NULL);
+        native = g_strcmp0(type, "Python") != 0 && g_strcmp0(type, "Mono") != 0;
+        g_free(type);
+    }
+    g_key_file_free(keyfile);
+
+    return native;
+}
+
+/*
+ * Called when the applet embedded, crashed, timed out or was removed.
+ */
+static void
+finish_launch(AwnAppletManager* manager, GtkWidget* applet, const gchar* result)
+{
+    AwnAppletManagerPrivate* priv = manager->priv;
+    AwnAppletLaunch* launch;
+
+    if (!priv->launch_queue) {
+        return;
+    }
+
+    g_queue_remove(priv->launch_queue, applet);
+
+    launch = (AwnAppletLaunch*)g_object_get_qdata(G_OBJECT(applet),
+             priv->launch_quark);
+    if (!launch || !launch->running) {
+        return;
+    }
+
+    launch->running = FALSE;
+    priv->launches_running--;
+    if (launch->timeout_id) {
+        g_source_remove(launch->timeout_id);
+        launch->timeout_id = 0;
+    }
+
+    g_debug("Applet %s%s: queued at %.0f ms, spawned at %.0f ms, %s at %.0f ms",
+            launch->uid, launch->native ? "" : " (interpreted)",
+            launch->queued * 1000.0, launch->spawned * 1000.0, result,
+            g_timer_elapsed(priv->launch_timer, NULL) * 1000.0);
+
+    if (priv->launches_running == 0 && g_queue_is_empty(priv->launch_queue)) {
+        g_debug("All applets started after %.0f ms",
+                g_timer_elapsed(priv->launch_timer, NULL) * 1000.0);
+    }
+
+    schedule_launches(manager);
+}
+
+static gboolean
+on_launch_timeout(AwnAppletLaunch* launch)
+{
+    launch->timeout_id = 0;
+    finish_launch(launch->manager, launch->applet, "timed out");
+
+    return FALSE;
+}
+
+/*
+ * Marks the queued applets that will end up on screen, using their last known
+ * (or placeholder) sizes for the ones that aren't there yet.
+ */
+static void
+update_launch_visibility(AwnAppletManager* manager)
+{
+    AwnAppletManagerPrivate* priv = manager->priv;
+    GdkScreen* screen = gtk_widget_get_screen(GTK_WIDGET(manager));
+    gboolean horizontal = priv->position == GTK_POS_TOP ||
+                          priv->position == GTK_POS_BOTTOM;
+    gint limit = horizontal ? gdk_screen_get_width(screen) :
+                 gdk_screen_get_height(screen);
+    gint extent = 0;
+    GList* list = gtk_container_get_children(GTK_CONTAINER(manager));
+
+    for (GList* it = list; it != NULL; it = it->next) {
+        GtkWidget* widget = GTK_WIDGET(it->data);
+        GtkAllocation alloc;
+        gint length;
+
+        /* stands in for its proxy, which is counted below */
+        if (AWN_IS_THROBBER(widget)) {
+            continue;
+        }
+
+        gtk_widget_get_allocation(widget, &alloc);
+        length = horizontal ? alloc.width : alloc.height;
+
+        if (AWN_IS_APPLET_PROXY(widget) &&
+                !gtk_socket_get_plug_window(GTK_SOCKET(widget))) {
+            AwnAppletLaunch* launch;
+            launch = (AwnAppletLaunch*)g_object_get_qdata(G_OBJECT(widget),
+                     priv->launch_quark);
+            length = launch ? get_placeholder_size(manager, launch->uid) : 0;
+            if (length <= 0) {
+                length = priv->size;
+            }
+            if (launch) {
+                launch->visible = extent < limit;
+            }
+        } else if (!gtk_widget_get_visible(widget) || length <= 1) {
+            continue;
+        }
+
+        extent += length;
+    }
+
+    g_list_free(list);
+}
+
+/* visible applets first, native ones ahead of interpreted, then panel order */
+static gint
+compare_launches(GtkWidget* a, GtkWidget* b, AwnAppletManager* manager)
+{
+    AwnAppletManagerPrivate* priv = manager->priv;
+    AwnAppletLaunch* la;
+    AwnAppletLaunch* lb;
+
+    la = (AwnAppletLaunch*)g_object_get_qdata(G_OBJECT(a), priv->launch_quark);
+    lb = (AwnAppletLaunch*)g_object_get_qdata(G_OBJECT(b), priv->launch_quark);
+
+    if (la->visible != lb->visible) {
+        return la->visible ? -1 : 1;
+    }
+    if (la->native != lb->native) {
+        return la->native ? -1 : 1;
+    }
+    return la->queued < lb->queued ? -1 : la->queued > lb->queued ? 1 : 0;
+}
+
+static gboolean
+run_launches(AwnAppletManager* manager)
+{
+    AwnAppletManagerPrivate* priv = manager->priv;
+
+    priv->launch_id = 0;
+
+    if (g_queue_get_length(priv->launch_queue) > 1) {
+        update_launch_visibility(manager);
+        /* g_queue_sort() is stable */
+        g_queue_sort(priv->launch_queue, (GCompareDataFunc)compare_launches,
+                     manager);
+    }
+
+    while (!g_queue_is_empty(priv->launch_queue) &&
+            (priv->launch_limit <= 0 ||
+             priv->launches_running < priv->launch_limit)) {
+        GtkWidget* applet = GTK_WIDGET(g_queue_pop_head(priv->launch_queue));
+        AwnAppletLaunch* launch;
+
+        launch = (AwnAppletLaunch*)g_object_get_qdata(G_OBJECT(applet),
+                 priv->launch_quark);
+        launch->running = TRUE;
+        launch->spawned = g_timer_elapsed(priv->launch_timer, NULL);
+        launch->timeout_id = g_timeout_add_seconds(APPLET_LAUNCH_TIMEOUT,
+                             (GSourceFunc)on_launch_timeout, launch);
+        priv->launches_running++;
+
+        /* might emit applet-crashed right away */
+        awn_applet_proxy_execute(AWN_APPLET_PROXY(applet));
+    }
+
+    return FALSE;
+}
+
+static void
+schedule_launches(AwnAppletManager* manager)
+{
+    AwnAppletManagerPrivate* priv = manager->priv;
+
+    if (priv->launch_id == 0 && priv->launch_queue &&
+            !g_queue_is_empty(priv->launch_queue)) {
+        priv->launch_id = g_idle_add_full(G_PRIORITY_HIGH_IDLE,
+                                          (GSourceFunc)run_launches,
+                                          manager, NULL);
+    }
+}
+
+static void
+queue_launch(AwnAppletManager* manager, GtkWidget* applet,
+             const gchar* path, const gchar* uid)
+{
+    AwnAppletManagerPrivate* priv = manager->priv;
+    AwnAppletLaunch* launch;
+
+    launch = g_slice_new0(AwnAppletLaunch);
+    launch->manager = manager;
+    launch->applet = applet;
+    launch->uid = g_strdup(uid);
+    launch->native = applet_is_native(path);
+    launch->queued = g_timer_elapsed(priv->launch_timer, NULL);
+    g_object_set_qdata_full(G_OBJECT(applet), priv->launch_quark, launch,
+                            (GDestroyNotify)awn_applet_launch_free);
+
+    update_placeholder_size(NULL, applet, manager);
+
+    /* ordered by run_launches() */
+    g_queue_push_tail(priv->launch_queue, applet);
+
+    schedule_launches(manager);
+}
+
 /*
  * APPLET CONTROL
  */
@@ -653,6 +1127,8 @@ _applet_plug_added(AwnAppletManager* manager, GtkWidget* applet)
             gtk_widget_show(applet);
         }
         gtk_widget_hide(awn_applet_proxy_get_throbber(proxy));
+
+        finish_launch(manager, applet, "embedded");
     }
 
     g_signal_emit(manager, _applet_manager_signals[APPLET_EMBEDDED], 0, applet);
@@ -667,6 +1143,8 @@ _applet_crashed(AwnAppletManager* manager, AwnAppletProxy* proxy)
     if (manager->priv->docklet_mode == FALSE) {
         gtk_widget_show(awn_applet_proxy_get_throbber(proxy));
     }
+
+    finish_launch(manager, GTK_WIDGET(proxy), "exited");
 }
 
 static GtkWidget*
@@ -702,13 +1180,15 @@ create_applet(AwnAppletManager* manager,
                                  G_CALLBACK(_applet_plug_added), manager);
         g_signal_connect_swapped(applet, "applet-crashed",
                                  G_CALLBACK(_applet_crashed), manager);
+        g_signal_connect(applet, "size-allocate",
+                         G_CALLBACK(on_applet_size_alloc), manager);
         widget = awn_applet_proxy_get_throbber(AWN_APPLET_PROXY(applet));
         g_signal_connect(widget, "size-allocate",
                          G_CALLBACK(on_icon_size_alloc), manager);
 
         gtk_box_pack_start(GTK_BOX(manager), applet, FALSE, FALSE, 0);
 
-        awn_applet_proxy_schedule_execute(AWN_APPLET_PROXY(applet));
+        queue_launch(manager, applet, path, uid);
     }
 
     gtk_box_pack_start(GTK_BOX(manager), widget, expand, fill, 0);
@@ -728,32 +1208,24 @@ create_applet(AwnAppletManager* manager,
     return applet;
 }
 
-static void
-zero_applets(gpointer key, GtkWidget* applet, AwnAppletManager* manager)
-{
-    if (G_IS_OBJECT(applet)) {
-        g_object_set_qdata(G_OBJECT(applet),
-                           manager->priv->touch_quark, GINT_TO_POINTER(0));
-    }
-}
-
 static gboolean
 delete_applets(gpointer key, GtkWidget* applet, AwnAppletManager* manager)
 {
     AwnAppletManagerPrivate* priv = manager->priv;
     const gchar*             uid;
-    gint                     touched;
+    guint                    touched;
 
     if (!G_IS_OBJECT(applet)) {
         return TRUE;
     }
 
-    touched = GPOINTER_TO_INT(g_object_get_qdata(G_OBJECT(applet),
-                              priv->touch_quark));
+    touched = GPOINTER_TO_UINT(g_object_get_qdata(G_OBJECT(applet),
+                               priv->touch_quark));
 
-    if (!touched) {
+    if (touched != priv->touch_serial) {
         if (AWN_IS_APPLET_PROXY(applet)) {
             g_object_get(applet, "uid", &uid, NULL);
+            finish_launch(manager, applet, "removed");
             g_signal_emit(manager, _applet_manager_signals[APPLET_REMOVED],
                           0, applet);
         } else if (GTK_IS_IMAGE(applet) && !AWN_IS_SEPARATOR(applet)) { // expander
@@ -776,94 +1248,126 @@ awn_applet_manager_refresh_applets(AwnAppletManager* manager)
 {
     AwnAppletManagerPrivate* priv = manager->priv;
     GSList*                  a;
-    GList*                   w;
-    gint                     i = 0;
-    gint                     applet_num = 0;
+    GHashTableIter           iter;
+    gpointer                 widget, value;
+    GSList**                 extras;
+    GList*                   children;
+    GPtrArray*               order;
+    guint                    applet_count;
+    guint                    applet_num = 0;
 
     if (!gtk_widget_get_realized(GTK_WIDGET(manager))) {
         return;
     }
 
+    /* Everything not touched by this refresh gets removed */
+    priv->touch_serial++;
+
     if (priv->applet_list == NULL) {
         g_debug("No applets");
-        g_hash_table_foreach(priv->applets, (GHFunc)zero_applets, manager);
         g_hash_table_foreach_remove(priv->applets, (GHRFunc)delete_applets,
                                     manager);
         return;
     }
 
-    guint applet_count = g_slist_length(priv->applet_list);
-    gint back_pos = (gint)applet_count;
-    back_pos = -back_pos;
-
-    /* Set each of the current apps as "untouched" */
-    g_hash_table_foreach(priv->applets, (GHFunc)zero_applets, manager);
+    applet_count = g_slist_length(priv->applet_list);
 
-    GList* widgets = g_hash_table_get_keys(priv->extra_widgets);
-    /* Go through the list of applets. Re-order those that are already active,
-     * and create those that are not
+    /* Which extra widgets go in front of which applet: a position >= 0
+     * counts from the start of the list, a negative one from its end.
      */
-    for (a = priv->applet_list; a; a = a->next) {
-        GtkWidget* applet = NULL;
-        gchar**     tokens;
+    extras = g_new0(GSList*, applet_count);
+    g_hash_table_iter_init(&iter, priv->extra_widgets);
+    while (g_hash_table_iter_next(&iter, &widget, &value)) {
+        gint pos = GPOINTER_TO_INT(value);
 
-        /* Get the two tokens from the saved string, where:
-         * tokens[0] == path to applet desktop file &
-         * tokens[1] == uid of applet
-         */
-        tokens = g_strsplit(a->data, "::", 2);
+        if (pos < 0) {
+            pos += applet_count;
+        }
+        if (pos >= 0 && pos < (gint)applet_count) {
+            extras[pos] = g_slist_prepend(extras[pos], widget);
+        }
+    }
+
+    order = g_ptr_array_sized_new(applet_count * 2);
 
-        if (tokens == NULL || g_strv_length(tokens) != 2) {
-            g_warning("Bad applet key: %s", (gchar*)a->data);
+    /* Go through the list of applets. Create those that are not active yet,
+     * and collect the order the box children should be in.
+     */
+    for (a = priv->applet_list; a; a = a->next) {
+        const gchar* entry = (const gchar*)a->data;
+        const gchar* separator;
+        GtkWidget*   applet;
+
+        /* The saved string is "path to applet desktop file::uid of applet" */
+        separator = entry ? strstr(entry, "::") : NULL;
+        if (separator == NULL) {
+            g_warning("Bad applet key: %s", entry);
             continue;
         }
 
-        /* See if the applet already exists */
-        applet = g_hash_table_lookup(priv->applets, tokens[1]);
+        const gchar* uid = separator + 2;
 
-        /* If not, create it */
+        /* See if the applet already exists, if not, create it */
+        applet = g_hash_table_lookup(priv->applets, uid);
         if (applet == NULL) {
-            applet = create_applet(manager, tokens[0], tokens[1]);
+            gchar* path = g_strndup(entry, separator - entry);
+            applet = create_applet(manager, path, uid);
+            g_free(path);
             if (!applet) {
-                g_strfreev(tokens);
                 continue;
             }
+        } else if (GPOINTER_TO_UINT(g_object_get_qdata(G_OBJECT(applet),
+                                    priv->touch_quark)) == priv->touch_serial) {
+            g_warning("Duplicate applet key: %s", entry);
+            continue;
         }
 
-        /* insert extra widgets on correct position */
-        w = widgets;
-        while (w) {
-            gint pos = GPOINTER_TO_INT(g_hash_table_lookup(priv->extra_widgets,
-                                       w->data));
-
-            if (pos == applet_num || pos == back_pos) {
-                gtk_box_reorder_child(GTK_BOX(manager), w->data, i++);
-                /* widget placed, remove from list */
-                widgets = g_list_remove(widgets, w->data);
-                w = widgets;
-                continue;
-            }
-
-            w = w->next;
+        /* extra widgets placed in front of this applet */
+        extras[applet_num] = g_slist_reverse(extras[applet_num]);
+        for (GSList* e = extras[applet_num]; e; e = e->next) {
+            g_ptr_array_add(order, e->data);
         }
         applet_num++;
-        back_pos++;
 
-        /* Order the applet correctly */
-        gtk_box_reorder_child(GTK_BOX(manager), applet, i++);
+        g_ptr_array_add(order, applet);
         if (AWN_IS_APPLET_PROXY(applet)) {
-            gtk_box_reorder_child(GTK_BOX(manager),
-                                  awn_applet_proxy_get_throbber(AWN_APPLET_PROXY(applet)), i++);
+            g_ptr_array_add(order,
+                            awn_applet_proxy_get_throbber(AWN_APPLET_PROXY(applet)));
         }
 
         /* Make sure we don't kill it during clean up */
         g_object_set_qdata(G_OBJECT(applet),
-                           priv->touch_quark, GINT_TO_POINTER(1));
+                           priv->touch_quark, GUINT_TO_POINTER(priv->touch_serial));
+    }
 
-        g_strfreev(tokens);
+    /* extra widgets without a matching applet end up behind them, in the
+     * order they are in now */
+    children = gtk_container_get_children(GTK_CONTAINER(manager));
+    for (GList* l = children; l; l = l->next) {
+        gint pos;
+
+        if (!g_hash_table_lookup_extended(priv->extra_widgets, l->data,
+                                          NULL, &value)) {
+            continue;
+        }
+        pos = GPOINTER_TO_INT(value);
+        if (pos < 0) {
+            pos += applet_count;
+        }
+        if (pos < 0 || pos >= (gint)applet_num) {
+            g_ptr_array_add(order, l->data);
+        }
     }
+    g_list_free(children);
+
+    /* applets about to be removed aren't in order, they are left alone */
+    awn_utils_reorder_box_children(GTK_BOX(manager), order);
 
-    g_list_free(widgets);
+    g_ptr_array_free(order, TRUE);
+    for (guint i = 0; i < applet_count; i++) {
+        g_slist_free(extras[i]);
+    }
+    g_free(extras);
 
     /* Delete applets that have been removed from the list */
     g_hash_table_foreach_remove(priv->applets, (GHRFunc)delete_applets, manager);
@@ -28,6 +28,7 @@
 #include "awn-applet-proxy.h"
 #include "awn-throbber.h"
 #include "libawn/gseal-transition.h"
+#include "libawn/awn-trace.h"
 
 extern "C" {
     G_DEFINE_TYPE(AwnAppletProxy, awn_applet_proxy, GTK_TYPE_SOCKET)
@@ -55,7 +56,9 @@ struct _AwnAppletProxyPrivate {
     GtkWidget* throbber;
 
     gint old_x, old_y, old_w, old_h;
-    guint idle_id;
+
+    /* last known size of the applet, used until the plug sizes itself */
+    gint placeholder_size;
 };
 
 enum {
@@ -78,6 +81,7 @@ static guint _proxy_signals[LAST_SIGNAL] = { 0 };
  * FORWARDS
  */
 static gboolean on_plug_removed(AwnAppletProxy* proxy, gpointer user_data);
+static void     on_plug_added(AwnAppletProxy* proxy, gpointer user_data);
 static void     on_size_alloc(AwnAppletProxy* proxy, GtkAllocation* a);
 static void     on_child_exit(GPid pid, gint status, gpointer user_data);
 
@@ -155,27 +159,32 @@ static void
 awn_applet_proxy_size_request(GtkWidget* widget, GtkRequisition* req)
 {
     AwnAppletProxyPrivate* priv = AWN_APPLET_PROXY_GET_PRIVATE(widget);
+    gint64 trace_start = awn_trace_begin();
 
     // call base.size_request()
     GTK_WIDGET_CLASS(awn_applet_proxy_parent_class)->size_request(widget, req);
 
     if (!priv->size_req_initialized && req->width == 1 && req->height == 1) {
         // to prevent flicker we set the size request to the same value
-        //   as AwnThrobber uses
+        //   as AwnThrobber uses (or the size the applet had last time)
+        gint size = priv->placeholder_size > 0 ?
+                    priv->placeholder_size : APPLY_SIZE_MULTIPLIER(priv->size);
         switch (priv->position) {
         case GTK_POS_LEFT:
         case GTK_POS_RIGHT:
-            req->height = APPLY_SIZE_MULTIPLIER(priv->size);
+            req->height = size;
             break;
         case GTK_POS_BOTTOM:
         case GTK_POS_TOP:
         default:
-            req->width = APPLY_SIZE_MULTIPLIER(priv->size);
+            req->width = size;
             break;
         }
     } else if (!priv->size_req_initialized) {
         priv->size_req_initialized = TRUE;
     }
+
+    awn_trace_end(AWN_TRACE_SIZE_NEGOTIATION, trace_start);
 }
 
 static void
@@ -194,11 +203,6 @@ awn_applet_proxy_dispose(GObject* object)
         priv->throbber = NULL;
     }
 
-    if (priv->idle_id) {
-        g_source_remove(priv->idle_id);
-        priv->idle_id = 0;
-    }
-
     G_OBJECT_CLASS(awn_applet_proxy_parent_class)->dispose(object);
 }
 
@@ -295,6 +299,7 @@ awn_applet_proxy_init(AwnAppletProxy* proxy)
 
     /* Connect to the socket signals */
     g_signal_connect(proxy, "plug-removed", G_CALLBACK(on_plug_removed), NULL);
+    g_signal_connect(proxy, "plug-added", G_CALLBACK(on_plug_added), NULL);
     g_signal_connect(proxy, "size-allocate", G_CALLBACK(on_size_alloc), NULL);
     awn_utils_ensure_transparent_bg(GTK_WIDGET(proxy));
     /* Rest is for the crash notification window */
@@ -338,9 +343,43 @@ awn_applet_proxy_new(const gchar* path,
     return proxy;
 }
 
+/*
+ * Makes the throbber (and the socket, until the plug asks for a size) as
+ * big as the applet was the last time, so the panel doesn't have to reflow
+ * once it's embedded.
+ */
+void
+awn_applet_proxy_set_placeholder_size(AwnAppletProxy* proxy, gint size)
+{
+    AwnAppletProxyPrivate* priv;
+
+    g_return_if_fail(AWN_IS_APPLET_PROXY(proxy));
+    priv = proxy->priv;
+
+    priv->placeholder_size = size;
+
+    if (size <= 0) {
+        gtk_widget_set_size_request(priv->throbber, -1, -1);
+    } else if (priv->position == GTK_POS_LEFT ||
+               priv->position == GTK_POS_RIGHT) {
+        gtk_widget_set_size_request(priv->throbber, -1, size);
+    } else {
+        gtk_widget_set_size_request(priv->throbber, size, -1);
+    }
+}
+
 /*
  * GtkSocket callbacks
  */
+static void
+on_plug_added(AwnAppletProxy* proxy, gpointer user_data)
+{
+    g_return_if_fail(AWN_IS_APPLET_PROXY(proxy));
+
+    /* the throbber is only shown again if the applet crashes */
+    gtk_widget_set_size_request(proxy->priv->throbber, -1, -1);
+}
+
 static gboolean
 on_plug_removed(AwnAppletProxy* proxy, gpointer user_data)
 {
@@ -527,26 +566,3 @@ awn_applet_proxy_execute(AwnAppletProxy* proxy)
     g_strfreev(argv);
     g_free(exec);
 }
-
-static gboolean
-awn_applet_proxy_idle_cb(gpointer data)
-{
-    g_return_val_if_fail(AWN_IS_APPLET_PROXY(data), FALSE);
-    AwnAppletProxyPrivate* priv = AWN_APPLET_PROXY_GET_PRIVATE(data);
-
-    awn_applet_proxy_execute(AWN_APPLET_PROXY(data));
-
-    priv->idle_id = 0;
-
-    return FALSE;
-}
-
-void
-awn_applet_proxy_schedule_execute(AwnAppletProxy* proxy)
-{
-    AwnAppletProxyPrivate* priv = AWN_APPLET_PROXY_GET_PRIVATE(proxy);
-
-    if (priv->idle_id == 0) {
-        priv->idle_id = g_idle_add(awn_applet_proxy_idle_cb, proxy);
-    }
-}
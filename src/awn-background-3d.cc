@@ -391,12 +391,54 @@ draw_rect_path(cairo_t* cr, Point3* vertices, float padding)
     cairo_close_path(cr);
 }
 
+/* Geometry & gradient cache slots */
+enum {
+    PATH_TOP_PLANE = 0
+};
+
+enum {
+    PATTERN_TOP_PLANE = 0,
+    PATTERN_TEXTURE,
+    PATTERN_HIGHLIGHT
+};
+
+/**
+ * append_plane_path:
+ * @param cr: a cairo context
+ * @param cache: the geometry cache entry
+ * @param vertices: vertices to use for drawing
+ * @param padding: padding from top
+ *
+ * Same as draw_rect_path, but all the planes are the top plane moved down
+ * by &padding, so the path is built once and translated afterwards.
+ */
+static void
+append_plane_path(cairo_t* cr, AwnBackgroundCache* cache,
+                  Point3* vertices, float padding)
+{
+    if (cache == NULL) {
+        draw_rect_path(cr, vertices, padding);
+        return;
+    }
+    if (cache->paths[PATH_TOP_PLANE] == NULL) {
+        draw_rect_path(cr, vertices, 0.);
+        awn_background_cache_store_path(cache, PATH_TOP_PLANE, cr);
+    }
+    /* the path isn't part of the graphics state, so it survives restore */
+    cairo_new_path(cr);
+    cairo_save(cr);
+    cairo_translate(cr, 0., padding);
+    awn_background_cache_append_path(cache, PATH_TOP_PLANE, cr);
+    cairo_restore(cr);
+}
+
 /**
  * draw_top_bottom_background:
  * @param bg: AwnBackground
  * @param cr: a cairo context
  * @param width: the width for the drawing
  * @param height: the height for the drawing
+ * @param cache: the geometry cache entry of this style
  *
  * Draws the bar in the bottom position on the cairo context &cr
  * on position x:0, y:0 with the specified &width and &height.
@@ -405,7 +447,8 @@ static void
 draw_top_bottom_background(AwnBackground*  bg,
                            cairo_t*        cr,
                            gfloat          width,
-                           gfloat          height)
+                           gfloat          height,
+                           AwnBackgroundCache* cache)
 {
     cairo_pattern_t* pat;
     float s = OBTAIN_THICKNESS(bg->panel_angle, bg->thickness);
@@ -419,7 +462,11 @@ draw_top_bottom_background(AwnBackground*  bg,
     width -= DRAW_XPADDING * 2.;
 
     /* calc vertices for draw the main path */
-    Point3* vertices = calc_points(bg, 0., 0., width, height);
+    Point3* vertices = (Point3*)awn_background_cache_get_data(cache);
+    if (vertices == NULL) {
+        vertices = calc_points(bg, 0., 0., width, height);
+        awn_background_cache_set_data(cache, vertices, free);
+    }
     /* calc the y coord of the top panel, used for pattern painting */
     float top_y = vertices[8].y;
 
@@ -440,7 +487,7 @@ draw_top_bottom_background(AwnBackground*  bg,
         /* if side is transparent (1. / 255.), don't draw bottom border */
         if (alpha > 0.003) {
             cairo_set_operator(cr, CAIRO_OPERATOR_OVER);
-            draw_rect_path(cr, vertices, s);
+            append_plane_path(cr, cache, vertices, s);
 #if FILL_BOTTOM_PLANE
             cairo_save(cr);
             awn_cairo_set_source_color(cr, bg->hilight_color);
@@ -456,7 +503,7 @@ draw_top_bottom_background(AwnBackground*  bg,
             cairo_set_line_width(cr, 1.5);
             cairo_set_operator(cr, CAIRO_OPERATOR_OVER);
             for (i = s - 1.; i >= 0. ; i -= 1.) {
-                draw_rect_path(cr, vertices, i);
+                append_plane_path(cr, cache, vertices, i);
                 awn_cairo_set_source_color(cr, bg->hilight_color);
                 cairo_stroke(cr);
             }
@@ -503,52 +550,61 @@ draw_top_bottom_background(AwnBackground*  bg,
     cairo_set_operator(cr, CAIRO_OPERATOR_OVER);
     cairo_set_line_width(cr, 2.);
     /* Draw the path of top plane */
-    draw_rect_path(cr, vertices, 0.);
+    append_plane_path(cr, cache, vertices, 0.);
     /* obtain 0.0 - 1.0 relative height for pattern drawing */
     top_y = top_y / height;
 
     /* Paint the top plane gradient */
-    pat = cairo_pattern_create_linear(0., 0., 0., height);
-    awn_cairo_pattern_add_color_stop_color(pat, top_y, bg->g_step_1);
-    awn_cairo_pattern_add_color_stop_color(pat, 1.0, bg->g_step_2);
+    pat = awn_background_cache_get_pattern(cache, PATTERN_TOP_PLANE);
+    if (pat == NULL) {
+        pat = cairo_pattern_create_linear(0., 0., 0., height);
+        awn_cairo_pattern_add_color_stop_color(pat, top_y, bg->g_step_1);
+        awn_cairo_pattern_add_color_stop_color(pat, 1.0, bg->g_step_2);
+        awn_background_cache_set_pattern(cache, PATTERN_TOP_PLANE, pat);
+    }
     cairo_save(cr);
     cairo_clip_preserve(cr);
     cairo_set_source(cr, pat);
     cairo_paint(cr);
-    cairo_pattern_destroy(pat);
     cairo_restore(cr);
 
     if (bg->enable_pattern && bg->pattern) {
         /* Paint the top plane pattern */
         cairo_save(cr);
-        pat = cairo_pattern_create_for_surface(bg->pattern);
-        cairo_pattern_set_extend(pat, CAIRO_EXTEND_REPEAT);
+        pat = awn_background_cache_get_pattern(cache, PATTERN_TEXTURE);
+        if (pat == NULL) {
+            pat = cairo_pattern_create_for_surface(bg->pattern);
+            cairo_pattern_set_extend(pat, CAIRO_EXTEND_REPEAT);
+            awn_background_cache_set_pattern(cache, PATTERN_TEXTURE, pat);
+        }
         cairo_clip_preserve(cr);
         cairo_set_source(cr, pat);
         cairo_paint(cr);
-        cairo_pattern_destroy(pat);
         cairo_restore(cr);
     }
 
 #if DRAW_HIGHLIGHT
     /* Prepare the hi-light */
-    pat = cairo_pattern_create_linear(0., 0., 0., height);
-    awn_cairo_pattern_add_color_stop_color
-    (pat, top_y + 0.0, bg->g_histep_1);
-    awn_cairo_pattern_add_color_stop_color
-    (pat, top_y + (1. - top_y) * 0.3, bg->g_histep_2);
+    pat = awn_background_cache_get_pattern(cache, PATTERN_HIGHLIGHT);
+    if (pat == NULL) {
+        pat = cairo_pattern_create_linear(0., 0., 0., height);
+        awn_cairo_pattern_add_color_stop_color
+        (pat, top_y + 0.0, bg->g_histep_1);
+        awn_cairo_pattern_add_color_stop_color
+        (pat, top_y + (1. - top_y) * 0.3, bg->g_histep_2);
 
-    desktop_agnostic_color_get_cairo_color
-    (bg->g_histep_2, &red, &green, &blue, &alpha);
-    cairo_pattern_add_color_stop_rgba
-    (pat, top_y + (1. - top_y) * 0.4, red, green, blue, 0.);
+        desktop_agnostic_color_get_cairo_color
+        (bg->g_histep_2, &red, &green, &blue, &alpha);
+        cairo_pattern_add_color_stop_rgba
+        (pat, top_y + (1. - top_y) * 0.4, red, green, blue, 0.);
+        awn_background_cache_set_pattern(cache, PATTERN_HIGHLIGHT, pat);
+    }
     /* Paint the hi-light gradient */
     cairo_save(cr);
     cairo_clip_preserve(cr);
     cairo_set_source(cr, pat);
     cairo_paint(cr);
     cairo_restore(cr);
-    cairo_pattern_destroy(pat);
 #endif
 #if DRAW_INTERNAL_BORDER
     /* Internal border of the top surface */
@@ -575,8 +631,6 @@ draw_top_bottom_background(AwnBackground*  bg,
 #endif
     /* restore genereal context */
     cairo_restore(cr);
-    /* free memory :) */
-    free(vertices);
 }
 
 /**
@@ -705,9 +759,13 @@ awn_background_3d_draw(AwnBackground*  bg,
                        GtkPositionType  position,
                        GdkRectangle*   area)
 {
+    AwnBackgroundCache* cache;
     gint temp;
     gint x = area->x, y = area->y;
     gint width = area->width, height = area->height;
+
+    cache = awn_background_cache_lookup(bg, AWN_TYPE_BACKGROUND_3D,
+                                        position, area, 0);
     cairo_save(cr);
 
     switch (position) {
@@ -736,7 +794,7 @@ awn_background_3d_draw(AwnBackground*  bg,
         break;
     }
 
-    draw_top_bottom_background(bg, cr, width, height);
+    draw_top_bottom_background(bg, cr, width, height, cache);
 
     cairo_restore(cr);
 }
@@ -0,0 +1,274 @@
+/*
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301  USA.
+ *
+ */
+
+/*
+ * Redraws every background style a number of times at several sizes,
+ * once with the geometry cache flushed before each frame (which is what
+ * every frame used to cost) and once with the cache kept warm.
+ *
+ * The second part exposes a mapped window repeatedly and compares the
+ * bytes written to the X connection (and time) when the cached background
+ * is kept client-side (as an image surface) and when it's a server-side
+ * surface, as AwnBackground keeps it. Run it against Xvfb, eg.
+ *   xvfb-run -s "-screen 0 2048x768x24" ./awn-background-benchmark
+ *
+ * Usage: awn-background-benchmark [iterations]
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <gtk/gtk.h>
+#include <libdesktop-agnostic/vfs.h>
+
+#include "awn-background.h"
+#include "awn-background-3d.h"
+#include "awn-background-curves.h"
+#include "awn-background-edgy.h"
+#include "awn-background-flat.h"
+#include "awn-background-floaty.h"
+#include "awn-background-lucido.h"
+#include "awn-panel.h"
+
+#define DEFAULT_ITERATIONS 1000
+
+typedef struct {
+    const gchar* name;
+    GType (*get_type)(void);
+} BenchStyle;
+
+static const BenchStyle styles[] = {
+    { "flat",   awn_background_flat_get_type },
+    { "3d",     awn_background_3d_get_type },
+    { "curves", awn_background_curves_get_type },
+    { "edgy",   awn_background_edgy_get_type },
+    { "floaty", awn_background_floaty_get_type },
+    { "lucido", awn_background_lucido_get_type }
+};
+
+static const struct {
+    gint width;
+    gint height;
+} sizes[] = {
+    { 200, 48 },
+    { 640, 64 },
+    { 1280, 100 },
+    { 1920, 160 }
+};
+
+static gdouble
+run(AwnBackground* bg, cairo_t* cr, GdkRectangle* area, gint iterations,
+    gboolean flush)
+{
+    GTimer* timer = g_timer_new();
+    gdouble elapsed;
+
+    for (gint i = 0; i < iterations; i++) {
+        if (flush) {
+            awn_background_cache_flush(bg);
+        }
+        cairo_save(cr);
+        cairo_set_operator(cr, CAIRO_OPERATOR_CLEAR);
+        cairo_paint(cr);
+        cairo_restore(cr);
+        awn_background_draw(bg, cr, GTK_POS_BOTTOM, area);
+    }
+    cairo_surface_flush(cairo_get_target(cr));
+
+    elapsed = g_timer_elapsed(timer, NULL);
+    g_timer_destroy(timer);
+
+    return elapsed;
+}
+
+/* bytes written by this process so far (X requests included) */
+static guint64
+get_written_bytes(void)
+{
+    gchar* contents = NULL;
+    guint64 wchar = 0;
+
+    if (g_file_get_contents("/proc/self/io", &contents, NULL, NULL)) {
+        gchar* line = strstr(contents, "wchar:");
+        if (line) {
+            wchar = g_ascii_strtoull(line + strlen("wchar:"), NULL, 10);
+        }
+        g_free(contents);
+    }
+
+    return wchar;
+}
+
+static void
+run_expose(AwnBackground* bg, GtkWidget* window, GdkRectangle* area,
+           gint iterations, gboolean client_side)
+{
+    GTimer* timer;
+    guint64 written;
+    cairo_surface_t* image = NULL;
+
+    if (client_side) {
+        /* this is what the helper surface used to be */
+        cairo_t* cr;
+        image = cairo_image_surface_create(CAIRO_FORMAT_ARGB32,
+                                           area->width, area->height);
+        cr = cairo_create(image);
+        awn_background_draw(bg, cr, GTK_POS_BOTTOM, area);
+        cairo_destroy(cr);
+    } else {
+        /* first frame renders a new helper surface for the window */
+        awn_background_invalidate(bg);
+    }
+
+    gdk_display_sync(gtk_widget_get_display(window));
+    written = get_written_bytes();
+    timer = g_timer_new();
+
+    for (gint i = 0; i < iterations; i++) {
+        cairo_t* cr = gdk_cairo_create(gtk_widget_get_window(window));
+        if (image) {
+            cairo_set_source_surface(cr, image, 0., 0.);
+            cairo_paint(cr);
+        } else {
+            awn_background_draw(bg, cr, GTK_POS_BOTTOM, area);
+        }
+        cairo_destroy(cr);
+        gdk_flush();
+    }
+    gdk_display_sync(gtk_widget_get_display(window));
+
+    g_print("%-12s %5dx%-5d %10.2f %14.1f\n",
+            client_side ? "client-side" : "server-side",
+            area->width, area->height,
+            g_timer_elapsed(timer, NULL) * 1000.0,
+            (get_written_bytes() - written) / 1024.0);
+
+    g_timer_destroy(timer);
+    if (image) {
+        cairo_surface_destroy(image);
+    }
+}
+
+static void
+bench_expose(DesktopAgnosticConfigClient* client, GtkWidget* panel,
+             gint iterations)
+{
+    AwnBackground* bg = AWN_BACKGROUND(g_object_new(AWN_TYPE_BACKGROUND_FLAT,
+                                       "client", client,
+                                       "panel", panel,
+                                       NULL));
+
+    g_print("\n%-12s %11s %10s %14s\n",
+            "helper", "size", "time/ms", "X traffic/KiB");
+
+    for (guint i = 0; i < G_N_ELEMENTS(sizes); i++) {
+        GdkRectangle area = { 0, 0, sizes[i].width, sizes[i].height };
+        GtkWidget* window = gtk_window_new(GTK_WINDOW_TOPLEVEL);
+
+        gtk_widget_set_app_paintable(window, TRUE);
+        gtk_window_set_default_size(GTK_WINDOW(window),
+                                    area.width, area.height);
+        gtk_widget_show(window);
+        while (gtk_events_pending()) {
+            gtk_main_iteration();
+        }
+
+        awn_background_invalidate(bg);
+        run_expose(bg, window, &area, iterations, TRUE);
+        run_expose(bg, window, &area, iterations, FALSE);
+
+        gtk_widget_destroy(window);
+    }
+
+    g_object_unref(bg);
+}
+
+gint
+main(gint argc, gchar* argv[])
+{
+    DesktopAgnosticConfigClient* client;
+    GtkWidget* panel;
+    GError* error = NULL;
+    gint iterations = DEFAULT_ITERATIONS;
+
+    gtk_init(&argc, &argv);
+
+    if (argc > 1) {
+        iterations = MAX(1, atoi(argv[1]));
+    }
+
+    desktop_agnostic_vfs_init(&error);
+    if (error) {
+        g_critical("Error initializing VFS subsystem: %s", error->message);
+        g_error_free(error);
+        return EXIT_FAILURE;
+    }
+
+    panel = awn_panel_new_with_panel_id(AWN_PANEL_ID_DEFAULT);
+    g_return_val_if_fail(panel, EXIT_FAILURE);
+    gtk_widget_realize(panel);
+
+    client = awn_config_get_default(AWN_PANEL_ID_DEFAULT, NULL);
+
+    g_print("%-8s %11s %12s %12s %8s\n",
+            "style", "size", "uncached/ms", "cached/ms", "speedup");
+
+    for (guint s = 0; s < G_N_ELEMENTS(styles); s++) {
+        AwnBackground* bg = AWN_BACKGROUND(g_object_new(styles[s].get_type(),
+                                           "client", client,
+                                           "panel", panel,
+                                           NULL));
+        /* measure the style itself, not the helper surface blit */
+        bg->cache_enabled = FALSE;
+
+        for (guint i = 0; i < G_N_ELEMENTS(sizes); i++) {
+            GdkRectangle area = { 0, 0, sizes[i].width, sizes[i].height };
+            cairo_surface_t* surface;
+            cairo_t* cr;
+            gdouble uncached, cached;
+
+            surface = cairo_image_surface_create(CAIRO_FORMAT_ARGB32,
+                                                 area.width, area.height);
+            cr = cairo_create(surface);
+
+            uncached = run(bg, cr, &area, iterations, TRUE);
+            cached = run(bg, cr, &area, iterations, FALSE);
+
+            g_print("%-8s %5dx%-5d %12.2f %12.2f %7.2fx\n",
+                    styles[s].name, area.width, area.height,
+                    uncached * 1000.0, cached * 1000.0,
+                    cached > 0.0 ? uncached / cached : 0.0);
+
+            cairo_destroy(cr);
+            cairo_surface_destroy(surface);
+        }
+
+        g_object_unref(bg);
+    }
+
+    bench_expose(client, panel, iterations);
+
+    gtk_widget_destroy(panel);
+
+    desktop_agnostic_vfs_shutdown(NULL);
+
+    return EXIT_SUCCESS;
+}
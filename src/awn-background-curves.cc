@@ -130,6 +130,18 @@ draw_rect_path(AwnBackground*  bg,
     cairo_restore(cr);
 }
 
+/* Geometry & gradient cache slots, the outer border reuses the outer path */
+enum {
+    CURVES_PATH_OUTER = 0,
+    CURVES_PATH_INNER_BORDER,
+    CURVES_PATH_INNER
+};
+
+enum {
+    CURVES_PATTERN_OUTER = 0,
+    CURVES_PATTERN_INNER
+};
+
 /**
  * draw_top_bottom_background:
  * @param bg: AwnBackground
@@ -138,6 +150,7 @@ draw_rect_path(AwnBackground*  bg,
  * @param y: the begin y position to draw
  * @param width: the width for the drawing
  * @param height: the height for the drawing
+ * @param cache: the geometry cache entry of this style
  *
  * Draws the bar in the bottom position on the cairo context &cr given
  * the &x position, &y position, &width and &height.
@@ -148,7 +161,8 @@ draw_top_bottom_background(AwnBackground*  bg,
                            gdouble         x,
                            gdouble         y,
                            gint            width,
-                           gint            height)
+                           gint            height,
+                           AwnBackgroundCache* cache)
 {
     cairo_pattern_t* pat;
     cairo_matrix_t matrix;
@@ -165,10 +179,12 @@ draw_top_bottom_background(AwnBackground*  bg,
     }
 
     /* Drawing outer ellips */
-    if (bg->enable_pattern && bg->pattern) {
+    pat = awn_background_cache_get_pattern(cache, CURVES_PATTERN_OUTER);
+    if (pat == NULL && bg->enable_pattern && bg->pattern) {
         pat = cairo_pattern_create_for_surface(bg->pattern);
         cairo_pattern_set_extend(pat, CAIRO_EXTEND_REPEAT);
-    } else {
+        awn_background_cache_set_pattern(cache, CURVES_PATTERN_OUTER, pat);
+    } else if (pat == NULL) {
         // we need pat_xscale for scaling the spherical gradient to ellipse...
         // why * 1.5 ? because it looks better :)
         const gdouble pat_xscale = curves_height / width * 1.5;
@@ -183,28 +199,33 @@ draw_top_bottom_background(AwnBackground*  bg,
         // scale to ellipse
         cairo_matrix_init_scale(&matrix, pat_xscale, 1.0);
         cairo_pattern_set_matrix(pat, &matrix);
+        awn_background_cache_set_pattern(cache, CURVES_PATTERN_OUTER, pat);
     }
 
     cairo_save(cr);
 
-    draw_rect_path(bg, cr, 0, height - curves_height, width, curves_height);
+    if (!awn_background_cache_append_path(cache, CURVES_PATH_OUTER, cr)) {
+        draw_rect_path(bg, cr, 0, height - curves_height, width, curves_height);
+        awn_background_cache_store_path(cache, CURVES_PATH_OUTER, cr);
+    }
     cairo_clip(cr);
     cairo_set_source(cr, pat);
     cairo_paint(cr);
 
     cairo_restore(cr);
 
-    cairo_pattern_destroy(pat);
-
     /* Internal border */
     awn_cairo_set_source_color(cr, bg->hilight_color);
-    draw_rect_path(bg, cr, 1.0, height - curves_height + 2.0,
-                   width - 2.0, curves_height - 2.0);
+    if (!awn_background_cache_append_path(cache, CURVES_PATH_INNER_BORDER, cr)) {
+        draw_rect_path(bg, cr, 1.0, height - curves_height + 2.0,
+                       width - 2.0, curves_height - 2.0);
+        awn_background_cache_store_path(cache, CURVES_PATH_INNER_BORDER, cr);
+    }
     cairo_stroke(cr);
 
     /* External border */
     awn_cairo_set_source_color(cr, bg->border_color);
-    draw_rect_path(bg, cr, 0.0, height - curves_height, width, curves_height);
+    awn_background_cache_append_path(cache, CURVES_PATH_OUTER, cr);
     cairo_stroke(cr);
 
     /* Drawing inner ellips */
@@ -216,22 +237,28 @@ draw_top_bottom_background(AwnBackground*  bg,
     x_pos = x_pos - min * 2;
     x_pos = x_pos * (bg->curves_symmetry) + min;
 
-    pat = cairo_pattern_create_radial(
-              (x_pos + width_inner / 2.0) * inner_pat_xscale, height, 0.01,
-              (x_pos + width_inner / 2.0) * inner_pat_xscale, height, curves_height / 2.0
-          );
-    awn_cairo_pattern_add_color_stop_color(pat, 0.0, bg->g_histep_1);
-    awn_cairo_pattern_add_color_stop_color(pat, 1.0, bg->g_histep_2);
+    pat = awn_background_cache_get_pattern(cache, CURVES_PATTERN_INNER);
+    if (pat == NULL) {
+        pat = cairo_pattern_create_radial(
+                  (x_pos + width_inner / 2.0) * inner_pat_xscale, height, 0.01,
+                  (x_pos + width_inner / 2.0) * inner_pat_xscale, height, curves_height / 2.0
+              );
+        awn_cairo_pattern_add_color_stop_color(pat, 0.0, bg->g_histep_1);
+        awn_cairo_pattern_add_color_stop_color(pat, 1.0, bg->g_histep_2);
 
-    // scale to ellipse
-    cairo_matrix_init_scale(&matrix, inner_pat_xscale, 1.0);
-    cairo_pattern_set_matrix(pat, &matrix);
+        // scale to ellipse
+        cairo_matrix_init_scale(&matrix, inner_pat_xscale, 1.0);
+        cairo_pattern_set_matrix(pat, &matrix);
+        awn_background_cache_set_pattern(cache, CURVES_PATTERN_INNER, pat);
+    }
 
-    draw_rect_path(bg, cr, x_pos, height - curves_height / 2.0,  width_inner, curves_height / 2.0);
+    if (!awn_background_cache_append_path(cache, CURVES_PATH_INNER, cr)) {
+        draw_rect_path(bg, cr, x_pos, height - curves_height / 2.0,  width_inner, curves_height / 2.0);
+        awn_background_cache_store_path(cache, CURVES_PATH_INNER, cr);
+    }
 
     cairo_set_source(cr, pat);
     cairo_fill(cr);
-    cairo_pattern_destroy(pat);
 }
 
 /**
@@ -319,9 +346,13 @@ awn_background_curves_draw(AwnBackground*  bg,
                            GtkPositionType  position,
                            GdkRectangle*   area)
 {
+    AwnBackgroundCache* cache;
     gint temp;
     gint x = area->x, y = area->y;
     gint width = area->width, height = area->height;
+
+    cache = awn_background_cache_lookup(bg, AWN_TYPE_BACKGROUND_CURVES,
+                                        position, area, 0);
     cairo_save(cr);
 
     switch (position) {
@@ -348,7 +379,7 @@ awn_background_curves_draw(AwnBackground*  bg,
         break;
     }
 
-    draw_top_bottom_background(bg, cr, 0, 0, width, height);
+    draw_top_bottom_background(bg, cr, 0, 0, width, height, cache);
 
     cairo_restore(cr);
 }
@@ -270,11 +270,25 @@ draw_path(cairo_t* cr, gint x, gdouble radius, gint width, gint height,
     }
 }
 
+/* Geometry & gradient cache slots */
+enum {
+    EDGY_PATH_FILL = 0,
+    EDGY_PATH_HILIGHT,
+    EDGY_PATH_INNER,
+    EDGY_PATH_OUTER
+};
+
+enum {
+    EDGY_PATTERN_FILL = 0,
+    EDGY_PATTERN_HILIGHT
+};
+
 static void
 draw_top_bottom_background(AwnBackground*  bg,
                            cairo_t*        cr,
                            gint            width,
-                           gint            height)
+                           gint            height,
+                           AwnBackgroundCache* cache)
 {
     cairo_pattern_t* pat;
 
@@ -304,20 +318,27 @@ draw_top_bottom_background(AwnBackground*  bg,
      */
 
     /* Draw the background */
-    if (bg->enable_pattern && bg->pattern) {
-        pat = cairo_pattern_create_for_surface(bg->pattern);
-        cairo_pattern_set_extend(pat, CAIRO_EXTEND_REPEAT);
-    } else {
-        pat = cairo_pattern_create_radial(bottom_left ? 0 : width, height, 1,
-                                          bottom_left ? 0 : width, height, height);
-        awn_cairo_pattern_add_color_stop_color(pat, 0.0, bg->g_step_2);
-        awn_cairo_pattern_add_color_stop_color(pat, 1.0, bg->g_step_1);
+    pat = awn_background_cache_get_pattern(cache, EDGY_PATTERN_FILL);
+    if (pat == NULL) {
+        if (bg->enable_pattern && bg->pattern) {
+            pat = cairo_pattern_create_for_surface(bg->pattern);
+            cairo_pattern_set_extend(pat, CAIRO_EXTEND_REPEAT);
+        } else {
+            pat = cairo_pattern_create_radial(bottom_left ? 0 : width, height, 1,
+                                              bottom_left ? 0 : width, height, height);
+            awn_cairo_pattern_add_color_stop_color(pat, 0.0, bg->g_step_2);
+            awn_cairo_pattern_add_color_stop_color(pat, 1.0, bg->g_step_1);
+        }
+        awn_background_cache_set_pattern(cache, EDGY_PATTERN_FILL, pat);
     }
 
     cairo_save(cr);
 
-    draw_path(cr, 0, height - 1.0, width, height, bottom_left);
-    cairo_line_to(cr, bottom_left ? 0.0 : width, height);
+    if (!awn_background_cache_append_path(cache, EDGY_PATH_FILL, cr)) {
+        draw_path(cr, 0, height - 1.0, width, height, bottom_left);
+        cairo_line_to(cr, bottom_left ? 0.0 : width, height);
+        awn_background_cache_store_path(cache, EDGY_PATH_FILL, cr);
+    }
     cairo_clip(cr);
     cairo_set_operator(cr, CAIRO_OPERATOR_SOURCE);
     cairo_set_source(cr, pat);
@@ -325,42 +346,52 @@ draw_top_bottom_background(AwnBackground*  bg,
 
     cairo_restore(cr);
 
-    cairo_pattern_destroy(pat);
-
     cairo_set_operator(cr, CAIRO_OPERATOR_OVER);
     /* Draw the hi-light */
 
-    pat = cairo_pattern_create_radial(bottom_left ? 0 : width, height,
-                                      height * 3 / 4,
-                                      bottom_left ? 0 : width, height,
-                                      height);
-    double red, green, blue, alpha;
-    desktop_agnostic_color_get_cairo_color(bg->g_histep_2, &red, &green, &blue, &alpha);
-    cairo_pattern_add_color_stop_rgba(pat, 0.0, red, green, blue, 0.);
-    awn_cairo_pattern_add_color_stop_color(pat, 0.2, bg->g_histep_2);
-    awn_cairo_pattern_add_color_stop_color(pat, 1.0, bg->g_histep_1);
-
-    draw_path(cr, 0, height * 3 / 4, width, height, bottom_left);
-    if (bottom_left) {
-        cairo_arc_negative(cr, 0, height, height - 2.0, 0.0, -M_PI / 2.0);
-    } else {
-        cairo_arc(cr, width, height, height - 2.0, -M_PI, -M_PI / 2.0);
+    pat = awn_background_cache_get_pattern(cache, EDGY_PATTERN_HILIGHT);
+    if (pat == NULL) {
+        pat = cairo_pattern_create_radial(bottom_left ? 0 : width, height,
+                                          height * 3 / 4,
+                                          bottom_left ? 0 : width, height,
+                                          height);
+        double red, green, blue, alpha;
+        desktop_agnostic_color_get_cairo_color(bg->g_histep_2, &red, &green, &blue, &alpha);
+        cairo_pattern_add_color_stop_rgba(pat, 0.0, red, green, blue, 0.);
+        awn_cairo_pattern_add_color_stop_color(pat, 0.2, bg->g_histep_2);
+        awn_cairo_pattern_add_color_stop_color(pat, 1.0, bg->g_histep_1);
+        awn_background_cache_set_pattern(cache, EDGY_PATTERN_HILIGHT, pat);
+    }
+
+    if (!awn_background_cache_append_path(cache, EDGY_PATH_HILIGHT, cr)) {
+        draw_path(cr, 0, height * 3 / 4, width, height, bottom_left);
+        if (bottom_left) {
+            cairo_arc_negative(cr, 0, height, height - 2.0, 0.0, -M_PI / 2.0);
+        } else {
+            cairo_arc(cr, width, height, height - 2.0, -M_PI, -M_PI / 2.0);
+        }
+        awn_background_cache_store_path(cache, EDGY_PATH_HILIGHT, cr);
     }
 
     cairo_set_source(cr, pat);
     cairo_fill(cr);
-    cairo_pattern_destroy(pat);
 
 paint_lines:
 
     /* Internal border */
     awn_cairo_set_source_color(cr, bg->hilight_color);
-    draw_path(cr, 0, height - 2.0, width, height, bottom_left);
+    if (!awn_background_cache_append_path(cache, EDGY_PATH_INNER, cr)) {
+        draw_path(cr, 0, height - 2.0, width, height, bottom_left);
+        awn_background_cache_store_path(cache, EDGY_PATH_INNER, cr);
+    }
     cairo_stroke(cr);
 
     /* External border */
     awn_cairo_set_source_color(cr, bg->border_color);
-    draw_path(cr, 0, height - 1.0, width, height, bottom_left);
+    if (!awn_background_cache_append_path(cache, EDGY_PATH_OUTER, cr)) {
+        draw_path(cr, 0, height - 1.0, width, height, bottom_left);
+        awn_background_cache_store_path(cache, EDGY_PATH_OUTER, cr);
+    }
     cairo_stroke(cr);
 }
 
@@ -530,6 +561,7 @@ awn_background_edgy_draw(AwnBackground*  bg,
                          GtkPositionType  position,
                          GdkRectangle*   area)
 {
+    AwnBackgroundCache* cache;
     gint temp;
     gint x = area->x, y = area->y;
     gint width = area->width, height = area->height;
@@ -538,11 +570,16 @@ awn_background_edgy_draw(AwnBackground*  bg,
         GdkRectangle areaf = {x, y, width, height};
         cairo_save(cr);
         awn_background_edgy_translate_for_flat(bg, position, &areaf);
+        /* the flat part keeps its own cache entry */
         AWN_BACKGROUND_CLASS(awn_background_edgy_parent_class)-> draw(
             bg, cr, position, &areaf);
         cairo_restore(cr);
     }
 
+    cache = awn_background_cache_lookup(bg, AWN_TYPE_BACKGROUND_EDGY,
+                                        position, area,
+                                        (awn_background_get_panel_alignment(bg) == 0.0 ? 2 : 0) |
+                                        (awn_panel_get_composited(bg->panel) ? 1 : 0));
     cairo_save(cr);
 
     switch (position) {
@@ -575,7 +612,7 @@ awn_background_edgy_draw(AwnBackground*  bg,
         break;
     }
 
-    draw_top_bottom_background(bg, cr, width, height);
+    draw_top_bottom_background(bg, cr, width, height, cache);
 
     cairo_restore(cr);
 }
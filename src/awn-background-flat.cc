@@ -178,16 +178,29 @@ draw_rect(AwnBackground*  bg,
     awn_cairo_rounded_rect(cr, x, y, width, height, bg->corner_radius, state);
 }
 
+/* Geometry & gradient cache slots */
+enum {
+    FLAT_PATH_FILL = 0,
+    FLAT_PATH_INNER,
+    FLAT_PATH_OUTER
+};
+
+enum {
+    FLAT_PATTERN_FILL = 0,
+    FLAT_PATTERN_HILIGHT
+};
+
 static void
 draw_top_bottom_background(AwnBackground*  bg,
                            GtkPositionType position,
                            cairo_t*        cr,
                            gint            width,
-                           gint            height)
+                           gint            height,
+                           gfloat          align,
+                           gboolean        expand,
+                           AwnBackgroundCache* cache)
 {
     cairo_pattern_t* pat;
-    gfloat   align = 0.5;
-    gboolean expand = FALSE;
 
     /* Make sure the bar gets drawn on the 0.5 pixels (for sharp edges) */
     cairo_translate(cr, 0.5, 0.5);
@@ -196,58 +209,69 @@ draw_top_bottom_background(AwnBackground*  bg,
     cairo_set_line_width(cr, 1.0);
     cairo_set_operator(cr, CAIRO_OPERATOR_OVER);
 
-    align = awn_background_get_panel_alignment(bg);
-    g_object_get(bg->panel, "expand", &expand, NULL);
-
     if (awn_panel_get_composited(bg->panel) == FALSE) {
         goto paint_lines;
     }
 
     /* Draw the background */
-    if (bg->enable_pattern && bg->pattern) {
-        pat = cairo_pattern_create_for_surface(bg->pattern);
-        cairo_pattern_set_extend(pat, CAIRO_EXTEND_REPEAT);
-    } else {
-        pat = cairo_pattern_create_linear(0, 0, 0, height);
-        awn_cairo_pattern_add_color_stop_color(pat, 0.0, bg->g_step_1);
-        awn_cairo_pattern_add_color_stop_color(pat, 1.0, bg->g_step_2);
+    pat = awn_background_cache_get_pattern(cache, FLAT_PATTERN_FILL);
+    if (pat == NULL) {
+        if (bg->enable_pattern && bg->pattern) {
+            pat = cairo_pattern_create_for_surface(bg->pattern);
+            cairo_pattern_set_extend(pat, CAIRO_EXTEND_REPEAT);
+        } else {
+            pat = cairo_pattern_create_linear(0, 0, 0, height);
+            awn_cairo_pattern_add_color_stop_color(pat, 0.0, bg->g_step_1);
+            awn_cairo_pattern_add_color_stop_color(pat, 1.0, bg->g_step_2);
+        }
+        awn_background_cache_set_pattern(cache, FLAT_PATTERN_FILL, pat);
     }
 
     // we're painting like this (clip + paint) because it has much better
     // performance as opposed to cairo_fill
     cairo_save(cr);
 
-    draw_rect(bg, cr, position, 1, 1, width - 3, height - 1, align, expand);
+    if (!awn_background_cache_append_path(cache, FLAT_PATH_FILL, cr)) {
+        draw_rect(bg, cr, position, 1, 1, width - 3, height - 1, align, expand);
+        awn_background_cache_store_path(cache, FLAT_PATH_FILL, cr);
+    }
     cairo_clip_preserve(cr);
     cairo_set_source(cr, pat);
     cairo_paint(cr);
 
     cairo_restore(cr);
 
-    cairo_pattern_destroy(pat);
-
     /* Draw the hi-light */
-    pat = cairo_pattern_create_linear(0, 0, 0, height);
-    awn_cairo_pattern_add_color_stop_color(pat, 0.0, bg->g_histep_1);
-    awn_cairo_pattern_add_color_stop_color(pat, 0.3, bg->g_histep_2);
-    double red, green, blue, alpha;
-    desktop_agnostic_color_get_cairo_color(bg->g_histep_2, &red, &green, &blue, &alpha);
-    cairo_pattern_add_color_stop_rgba(pat, 0.36, red, green, blue, 0.);
+    pat = awn_background_cache_get_pattern(cache, FLAT_PATTERN_HILIGHT);
+    if (pat == NULL) {
+        pat = cairo_pattern_create_linear(0, 0, 0, height);
+        awn_cairo_pattern_add_color_stop_color(pat, 0.0, bg->g_histep_1);
+        awn_cairo_pattern_add_color_stop_color(pat, 0.3, bg->g_histep_2);
+        double red, green, blue, alpha;
+        desktop_agnostic_color_get_cairo_color(bg->g_histep_2, &red, &green, &blue, &alpha);
+        cairo_pattern_add_color_stop_rgba(pat, 0.36, red, green, blue, 0.);
+        awn_background_cache_set_pattern(cache, FLAT_PATTERN_HILIGHT, pat);
+    }
 
     cairo_set_source(cr, pat);
     cairo_fill(cr);
-    cairo_pattern_destroy(pat);
 
 paint_lines:
 
     /* Internal border */
     awn_cairo_set_source_color(cr, bg->hilight_color);
-    draw_rect(bg, cr, position, 1, 1, width - 3, height + 3, align, expand);
+    if (!awn_background_cache_append_path(cache, FLAT_PATH_INNER, cr)) {
+        draw_rect(bg, cr, position, 1, 1, width - 3, height + 3, align, expand);
+        awn_background_cache_store_path(cache, FLAT_PATH_INNER, cr);
+    }
     cairo_stroke(cr);
 
     /* External border */
     awn_cairo_set_source_color(cr, bg->border_color);
-    draw_rect(bg, cr, position, 0, 0, width - 1, height + 3, align, expand);
+    if (!awn_background_cache_append_path(cache, FLAT_PATH_OUTER, cr)) {
+        draw_rect(bg, cr, position, 0, 0, width - 1, height + 3, align, expand);
+        awn_background_cache_store_path(cache, FLAT_PATH_OUTER, cr);
+    }
     cairo_stroke(cr);
 }
 
@@ -309,9 +333,21 @@ awn_background_flat_draw(AwnBackground*  bg,
                          GtkPositionType  position,
                          GdkRectangle*   area)
 {
+    AwnBackgroundCache* cache;
     gint temp;
     gint x = area->x, y = area->y;
     gint width = area->width, height = area->height;
+    gfloat   align = 0.5;
+    gboolean expand = FALSE;
+
+    align = awn_background_get_panel_alignment(bg);
+    g_object_get(bg->panel, "expand", &expand, NULL);
+
+    cache = awn_background_cache_lookup(bg, AWN_TYPE_BACKGROUND_FLAT,
+                                        position, area,
+                                        (guint)(align * 1000) << 2 |
+                                        (awn_panel_get_composited(bg->panel) ? 2 : 0) |
+                                        (expand ? 1 : 0));
     cairo_save(cr);
 
     switch (position) {
@@ -340,7 +376,8 @@ awn_background_flat_draw(AwnBackground*  bg,
         break;
     }
 
-    draw_top_bottom_background(bg, position, cr, width, height);
+    draw_top_bottom_background(bg, position, cr, width, height,
+                               align, expand, cache);
 
     cairo_restore(cr);
 }
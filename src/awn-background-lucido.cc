@@ -44,9 +44,18 @@ struct _AwnBackgroundLucidoPrivate {
     gfloat    lastx;
     gfloat    lastxend;
     GArray*   pos;
+    GArray*   target;
     gint      pos_size;
+
+    /* geometry of the last drawn frame, used to limit animation redraws */
+    GtkPositionType position;
+    GdkRectangle    area;
     guint     tid;
     gboolean  needs_animation;
+
+    /* applet manager children, in drawing order */
+    GList*    widgets;
+    gboolean  widgets_rtl;
 };
 
 #define TOP_PADDING 2
@@ -120,9 +129,20 @@ awn_background_lucido_align_changed(AwnBackground* bg)
     awn_background_emit_padding_changed(bg);
 }
 
+static void
+_invalidate_applet_widgets(AwnBackground* bg)
+{
+    AwnBackgroundLucidoPrivate* priv =
+        AWN_BACKGROUND_LUCIDO_GET_PRIVATE(AWN_BACKGROUND_LUCIDO(bg));
+
+    g_list_free(priv->widgets);
+    priv->widgets = NULL;
+}
+
 static void
 awn_background_lucido_applets_refreshed(AwnBackground* bg)
 {
+    _invalidate_applet_widgets(bg);
     _set_special_widget_width_and_transparent
     (bg, TRANSFORM_RADIUS(bg->corner_radius), TRUE, FALSE);
     awn_background_emit_changed(bg);
@@ -160,6 +180,10 @@ awn_background_lucido_constructed(GObject* object)
     g_return_if_fail(manager);
     g_signal_connect_swapped(manager, "applets-refreshed",
                              G_CALLBACK(awn_background_lucido_applets_refreshed), bg);
+    g_signal_connect_swapped(manager, "add",
+                             G_CALLBACK(_invalidate_applet_widgets), bg);
+    g_signal_connect_swapped(manager, "remove",
+                             G_CALLBACK(_invalidate_applet_widgets), bg);
     awn_background_lucido_applets_refreshed(AWN_BACKGROUND(bg));
 }
 
@@ -172,6 +196,7 @@ awn_background_lucido_dispose(GObject* object)
     AwnBackgroundLucido* lbg = AWN_BACKGROUND_LUCIDO(object);
     AwnBackgroundLucidoPrivate* priv = AWN_BACKGROUND_LUCIDO_GET_PRIVATE(lbg);
     g_array_free(priv->pos, TRUE);
+    g_array_free(priv->target, TRUE);
 
     gpointer monitor = NULL;
     if (AWN_BACKGROUND(object)->panel) {
@@ -195,7 +220,10 @@ awn_background_lucido_dispose(GObject* object)
     if (manager) {
         g_signal_handlers_disconnect_by_func(manager,
                                              G_CALLBACK(awn_background_lucido_applets_refreshed), object);
+        g_signal_handlers_disconnect_by_func(manager,
+                                             G_CALLBACK(_invalidate_applet_widgets), object);
     }
+    _invalidate_applet_widgets(AWN_BACKGROUND(object));
     /* remove animation timer */
     if (priv->tid) {
         g_source_remove(priv->tid);
@@ -233,7 +261,10 @@ awn_background_lucido_init(AwnBackgroundLucido* bg)
     priv->needs_animation = FALSE;
     priv->tid = 0;
     priv->pos = g_array_new(FALSE, TRUE, sizeof(gfloat));
+    priv->target = g_array_new(FALSE, TRUE, sizeof(gfloat));
     priv->pos_size = 0;
+    priv->widgets = NULL;
+    priv->widgets_rtl = FALSE;
 }
 
 AwnBackground*
@@ -262,15 +293,71 @@ _add_n_positions(AwnBackgroundLucidoPrivate* priv, gint n, gfloat startpos)
 {
     while (n-- > 0) {
         g_array_append_val(priv->pos, startpos);
+        g_array_append_val(priv->target, startpos);
         ++priv->pos_size;
     }
 }
 
+static float coord_get_near(const gfloat from, const gfloat to);
+
+/*
+ * _get_animation_dirty_rect:
+ * computes the part of the panel (in window coordinates) which changes
+ * during the next animation step - the span between current and next
+ * position of every moving curve, plus the curve itself and glow padding.
+ * Returns FALSE if nothing is moving.
+ */
+static gboolean
+_get_animation_dirty_rect(AwnBackground* bg,
+                          AwnBackgroundLucidoPrivate* priv,
+                          GdkRectangle* rect)
+{
+    gfloat start = G_MAXFLOAT, end = -G_MAXFLOAT;
+    const gfloat d = TRANSFORM_RADIUS(bg->corner_radius);
+
+    for (gint j = 0; j < priv->pos_size; j++) {
+        gfloat from = g_array_index(priv->pos, gfloat, j);
+        gfloat to = g_array_index(priv->target, gfloat, j);
+        if (from == to) {
+            continue;
+        }
+        gfloat next = coord_get_near(from, to);
+        start = MIN(start, MIN(from, next));
+        end = MAX(end, MAX(from, next) + d);
+    }
+    if (start > end) {
+        return FALSE;
+    }
+
+    /* antialiasing & the half pixel translation */
+    gint pad = awn_panel_get_glow_size(bg->panel) + 2;
+    gint span_start = (gint)floorf(start) - pad;
+    gint span_len = (gint)ceilf(end) - (gint)floorf(start) + 2 * pad;
+
+    *rect = priv->area;
+    switch (priv->position) {
+    case GTK_POS_LEFT:
+    case GTK_POS_RIGHT:
+        rect->x -= pad;
+        rect->width += 2 * pad;
+        rect->y = span_start;
+        rect->height = span_len;
+        break;
+    default:
+        rect->y -= pad;
+        rect->height += 2 * pad;
+        rect->x = span_start;
+        rect->width = span_len;
+        break;
+    }
+    return TRUE;
+}
+
 /*
  * awn_background_lucido_redraw:
  * @lbg: the lucido background ojbect
  *
- * Queue redraw of the panel and repeat itself if needed
+ * Queue redraw of the moving part of the panel and repeat itself if needed
  */
 static gboolean
 awn_background_lucido_redraw(AwnBackgroundLucido* lbg)
@@ -280,12 +367,15 @@ awn_background_lucido_redraw(AwnBackgroundLucido* lbg)
     AwnBackgroundLucidoPrivate* priv;
     AwnBackground* bg = AWN_BACKGROUND(lbg);
     priv = AWN_BACKGROUND_LUCIDO_GET_PRIVATE(lbg);
+    GdkRectangle dirty;
 
-    if (priv->needs_animation) {
-        awn_background_invalidate(bg);
-        gtk_widget_queue_draw(GTK_WIDGET(bg->panel));
+    if (priv->needs_animation && _get_animation_dirty_rect(bg, priv, &dirty)) {
+        awn_background_invalidate_area(bg, &dirty);
+        gtk_widget_queue_draw_area(GTK_WIDGET(bg->panel), dirty.x, dirty.y,
+                                   dirty.width, dirty.height);
         return TRUE;
     } else {
+        priv->needs_animation = FALSE;
         priv->tid = 0;
         return FALSE;
     }
@@ -326,19 +416,35 @@ _line_from_to(cairo_t* cr,
 }
 
 /*
- * Gets applet manager's childs.
- * Sets docklet mode = TRUE if panel is in docklet mode
+ * Gets applet manager's childs (reversed if RTL swap is needed).
+ * The list is cached until the applet manager's children change,
+ * it's owned by the background and mustn't be freed.
  */
 static GList*
 _get_applet_widgets(AwnBackground* bg)
 {
+    AwnBackgroundLucidoPrivate* priv =
+        AWN_BACKGROUND_LUCIDO_GET_PRIVATE(AWN_BACKGROUND_LUCIDO(bg));
+    gboolean rtl = awn_background_do_rtl_swap(bg);
+
+    if (priv->widgets && priv->widgets_rtl == rtl) {
+        return priv->widgets;
+    }
+    g_list_free(priv->widgets);
+    priv->widgets = NULL;
+
     AwnAppletManager* manager = NULL;
     g_object_get(bg->panel, "applet-manager", &manager, NULL);
     if (!manager) {
         return NULL;
     }
 
-    return gtk_container_get_children(GTK_CONTAINER(manager));
+    priv->widgets = gtk_container_get_children(GTK_CONTAINER(manager));
+    priv->widgets_rtl = rtl;
+    if (rtl) {
+        priv->widgets = g_list_reverse(priv->widgets);
+    }
+    return priv->widgets;
 }
 
 /*
@@ -482,11 +588,7 @@ _create_path_lucido(AwnBackground*  bg,
     /********************     OBTAIN LIST OF APPLETS    *************************/
     /****************************************************************************/
     gboolean docklet_mode = awn_panel_get_docklet_mode(bg->panel);
-    GList* widgets = _get_applet_widgets(bg);
-    if (widgets && awn_background_do_rtl_swap(bg)) {
-        widgets = g_list_reverse(widgets);
-    }
-    GList* i = widgets;
+    GList* i = _get_applet_widgets(bg);
     GtkWidget* widget = NULL;
     /* j = index of last special widget found */
     gint j = -1;
@@ -552,6 +654,13 @@ _create_path_lucido(AwnBackground*  bg,
     }
     curx = lx;
     gint wx, wy;
+    if (update_positions) {
+        /* curves which disappeared don't move anymore */
+        for (gint k = 0; k < priv->pos_size; k++) {
+            g_array_index(priv->target, gfloat, k) =
+                g_array_index(priv->pos, gfloat, k);
+        }
+    }
     /* fake docklet mode if not composited */
     if (!docklet_mode && composited) {
         for (; i; i = i->next) {
@@ -581,15 +690,18 @@ _create_path_lucido(AwnBackground*  bg,
             /*****************    UPDATE SINGLE CURVE POSITION  *********************/
             /************************************************************************/
             if (update_positions) {
-                curx = lroundf(curx);
-                if (curx != g_array_index(priv->pos, gfloat, j)) {
-                    needs_animation = TRUE;
-                }
-                curx = coord_get_near(g_array_index(priv->pos, gfloat, j), curx);
+                gfloat target = MIN(lroundf(curx), w - rdc - d);
+                curx = coord_get_near(g_array_index(priv->pos, gfloat, j),
+                                      lroundf(curx));
                 if (curx > (w - rdc - d)) {
                     curx = w - rdc - d;
                 }
                 g_array_index(priv->pos, gfloat, j) = curx;
+                g_array_index(priv->target, gfloat, j) = target;
+                /* keep animating only until the curve reaches its target */
+                if (curx != target) {
+                    needs_animation = TRUE;
+                }
             }
             /* when drawing shape mask, use the final coord */
             else if (!shape_mask) {
@@ -607,7 +719,6 @@ _create_path_lucido(AwnBackground*  bg,
         }
     }
     y = saved_y;
-    g_list_free(widgets);
     /****************************************************************************/
     /************************     CLOSE THE PATH   ******************************/
     /****************************************************************************/
@@ -654,13 +765,21 @@ _create_path_lucido(AwnBackground*  bg,
     return y;
 }
 
+/* Gradient cache slots, the paths are animated so only patterns are kept */
+enum {
+    LUCIDO_PATTERN_TEXTURE = 0,
+    LUCIDO_PATTERN_INTERNAL,
+    LUCIDO_PATTERN_EXTERNAL
+};
+
 static void
 draw_top_bottom_background(AwnBackground*   bg,
                            GtkPositionType  position,
                            cairo_t*         cr,
                            gfloat           width,
                            gfloat           height,
-                           gint             x_start_limit)
+                           gint             x_start_limit,
+                           AwnBackgroundCache* cache)
 {
     cairo_pattern_t* pat = NULL;
 
@@ -693,21 +812,28 @@ draw_top_bottom_background(AwnBackground*   bg,
         /* Draw internal pattern if needed */
         if (bg->enable_pattern && bg->pattern) {
             /* Prepare pattern */
-            pat = cairo_pattern_create_for_surface(bg->pattern);
-            cairo_pattern_set_extend(pat, CAIRO_EXTEND_REPEAT);
+            pat = awn_background_cache_get_pattern(cache, LUCIDO_PATTERN_TEXTURE);
+            if (pat == NULL) {
+                pat = cairo_pattern_create_for_surface(bg->pattern);
+                cairo_pattern_set_extend(pat, CAIRO_EXTEND_REPEAT);
+                awn_background_cache_set_pattern(cache, LUCIDO_PATTERN_TEXTURE, pat);
+            }
             /* Draw */
             cairo_save(cr);
             cairo_clip_preserve(cr);
             cairo_set_source(cr, pat);
             cairo_paint(cr);
             cairo_restore(cr);
-            cairo_pattern_destroy(pat);
         }
 
         /* Prepare the internal background */
-        pat = cairo_pattern_create_linear(x, y_pat, x, height);
-        awn_cairo_pattern_add_color_stop_color(pat, 0., bg->g_histep_1);
-        awn_cairo_pattern_add_color_stop_color(pat, 1.0, bg->g_histep_2);
+        pat = awn_background_cache_get_pattern(cache, LUCIDO_PATTERN_INTERNAL);
+        if (pat == NULL) {
+            pat = cairo_pattern_create_linear(x, y_pat, x, height);
+            awn_cairo_pattern_add_color_stop_color(pat, 0., bg->g_histep_1);
+            awn_cairo_pattern_add_color_stop_color(pat, 1.0, bg->g_histep_2);
+            awn_background_cache_set_pattern(cache, LUCIDO_PATTERN_INTERNAL, pat);
+        }
 
         /* Draw the internal background gradient */
         cairo_save(cr);
@@ -725,10 +851,13 @@ draw_top_bottom_background(AwnBackground*   bg,
                                     FALSE, expand, align, composited, FALSE, FALSE);
 
         /* Prepare external background gradient*/
-        cairo_pattern_destroy(pat);
-        pat = cairo_pattern_create_linear(x, y_pat, x, height);
-        awn_cairo_pattern_add_color_stop_color(pat, 0.0, bg->g_step_1);
-        awn_cairo_pattern_add_color_stop_color(pat, 1.0, bg->g_step_2);
+        pat = awn_background_cache_get_pattern(cache, LUCIDO_PATTERN_EXTERNAL);
+        if (pat == NULL) {
+            pat = cairo_pattern_create_linear(x, y_pat, x, height);
+            awn_cairo_pattern_add_color_stop_color(pat, 0.0, bg->g_step_1);
+            awn_cairo_pattern_add_color_stop_color(pat, 1.0, bg->g_step_2);
+            awn_background_cache_set_pattern(cache, LUCIDO_PATTERN_EXTERNAL, pat);
+        }
 
         /* Clean below external background */
         cairo_set_operator(cr, CAIRO_OPERATOR_SOURCE);
@@ -738,7 +867,6 @@ draw_top_bottom_background(AwnBackground*   bg,
         cairo_set_source(cr, pat);
         cairo_paint(cr);
         cairo_restore(cr);
-        cairo_pattern_destroy(pat);
         /* Restore operator */
         cairo_set_operator(cr, CAIRO_OPERATOR_OVER);
 
@@ -834,10 +962,18 @@ awn_background_lucido_draw(AwnBackground*  bg,
                            GtkPositionType  position,
                            GdkRectangle*   area)
 {
+    AwnBackgroundCache* cache;
     gint temp;
     gint x = area->x, y = area->y;
     gint width = area->width, height = area->height;
     gint x_start_limit = x;
+
+    cache = awn_background_cache_lookup(bg, AWN_TYPE_BACKGROUND_LUCIDO,
+                                        position, area, 0);
+    AwnBackgroundLucidoPrivate* priv =
+        AWN_BACKGROUND_LUCIDO_GET_PRIVATE(AWN_BACKGROUND_LUCIDO(bg));
+    priv->position = position;
+    priv->area = *area;
     cairo_save(cr);
 
     switch (position) {
@@ -872,7 +1008,8 @@ awn_background_lucido_draw(AwnBackground*  bg,
         break;
     }
 
-    draw_top_bottom_background(bg, position, cr, width, height, x_start_limit);
+    draw_top_bottom_background(bg, position, cr, width, height, x_start_limit,
+                               cache);
 
     cairo_restore(cr);
 #if DEBUG_SHAPE_MASK
@@ -886,11 +1023,7 @@ _set_special_widget_width_and_transparent(AwnBackground* bg,
         gboolean      transp,
         gboolean      dispose)
 {
-    GList* widgets = _get_applet_widgets(bg);
-    if (widgets && awn_background_do_rtl_swap(bg)) {
-        widgets = g_list_reverse(widgets);
-    }
-    GList* i = widgets;
+    GList* i = _get_applet_widgets(bg);
     GtkWidget* widget = NULL;
 
     if (i && IS_SPECIAL(i->data) && !dispose) {
@@ -909,8 +1042,6 @@ _set_special_widget_width_and_transparent(AwnBackground* bg,
         awn_separator_set_separator_size(AWN_SEPARATOR(widget), width);
         awn_separator_set_transparent(AWN_SEPARATOR(widget), transp);
     }
-
-    g_list_free(widgets);
 }
 
 static void
@@ -1020,8 +1151,7 @@ awn_background_lucido_get_needs_redraw(AwnBackground* bg,
     /* Check separators positions,
      * because bar's width doesn't change in expanded mode
      */
-    GList* widgets = _get_applet_widgets(bg);
-    GList* i = widgets;
+    GList* i = _get_applet_widgets(bg);
     GtkWidget* widget = NULL;
     gint  wcheck = 0, j = 0;
 
@@ -1042,7 +1172,6 @@ awn_background_lucido_get_needs_redraw(AwnBackground* bg,
             break;
         }
     }
-    g_list_free(widgets);
     AwnBackgroundLucidoPrivate* priv =
         AWN_BACKGROUND_LUCIDO_GET_PRIVATE(AWN_BACKGROUND_LUCIDO(bg));
     if (priv->expw != wcheck) {
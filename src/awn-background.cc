@@ -29,6 +29,7 @@
 #include "awn-defines.h"
 #include "libawn/gseal-transition.h"
 #include "libawn/awn-effects-ops-helpers.h"
+#include "libawn/awn-trace.h"
 
 extern "C" {
     G_DEFINE_ABSTRACT_TYPE(AwnBackground, awn_background, G_TYPE_OBJECT)
@@ -249,6 +250,12 @@ awn_background_get_property(GObject*    object,
     }
 }
 
+static void
+awn_background_config_changed(GObject* object)
+{
+    awn_background_emit_changed(AWN_BACKGROUND(object));
+}
+
 static void
 awn_background_set_property(GObject*      object,
                             guint         prop_id,
@@ -372,8 +379,12 @@ awn_background_set_property(GObject*      object,
         G_OBJECT_WARN_INVALID_PROPERTY_ID(object, prop_id, pspec);
         return;
     }
-    awn_background_invalidate(bg);
-    g_signal_emit(object, _bg_signals[CHANGED], 0);
+    /* a theme sets many of these at once, redraw only once */
+    if (bg->client) {
+        awn_config_queue_update(bg->client, object, awn_background_config_changed);
+    } else {
+        awn_background_config_changed(object);
+    }
 }
 
 static void
@@ -425,6 +436,11 @@ awn_background_finalize(GObject* object)
         cairo_surface_finish(bg->helper_surface);
         cairo_surface_destroy(bg->helper_surface);
     }
+    if (bg->dirty_region) {
+        gdk_region_destroy(bg->dirty_region);
+    }
+
+    awn_background_cache_flush(bg);
 
     G_OBJECT_CLASS(awn_background_parent_class)->finalize(object);
 }
@@ -681,12 +697,14 @@ awn_background_refresh_pattern(AwnBackground* bg)
 
             cairo_t* temp_cr = gdk_cairo_create(window);
 
+            awn_trace_count(AWN_TRACE_SURFACES_CREATED);
             bg->pattern = cairo_surface_create_similar(cairo_get_target(temp_cr),
                           CAIRO_CONTENT_COLOR_ALPHA,
                           w, h);
 
             cairo_destroy(temp_cr);
         } else {
+            awn_trace_count(AWN_TRACE_SURFACES_CREATED);
             bg->pattern = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, w, h);
         }
         // copy the pixbuf to cairo surface
@@ -712,8 +730,12 @@ awn_background_init(AwnBackground* bg)
     bg->sep_color = NULL;
     bg->needs_redraw = TRUE;
     bg->helper_surface = NULL;
+    bg->helper_width = 0;
+    bg->helper_height = 0;
+    bg->dirty_region = NULL;
     bg->cache_enabled = TRUE;
     bg->draw_glow = FALSE;
+    bg->geometry = NULL;
 }
 
 static void
@@ -733,6 +755,7 @@ awn_background_draw_glow(AwnBackground* bg, cairo_t* cr,
 
     cairo_save(cr);
     /* Create a surface to apply the glow */
+    awn_trace_count(AWN_TRACE_SURFACES_CREATED);
     cairo_surface_t* blur_srfc = cairo_image_surface_create
                                  (CAIRO_FORMAT_ARGB32,
                                   width,
@@ -782,36 +805,59 @@ awn_background_draw(AwnBackground*  bg,
                     GdkRectangle*   area)
 {
     AwnBackgroundClass* klass;
+    gint64 trace_start;
 
     g_return_if_fail(AWN_IS_BACKGROUND(bg));
 
     klass = AWN_BACKGROUND_GET_CLASS(bg);
     g_return_if_fail(klass->draw != NULL);
 
+    trace_start = awn_trace_begin();
     /* Check if background caching is enabled - TRUE by default */
     if (bg->cache_enabled) {
         g_return_if_fail(klass->get_needs_redraw != NULL);
         cairo_save(cr);
 
+        GdkRegion* dirty = bg->dirty_region;
+        bg->dirty_region = NULL;
+
         /* Check if background needs to be redrawn */
-        if (klass->get_needs_redraw(bg, position, area)) {
+        gboolean full_redraw = klass->get_needs_redraw(bg, position, area);
+        if (full_redraw || dirty) {
             cairo_t* temp_cr;
             gint rad = awn_panel_get_glow_size(bg->panel);
             gint full_width = area->x + area->width + rad;
             gint full_height = area->y + area->height + rad;
 
+            cairo_surface_t* target = cairo_get_target(cr);
             gboolean realloc_needed = bg->helper_surface == NULL ||
-                                      cairo_image_surface_get_width(bg->helper_surface) != full_width ||
-                                      cairo_image_surface_get_height(bg->helper_surface) != full_height;
-            if (realloc_needed) {
+                                      bg->helper_width != full_width ||
+                                      bg->helper_height != full_height ||
+                                      cairo_surface_get_type(bg->helper_surface) !=
+                                      cairo_surface_get_type(target);
+            /* the glow is blurred from the whole background, so it can't be
+             * repainted piecewise */
+            gboolean glow = bg->draw_glow && awn_panel_get_composited(bg->panel);
+            if (!full_redraw && !realloc_needed && !glow) {
+                temp_cr = cairo_create(bg->helper_surface);
+                gdk_cairo_region(temp_cr, dirty);
+                cairo_clip(temp_cr);
+                cairo_set_operator(temp_cr, CAIRO_OPERATOR_CLEAR);
+                cairo_paint(temp_cr);
+                cairo_set_operator(temp_cr, CAIRO_OPERATOR_OVER);
+            } else if (realloc_needed) {
                 /* Free last surface */
                 if (bg->helper_surface != NULL) {
                     cairo_surface_destroy(bg->helper_surface);
                 }
-                /* Create new surface */
-                bg->helper_surface = cairo_image_surface_create(CAIRO_FORMAT_ARGB32,
+                /* Create new surface, on the X server if target is a window */
+                awn_trace_count(AWN_TRACE_SURFACES_CREATED);
+                bg->helper_surface = cairo_surface_create_similar(target,
+                                     CAIRO_CONTENT_COLOR_ALPHA,
                                      full_width,
                                      full_height);
+                bg->helper_width = full_width;
+                bg->helper_height = full_height;
                 temp_cr = cairo_create(bg->helper_surface);
             } else {
                 temp_cr = cairo_create(bg->helper_surface);
@@ -821,11 +867,14 @@ awn_background_draw(AwnBackground*  bg,
             }
             /* Draw background on temp cairo_t */
             klass->draw(bg, temp_cr, position, area);
-            if (bg->draw_glow && awn_panel_get_composited(bg->panel)) {
+            if (glow) {
                 awn_background_draw_glow(bg, temp_cr, area, rad, position);
             }
             cairo_destroy(temp_cr);
         }
+        if (dirty) {
+            gdk_region_destroy(dirty);
+        }
         /* Paint saved surface */
         cairo_set_source_surface(cr, bg->helper_surface, 0., 0.);
         cairo_paint(cr);
@@ -833,6 +882,7 @@ awn_background_draw(AwnBackground*  bg,
     } else {
         klass->draw(bg, cr, position, area);
     }
+    awn_trace_end(AWN_TRACE_BACKGROUND_DRAW, trace_start);
 }
 
 void
@@ -930,6 +980,7 @@ void
 awn_background_emit_padding_changed(AwnBackground* bg)
 {
     g_return_if_fail(AWN_IS_BACKGROUND(bg));
+    awn_background_cache_flush(bg);
     awn_background_invalidate(bg);
     g_signal_emit(bg, _bg_signals[PADDING_CHANGED], 0);
 }
@@ -938,6 +989,7 @@ void
 awn_background_emit_changed(AwnBackground* bg)
 {
     g_return_if_fail(AWN_IS_BACKGROUND(bg));
+    awn_background_cache_flush(bg);
     awn_background_invalidate(bg);
     g_signal_emit(bg, _bg_signals[CHANGED], 0);
 }
@@ -998,13 +1050,25 @@ set_cfg_from_theme(GdkColor*                    color,
     da_color = desktop_agnostic_color_new(color, alpha * 256);
     g_value_init(&val, DESKTOP_AGNOSTIC_TYPE_COLOR);
     g_value_set_object(&val, da_color);
-    desktop_agnostic_config_client_set_value(client,
-            group, key,
-            &val, NULL);
+    awn_config_set_value(client, group, key, &val, NULL);
     g_value_unset(&val);
     g_object_unref(da_color);
 }
 
+static void
+set_cfg_bool(DesktopAgnosticConfigClient* client,
+             const gchar*                 group,
+             const gchar*                 key,
+             gboolean                     value)
+{
+    GValue val = {0};
+
+    g_value_init(&val, G_TYPE_BOOLEAN);
+    g_value_set_boolean(&val, value);
+    awn_config_set_value(client, group, key, &val, NULL);
+    g_value_unset(&val);
+}
+
 static void
 load_colours_from_widget(AwnBackground* bg, GtkWidget* widget)
 {
@@ -1020,6 +1084,7 @@ load_colours_from_widget(AwnBackground* bg, GtkWidget* widget)
     }
 
     g_debug("Updating gtk theme colours");
+    awn_config_begin_update(client);
 
     /* main colours */
     set_cfg_from_theme(&style->bg[GTK_STATE_NORMAL], 224,
@@ -1056,18 +1121,14 @@ load_colours_from_widget(AwnBackground* bg, GtkWidget* widget)
                        client, AWN_GROUP_EFFECTS, AWN_EFFECTS_RECT_OUTLINE);
 
     /* Don't draw patterns */
-    desktop_agnostic_config_client_set_bool(client,
-                                            AWN_GROUP_THEME,
-                                            AWN_THEME_DRAW_PATTERN,
-                                            FALSE, NULL);
+    set_cfg_bool(client, AWN_GROUP_THEME, AWN_THEME_DRAW_PATTERN, FALSE);
 
     /* Set up separators to draw in the standard way */
-    desktop_agnostic_config_client_set_bool(client,
-                                            AWN_GROUP_THEME,
-                                            AWN_THEME_SHOW_SEP,
-                                            TRUE, NULL);
+    set_cfg_bool(client, AWN_GROUP_THEME, AWN_THEME_SHOW_SEP, TRUE);
 
     /* Misc settings */
+
+    awn_config_end_update(client, NULL);
 }
 
 static void
@@ -1086,10 +1147,12 @@ load_dlg_colours_from_widget(AwnBackground* bg, GtkWidget* widget)
     g_debug("Updating dialog colours");
 
     /* Set colors for AwnDialog */
+    awn_config_begin_update(client);
     set_cfg_from_theme(&style->bg[GTK_STATE_NORMAL], 255,
                        client, AWN_GROUP_THEME, AWN_THEME_DLG_BG);
     set_cfg_from_theme(&style->bg[GTK_STATE_PRELIGHT], 255,
                        client, AWN_GROUP_THEME, AWN_THEME_DLG_TITLE_BG);
+    awn_config_end_update(client, NULL);
 }
 
 static void
@@ -1101,6 +1164,7 @@ update_widget_colors(GtkWidget* widget, AwnBackground* bg)
     if (bg->dialog_gtk_mode) {
         load_dlg_colours_from_widget(bg, widget);
     }
+    awn_background_cache_flush(bg);
 }
 
 static void
@@ -1212,6 +1276,180 @@ static gboolean awn_background_get_needs_redraw(AwnBackground* bg,
 void awn_background_invalidate(AwnBackground*  bg)
 {
     bg->needs_redraw = 1;
+    if (bg->dirty_region) {
+        gdk_region_destroy(bg->dirty_region);
+        bg->dirty_region = NULL;
+    }
+}
+
+/*
+ * Marks only @area (in panel window coordinates) of the cached background
+ * for repaint, the style still draws its whole path but cairo clips the
+ * rasterization to the dirty region.
+ */
+void awn_background_invalidate_area(AwnBackground* bg, GdkRectangle* area)
+{
+    g_return_if_fail(AWN_IS_BACKGROUND(bg) && area);
+
+    if (bg->needs_redraw) {
+        return;
+    }
+    if (bg->dirty_region == NULL) {
+        bg->dirty_region = gdk_region_rectangle(area);
+    } else {
+        gdk_region_union_with_rect(bg->dirty_region, area);
+    }
+}
+
+/*
+ * Geometry cache
+ *
+ * Every style keeps one entry (identified by the style's GType, so a derived
+ * class can chain up to its parent's draw without evicting its own entry).
+ * An entry is reused as long as position, area and the style-specific key
+ * stay the same, any property change flushes all of them.
+ */
+static void
+awn_background_cache_clear(AwnBackgroundCache* cache)
+{
+    for (guint i = 0; i < AWN_BACKGROUND_CACHE_SLOTS; i++) {
+        if (cache->paths[i]) {
+            cairo_path_destroy(cache->paths[i]);
+            cache->paths[i] = NULL;
+        }
+        if (cache->patterns[i]) {
+            cairo_pattern_destroy(cache->patterns[i]);
+            cache->patterns[i] = NULL;
+        }
+    }
+    if (cache->data && cache->data_free) {
+        cache->data_free(cache->data);
+    }
+    cache->data = NULL;
+    cache->data_free = NULL;
+}
+
+AwnBackgroundCache*
+awn_background_cache_lookup(AwnBackground* bg, GType style,
+                            GtkPositionType position, GdkRectangle* area,
+                            guint key)
+{
+    AwnBackgroundCache* cache = NULL;
+
+    g_return_val_if_fail(AWN_IS_BACKGROUND(bg) && area, NULL);
+
+    for (GSList* l = bg->geometry; l; l = l->next) {
+        if (((AwnBackgroundCache*)l->data)->style == style) {
+            cache = (AwnBackgroundCache*)l->data;
+            break;
+        }
+    }
+
+    if (cache == NULL) {
+        cache = g_slice_new0(AwnBackgroundCache);
+        cache->style = style;
+        cache->position = position;
+        cache->area = *area;
+        cache->key = key;
+        bg->geometry = g_slist_prepend(bg->geometry, cache);
+    } else if (cache->position != position || cache->key != key ||
+               cache->area.x != area->x || cache->area.y != area->y ||
+               cache->area.width != area->width ||
+               cache->area.height != area->height) {
+        awn_background_cache_clear(cache);
+        cache->position = position;
+        cache->area = *area;
+        cache->key = key;
+    }
+
+    return cache;
+}
+
+void
+awn_background_cache_flush(AwnBackground* bg)
+{
+    g_return_if_fail(AWN_IS_BACKGROUND(bg));
+
+    for (GSList* l = bg->geometry; l; l = l->next) {
+        awn_background_cache_clear((AwnBackgroundCache*)l->data);
+        g_slice_free(AwnBackgroundCache, l->data);
+    }
+    g_slist_free(bg->geometry);
+    bg->geometry = NULL;
+}
+
+/* Appends the cached path to cr, returns FALSE if it isn't cached yet */
+gboolean
+awn_background_cache_append_path(AwnBackgroundCache* cache, guint slot,
+                                 cairo_t* cr)
+{
+    g_return_val_if_fail(slot < AWN_BACKGROUND_CACHE_SLOTS, FALSE);
+
+    if (cache == NULL || cache->paths[slot] == NULL) {
+        return FALSE;
+    }
+    cairo_append_path(cr, cache->paths[slot]);
+    return TRUE;
+}
+
+/* Stores the current path of cr (in user space of the current CTM) */
+void
+awn_background_cache_store_path(AwnBackgroundCache* cache, guint slot,
+                                cairo_t* cr)
+{
+    g_return_if_fail(slot < AWN_BACKGROUND_CACHE_SLOTS);
+
+    if (cache == NULL) {
+        return;
+    }
+    if (cache->paths[slot]) {
+        cairo_path_destroy(cache->paths[slot]);
+    }
+    cache->paths[slot] = cairo_copy_path(cr);
+}
+
+cairo_pattern_t*
+awn_background_cache_get_pattern(AwnBackgroundCache* cache, guint slot)
+{
+    g_return_val_if_fail(slot < AWN_BACKGROUND_CACHE_SLOTS, NULL);
+
+    return cache ? cache->patterns[slot] : NULL;
+}
+
+/* Takes ownership of pattern, returns it for convenience */
+cairo_pattern_t*
+awn_background_cache_set_pattern(AwnBackgroundCache* cache, guint slot,
+                                 cairo_pattern_t* pattern)
+{
+    g_return_val_if_fail(slot < AWN_BACKGROUND_CACHE_SLOTS, pattern);
+
+    if (cache == NULL) {
+        return pattern;
+    }
+    if (cache->patterns[slot] && cache->patterns[slot] != pattern) {
+        cairo_pattern_destroy(cache->patterns[slot]);
+    }
+    cache->patterns[slot] = pattern;
+    return pattern;
+}
+
+gpointer
+awn_background_cache_get_data(AwnBackgroundCache* cache)
+{
+    return cache ? cache->data : NULL;
+}
+
+void
+awn_background_cache_set_data(AwnBackgroundCache* cache, gpointer data,
+                              GDestroyNotify destroy)
+{
+    g_return_if_fail(cache != NULL);
+
+    if (cache->data && cache->data_free) {
+        cache->data_free(cache->data);
+    }
+    cache->data = data;
+    cache->data_free = destroy;
 }
 
 /* vim: set et ts=2 sts=2 sw=2 : */
@@ -53,6 +53,26 @@ extern "C" {
 
 typedef struct _AwnBackground AwnBackground;
 typedef struct _AwnBackgroundClass AwnBackgroundClass;
+typedef struct _AwnBackgroundCache AwnBackgroundCache;
+
+#define AWN_BACKGROUND_CACHE_SLOTS 4
+
+/* Geometry & gradient cache of a single style.
+ * Paths and patterns only depend on the panel geometry and the appearance
+ * options, so a style can reuse them until one of those changes.
+ */
+struct _AwnBackgroundCache {
+    GType            style;
+    GtkPositionType  position;
+    GdkRectangle     area;
+    guint            key;
+
+    cairo_path_t*    paths[AWN_BACKGROUND_CACHE_SLOTS];
+    cairo_pattern_t* patterns[AWN_BACKGROUND_CACHE_SLOTS];
+
+    gpointer         data;
+    GDestroyNotify   data_free;
+};
 
 struct _AwnBackground {
     GObject  parent;
@@ -79,11 +99,17 @@ struct _AwnBackground {
     cairo_surface_t* pattern;
 
     /*  Speedup code.
-     *  We can save the bg and redraw only when properties changes
+     *  We can save the bg and redraw only when properties changes,
+     *  helper_surface is created similar to the target (ie. a server-side
+     *  pixmap for windows), so exposes don't upload it over the wire again
      */
     gboolean          cache_enabled;
     gboolean          needs_redraw;
     cairo_surface_t*  helper_surface;
+    gint              helper_width;
+    gint              helper_height;
+    /* part of helper_surface to repaint when needs_redraw isn't set */
+    GdkRegion*        dirty_region;
 
     gboolean          draw_glow;
 
@@ -104,6 +130,7 @@ struct _AwnBackground {
 
     /* private */
     guint    changed;
+    GSList*  geometry;
 };
 
 struct _AwnBackgroundClass {
@@ -159,6 +186,8 @@ void awn_background_draw(AwnBackground*  bg,
 
 void awn_background_invalidate(AwnBackground*  bg);
 
+void awn_background_invalidate_area(AwnBackground* bg, GdkRectangle* area);
+
 void awn_background_padding_request(AwnBackground* bg,
                                     GtkPositionType position,
                                     guint* padding_top,
@@ -192,6 +221,25 @@ gboolean awn_background_get_glow(AwnBackground*  bg);
 void awn_background_emit_padding_changed(AwnBackground* bg);
 void awn_background_emit_changed(AwnBackground* bg);
 
+AwnBackgroundCache* awn_background_cache_lookup(AwnBackground* bg,
+                                                GType style,
+                                                GtkPositionType position,
+                                                GdkRectangle* area,
+                                                guint key);
+void awn_background_cache_flush(AwnBackground* bg);
+gboolean awn_background_cache_append_path(AwnBackgroundCache* cache,
+                                          guint slot, cairo_t* cr);
+void awn_background_cache_store_path(AwnBackgroundCache* cache,
+                                     guint slot, cairo_t* cr);
+cairo_pattern_t* awn_background_cache_get_pattern(AwnBackgroundCache* cache,
+                                                  guint slot);
+cairo_pattern_t* awn_background_cache_set_pattern(AwnBackgroundCache* cache,
+                                                  guint slot,
+                                                  cairo_pattern_t* pattern);
+gpointer awn_background_cache_get_data(AwnBackgroundCache* cache);
+void awn_background_cache_set_data(AwnBackgroundCache* cache,
+                                   gpointer data, GDestroyNotify destroy);
+
 gfloat awn_background_get_panel_alignment(AwnBackground* bg);
 gboolean awn_background_do_rtl_swap(AwnBackground* bg);
 
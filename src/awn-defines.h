@@ -40,6 +40,7 @@
 #define AWN_PANELS_HIDE_DELAY      "hide_delay"
 #define AWN_PANELS_POLL_DELAY      "mouse_poll_delay"
 #define AWN_PANELS_IDS             "panel_list"
+#define AWN_PANELS_LAUNCH_LIMIT    "applet_launch_limit"
 
 #define AWN_GROUP_PANEL            "panel"
 #define AWN_PANEL_PANEL_MODE       "panel_mode"
@@ -36,9 +36,12 @@
 #include "awn-app.h"
 #include "awn-defines.h"
 
+#include "libawn/awn-trace.h"
+
 static gboolean version = FALSE;
 static gboolean is_startup = FALSE;
 static gint startup_delay = 0;
+static gboolean trace = FALSE;
 
 GOptionEntry entries[] = {
     {
@@ -59,6 +62,12 @@ GOptionEntry entries[] = {
         &startup_delay,
         "Number of seconds to wait before starting", NULL
     },
+    {
+        "trace", 0,
+        0, G_OPTION_ARG_NONE,
+        &trace,
+        "Record frame timings from the start, see the panel's GetTrace method", NULL
+    },
     {
         NULL
     }
@@ -95,6 +104,10 @@ main(gint argc, gchar* argv[])
         return EXIT_SUCCESS;
     }
 
+    if (trace) {
+        awn_trace_set_enabled(TRUE);
+    }
+
     /* Init the world */
     if (!g_thread_supported()) {
         g_thread_init(NULL);
@@ -30,9 +30,11 @@
 #include <string.h>
 #include <float.h>
 #include <math.h>
+#include <unistd.h>
 #include <dbus/dbus.h>
 #include "awn-panel.h"
 #include "awn-panel-dispatcher.h"
+#include "libawn/awn-trace.h"
 
 typedef struct _DBusObjectVTable _DBusObjectVTable;
 #define _g_free0(var) (var = (g_free (var), NULL))
@@ -73,10 +75,12 @@ static DBusHandlerResult _dbus_awn_panel_dbus_interface_delete_applet(AwnPanelDB
 static DBusHandlerResult _dbus_awn_panel_dbus_interface_docklet_request(AwnPanelDBusInterface* self, DBusConnection* connection, DBusMessage* message);
 static DBusHandlerResult _dbus_awn_panel_dbus_interface_get_inhibitors(AwnPanelDBusInterface* self, DBusConnection* connection, DBusMessage* message);
 static DBusHandlerResult _dbus_awn_panel_dbus_interface_get_snapshot(AwnPanelDBusInterface* self, DBusConnection* connection, DBusMessage* message);
+static DBusHandlerResult _dbus_awn_panel_dbus_interface_get_snapshot_fd(AwnPanelDBusInterface* self, DBusConnection* connection, DBusMessage* message);
 static DBusHandlerResult _dbus_awn_panel_dbus_interface_inhibit_autohide(AwnPanelDBusInterface* self, DBusConnection* connection, DBusMessage* message);
 static DBusHandlerResult _dbus_awn_panel_dbus_interface_uninhibit_autohide(AwnPanelDBusInterface* self, DBusConnection* connection, DBusMessage* message);
 static DBusHandlerResult _dbus_awn_panel_dbus_interface_set_applet_flags(AwnPanelDBusInterface* self, DBusConnection* connection, DBusMessage* message);
 static DBusHandlerResult _dbus_awn_panel_dbus_interface_set_glow(AwnPanelDBusInterface* self, DBusConnection* connection, DBusMessage* message);
+static DBusHandlerResult _dbus_awn_panel_dbus_interface_get_trace(AwnPanelDBusInterface* self, DBusConnection* connection, DBusMessage* message);
 static void _dbus_awn_panel_dbus_interface_destroy_applet(GObject* _sender, const gchar* uid, DBusConnection* _connection);
 static void _dbus_awn_panel_dbus_interface_destroy_notify(GObject* _sender, DBusConnection* _connection);
 static void _dbus_awn_panel_dbus_interface_property_changed(GObject* _sender, const gchar* prop_name, GValue* value, DBusConnection* _connection);
@@ -93,10 +97,12 @@ static void awn_panel_dbus_interface_dbus_proxy_delete_applet(AwnPanelDBusInterf
 static gint64 awn_panel_dbus_interface_dbus_proxy_docklet_request(AwnPanelDBusInterface* self, gint min_size, gboolean shrink, gboolean expand, GError** error);
 static gchar** awn_panel_dbus_interface_dbus_proxy_get_inhibitors(AwnPanelDBusInterface* self, int* result_length1, GError** error);
 static void awn_panel_dbus_interface_dbus_proxy_get_snapshot(AwnPanelDBusInterface* self, AwnImageStruct* result, GError** error);
+static gint awn_panel_dbus_interface_dbus_proxy_get_snapshot_fd(AwnPanelDBusInterface* self, gint x, gint y, gint width, gint height, gint* out_width, gint* out_height, gint* rowstride, GError** error);
 static guint awn_panel_dbus_interface_dbus_proxy_inhibit_autohide(AwnPanelDBusInterface* self, const char* sender, const gchar* app_name, const gchar* reason, GError** error);
 static void awn_panel_dbus_interface_dbus_proxy_uninhibit_autohide(AwnPanelDBusInterface* self, guint cookie, GError** error);
 static void awn_panel_dbus_interface_dbus_proxy_set_applet_flags(AwnPanelDBusInterface* self, const gchar* uid, gint flags, GError** error);
 static void awn_panel_dbus_interface_dbus_proxy_set_glow(AwnPanelDBusInterface* self, const char* sender, gboolean activate, GError** error);
+static gchar* awn_panel_dbus_interface_dbus_proxy_get_trace(AwnPanelDBusInterface* self, gboolean enable, GError** error);
 static gdouble awn_panel_dbus_interface_dbus_proxy_get_offset_modifier(AwnPanelDBusInterface* self);
 static gint awn_panel_dbus_interface_dbus_proxy_get_max_size(AwnPanelDBusInterface* self);
 static gint awn_panel_dbus_interface_dbus_proxy_get_offset(AwnPanelDBusInterface* self);
@@ -129,10 +135,12 @@ static void awn_panel_dispatcher_real_delete_applet(AwnPanelDBusInterface* base,
 static gint64 awn_panel_dispatcher_real_docklet_request(AwnPanelDBusInterface* base, gint min_size, gboolean shrink, gboolean expand, GError** error);
 static gchar** awn_panel_dispatcher_real_get_inhibitors(AwnPanelDBusInterface* base, int* result_length1, GError** error);
 static void awn_panel_dispatcher_real_get_snapshot(AwnPanelDBusInterface* base, AwnImageStruct* result, GError** error);
+static gint awn_panel_dispatcher_real_get_snapshot_fd(AwnPanelDBusInterface* base, gint x, gint y, gint width, gint height, gint* out_width, gint* out_height, gint* rowstride, GError** error);
 static guint awn_panel_dispatcher_real_inhibit_autohide(AwnPanelDBusInterface* base, const char* sender, const gchar* app_name, const gchar* reason, GError** error);
 static void awn_panel_dispatcher_real_uninhibit_autohide(AwnPanelDBusInterface* base, guint cookie, GError** error);
 static void awn_panel_dispatcher_real_set_applet_flags(AwnPanelDBusInterface* base, const gchar* uid, gint flags, GError** error);
 static void awn_panel_dispatcher_real_set_glow(AwnPanelDBusInterface* base, const char* sender, gboolean activate, GError** error);
+static gchar* awn_panel_dispatcher_real_get_trace(AwnPanelDBusInterface* base, gboolean enable, GError** error);
 static void awn_panel_dispatcher_set_panel(AwnPanelDispatcher* self, AwnPanel* value);
 static void awn_panel_dispatcher_finalize(GObject* obj);
 void awn_panel_dispatcher_dbus_register_object(DBusConnection* connection, const char* path, void* object);
@@ -234,6 +242,12 @@ void awn_panel_dbus_interface_get_snapshot(AwnPanelDBusInterface* self, AwnImage
 }
 
 
+gint awn_panel_dbus_interface_get_snapshot_fd(AwnPanelDBusInterface* self, gint x, gint y, gint width, gint height, gint* out_width, gint* out_height, gint* rowstride, GError** error)
+{
+    return AWN_PANEL_DBUS_INTERFACE_GET_INTERFACE(self)->get_snapshot_fd(self, x, y, width, height, out_width, out_height, rowstride, error);
+}
+
+
 guint awn_panel_dbus_interface_inhibit_autohide(AwnPanelDBusInterface* self, const char* sender, const gchar* app_name, const gchar* reason, GError** error)
 {
     return AWN_PANEL_DBUS_INTERFACE_GET_INTERFACE(self)->inhibit_autohide(self, sender, app_name, reason, error);
@@ -258,6 +272,12 @@ void awn_panel_dbus_interface_set_glow(AwnPanelDBusInterface* self, const char*
 }
 
 
+gchar* awn_panel_dbus_interface_get_trace(AwnPanelDBusInterface* self, gboolean enable, GError** error)
+{
+    return AWN_PANEL_DBUS_INTERFACE_GET_INTERFACE(self)->get_trace(self, enable, error);
+}
+
+
 gdouble awn_panel_dbus_interface_get_offset_modifier(AwnPanelDBusInterface* self)
 {
     return AWN_PANEL_DBUS_INTERFACE_GET_INTERFACE(self)->get_offset_modifier(self);
@@ -386,7 +406,7 @@ static DBusHandlerResult _dbus_awn_panel_dbus_interface_introspect(AwnPanelDBusI
     reply = dbus_message_new_method_return(message);
     dbus_message_iter_init_append(reply, &iter);
     xml_data = g_string_new("<!DOCTYPE node PUBLIC \"-//freedesktop//DTD D-BUS Object Introspection 1.0//EN\" \"http://www.freedesktop.org/standards/dbus/1.0/introspect.dtd\">\n");
-    g_string_append(xml_data, "<node>\n<interface name=\"org.freedesktop.DBus.Introspectable\">\n  <method name=\"Introspect\">\n    <arg name=\"data\" direction=\"out\" type=\"s\"/>\n  </method>\n</interface>\n<interface name=\"org.freedesktop.DBus.Properties\">\n  <method name=\"Get\">\n    <arg name=\"interface\" direction=\"in\" type=\"s\"/>\n    <arg name=\"propname\" direction=\"in\" type=\"s\"/>\n    <arg name=\"value\" direction=\"out\" type=\"v\"/>\n  </method>\n  <method name=\"Set\">\n    <arg name=\"interface\" direction=\"in\" type=\"s\"/>\n    <arg name=\"propname\" direction=\"in\" type=\"s\"/>\n    <arg name=\"value\" direction=\"in\" type=\"v\"/>\n  </method>\n  <method name=\"GetAll\">\n    <arg name=\"interface\" direction=\"in\" type=\"s\"/>\n    <arg name=\"props\" direction=\"out\" type=\"a{sv}\"/>\n  </method>\n</interface>\n<interface name=\"org.awnproject.Awn.Panel\">\n  <method name=\"AddApplet\">\n    <arg name=\"desktop_file\" type=\"s\" direction=\"in\"/>\n  </method>\n  <method name=\"DeleteApplet\">\n    <arg name=\"uid\" type=\"s\" direction=\"in\"/>\n  </method>\n  <method name=\"DockletRequest\">\n    <arg name=\"min_size\" type=\"i\" direction=\"in\"/>\n    <arg name=\"shrink\" type=\"b\" direction=\"in\"/>\n    <arg name=\"expand\" type=\"b\" direction=\"in\"/>\n    <arg name=\"result\" type=\"x\" direction=\"out\"/>\n  </method>\n  <method name=\"GetInhibitors\">\n    <arg name=\"result\" type=\"as\" direction=\"out\"/>\n  </method>\n  <method name=\"GetSnapshot\">\n    <arg name=\"result\" type=\"(iiibiiay)\" direction=\"out\"/>\n  </method>\n  <method name=\"InhibitAutohide\">\n    <arg name=\"app_name\" type=\"s\" direction=\"in\"/>\n    <arg name=\"reason\" type=\"s\" direction=\"in\"/>\n    <arg name=\"result\" type=\"u\" direction=\"out\"/>\n  </method>\n  <method name=\"UninhibitAutohide\">\n    <arg name=\"cookie\" type=\"u\" direction=\"in\"/>\n  </method>\n  <method name=\"SetAppletFlags\">\n    <arg name=\"uid\" type=\"s\" direction=\"in\"/>\n    <arg name=\"flags\" type=\"i\" direction=\"in\"/>\n  </method>\n  <method name=\"SetGlow\">\n    <arg name=\"activate\" type=\"b\" direction=\"in\"/>\n  </method>\n  <property name=\"OffsetModifier\" type=\"d\" access=\"read\"/>\n  <property name=\"MaxSize\" type=\"i\" access=\"read\"/>\n  <property name=\"Offset\" type=\"i\" access=\"readwrite\"/>\n  <property name=\"PathType\" type=\"i\" access=\"read\"/>\n  <property name=\"Position\" type=\"i\" access=\"readwrite\"/>\n  <property name=\"Size\" type=\"i\" access=\"readwrite\"/>\n  <property name=\"PanelXid\" type=\"x\" access=\"read\"/>\n  <signal name=\"DestroyApplet\">\n    <arg name=\"uid\" type=\"s\"/>\n  </signal>\n  <signal name=\"DestroyNotify\">\n  </signal>\n  <signal name=\"PropertyChanged\">\n    <arg name=\"prop_name\" type=\"s\"/>\n    <arg name=\"value\" type=\"v\"/>\n  </signal>\n</interface>\n");
+    g_string_append(xml_data, "<node>\n<interface name=\"org.freedesktop.DBus.Introspectable\">\n  <method name=\"Introspect\">\n    <arg name=\"data\" direction=\"out\" type=\"s\"/>\n  </method>\n</interface>\n<interface name=\"org.freedesktop.DBus.Properties\">\n  <method name=\"Get\">\n    <arg name=\"interface\" direction=\"in\" type=\"s\"/>\n    <arg name=\"propname\" direction=\"in\" type=\"s\"/>\n    <arg name=\"value\" direction=\"out\" type=\"v\"/>\n  </method>\n  <method name=\"Set\">\n    <arg name=\"interface\" direction=\"in\" type=\"s\"/>\n    <arg name=\"propname\" direction=\"in\" type=\"s\"/>\n    <arg name=\"value\" direction=\"in\" type=\"v\"/>\n  </method>\n  <method name=\"GetAll\">\n    <arg name=\"interface\" direction=\"in\" type=\"s\"/>\n    <arg name=\"props\" direction=\"out\" type=\"a{sv}\"/>\n  </method>\n</interface>\n<interface name=\"org.awnproject.Awn.Panel\">\n  <method name=\"AddApplet\">\n    <arg name=\"desktop_file\" type=\"s\" direction=\"in\"/>\n  </method>\n  <method name=\"DeleteApplet\">\n    <arg name=\"uid\" type=\"s\" direction=\"in\"/>\n  </method>\n  <method name=\"DockletRequest\">\n    <arg name=\"min_size\" type=\"i\" direction=\"in\"/>\n    <arg name=\"shrink\" type=\"b\" direction=\"in\"/>\n    <arg name=\"expand\" type=\"b\" direction=\"in\"/>\n    <arg name=\"result\" type=\"x\" direction=\"out\"/>\n  </method>\n  <method name=\"GetInhibitors\">\n    <arg name=\"result\" type=\"as\" direction=\"out\"/>\n  </method>\n  <method name=\"GetSnapshot\">\n    <arg name=\"result\" type=\"(iiibiiay)\" direction=\"out\"/>\n  </method>\n  <method name=\"GetSnapshotFd\">\n    <arg name=\"x\" type=\"i\" direction=\"in\"/>\n    <arg name=\"y\" type=\"i\" direction=\"in\"/>\n    <arg name=\"width\" type=\"i\" direction=\"in\"/>\n    <arg name=\"height\" type=\"i\" direction=\"in\"/>\n    <arg name=\"out_width\" type=\"i\" direction=\"out\"/>\n    <arg name=\"out_height\" type=\"i\" direction=\"out\"/>\n    <arg name=\"rowstride\" type=\"i\" direction=\"out\"/>\n    <arg name=\"result\" type=\"h\" direction=\"out\"/>\n  </method>\n  <method name=\"InhibitAutohide\">\n    <arg name=\"app_name\" type=\"s\" direction=\"in\"/>\n    <arg name=\"reason\" type=\"s\" direction=\"in\"/>\n    <arg name=\"result\" type=\"u\" direction=\"out\"/>\n  </method>\n  <method name=\"UninhibitAutohide\">\n    <arg name=\"cookie\" type=\"u\" direction=\"in\"/>\n  </method>\n  <method name=\"SetAppletFlags\">\n    <arg name=\"uid\" type=\"s\" direction=\"in\"/>\n    <arg name=\"flags\" type=\"i\" direction=\"in\"/>\n  </method>\n  <method name=\"SetGlow\">\n    <arg name=\"activate\" type=\"b\" direction=\"in\"/>\n  </method>\n  <method name=\"GetTrace\">\n    <arg name=\"enable\" type=\"b\" direction=\"in\"/>\n    <arg name=\"result\" type=\"s\" direction=\"out\"/>\n  </method>\n  <property name=\"OffsetModifier\" type=\"d\" access=\"read\"/>\n  <property name=\"MaxSize\" type=\"i\" access=\"read\"/>\n  <property name=\"Offset\" type=\"i\" access=\"readwrite\"/>\n  <property name=\"PathType\" type=\"i\" access=\"read\"/>\n  <property name=\"Position\" type=\"i\" access=\"readwrite\"/>\n  <property name=\"Size\" type=\"i\" access=\"readwrite\"/>\n  <property name=\"PanelXid\" type=\"x\" access=\"read\"/>\n  <signal name=\"DestroyApplet\">\n    <arg name=\"uid\" type=\"s\"/>\n  </signal>\n  <signal name=\"DestroyNotify\">\n  </signal>\n  <signal name=\"PropertyChanged\">\n    <arg name=\"prop_name\" type=\"s\"/>\n    <arg name=\"value\" type=\"v\"/>\n  </signal>\n</interface>\n");
     dbus_connection_list_registered(connection, g_object_get_data((GObject*) self, "dbus_object_path"), &children);
     for (i = 0; children[i]; i++) {
         g_string_append_printf(xml_data, "<node name=\"%s\"/>\n", children[i]);
@@ -1396,13 +1416,9 @@ static DBusHandlerResult _dbus_awn_panel_dbus_interface_get_snapshot(AwnPanelDBu
     _tmp38_ = result.num_channels;
     dbus_message_iter_append_basic(&_tmp32_, DBUS_TYPE_INT32, &_tmp38_);
     _tmp39_ = result.pixel_data;
+    _tmp41_ = result.pixel_data_length1;
     dbus_message_iter_open_container(&_tmp32_, DBUS_TYPE_ARRAY, "y", &_tmp40_);
-    for (_tmp41_ = 0; _tmp41_ < result.pixel_data_length1; _tmp41_++) {
-        guint8 _tmp42_;
-        _tmp42_ = *_tmp39_;
-        dbus_message_iter_append_basic(&_tmp40_, DBUS_TYPE_BYTE, &_tmp42_);
-        _tmp39_++;
-    }
+    dbus_message_iter_append_fixed_array(&_tmp40_, DBUS_TYPE_BYTE, &_tmp39_, _tmp41_);
     dbus_message_iter_close_container(&_tmp32_, &_tmp40_);
     dbus_message_iter_close_container(&iter, &_tmp32_);
     awn_image_struct_destroy(& result);
@@ -1416,6 +1432,77 @@ static DBusHandlerResult _dbus_awn_panel_dbus_interface_get_snapshot(AwnPanelDBu
 }
 
 
+static DBusHandlerResult _dbus_awn_panel_dbus_interface_get_snapshot_fd(AwnPanelDBusInterface* self, DBusConnection* connection, DBusMessage* message)
+{
+    DBusMessage* reply;
+    if (strcmp(dbus_message_get_signature(message), "iiii")) {
+        return DBUS_HANDLER_RESULT_NOT_YET_HANDLED;
+    }
+#ifdef DBUS_TYPE_UNIX_FD
+    DBusMessageIter iter;
+    GError* error;
+    gint x = 0;
+    gint y = 0;
+    gint width = 0;
+    gint height = 0;
+    dbus_int32_t _tmp0_;
+    gint out_width = 0;
+    gint out_height = 0;
+    gint rowstride = 0;
+    gint result;
+    dbus_int32_t _tmp1_;
+    error = NULL;
+    if (!dbus_connection_can_send_type(connection, DBUS_TYPE_UNIX_FD)) {
+        reply = dbus_message_new_error(message, "org.freedesktop.DBus.Error.NotSupported", "Connection can't pass file descriptors");
+        dbus_connection_send(connection, reply, NULL);
+        dbus_message_unref(reply);
+        return DBUS_HANDLER_RESULT_HANDLED;
+    }
+    dbus_message_iter_init(message, &iter);
+    dbus_message_iter_get_basic(&iter, &_tmp0_);
+    dbus_message_iter_next(&iter);
+    x = _tmp0_;
+    dbus_message_iter_get_basic(&iter, &_tmp0_);
+    dbus_message_iter_next(&iter);
+    y = _tmp0_;
+    dbus_message_iter_get_basic(&iter, &_tmp0_);
+    dbus_message_iter_next(&iter);
+    width = _tmp0_;
+    dbus_message_iter_get_basic(&iter, &_tmp0_);
+    dbus_message_iter_next(&iter);
+    height = _tmp0_;
+    result = awn_panel_dbus_interface_get_snapshot_fd(self, x, y, width, height, &out_width, &out_height, &rowstride, &error);
+    if (error) {
+        reply = dbus_message_new_error(message, "org.freedesktop.DBus.Error.Failed", error->message);
+        g_error_free(error);
+        dbus_connection_send(connection, reply, NULL);
+        dbus_message_unref(reply);
+        return DBUS_HANDLER_RESULT_HANDLED;
+    }
+    reply = dbus_message_new_method_return(message);
+    dbus_message_iter_init_append(reply, &iter);
+    _tmp1_ = out_width;
+    dbus_message_iter_append_basic(&iter, DBUS_TYPE_INT32, &_tmp1_);
+    _tmp1_ = out_height;
+    dbus_message_iter_append_basic(&iter, DBUS_TYPE_INT32, &_tmp1_);
+    _tmp1_ = rowstride;
+    dbus_message_iter_append_basic(&iter, DBUS_TYPE_INT32, &_tmp1_);
+    /* the message keeps its own duplicate of the descriptor */
+    dbus_message_iter_append_basic(&iter, DBUS_TYPE_UNIX_FD, &result);
+    close(result);
+#else
+    reply = dbus_message_new_error(message, "org.freedesktop.DBus.Error.NotSupported", "D-Bus was built without file descriptor passing");
+#endif
+    if (reply) {
+        dbus_connection_send(connection, reply, NULL);
+        dbus_message_unref(reply);
+        return DBUS_HANDLER_RESULT_HANDLED;
+    } else {
+        return DBUS_HANDLER_RESULT_NOT_YET_HANDLED;
+    }
+}
+
+
 static DBusHandlerResult _dbus_awn_panel_dbus_interface_inhibit_autohide(AwnPanelDBusInterface* self, DBusConnection* connection, DBusMessage* message)
 {
     DBusMessageIter iter;
@@ -1977,6 +2064,46 @@ static DBusHandlerResult _dbus_awn_panel_dbus_interface_set_glow(AwnPanelDBusInt
 }
 
 
+static DBusHandlerResult _dbus_awn_panel_dbus_interface_get_trace(AwnPanelDBusInterface* self, DBusConnection* connection, DBusMessage* message)
+{
+    DBusMessageIter iter;
+    GError* error;
+    gboolean enable = FALSE;
+    dbus_bool_t _tmp0_;
+    const char* _tmp1_;
+    gchar* result;
+    DBusMessage* reply;
+    error = NULL;
+    if (strcmp(dbus_message_get_signature(message), "b")) {
+        return DBUS_HANDLER_RESULT_NOT_YET_HANDLED;
+    }
+    dbus_message_iter_init(message, &iter);
+    dbus_message_iter_get_basic(&iter, &_tmp0_);
+    dbus_message_iter_next(&iter);
+    enable = _tmp0_;
+    result = awn_panel_dbus_interface_get_trace(self, enable, &error);
+    if (error) {
+        reply = dbus_message_new_error(message, "org.freedesktop.DBus.Error.Failed", error->message);
+        g_error_free(error);
+        dbus_connection_send(connection, reply, NULL);
+        dbus_message_unref(reply);
+        return DBUS_HANDLER_RESULT_HANDLED;
+    }
+    reply = dbus_message_new_method_return(message);
+    dbus_message_iter_init_append(reply, &iter);
+    _tmp1_ = result;
+    dbus_message_iter_append_basic(&iter, DBUS_TYPE_STRING, &_tmp1_);
+    _g_free0(result);
+    if (reply) {
+        dbus_connection_send(connection, reply, NULL);
+        dbus_message_unref(reply);
+        return DBUS_HANDLER_RESULT_HANDLED;
+    } else {
+        return DBUS_HANDLER_RESULT_NOT_YET_HANDLED;
+    }
+}
+
+
 DBusHandlerResult awn_panel_dbus_interface_dbus_message(DBusConnection* connection, DBusMessage* message, void* object)
 {
     DBusHandlerResult result;
@@ -1999,6 +2126,8 @@ DBusHandlerResult awn_panel_dbus_interface_dbus_message(DBusConnection* connecti
         result = _dbus_awn_panel_dbus_interface_get_inhibitors(object, connection, message);
     } else if (dbus_message_is_method_call(message, "org.awnproject.Awn.Panel", "GetSnapshot")) {
         result = _dbus_awn_panel_dbus_interface_get_snapshot(object, connection, message);
+    } else if (dbus_message_is_method_call(message, "org.awnproject.Awn.Panel", "GetSnapshotFd")) {
+        result = _dbus_awn_panel_dbus_interface_get_snapshot_fd(object, connection, message);
     } else if (dbus_message_is_method_call(message, "org.awnproject.Awn.Panel", "InhibitAutohide")) {
         result = _dbus_awn_panel_dbus_interface_inhibit_autohide(object, connection, message);
     } else if (dbus_message_is_method_call(message, "org.awnproject.Awn.Panel", "UninhibitAutohide")) {
@@ -2007,6 +2136,8 @@ DBusHandlerResult awn_panel_dbus_interface_dbus_message(DBusConnection* connecti
         result = _dbus_awn_panel_dbus_interface_set_applet_flags(object, connection, message);
     } else if (dbus_message_is_method_call(message, "org.awnproject.Awn.Panel", "SetGlow")) {
         result = _dbus_awn_panel_dbus_interface_set_glow(object, connection, message);
+    } else if (dbus_message_is_method_call(message, "org.awnproject.Awn.Panel", "GetTrace")) {
+        result = _dbus_awn_panel_dbus_interface_get_trace(object, connection, message);
     }
     if (result == DBUS_HANDLER_RESULT_HANDLED) {
         return result;
@@ -2852,10 +2983,9 @@ static void awn_panel_dbus_interface_dbus_proxy_get_snapshot(AwnPanelDBusInterfa
     dbus_int32_t _tmp38_;
     dbus_int32_t _tmp39_;
     gchar* _tmp40_;
-    int _tmp40__length;
-    int _tmp40__size;
     int _tmp40__length1;
     DBusMessageIter _tmp41_;
+    const guint8* _tmp42_;
     if (((AwnPanelDBusInterfaceDBusProxy*) self)->disposed) {
         g_set_error(error, DBUS_GERROR, DBUS_GERROR_DISCONNECTED, "%s", "Connection is closed");
         return;
@@ -2971,21 +3101,11 @@ static void awn_panel_dbus_interface_dbus_proxy_get_snapshot(AwnPanelDBusInterfa
     dbus_message_iter_get_basic(&_tmp33_, &_tmp39_);
     dbus_message_iter_next(&_tmp33_);
     _tmp32_.num_channels = _tmp39_;
-    _tmp40_ = g_new(gchar, 5);
-    _tmp40__length = 0;
-    _tmp40__size = 4;
-    _tmp40__length1 = 0;
     dbus_message_iter_recurse(&_tmp33_, &_tmp41_);
-    for (; dbus_message_iter_get_arg_type(&_tmp41_); _tmp40__length1++) {
-        guint8 _tmp42_;
-        if (_tmp40__size == _tmp40__length) {
-            _tmp40__size = 2 * _tmp40__size;
-            _tmp40_ = g_renew(gchar, _tmp40_, _tmp40__size + 1);
-        }
-        dbus_message_iter_get_basic(&_tmp41_, &_tmp42_);
-        dbus_message_iter_next(&_tmp41_);
-        _tmp40_[_tmp40__length++] = _tmp42_;
-    }
+    dbus_message_iter_get_fixed_array(&_tmp41_, &_tmp42_, &_tmp40__length1);
+    _tmp40_ = g_new(gchar, _tmp40__length1 + 1);
+    memcpy(_tmp40_, _tmp42_, _tmp40__length1);
+    _tmp40_[_tmp40__length1] = 0;
     _tmp32_.pixel_data_length1 = _tmp40__length1;
     dbus_message_iter_next(&_tmp33_);
     _tmp32_.pixel_data = _tmp40_;
@@ -2995,6 +3115,60 @@ static void awn_panel_dbus_interface_dbus_proxy_get_snapshot(AwnPanelDBusInterfa
 }
 
 
+static gint awn_panel_dbus_interface_dbus_proxy_get_snapshot_fd(AwnPanelDBusInterface* self, gint x, gint y, gint width, gint height, gint* out_width, gint* out_height, gint* rowstride, GError** error)
+{
+    DBusError _dbus_error;
+    DBusGConnection* _connection;
+    DBusMessage* _message, *_reply;
+    DBusMessageIter _iter;
+    dbus_int32_t _tmp0_;
+    gint _result = -1;
+    if (((AwnPanelDBusInterfaceDBusProxy*) self)->disposed) {
+        g_set_error(error, DBUS_GERROR, DBUS_GERROR_DISCONNECTED, "%s", "Connection is closed");
+        return -1;
+    }
+    _message = dbus_message_new_method_call(dbus_g_proxy_get_bus_name((DBusGProxy*) self), dbus_g_proxy_get_path((DBusGProxy*) self), "org.awnproject.Awn.Panel", "GetSnapshotFd");
+    dbus_message_iter_init_append(_message, &_iter);
+    _tmp0_ = x;
+    dbus_message_iter_append_basic(&_iter, DBUS_TYPE_INT32, &_tmp0_);
+    _tmp0_ = y;
+    dbus_message_iter_append_basic(&_iter, DBUS_TYPE_INT32, &_tmp0_);
+    _tmp0_ = width;
+    dbus_message_iter_append_basic(&_iter, DBUS_TYPE_INT32, &_tmp0_);
+    _tmp0_ = height;
+    dbus_message_iter_append_basic(&_iter, DBUS_TYPE_INT32, &_tmp0_);
+    g_object_get(self, "connection", &_connection, NULL);
+    dbus_error_init(&_dbus_error);
+    _reply = dbus_connection_send_with_reply_and_block(dbus_g_connection_get_connection(_connection), _message, -1, &_dbus_error);
+    dbus_g_connection_unref(_connection);
+    dbus_message_unref(_message);
+    if (dbus_error_is_set(&_dbus_error)) {
+        g_set_error(error, DBUS_GERROR, strcmp(_dbus_error.name, "org.freedesktop.DBus.Error.NotSupported") == 0 ? DBUS_GERROR_NOT_SUPPORTED : DBUS_GERROR_FAILED, "%s", _dbus_error.message);
+        dbus_error_free(&_dbus_error);
+        return -1;
+    }
+    if (strcmp(dbus_message_get_signature(_reply), "iiih")) {
+        g_set_error(error, DBUS_GERROR, DBUS_GERROR_INVALID_SIGNATURE, "Invalid signature, expected \"%s\", got \"%s\"", "iiih", dbus_message_get_signature(_reply));
+        dbus_message_unref(_reply);
+        return -1;
+    }
+    dbus_message_iter_init(_reply, &_iter);
+    dbus_message_iter_get_basic(&_iter, &_tmp0_);
+    dbus_message_iter_next(&_iter);
+    *out_width = _tmp0_;
+    dbus_message_iter_get_basic(&_iter, &_tmp0_);
+    dbus_message_iter_next(&_iter);
+    *out_height = _tmp0_;
+    dbus_message_iter_get_basic(&_iter, &_tmp0_);
+    dbus_message_iter_next(&_iter);
+    *rowstride = _tmp0_;
+    /* we get a duplicate which the caller owns */
+    dbus_message_iter_get_basic(&_iter, &_result);
+    dbus_message_unref(_reply);
+    return _result;
+}
+
+
 static guint awn_panel_dbus_interface_dbus_proxy_inhibit_autohide(AwnPanelDBusInterface* self, const char* sender, const gchar* app_name, const gchar* reason, GError** error)
 {
     DBusError _dbus_error;
@@ -3443,6 +3617,47 @@ static void awn_panel_dbus_interface_dbus_proxy_set_glow(AwnPanelDBusInterface*
 }
 
 
+static gchar* awn_panel_dbus_interface_dbus_proxy_get_trace(AwnPanelDBusInterface* self, gboolean enable, GError** error)
+{
+    DBusError _dbus_error;
+    DBusGConnection* _connection;
+    DBusMessage* _message, *_reply;
+    DBusMessageIter _iter;
+    dbus_bool_t _tmp0_;
+    const char* _tmp1_;
+    gchar* _result;
+    if (((AwnPanelDBusInterfaceDBusProxy*) self)->disposed) {
+        g_set_error(error, DBUS_GERROR, DBUS_GERROR_DISCONNECTED, "%s", "Connection is closed");
+        return NULL;
+    }
+    _message = dbus_message_new_method_call(dbus_g_proxy_get_bus_name((DBusGProxy*) self), dbus_g_proxy_get_path((DBusGProxy*) self), "org.awnproject.Awn.Panel", "GetTrace");
+    dbus_message_iter_init_append(_message, &_iter);
+    _tmp0_ = enable;
+    dbus_message_iter_append_basic(&_iter, DBUS_TYPE_BOOLEAN, &_tmp0_);
+    g_object_get(self, "connection", &_connection, NULL);
+    dbus_error_init(&_dbus_error);
+    _reply = dbus_connection_send_with_reply_and_block(dbus_g_connection_get_connection(_connection), _message, -1, &_dbus_error);
+    dbus_g_connection_unref(_connection);
+    dbus_message_unref(_message);
+    if (dbus_error_is_set(&_dbus_error)) {
+        g_set_error(error, DBUS_GERROR, DBUS_GERROR_FAILED, "%s", _dbus_error.message);
+        dbus_error_free(&_dbus_error);
+        return NULL;
+    }
+    if (strcmp(dbus_message_get_signature(_reply), "s")) {
+        g_set_error(error, DBUS_GERROR, DBUS_GERROR_INVALID_SIGNATURE, "Invalid signature, expected \"%s\", got \"%s\"", "s", dbus_message_get_signature(_reply));
+        dbus_message_unref(_reply);
+        return NULL;
+    }
+    dbus_message_iter_init(_reply, &_iter);
+    dbus_message_iter_get_basic(&_iter, &_tmp1_);
+    dbus_message_iter_next(&_iter);
+    _result = g_strdup(_tmp1_);
+    dbus_message_unref(_reply);
+    return _result;
+}
+
+
 static gdouble awn_panel_dbus_interface_dbus_proxy_get_offset_modifier(AwnPanelDBusInterface* self)
 {
     DBusError _dbus_error;
@@ -3919,10 +4134,12 @@ static void awn_panel_dbus_interface_dbus_proxy_awn_panel_dbus_interface__interf
     iface->docklet_request = awn_panel_dbus_interface_dbus_proxy_docklet_request;
     iface->get_inhibitors = awn_panel_dbus_interface_dbus_proxy_get_inhibitors;
     iface->get_snapshot = awn_panel_dbus_interface_dbus_proxy_get_snapshot;
+    iface->get_snapshot_fd = awn_panel_dbus_interface_dbus_proxy_get_snapshot_fd;
     iface->inhibit_autohide = awn_panel_dbus_interface_dbus_proxy_inhibit_autohide;
     iface->uninhibit_autohide = awn_panel_dbus_interface_dbus_proxy_uninhibit_autohide;
     iface->set_applet_flags = awn_panel_dbus_interface_dbus_proxy_set_applet_flags;
     iface->set_glow = awn_panel_dbus_interface_dbus_proxy_set_glow;
+    iface->get_trace = awn_panel_dbus_interface_dbus_proxy_get_trace;
     iface->get_offset_modifier = awn_panel_dbus_interface_dbus_proxy_get_offset_modifier;
     iface->get_max_size = awn_panel_dbus_interface_dbus_proxy_get_max_size;
     iface->get_offset = awn_panel_dbus_interface_dbus_proxy_get_offset;
@@ -4178,6 +4395,16 @@ static void awn_panel_dispatcher_real_get_snapshot(AwnPanelDBusInterface* base,
 }
 
 
+static gint awn_panel_dispatcher_real_get_snapshot_fd(AwnPanelDBusInterface* base, gint x, gint y, gint width, gint height, gint* out_width, gint* out_height, gint* rowstride, GError** error)
+{
+    AwnPanelDispatcher* self;
+    gint result = -1;
+    self = (AwnPanelDispatcher*) base;
+    awn_panel_get_snapshot_fd(self->priv->_panel, x, y, width, height, &result, out_width, out_height, rowstride, error);
+    return result;
+}
+
+
 static guint awn_panel_dispatcher_real_inhibit_autohide(AwnPanelDBusInterface* base, const char* sender, const gchar* app_name, const gchar* reason, GError** error)
 {
     AwnPanelDispatcher* self;
@@ -4230,6 +4457,17 @@ static void awn_panel_dispatcher_real_set_glow(AwnPanelDBusInterface* base, cons
 }
 
 
+static gchar* awn_panel_dispatcher_real_get_trace(AwnPanelDBusInterface* base, gboolean enable, GError** error)
+{
+    gchar* result;
+    /* what was recorded so far, before a new recording clears it, the
+     * caller saves it wherever it likes */
+    result = awn_trace_to_json();
+    awn_trace_set_enabled(enable);
+    return result;
+}
+
+
 AwnPanel* awn_panel_dispatcher_get_panel(AwnPanelDispatcher* self)
 {
     AwnPanel* result;
@@ -4374,10 +4612,12 @@ static void awn_panel_dispatcher_awn_panel_dbus_interface_interface_init(AwnPane
     iface->docklet_request = (gint64(*)(AwnPanelDBusInterface* , gint , gboolean , gboolean , GError**)) awn_panel_dispatcher_real_docklet_request;
     iface->get_inhibitors = (gchar** (*)(AwnPanelDBusInterface* , int* , GError**)) awn_panel_dispatcher_real_get_inhibitors;
     iface->get_snapshot = (AwnImageStruct(*)(AwnPanelDBusInterface* , AwnImageStruct* , GError**)) awn_panel_dispatcher_real_get_snapshot;
+    iface->get_snapshot_fd = (gint(*)(AwnPanelDBusInterface* , gint , gint , gint , gint , gint* , gint* , gint* , GError**)) awn_panel_dispatcher_real_get_snapshot_fd;
     iface->inhibit_autohide = (guint(*)(AwnPanelDBusInterface* , const char* , const gchar* , const gchar* , GError**)) awn_panel_dispatcher_real_inhibit_autohide;
     iface->uninhibit_autohide = (void (*)(AwnPanelDBusInterface* , guint , GError**)) awn_panel_dispatcher_real_uninhibit_autohide;
     iface->set_applet_flags = (void (*)(AwnPanelDBusInterface* , const gchar* , gint , GError**)) awn_panel_dispatcher_real_set_applet_flags;
     iface->set_glow = (void (*)(AwnPanelDBusInterface* , const char* , gboolean , GError**)) awn_panel_dispatcher_real_set_glow;
+    iface->get_trace = (gchar* (*)(AwnPanelDBusInterface* , gboolean , GError**)) awn_panel_dispatcher_real_get_trace;
     iface->get_offset_modifier = awn_panel_dispatcher_real_get_offset_modifier;
     iface->get_max_size = awn_panel_dispatcher_real_get_max_size;
     iface->get_offset = awn_panel_dispatcher_real_get_offset;
@@ -4418,7 +4658,7 @@ static DBusHandlerResult _dbus_awn_panel_dispatcher_introspect(AwnPanelDispatche
     reply = dbus_message_new_method_return(message);
     dbus_message_iter_init_append(reply, &iter);
     xml_data = g_string_new("<!DOCTYPE node PUBLIC \"-//freedesktop//DTD D-BUS Object Introspection 1.0//EN\" \"http://www.freedesktop.org/standards/dbus/1.0/introspect.dtd\">\n");
-    g_string_append(xml_data, "<node>\n<interface name=\"org.freedesktop.DBus.Introspectable\">\n  <method name=\"Introspect\">\n    <arg name=\"data\" direction=\"out\" type=\"s\"/>\n  </method>\n</interface>\n<interface name=\"org.freedesktop.DBus.Properties\">\n  <method name=\"Get\">\n    <arg name=\"interface\" direction=\"in\" type=\"s\"/>\n    <arg name=\"propname\" direction=\"in\" type=\"s\"/>\n    <arg name=\"value\" direction=\"out\" type=\"v\"/>\n  </method>\n  <method name=\"Set\">\n    <arg name=\"interface\" direction=\"in\" type=\"s\"/>\n    <arg name=\"propname\" direction=\"in\" type=\"s\"/>\n    <arg name=\"value\" direction=\"in\" type=\"v\"/>\n  </method>\n  <method name=\"GetAll\">\n    <arg name=\"interface\" direction=\"in\" type=\"s\"/>\n    <arg name=\"props\" direction=\"out\" type=\"a{sv}\"/>\n  </method>\n</interface>\n<interface name=\"org.awnproject.Awn.Panel\">\n  <method name=\"AddApplet\">\n    <arg name=\"desktop_file\" type=\"s\" direction=\"in\"/>\n  </method>\n  <method name=\"DeleteApplet\">\n    <arg name=\"uid\" type=\"s\" direction=\"in\"/>\n  </method>\n  <method name=\"DockletRequest\">\n    <arg name=\"min_size\" type=\"i\" direction=\"in\"/>\n    <arg name=\"shrink\" type=\"b\" direction=\"in\"/>\n    <arg name=\"expand\" type=\"b\" direction=\"in\"/>\n    <arg name=\"result\" type=\"x\" direction=\"out\"/>\n  </method>\n  <method name=\"GetInhibitors\">\n    <arg name=\"result\" type=\"as\" direction=\"out\"/>\n  </method>\n  <method name=\"GetSnapshot\">\n    <arg name=\"result\" type=\"(iiibiiay)\" direction=\"out\"/>\n  </method>\n  <method name=\"InhibitAutohide\">\n    <arg name=\"app_name\" type=\"s\" direction=\"in\"/>\n    <arg name=\"reason\" type=\"s\" direction=\"in\"/>\n    <arg name=\"result\" type=\"u\" direction=\"out\"/>\n  </method>\n  <method name=\"UninhibitAutohide\">\n    <arg name=\"cookie\" type=\"u\" direction=\"in\"/>\n  </method>\n  <method name=\"SetAppletFlags\">\n    <arg name=\"uid\" type=\"s\" direction=\"in\"/>\n    <arg name=\"flags\" type=\"i\" direction=\"in\"/>\n  </method>\n  <method name=\"SetGlow\">\n    <arg name=\"activate\" type=\"b\" direction=\"in\"/>\n  </method>\n  <property name=\"OffsetModifier\" type=\"d\" access=\"read\"/>\n  <property name=\"MaxSize\" type=\"i\" access=\"read\"/>\n  <property name=\"Offset\" type=\"i\" access=\"readwrite\"/>\n  <property name=\"PathType\" type=\"i\" access=\"read\"/>\n  <property name=\"Position\" type=\"i\" access=\"readwrite\"/>\n  <property name=\"Size\" type=\"i\" access=\"readwrite\"/>\n  <property name=\"PanelXid\" type=\"x\" access=\"read\"/>\n  <signal name=\"DestroyApplet\">\n    <arg name=\"uid\" type=\"s\"/>\n  </signal>\n  <signal name=\"DestroyNotify\">\n  </signal>\n  <signal name=\"PropertyChanged\">\n    <arg name=\"prop_name\" type=\"s\"/>\n    <arg name=\"value\" type=\"v\"/>\n  </signal>\n</interface>\n");
+    g_string_append(xml_data, "<node>\n<interface name=\"org.freedesktop.DBus.Introspectable\">\n  <method name=\"Introspect\">\n    <arg name=\"data\" direction=\"out\" type=\"s\"/>\n  </method>\n</interface>\n<interface name=\"org.freedesktop.DBus.Properties\">\n  <method name=\"Get\">\n    <arg name=\"interface\" direction=\"in\" type=\"s\"/>\n    <arg name=\"propname\" direction=\"in\" type=\"s\"/>\n    <arg name=\"value\" direction=\"out\" type=\"v\"/>\n  </method>\n  <method name=\"Set\">\n    <arg name=\"interface\" direction=\"in\" type=\"s\"/>\n    <arg name=\"propname\" direction=\"in\" type=\"s\"/>\n    <arg name=\"value\" direction=\"in\" type=\"v\"/>\n  </method>\n  <method name=\"GetAll\">\n    <arg name=\"interface\" direction=\"in\" type=\"s\"/>\n    <arg name=\"props\" direction=\"out\" type=\"a{sv}\"/>\n  </method>\n</interface>\n<interface name=\"org.awnproject.Awn.Panel\">\n  <method name=\"AddApplet\">\n    <arg name=\"desktop_file\" type=\"s\" direction=\"in\"/>\n  </method>\n  <method name=\"DeleteApplet\">\n    <arg name=\"uid\" type=\"s\" direction=\"in\"/>\n  </method>\n  <method name=\"DockletRequest\">\n    <arg name=\"min_size\" type=\"i\" direction=\"in\"/>\n    <arg name=\"shrink\" type=\"b\" direction=\"in\"/>\n    <arg name=\"expand\" type=\"b\" direction=\"in\"/>\n    <arg name=\"result\" type=\"x\" direction=\"out\"/>\n  </method>\n  <method name=\"GetInhibitors\">\n    <arg name=\"result\" type=\"as\" direction=\"out\"/>\n  </method>\n  <method name=\"GetSnapshot\">\n    <arg name=\"result\" type=\"(iiibiiay)\" direction=\"out\"/>\n  </method>\n  <method name=\"GetSnapshotFd\">\n    <arg name=\"x\" type=\"i\" direction=\"in\"/>\n    <arg name=\"y\" type=\"i\" direction=\"in\"/>\n    <arg name=\"width\" type=\"i\" direction=\"in\"/>\n    <arg name=\"height\" type=\"i\" direction=\"in\"/>\n    <arg name=\"out_width\" type=\"i\" direction=\"out\"/>\n    <arg name=\"out_height\" type=\"i\" direction=\"out\"/>\n    <arg name=\"rowstride\" type=\"i\" direction=\"out\"/>\n    <arg name=\"result\" type=\"h\" direction=\"out\"/>\n  </method>\n  <method name=\"InhibitAutohide\">\n    <arg name=\"app_name\" type=\"s\" direction=\"in\"/>\n    <arg name=\"reason\" type=\"s\" direction=\"in\"/>\n    <arg name=\"result\" type=\"u\" direction=\"out\"/>\n  </method>\n  <method name=\"UninhibitAutohide\">\n    <arg name=\"cookie\" type=\"u\" direction=\"in\"/>\n  </method>\n  <method name=\"SetAppletFlags\">\n    <arg name=\"uid\" type=\"s\" direction=\"in\"/>\n    <arg name=\"flags\" type=\"i\" direction=\"in\"/>\n  </method>\n  <method name=\"SetGlow\">\n    <arg name=\"activate\" type=\"b\" direction=\"in\"/>\n  </method>\n  <method name=\"GetTrace\">\n    <arg name=\"enable\" type=\"b\" direction=\"in\"/>\n    <arg name=\"result\" type=\"s\" direction=\"out\"/>\n  </method>\n  <property name=\"OffsetModifier\" type=\"d\" access=\"read\"/>\n  <property name=\"MaxSize\" type=\"i\" access=\"read\"/>\n  <property name=\"Offset\" type=\"i\" access=\"readwrite\"/>\n  <property name=\"PathType\" type=\"i\" access=\"read\"/>\n  <property name=\"Position\" type=\"i\" access=\"readwrite\"/>\n  <property name=\"Size\" type=\"i\" access=\"readwrite\"/>\n  <property name=\"PanelXid\" type=\"x\" access=\"read\"/>\n  <signal name=\"DestroyApplet\">\n    <arg name=\"uid\" type=\"s\"/>\n  </signal>\n  <signal name=\"DestroyNotify\">\n  </signal>\n  <signal name=\"PropertyChanged\">\n    <arg name=\"prop_name\" type=\"s\"/>\n    <arg name=\"value\" type=\"v\"/>\n  </signal>\n</interface>\n");
     dbus_connection_list_registered(connection, g_object_get_data((GObject*) self, "dbus_object_path"), &children);
     for (i = 0; children[i]; i++) {
         g_string_append_printf(xml_data, "<node name=\"%s\"/>\n", children[i]);
@@ -58,10 +58,12 @@ struct _AwnPanelDBusInterfaceIface {
     gint64(*docklet_request)(AwnPanelDBusInterface* self, gint min_size, gboolean shrink, gboolean expand, GError** error);
     gchar** (*get_inhibitors)(AwnPanelDBusInterface* self, int* result_length1, GError** error);
     void (*get_snapshot)(AwnPanelDBusInterface* self, AwnImageStruct* result, GError** error);
+    gint(*get_snapshot_fd)(AwnPanelDBusInterface* self, gint x, gint y, gint width, gint height, gint* out_width, gint* out_height, gint* rowstride, GError** error);
     guint(*inhibit_autohide)(AwnPanelDBusInterface* self, const char* sender, const gchar* app_name, const gchar* reason, GError** error);
     void (*uninhibit_autohide)(AwnPanelDBusInterface* self, guint cookie, GError** error);
     void (*set_applet_flags)(AwnPanelDBusInterface* self, const gchar* uid, gint flags, GError** error);
     void (*set_glow)(AwnPanelDBusInterface* self, const char* sender, gboolean activate, GError** error);
+    gchar* (*get_trace)(AwnPanelDBusInterface* self, gboolean enable, GError** error);
     gdouble(*get_offset_modifier)(AwnPanelDBusInterface* self);
     gint(*get_max_size)(AwnPanelDBusInterface* self);
     gint(*get_offset)(AwnPanelDBusInterface* self);
@@ -96,10 +98,12 @@ void awn_panel_dbus_interface_delete_applet(AwnPanelDBusInterface* self, const g
 gint64 awn_panel_dbus_interface_docklet_request(AwnPanelDBusInterface* self, gint min_size, gboolean shrink, gboolean expand, GError** error);
 gchar** awn_panel_dbus_interface_get_inhibitors(AwnPanelDBusInterface* self, int* result_length1, GError** error);
 void awn_panel_dbus_interface_get_snapshot(AwnPanelDBusInterface* self, AwnImageStruct* result, GError** error);
+gint awn_panel_dbus_interface_get_snapshot_fd(AwnPanelDBusInterface* self, gint x, gint y, gint width, gint height, gint* out_width, gint* out_height, gint* rowstride, GError** error);
 guint awn_panel_dbus_interface_inhibit_autohide(AwnPanelDBusInterface* self, const char* sender, const gchar* app_name, const gchar* reason, GError** error);
 void awn_panel_dbus_interface_uninhibit_autohide(AwnPanelDBusInterface* self, guint cookie, GError** error);
 void awn_panel_dbus_interface_set_applet_flags(AwnPanelDBusInterface* self, const gchar* uid, gint flags, GError** error);
 void awn_panel_dbus_interface_set_glow(AwnPanelDBusInterface* self, const char* sender, gboolean activate, GError** error);
+gchar* awn_panel_dbus_interface_get_trace(AwnPanelDBusInterface* self, gboolean enable, GError** error);
 gdouble awn_panel_dbus_interface_get_offset_modifier(AwnPanelDBusInterface* self);
 gint awn_panel_dbus_interface_get_max_size(AwnPanelDBusInterface* self);
 gint awn_panel_dbus_interface_get_offset(AwnPanelDBusInterface* self);
@@ -23,11 +23,19 @@
 
 #include "config.h"
 
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
 #include <gdk/gdkx.h>
 #include <glib/gi18n.h>
 
 #include <X11/Xlib.h>
 #include <X11/extensions/shape.h>
+#include <X11/extensions/Xrender.h>
 
 #include <dbus/dbus-glib.h>
 #include <dbus/dbus-glib-bindings.h>
@@ -53,6 +61,8 @@
 #include "awn-throbber.h"
 #include "awn-x.h"
 
+#include "libawn/awn-shape.h"
+#include "libawn/awn-trace.h"
 #include "libawn/gseal-transition.h"
 #include "xutils.h"
 
@@ -114,6 +124,16 @@ struct _AwnPanelPrivate {
     guint strut_update_id;
     guint masks_update_id;
 
+    /* the strut as last published */
+    GtkPositionType strut_position;
+    gint strut_size;
+    gint strut_start;
+    gint strut_end;
+
+    /* persisted layout, see awn_panel_load_layout */
+    gboolean layout_restored;
+    guint layout_save_id;
+
     /* animated resizing */
     gint draw_width;
     gint draw_height;
@@ -158,6 +178,15 @@ struct _AwnPanelPrivate {
     GdkPixmap* tmp_pixmap;
     gfloat docklet_alpha;
     guint docklet_appear_timer_id;
+    gboolean crossfade_render;
+    GTimer* crossfade_timer;
+    gdouble crossfade_duration;
+    gdouble crossfade_interval;
+    guint crossfade_frames;
+    guint crossfade_ticks;
+    guint crossfade_step;       /* alpha step of the schedule last shown */
+    guint crossfade_late;
+    guint crossfade_skipped;
 };
 
 typedef struct _AwnInhibitItem {
@@ -169,6 +198,13 @@ typedef struct _AwnInhibitItem {
 
 #define CLICKTHROUGH_OPACITY 0.3
 
+/* seconds the settled layout is saved after the last change */
+#define LAYOUT_SAVE_DELAY 5
+#define LAYOUT_GROUP "layout"
+
+#define CROSSFADE_START_ALPHA 0.2
+#define CROSSFADE_STEPS 6
+
 #define ROUND(x) (x < 0 ? x - 0.5 : x + 0.5)
 
 //#define DEBUG_INPUT_SHAPE
@@ -354,6 +390,12 @@ static void     awn_panel_docklet_destroy(AwnPanel* panel);
 static void     awn_panel_queue_strut_update(AwnPanel* panel);
 
 static void     awn_panel_set_strut(AwnPanel* panel);
+static void     awn_panel_publish_strut(AwnPanel* panel,
+                                        GtkPositionType position,
+                                        gint strut, gint start, gint end);
+static void     awn_panel_load_layout(AwnPanel* panel);
+static void     awn_panel_queue_layout_save(AwnPanel* panel);
+static void     on_panel_realize(GtkWidget* widget, gpointer data);
 
 static void     awn_panel_remove_strut(AwnPanel* panel);
 
@@ -673,6 +715,11 @@ awn_panel_constructed(GObject* object)
                                         DESKTOP_AGNOSTIC_CONFIG_BIND_METHOD_FALLBACK,
                                         NULL);
 
+    /* Start with the layout we had last time (if it still applies) */
+    awn_panel_load_layout(AWN_PANEL(panel));
+    g_signal_connect_after(panel, "realize",
+                           G_CALLBACK(on_panel_realize), NULL);
+
     /* Size and position */
     g_signal_connect(panel, "configure-event",
                      G_CALLBACK(on_window_configure), NULL);
@@ -1026,6 +1073,7 @@ awn_panel_resize_timeout(gpointer data)
         priv->resize_timer_id = 0;
 
         awn_panel_queue_masks_update(panel);
+        awn_panel_queue_layout_save(panel);
     }
 
     return !resize_done;
@@ -1744,6 +1792,21 @@ awn_panel_dispose(GObject* object)
         priv->resize_timer_id = 0;
     }
 
+    if (priv->layout_save_id) {
+        g_source_remove(priv->layout_save_id);
+        priv->layout_save_id = 0;
+    }
+
+    if (priv->docklet_appear_timer_id) {
+        g_source_remove(priv->docklet_appear_timer_id);
+        priv->docklet_appear_timer_id = 0;
+    }
+
+    if (priv->crossfade_timer) {
+        g_timer_destroy(priv->crossfade_timer);
+        priv->crossfade_timer = NULL;
+    }
+
     if (priv->dbus_proxy) {
         g_object_unref(priv->dbus_proxy);
         priv->dbus_proxy = NULL;
@@ -2430,10 +2493,8 @@ on_composited_changed(GtkWidget* widget, gpointer data)
     priv->composited = gtk_widget_is_composited(widget);
     priv->animated_resize = priv->composited;
 
-    if (priv->composited) {
-        gtk_widget_shape_combine_mask(widget, NULL, 0, 0);
-    } else {
-        gtk_widget_input_shape_combine_mask(widget, NULL, 0, 0);
+    if (gtk_widget_get_window(widget)) {
+        awn_shape_apply(gtk_widget_get_window(widget), !priv->composited, NULL);
     }
     gdk_window_set_composited(win, priv->composited);
 
@@ -2459,12 +2520,19 @@ awn_panel_update_masks(GtkWidget* panel,
 {
     AwnPanelPrivate* priv;
     GtkAllocation   alloc;
-    GdkBitmap*       shaped_bitmap;
-    cairo_t*         cr;
+    GdkWindow*       win;
+    GdkRegion*       region;
+    gint64           trace_start;
 
     g_return_if_fail(AWN_IS_PANEL(panel));
     priv = AWN_PANEL(panel)->priv;
 
+    win = gtk_widget_get_window(panel);
+    if (!win) {
+        return;
+    }
+    trace_start = awn_trace_begin();
+
     gtk_widget_get_allocation(GTK_WIDGET(panel), &alloc);
 
     if (!real_width) {
@@ -2475,20 +2543,12 @@ awn_panel_update_masks(GtkWidget* panel,
     }
 
     if (priv->clickthrough && priv->composited) {
-        GdkRegion* region = gdk_region_new();
-        GdkWindow* win = gtk_widget_get_window(GTK_WIDGET(panel));
-        gdk_window_input_shape_combine_region(win, region, 0, 0);
-        gdk_region_destroy(region);
+        region = gdk_region_new();
     } else {
-        shaped_bitmap = (GdkBitmap*)gdk_pixmap_new(NULL,
-                        real_width, real_height, 1);
-
-        g_return_if_fail(shaped_bitmap);
-
-        /* clear the bitmap */
-        cr = gdk_cairo_create(shaped_bitmap);
-        cairo_set_operator(cr, CAIRO_OPERATOR_CLEAR);
-        cairo_paint(cr);
+        /* backgrounds can only paint their shape, do that client-side */
+        cairo_surface_t* mask = awn_shape_mask_new(real_width, real_height);
+        cairo_t* cr = cairo_create(mask);
+        GdkRegion* applets;
 
         cairo_set_operator(cr, CAIRO_OPERATOR_SOURCE);
 
@@ -2503,34 +2563,22 @@ awn_panel_update_masks(GtkWidget* panel,
         else {
             awn_background_get_shape_mask(priv->bg, cr, priv->position, &area);
         }
-
-        /* combine with applet's eventbox (with proper dimensions) */
-        cairo_set_operator(cr, CAIRO_OPERATOR_ADD);
-        cairo_set_source_rgb(cr, 1.0f, 1.0f, 1.0f);
-
-        GdkRegion* region = awn_panel_get_mask(AWN_PANEL(panel));
-        gdk_cairo_region(cr, region);
-        cairo_fill(cr);
-        gdk_region_destroy(region);
-#if 0
-        awn_panel_get_applet_rect(AWN_PANEL(panel), &applet_rect,
-                                  real_width, real_height);
-        cairo_identity_matrix(cr);
-        cairo_new_path(cr);
-        cairo_rectangle(cr, applet_rect.x, applet_rect.y,
-                        applet_rect.width, applet_rect.height);
-        cairo_fill(cr);
-#endif
         cairo_destroy(cr);
 
-        if (priv->composited) {
-            gtk_widget_input_shape_combine_mask(panel, shaped_bitmap, 0, 0);
-        } else {
-            gtk_widget_shape_combine_mask(panel, shaped_bitmap, 0, 0);
-        }
+        region = awn_shape_region_from_mask(mask);
+        cairo_surface_destroy(mask);
 
-        g_object_unref(shaped_bitmap);
+        /* combine with applet's eventbox (with proper dimensions) */
+        applets = awn_panel_get_mask(AWN_PANEL(panel));
+        gdk_region_union(region, applets);
+        gdk_region_destroy(applets);
     }
+
+    /* no-op if the shape didn't change */
+    awn_shape_apply(win, priv->composited, region);
+    gdk_region_destroy(region);
+
+    awn_trace_end(AWN_TRACE_MASK_UPDATE, trace_start);
 }
 
 static gboolean
@@ -2706,6 +2754,7 @@ awn_panel_expose(GtkWidget* widget, GdkEventExpose* event)
     cairo_t*         cr;
     GtkWidget*       child;
     GdkWindow*       win;
+    gint64           trace_start = awn_trace_begin();
 
     g_return_val_if_fail(AWN_IS_PANEL(widget), FALSE);
     priv = AWN_PANEL(widget)->priv;
@@ -2784,6 +2833,7 @@ awn_panel_expose(GtkWidget* widget, GdkEventExpose* event)
     /* Pass on the expose event to the child */
     child = gtk_bin_get_child(GTK_BIN(widget));
     if (!GTK_IS_WIDGET(child)) {
+        awn_trace_end(AWN_TRACE_EXPOSE, trace_start);
         return TRUE;
     }
 
@@ -2800,8 +2850,31 @@ awn_panel_expose(GtkWidget* widget, GdkEventExpose* event)
         region = gdk_region_rectangle(&box_alloc);
         gdk_region_intersect(region, event->region);
 
-        if (priv->docklet_alpha < 1.0) {
+        if (priv->docklet_alpha < 1.0 && priv->crossfade_render) {
+            /* Both layers are composited by the server with a constant alpha
+             * mask, neither the snapshot nor the applets get rewritten.
+             */
+            priv->crossfade_frames++;
+
+            cairo_save(cr);
+            gdk_cairo_rectangle(cr, &priv->snapshot_paint_size);
+            cairo_clip(cr);
+            cairo_set_operator(cr, CAIRO_OPERATOR_OVER);
+            gdk_cairo_set_source_pixmap(cr, priv->dock_snapshot, 0, 0);
+            cairo_paint_with_alpha(cr, 1.0 - priv->docklet_alpha);
+            cairo_restore(cr);
+
+            gdk_cairo_set_source_pixmap(cr, gtk_widget_get_window(child),
+                                        child->allocation.x, child->allocation.y);
+            gdk_cairo_region(cr, region);
+            cairo_clip(cr);
+            cairo_paint_with_alpha(cr, priv->docklet_alpha);
+
+            gdk_region_destroy(region);
+            region = NULL;
+        } else if (priv->docklet_alpha < 1.0) {
             // redirect painting to offscreen pixmap, so we can change its alpha
+            priv->crossfade_frames++;
             cr = gdk_cairo_create(priv->tmp_pixmap);
             gdk_cairo_region(cr, region);
             cairo_clip(cr);
@@ -2809,14 +2882,16 @@ awn_panel_expose(GtkWidget* widget, GdkEventExpose* event)
             cairo_paint(cr);
         }
 
-        gdk_cairo_set_source_pixmap(cr, gtk_widget_get_window(child),
-                                    child->allocation.x, child->allocation.y);
+        if (region) {
+            gdk_cairo_set_source_pixmap(cr, gtk_widget_get_window(child),
+                                        child->allocation.x, child->allocation.y);
 
-        gdk_cairo_region(cr, region);
-        cairo_clip(cr);
+            gdk_cairo_region(cr, region);
+            cairo_clip(cr);
 
-        cairo_set_operator(cr, CAIRO_OPERATOR_OVER);
-        cairo_paint(cr);
+            cairo_set_operator(cr, CAIRO_OPERATOR_OVER);
+            cairo_paint(cr);
+        }
 
         if (window_cr != cr) {
             /* We need to be careful with clipping here - when painting dock_snapshot
@@ -2846,7 +2921,9 @@ awn_panel_expose(GtkWidget* widget, GdkEventExpose* event)
             gdk_cairo_set_source_pixmap(cr, priv->tmp_pixmap, 0, 0);
             cairo_paint(cr);
         }
-        gdk_region_destroy(region);
+        if (region) {
+            gdk_region_destroy(region);
+        }
     }
 
 #ifdef DEBUG_INPUT_SHAPE
@@ -2911,6 +2988,8 @@ propagate:
                                    child,
                                    event);
 
+    awn_trace_end(AWN_TRACE_EXPOSE, trace_start);
+
     return TRUE;
 }
 
@@ -3521,17 +3600,169 @@ awn_panel_set_strut(AwnPanel* panel)
     awn_background_get_strut_offsets(priv->bg, priv->position, &area,
                                      &strut, &strut_start, &strut_end);
 
-    win = gtk_widget_get_window(GTK_WIDGET(panel));
-
-    xutils_set_strut(win, priv->position, strut, strut_start, strut_end);
+    awn_panel_publish_strut(panel, priv->position,
+                            strut, strut_start, strut_end);
+    awn_panel_queue_layout_save(panel);
 }
 
 static void
 awn_panel_remove_strut(AwnPanel* panel)
 {
-    GdkWindow* win;
-    win = gtk_widget_get_window(GTK_WIDGET(panel));
-    xutils_set_strut(win, 0, 0, 0, 0);
+    awn_panel_publish_strut(panel, (GtkPositionType)0, 0, 0, 0);
+}
+
+/*
+ * Only talks to the X server (and the window manager) if the strut changed.
+ */
+static void
+awn_panel_publish_strut(AwnPanel* panel, GtkPositionType position,
+                        gint strut, gint start, gint end)
+{
+    AwnPanelPrivate* priv = panel->priv;
+    GdkWindow* win = gtk_widget_get_window(GTK_WIDGET(panel));
+
+    if (!win) {
+        return;
+    }
+
+    if (priv->strut_position == position && priv->strut_size == strut &&
+            priv->strut_start == start && priv->strut_end == end) {
+        return;
+    }
+
+    priv->strut_position = position;
+    priv->strut_size = strut;
+    priv->strut_start = start;
+    priv->strut_end = end;
+
+    xutils_set_strut(win, position, strut, start, end);
+}
+
+/*
+ * LAYOUT SNAPSHOT
+ *
+ * The settled size of the background and the strut are saved, so on the next
+ * start the panel is drawn (and reserves its screen edge) at its final size
+ * right away, instead of growing while the applets embed. The sizes of the
+ * applets themselves are kept by AwnAppletManager.
+ */
+static gchar*
+awn_panel_get_layout_filename(AwnPanel* panel)
+{
+    gchar* basename = g_strdup_printf("panel-%d-layout", panel->priv->panel_id);
+    gchar* filename = g_build_filename(g_get_user_cache_dir(), "awn",
+                                       basename, NULL);
+    g_free(basename);
+
+    return filename;
+}
+
+static void
+awn_panel_load_layout(AwnPanel* panel)
+{
+    AwnPanelPrivate* priv = panel->priv;
+    GKeyFile* keyfile = g_key_file_new();
+    gchar* filename = awn_panel_get_layout_filename(panel);
+
+    if (g_key_file_load_from_file(keyfile, filename, G_KEY_FILE_NONE, NULL)) {
+#define LAYOUT_INT(key) g_key_file_get_integer(keyfile, LAYOUT_GROUP, key, NULL)
+        /* only if nothing that affects the layout changed in the meantime */
+        if (LAYOUT_INT("position") == (gint)priv->position &&
+                LAYOUT_INT("size") == priv->size &&
+                LAYOUT_INT("offset") == priv->offset &&
+                LAYOUT_INT("expand") == priv->expand &&
+                LAYOUT_INT("monitor_width") == priv->monitor->width &&
+                LAYOUT_INT("monitor_height") == priv->monitor->height &&
+                LAYOUT_INT("draw_width") > 0 && LAYOUT_INT("draw_height") > 0) {
+            priv->draw_width = LAYOUT_INT("draw_width");
+            priv->draw_height = LAYOUT_INT("draw_height");
+            /* published once the window is realized */
+            priv->strut_position = (GtkPositionType)LAYOUT_INT("strut_position");
+            priv->strut_size = LAYOUT_INT("strut");
+            priv->strut_start = LAYOUT_INT("strut_start");
+            priv->strut_end = LAYOUT_INT("strut_end");
+            priv->layout_restored = TRUE;
+        }
+#undef LAYOUT_INT
+    }
+
+    g_free(filename);
+    g_key_file_free(keyfile);
+}
+
+static gboolean
+awn_panel_save_layout(AwnPanel* panel)
+{
+    AwnPanelPrivate* priv = panel->priv;
+    GKeyFile* keyfile;
+    gchar* filename;
+    gchar* dirname;
+    gchar* data;
+    gsize length;
+
+    priv->layout_save_id = 0;
+
+    /* not settled yet, we'll be back when it is */
+    if (priv->resize_timer_id) {
+        return FALSE;
+    }
+
+    keyfile = g_key_file_new();
+    g_key_file_set_integer(keyfile, LAYOUT_GROUP, "position", priv->position);
+    g_key_file_set_integer(keyfile, LAYOUT_GROUP, "size", priv->size);
+    g_key_file_set_integer(keyfile, LAYOUT_GROUP, "offset", priv->offset);
+    g_key_file_set_integer(keyfile, LAYOUT_GROUP, "expand", priv->expand);
+    g_key_file_set_integer(keyfile, LAYOUT_GROUP, "monitor_width",
+                           priv->monitor->width);
+    g_key_file_set_integer(keyfile, LAYOUT_GROUP, "monitor_height",
+                           priv->monitor->height);
+    g_key_file_set_integer(keyfile, LAYOUT_GROUP, "draw_width", priv->draw_width);
+    g_key_file_set_integer(keyfile, LAYOUT_GROUP, "draw_height", priv->draw_height);
+    g_key_file_set_integer(keyfile, LAYOUT_GROUP, "strut_position",
+                           priv->strut_position);
+    g_key_file_set_integer(keyfile, LAYOUT_GROUP, "strut", priv->strut_size);
+    g_key_file_set_integer(keyfile, LAYOUT_GROUP, "strut_start", priv->strut_start);
+    g_key_file_set_integer(keyfile, LAYOUT_GROUP, "strut_end", priv->strut_end);
+
+    filename = awn_panel_get_layout_filename(panel);
+    dirname = g_path_get_dirname(filename);
+    data = g_key_file_to_data(keyfile, &length, NULL);
+    if (g_mkdir_with_parents(dirname, 0755) == 0) {
+        g_file_set_contents(filename, data, length, NULL);
+    }
+
+    g_free(data);
+    g_free(dirname);
+    g_free(filename);
+    g_key_file_free(keyfile);
+
+    return FALSE;
+}
+
+static void
+awn_panel_queue_layout_save(AwnPanel* panel)
+{
+    AwnPanelPrivate* priv = panel->priv;
+
+    if (priv->layout_save_id) {
+        g_source_remove(priv->layout_save_id);
+    }
+    priv->layout_save_id = g_timeout_add_seconds(LAYOUT_SAVE_DELAY,
+                           (GSourceFunc)awn_panel_save_layout, panel);
+}
+
+static void
+on_panel_realize(GtkWidget* widget, gpointer data)
+{
+    AwnPanelPrivate* priv = AWN_PANEL(widget)->priv;
+
+    if (priv->layout_restored && priv->panel_mode) {
+        /* reserve the edge we had last time before anything is mapped */
+        xutils_set_strut(gtk_widget_get_window(widget), priv->strut_position,
+                         priv->strut_size, priv->strut_start, priv->strut_end);
+    } else {
+        priv->strut_size = -1; /* nothing published yet */
+    }
 }
 
 /*
@@ -3821,7 +4052,25 @@ docklet_appear_cb(AwnPanel* panel)
     AwnPanelPrivate* priv = panel->priv;
 
     gfloat old_alpha = 1 - priv->docklet_alpha;
-    priv->docklet_alpha += 0.15;
+    gdouble elapsed = g_timer_elapsed(priv->crossfade_timer, NULL);
+    guint step = MIN((guint)(elapsed / priv->crossfade_interval),
+                     (guint)CROSSFADE_STEPS);
+
+    /* compare the tick with the schedule: it was due at ticks * interval */
+    priv->crossfade_ticks++;
+    if (elapsed - priv->crossfade_ticks * priv->crossfade_interval >
+            priv->crossfade_interval / 2) {
+        priv->crossfade_late++;
+    }
+    if (step > priv->crossfade_step + 1) {
+        priv->crossfade_skipped += step - priv->crossfade_step - 1;
+    }
+    priv->crossfade_step = MAX(step, priv->crossfade_step);
+
+    // follow the clock, a late tick skips ahead instead of slowing the fade
+    priv->docklet_alpha = CROSSFADE_START_ALPHA + (1.0 - CROSSFADE_START_ALPHA) *
+                          elapsed / priv->crossfade_duration;
+    priv->docklet_alpha = MIN(priv->docklet_alpha, 1.0);
 
     x = MIN(priv->snapshot_paint_size.x, priv->box->allocation.x);
     y = MIN(priv->snapshot_paint_size.y, priv->box->allocation.y);
@@ -3835,18 +4084,28 @@ docklet_appear_cb(AwnPanel* panel)
     gdk_window_invalidate_rect(window, &rect, FALSE);
 
     if (priv->docklet_alpha >= 1.0) {
+        g_debug("Docklet crossfade (%s): %u ticks for %u steps, %u late, "
+                "%u steps skipped, %u frames painted",
+                priv->crossfade_render ? "render" : "fallback",
+                priv->crossfade_ticks, CROSSFADE_STEPS, priv->crossfade_late,
+                priv->crossfade_skipped, priv->crossfade_frames);
+
         priv->docklet_appear_timer_id = 0;
         g_object_unref(priv->dock_snapshot);
-        g_object_unref(priv->tmp_pixmap);
         priv->dock_snapshot = NULL;
-        priv->tmp_pixmap = NULL;
+        if (priv->tmp_pixmap) {
+            g_object_unref(priv->tmp_pixmap);
+            priv->tmp_pixmap = NULL;
+        }
         return FALSE;
     }
 
-    // let's change alpha of the pixmap here, no need to wait for expose
-    multiply_pixmap_alpha(priv->dock_snapshot,
-                          (GdkRectangle*)&priv->snapshot_paint_size,
-                          (1 - priv->docklet_alpha) / old_alpha);
+    if (!priv->crossfade_render) {
+        // let's change alpha of the pixmap here, no need to wait for expose
+        multiply_pixmap_alpha(priv->dock_snapshot,
+                              (GdkRectangle*)&priv->snapshot_paint_size,
+                              (1 - priv->docklet_alpha) / old_alpha);
+    }
 
     return TRUE;
 }
@@ -3867,6 +4126,15 @@ get_window_snapshot(GdkDrawable* drawable, gint width, gint height)
     return pixmap;
 }
 
+static gboolean
+awn_panel_has_render(AwnPanel* panel)
+{
+    Display* dpy = GDK_DISPLAY_XDISPLAY(gtk_widget_get_display(GTK_WIDGET(panel)));
+    gint event_base, error_base;
+
+    return XRenderQueryExtension(dpy, &event_base, &error_base);
+}
+
 static void
 awn_panel_prepare_crossfade(AwnPanel* panel, gint time_step)
 {
@@ -3879,20 +4147,42 @@ awn_panel_prepare_crossfade(AwnPanel* panel, gint time_step)
 
         if (priv->dock_snapshot) {
             g_object_unref(priv->dock_snapshot);
+            priv->dock_snapshot = NULL;
+        }
+        if (priv->tmp_pixmap) {
             g_object_unref(priv->tmp_pixmap);
+            priv->tmp_pixmap = NULL;
         }
 
         width = priv->eventbox->allocation.width;
         height = priv->eventbox->allocation.height;
 
+        /* With RENDER the snapshot is uploaded once and blended at paint
+         * time, otherwise its alpha is rewritten on every tick.
+         */
+        priv->crossfade_render = awn_panel_has_render(panel);
         priv->dock_snapshot = get_window_snapshot(drawable, width, height);
         priv->snapshot_paint_size = priv->box->allocation;
-        priv->docklet_alpha = 0.2;
-        multiply_pixmap_alpha(priv->dock_snapshot,
-                              (GdkRectangle*)&priv->snapshot_paint_size,
-                              1 - priv->docklet_alpha);
+        priv->docklet_alpha = CROSSFADE_START_ALPHA;
+        if (!priv->crossfade_render) {
+            multiply_pixmap_alpha(priv->dock_snapshot,
+                                  (GdkRectangle*)&priv->snapshot_paint_size,
+                                  1 - priv->docklet_alpha);
 
-        priv->tmp_pixmap = gdk_pixmap_new(drawable, width, height, -1);
+            priv->tmp_pixmap = gdk_pixmap_new(drawable, width, height, -1);
+        }
+
+        priv->crossfade_interval = time_step / 1000.0;
+        priv->crossfade_duration = priv->crossfade_interval * CROSSFADE_STEPS;
+        priv->crossfade_frames = 0;
+        priv->crossfade_ticks = 0;
+        priv->crossfade_step = 0;
+        priv->crossfade_late = 0;
+        priv->crossfade_skipped = 0;
+        if (!priv->crossfade_timer) {
+            priv->crossfade_timer = g_timer_new();
+        }
+        g_timer_start(priv->crossfade_timer);
 
         gtk_widget_queue_draw_area(GTK_WIDGET(panel),
                                    priv->snapshot_paint_size.x,
@@ -4062,6 +4352,83 @@ awn_panel_docklet_request(AwnPanel* panel,
     return window_id;
 }
 
+/*
+ * The part of the window which has something painted on it. The draw rect
+ * covers just the background, applets on a curved (or otherwise raised)
+ * path stick out of it, so add the applet mask as well.
+ */
+static void
+awn_panel_get_snapshot_rect(AwnPanel* panel, GdkRectangle* rect)
+{
+    GtkAllocation alloc;
+    GdkRectangle window_rect;
+
+    awn_panel_get_draw_rect(panel, rect, 0, 0);
+
+    if (panel->priv->composited) {
+        GdkRegion* region = awn_panel_get_mask(panel);
+        GdkRectangle applets;
+
+        gdk_region_get_clipbox(region, &applets);
+        gdk_region_destroy(region);
+        if (applets.width > 0 && applets.height > 0) {
+            gdk_rectangle_union(rect, &applets, rect);
+        }
+    }
+
+    gtk_widget_get_allocation(GTK_WIDGET(panel), &alloc);
+    window_rect.x = 0;
+    window_rect.y = 0;
+    window_rect.width = alloc.width;
+    window_rect.height = alloc.height;
+    if (!gdk_rectangle_intersect(rect, &window_rect, rect)) {
+        rect->width = rect->height = 0;
+    }
+}
+
+/*
+ * Limits the snapshot rect to the requested region (relative to the rect),
+ * zero or negative width/height mean "up to the end".
+ */
+static void
+awn_panel_clip_snapshot_rect(GdkRectangle* rect,
+                             gint x, gint y, gint width, gint height)
+{
+    GdkRectangle region;
+
+    region.x = rect->x + MAX(x, 0);
+    region.y = rect->y + MAX(y, 0);
+    region.width = width > 0 ? width : rect->width;
+    region.height = height > 0 ? height : rect->height;
+
+    if (!gdk_rectangle_intersect(rect, &region, rect)) {
+        rect->width = rect->height = 0;
+    }
+}
+
+/* paints the window contents at @rect into @data (ARGB32, @stride) */
+static void
+awn_panel_paint_snapshot(AwnPanel* panel, GdkRectangle* rect,
+                         guchar* data, gint stride)
+{
+    GdkWindow* window = gtk_widget_get_window(GTK_WIDGET(panel));
+    cairo_surface_t* surface;
+    cairo_t* cr;
+
+    surface = cairo_image_surface_create_for_data(data, CAIRO_FORMAT_ARGB32,
+              rect->width,
+              rect->height,
+              stride);
+    cr = cairo_create(surface);
+    cairo_set_operator(cr, CAIRO_OPERATOR_SOURCE);
+    gdk_cairo_set_source_pixmap(cr, window, -rect->x, -rect->y);
+    cairo_paint(cr);
+
+    cairo_destroy(cr);
+    cairo_surface_flush(surface);
+    cairo_surface_destroy(surface);
+}
+
 gboolean
 awn_panel_get_snapshot(AwnPanel* panel,
                        gint*     width,
@@ -4075,46 +4442,127 @@ awn_panel_get_snapshot(AwnPanel* panel,
                        GError** error)
 {
     GdkRectangle rect;
+    gint         stride;
     guint        data_len;
     g_return_val_if_fail(AWN_IS_PANEL(panel), FALSE);
 
-    awn_panel_get_draw_rect(panel, &rect, 0, 0);
-
-    // get snapshot from root window, cause we'll loose alpha anyway
-    GdkWindow* window = gtk_widget_get_window(GTK_WIDGET(panel));
+    awn_panel_get_snapshot_rect(panel, &rect);
 
-    // FIXME: incorrect width/height for curved dock
-    cairo_surface_t* surface = cairo_image_surface_create(CAIRO_FORMAT_ARGB32,
-                               rect.width,
-                               rect.height);
-    cairo_t* cr = cairo_create(surface);
-    cairo_set_operator(cr, CAIRO_OPERATOR_CLEAR);
-    cairo_paint(cr);
+    stride = cairo_format_stride_for_width(CAIRO_FORMAT_ARGB32, rect.width);
+    data_len = rect.height * stride;
 
-    cairo_set_operator(cr, CAIRO_OPERATOR_OVER);
-    gdk_cairo_set_source_pixmap(cr, window, -rect.x, -rect.y);
-    cairo_paint(cr);
-
-    cairo_destroy(cr);
-    cairo_surface_flush(surface);
+    // paint straight into the buffer we hand out
+    *pixels = (gchar*)g_malloc0(MAX(data_len, 1));
+    if (data_len) {
+        awn_panel_paint_snapshot(panel, &rect, (guchar*)*pixels, stride);
+    }
 
     // stuff the pixbuf to our out param
     *width = rect.width;
     *height = rect.height;
-    *rowstride = cairo_image_surface_get_stride(surface);
+    *rowstride = stride;
     *has_alpha = TRUE;
     *bits_per_sample = 8;
     *num_channels = 4;
+    *pixels_length = data_len;
 
-    data_len = rect.height * cairo_image_surface_get_stride(surface);
-    //gint image_len = (height - 1) * rowstride + width *
-    //  ((n_channels * bits_per_sample + 7) / 8);
+    return TRUE;
+}
 
-    guchar* image = cairo_image_surface_get_data(surface);
-    *pixels = g_memdup(image, data_len);
-    *pixels_length = data_len;
+static gint
+awn_panel_create_snapshot_fd(gsize size, GError** error)
+{
+    gint fd = -1;
 
-    cairo_surface_destroy(surface);
+#ifdef SYS_memfd_create
+    fd = syscall(SYS_memfd_create, "awn-snapshot", 1 /* MFD_CLOEXEC */);
+#endif
+    if (fd < 0) {
+        // no memfd, use an unlinked shm segment instead
+        gchar* name = g_strdup_printf("/awn-snapshot-%d-%u", getpid(),
+                                      g_random_int());
+        fd = shm_open(name, O_RDWR | O_CREAT | O_EXCL, 0600);
+        if (fd >= 0) {
+            shm_unlink(name);
+        }
+        g_free(name);
+    }
+
+    if (fd < 0 || ftruncate(fd, size) != 0) {
+        g_set_error(error, DBUS_GERROR, DBUS_GERROR_FAILED,
+                    "Unable to create snapshot buffer: %s", g_strerror(errno));
+        if (fd >= 0) {
+            close(fd);
+        }
+        return -1;
+    }
+
+    return fd;
+}
+
+/**
+ * awn_panel_get_snapshot_fd:
+ * @panel: an #AwnPanel.
+ * @x: left edge of the requested region (relative to the snapshot area).
+ * @y: top edge of the requested region.
+ * @width: width of the region, 0 for the full width.
+ * @height: height of the region, 0 for the full height.
+ * @fd: return location for a file descriptor with the pixels.
+ * @out_width: actual width of the snapshot.
+ * @out_height: actual height of the snapshot.
+ * @rowstride: rowstride of the pixel data.
+ *
+ * Like awn_panel_get_snapshot(), but the window is painted straight into
+ * an anonymous shared memory file (ARGB32, premultiplied) which the caller
+ * can mmap, so the pixels are never copied. The caller owns @fd.
+ *
+ * Returns: TRUE on success.
+ */
+gboolean
+awn_panel_get_snapshot_fd(AwnPanel* panel,
+                          gint      x,
+                          gint      y,
+                          gint      width,
+                          gint      height,
+                          gint*     fd,
+                          gint*     out_width,
+                          gint*     out_height,
+                          gint*     rowstride,
+                          GError**  error)
+{
+    GdkRectangle rect;
+    gint         stride;
+    gsize        size;
+    gpointer     data;
+    g_return_val_if_fail(AWN_IS_PANEL(panel), FALSE);
+
+    awn_panel_get_snapshot_rect(panel, &rect);
+    awn_panel_clip_snapshot_rect(&rect, x, y, width, height);
+
+    stride = cairo_format_stride_for_width(CAIRO_FORMAT_ARGB32, rect.width);
+    size = rect.height * stride;
+
+    *fd = awn_panel_create_snapshot_fd(MAX(size, 1), error);
+    if (*fd < 0) {
+        return FALSE;
+    }
+
+    if (size) {
+        data = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, *fd, 0);
+        if (data == MAP_FAILED) {
+            g_set_error(error, DBUS_GERROR, DBUS_GERROR_FAILED,
+                        "Unable to map snapshot buffer: %s", g_strerror(errno));
+            close(*fd);
+            *fd = -1;
+            return FALSE;
+        }
+        awn_panel_paint_snapshot(panel, &rect, (guchar*)data, stride);
+        munmap(data, size);
+    }
+
+    *out_width = rect.width;
+    *out_height = rect.height;
+    *rowstride = stride;
 
     return TRUE;
 }
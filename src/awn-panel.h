@@ -131,6 +131,17 @@ gboolean    awn_panel_get_snapshot(AwnPanel* panel,
                                    gint*     pixels_length,
                                    GError** error);
 
+gboolean    awn_panel_get_snapshot_fd(AwnPanel* panel,
+                                      gint      x,
+                                      gint      y,
+                                      gint      width,
+                                      gint      height,
+                                      gint*     fd,
+                                      gint*     out_width,
+                                      gint*     out_height,
+                                      gint*     rowstride,
+                                      GError**  error);
+
 gboolean    awn_panel_get_all_server_flags(AwnPanel* panel,
         GHashTable** hash,
         gchar*     name,
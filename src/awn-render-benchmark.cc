@@ -0,0 +1,889 @@
+/*
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301  USA.
+ *
+ */
+
+/*
+ * Renders a fixed number of frames of every effect of every effect bundle,
+ * of every background style and of every overlay type through the real
+ * expose paths, and prints the time, the number of allocations and the
+ * number of cairo surfaces created per frame, one case per line:
+ *   <case> <tab> <frames> <tab> <ms/frame> <tab> <allocs/frame> <tab> <surfaces/frame>
+ *
+ * The animation timeouts run on a fake clock which advances exactly one
+ * frame (40ms) per rendered frame, so every run draws the same frames no
+ * matter how slow the machine is. Save the output of one run and pass it
+ * to --compare to print the differences, the exit status is non-zero if a
+ * case got slower (or allocates more) than --threshold percent. A baseline
+ * recorded with a different --frames or --size is refused, a single case
+ * with a different frame count is not compared.
+ * Every background style is run twice: "background/<style>" invalidates it
+ * each frame and so redraws the whole style, "background/<style>/cached"
+ * only blits the surface the style keeps between frames.
+ * The panel the backgrounds need uses a scratch panel id and a private
+ * config and cache directory, so nothing the user has saved gets touched.
+ * Run it against Xvfb, eg.
+ *   xvfb-run -s "-screen 0 1024x768x24" ./awn-render-benchmark > baseline
+ *   xvfb-run -s "-screen 0 1024x768x24" ./awn-render-benchmark --compare=baseline
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <dlfcn.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <cairo-xlib.h>
+#include <glib/gstdio.h>
+#include <gtk/gtk.h>
+#include <libawn/libawn.h>
+#include <libdesktop-agnostic/vfs.h>
+
+#include "awn-background.h"
+#include "awn-background-3d.h"
+#include "awn-background-curves.h"
+#include "awn-background-edgy.h"
+#include "awn-background-flat.h"
+#include "awn-background-floaty.h"
+#include "awn-background-lucido.h"
+#include "awn-background-null.h"
+#include "awn-panel.h"
+#include "libawn/awn-effects-ops-new.h"
+
+#define FRAME_INTERVAL 40 /* ms, AwnEffects runs at 25 fps */
+#define DEFAULT_FRAMES 250
+#define DEFAULT_SIZE 48
+#define DEFAULT_THRESHOLD 10.0
+#define BENCH_PANEL_ID 99 /* never saved over the user's panels */
+
+/* same names as tests/test-awn-effects.cc */
+static const gchar* effect_names[] = {
+    "AWN_EFFECT_NONE",
+    "AWN_EFFECT_OPENING",
+    "AWN_EFFECT_CLOSING",
+    "AWN_EFFECT_HOVER",
+    "AWN_EFFECT_LAUNCHING",
+    "AWN_EFFECT_ATTENTION",
+    "AWN_EFFECT_DESATURATE"
+};
+
+/* in the order AwnEffects registers them */
+static const gchar* bundle_names[] = {
+    "simple", "classic", "fade", "spotlight", "zoom",
+    "squish", "turn3d", "spotlight3d", "glow"
+};
+
+typedef struct {
+    const gchar* name;
+    GType (*get_type)(void);
+} BenchStyle;
+
+static const BenchStyle styles[] = {
+    { "flat",   awn_background_flat_get_type },
+    { "3d",     awn_background_3d_get_type },
+    { "curves", awn_background_curves_get_type },
+    { "edgy",   awn_background_edgy_get_type },
+    { "floaty", awn_background_floaty_get_type },
+    { "lucido", awn_background_lucido_get_type },
+    { "null",   awn_background_null_get_type }
+};
+
+typedef enum {
+    OVERLAY_TEXT,
+    OVERLAY_PROGRESS_CIRCLE,
+    OVERLAY_THROBBER,
+    OVERLAY_PIXBUF,
+    OVERLAY_PIXBUF_FILE,
+    OVERLAY_THEMED_ICON
+} BenchOverlay;
+
+static const gchar* overlay_names[] = {
+    "text", "progress-circle", "throbber", "pixbuf", "pixbuf-file",
+    "themed-icon"
+};
+
+typedef struct {
+    gint    frames;
+    gdouble ms;
+    gdouble allocs;
+    gdouble surfaces;
+} BenchResult;
+
+static gint frames = DEFAULT_FRAMES;
+static gint icon_size = DEFAULT_SIZE;
+static gchar* filter = NULL;
+static gchar* compare_file = NULL;
+static gdouble threshold = DEFAULT_THRESHOLD;
+
+static GOptionEntry entries[] = {
+    {
+        "frames", 'n',
+        0, G_OPTION_ARG_INT,
+        &frames,
+        "Number of frames rendered per case", "N"
+    },
+    {
+        "size", 's',
+        0, G_OPTION_ARG_INT,
+        &icon_size,
+        "Icon size", "PIXELS"
+    },
+    {
+        "filter", 'f',
+        0, G_OPTION_ARG_STRING,
+        &filter,
+        "Only run the cases containing this string", "STRING"
+    },
+    {
+        "compare", 'c',
+        0, G_OPTION_ARG_FILENAME,
+        &compare_file,
+        "Compare against the output of an earlier run", "FILE"
+    },
+    {
+        "threshold", 't',
+        0, G_OPTION_ARG_DOUBLE,
+        &threshold,
+        "Allowed slowdown in percent when comparing", "PERCENT"
+    },
+    { NULL }
+};
+
+/*
+ * Counters. Allocations are counted by wrapping glibc's malloc, surfaces
+ * by wrapping the cairo constructors used outside of cairo itself.
+ */
+static gboolean counting = FALSE;
+static gulong n_allocs = 0;
+static gulong n_surfaces = 0;
+
+#ifdef __GLIBC__
+#define HAVE_ALLOC_COUNTER 1
+
+extern "C" {
+extern void* __libc_malloc(size_t size);
+extern void* __libc_calloc(size_t nmemb, size_t size);
+extern void* __libc_realloc(void* ptr, size_t size);
+
+void*
+malloc(size_t size)
+{
+    if (counting) {
+        n_allocs++;
+    }
+    return __libc_malloc(size);
+}
+
+void*
+calloc(size_t nmemb, size_t size)
+{
+    if (counting) {
+        n_allocs++;
+    }
+    return __libc_calloc(nmemb, size);
+}
+
+void*
+realloc(void* ptr, size_t size)
+{
+    if (counting && !ptr) {
+        n_allocs++;
+    }
+    return __libc_realloc(ptr, size);
+}
+}
+#endif
+
+#define REAL(name, type) \
+    static type real = NULL; \
+    if (!real) { \
+        real = (type) dlsym(RTLD_NEXT, name); \
+    } \
+    if (counting) { \
+        n_surfaces++; \
+    }
+
+extern "C" {
+cairo_surface_t*
+cairo_image_surface_create(cairo_format_t format, int width, int height)
+{
+    typedef cairo_surface_t* (*Func)(cairo_format_t, int, int);
+    REAL("cairo_image_surface_create", Func);
+    return real(format, width, height);
+}
+
+cairo_surface_t*
+cairo_image_surface_create_for_data(unsigned char* data, cairo_format_t format,
+                                    int width, int height, int stride)
+{
+    typedef cairo_surface_t* (*Func)(unsigned char*, cairo_format_t,
+                                     int, int, int);
+    REAL("cairo_image_surface_create_for_data", Func);
+    return real(data, format, width, height, stride);
+}
+
+cairo_surface_t*
+cairo_surface_create_similar(cairo_surface_t* other, cairo_content_t content,
+                             int width, int height)
+{
+    typedef cairo_surface_t* (*Func)(cairo_surface_t*, cairo_content_t,
+                                     int, int);
+    REAL("cairo_surface_create_similar", Func);
+    return real(other, content, width, height);
+}
+
+cairo_surface_t*
+cairo_xlib_surface_create(Display* dpy, Drawable drawable, Visual* visual,
+                          int width, int height)
+{
+    typedef cairo_surface_t* (*Func)(Display*, Drawable, Visual*, int, int);
+    REAL("cairo_xlib_surface_create", Func);
+    return real(dpy, drawable, visual, width, height);
+}
+}
+
+/*
+ * Fake clock. g_timeout_add() is replaced by a source which only becomes
+ * ready once the fake time passed its expiry, the time only moves in
+ * render_frame().
+ */
+typedef struct {
+    GSource source;
+    guint   interval;
+    guint64 expiry;
+} FakeTimeout;
+
+static guint64 fake_now = 0;
+
+static gboolean
+fake_timeout_prepare(GSource* source, gint* timeout)
+{
+    *timeout = -1;
+    return fake_now >= ((FakeTimeout*) source)->expiry;
+}
+
+static gboolean
+fake_timeout_check(GSource* source)
+{
+    return fake_now >= ((FakeTimeout*) source)->expiry;
+}
+
+static gboolean
+fake_timeout_dispatch(GSource* source, GSourceFunc callback, gpointer data)
+{
+    FakeTimeout* timeout = (FakeTimeout*) source;
+
+    if (!callback || !callback(data)) {
+        return FALSE;
+    }
+    timeout->expiry = fake_now + MAX(timeout->interval, 1);
+    return TRUE;
+}
+
+static GSourceFuncs fake_timeout_funcs = {
+    fake_timeout_prepare,
+    fake_timeout_check,
+    fake_timeout_dispatch,
+    NULL
+};
+
+extern "C" {
+guint
+g_timeout_add_full(gint priority, guint interval, GSourceFunc function,
+                   gpointer data, GDestroyNotify notify)
+{
+    GSource* source = g_source_new(&fake_timeout_funcs, sizeof(FakeTimeout));
+    guint id;
+
+    ((FakeTimeout*) source)->interval = interval;
+    ((FakeTimeout*) source)->expiry = fake_now + interval;
+    g_source_set_priority(source, priority);
+    g_source_set_callback(source, function, data, notify);
+    id = g_source_attach(source, NULL);
+    g_source_unref(source);
+
+    return id;
+}
+
+guint
+g_timeout_add(guint interval, GSourceFunc function, gpointer data)
+{
+    return g_timeout_add_full(G_PRIORITY_DEFAULT, interval, function, data,
+                              NULL);
+}
+}
+
+/* advances the fake clock by one frame and draws whatever got invalidated */
+static void
+render_frame(GtkWidget* window)
+{
+    fake_now += FRAME_INTERVAL;
+    /* bounded, a source may want to run again on every iteration */
+    for (gint i = 0; i < 100 && g_main_context_pending(NULL); i++) {
+        g_main_context_iteration(NULL, FALSE);
+    }
+    gdk_window_process_all_updates();
+    gdk_display_sync(gtk_widget_get_display(window));
+}
+
+typedef void (*BenchFrameFunc)(gint frame, gpointer data);
+
+static BenchResult
+run_frames(GtkWidget* window, BenchFrameFunc func, gpointer data)
+{
+    BenchResult result;
+    GTimer* timer;
+
+    /* get the first-time work (theme lookups, caches) out of the way */
+    for (gint i = 0; i < MAX(frames / 10, 1); i++) {
+        func(i, data);
+        render_frame(window);
+    }
+
+    n_allocs = 0;
+    n_surfaces = 0;
+    counting = TRUE;
+    timer = g_timer_new();
+    for (gint i = 0; i < frames; i++) {
+        func(i, data);
+        render_frame(window);
+    }
+    counting = FALSE;
+
+    result.frames = frames;
+    result.ms = g_timer_elapsed(timer, NULL) * 1000.0 / frames;
+#ifdef HAVE_ALLOC_COUNTER
+    result.allocs = (gdouble) n_allocs / frames;
+#else
+    result.allocs = -1.0;
+#endif
+    result.surfaces = (gdouble) n_surfaces / frames;
+    g_timer_destroy(timer);
+
+    return result;
+}
+
+static GtkWidget*
+bench_window_new(gint width, gint height)
+{
+    GtkWidget* window = gtk_window_new(GTK_WINDOW_TOPLEVEL);
+
+    gtk_window_set_default_size(GTK_WINDOW(window), width, height);
+    gtk_widget_set_app_paintable(window, TRUE);
+
+    return window;
+}
+
+static void
+bench_window_show(GtkWidget* window)
+{
+    gtk_widget_show_all(window);
+    while (gtk_events_pending()) {
+        gtk_main_iteration();
+    }
+}
+
+static GdkPixbuf*
+bench_pixbuf_new(void)
+{
+    GdkPixbuf* pixbuf = gdk_pixbuf_new(GDK_COLORSPACE_RGB, TRUE, 8,
+                                       icon_size, icon_size);
+    gdk_pixbuf_fill(pixbuf, 0x3465a4ff);
+
+    return pixbuf;
+}
+
+static GtkWidget*
+bench_icon_new(void)
+{
+    GtkWidget* icon = awn_icon_new();
+    GdkPixbuf* pixbuf = bench_pixbuf_new();
+
+    awn_icon_set_from_pixbuf(AWN_ICON(icon), pixbuf);
+    g_object_unref(pixbuf);
+
+    return icon;
+}
+
+/* case name -> BenchResult, read from a saved run */
+static GHashTable* baseline = NULL;
+static gint baseline_frames = -1;
+static gint baseline_size = -1;
+static gboolean regressed = FALSE;
+
+static gboolean
+load_baseline(const gchar* filename)
+{
+    gchar* contents;
+    gchar** lines;
+    GError* error = NULL;
+
+    if (!g_file_get_contents(filename, &contents, NULL, &error)) {
+        g_printerr("%s\n", error->message);
+        g_error_free(error);
+        return FALSE;
+    }
+
+    baseline = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, g_free);
+    lines = g_strsplit(contents, "\n", -1);
+    for (gchar** line = lines; *line; line++) {
+        gchar** fields;
+
+        if (**line == '#') {
+            sscanf(*line, "# frames=%d size=%d", &baseline_frames, &baseline_size);
+            continue;
+        }
+        if (**line == '\0') {
+            continue;
+        }
+        fields = g_strsplit(*line, "\t", -1);
+        if (g_strv_length(fields) >= 5) {
+            BenchResult* result = g_new(BenchResult, 1);
+            result->frames = atoi(fields[1]);
+            result->ms = g_ascii_strtod(fields[2], NULL);
+            result->allocs = g_ascii_strtod(fields[3], NULL);
+            result->surfaces = g_ascii_strtod(fields[4], NULL);
+            g_hash_table_insert(baseline, g_strdup(fields[0]), result);
+        }
+        g_strfreev(fields);
+    }
+    g_strfreev(lines);
+    g_free(contents);
+
+    /* the times and counts per frame depend on both */
+    if (baseline_frames != frames || baseline_size != icon_size) {
+        g_printerr("%s was recorded with --frames=%d --size=%d, "
+                   "this run uses --frames=%d --size=%d\n",
+                   filename, baseline_frames, baseline_size, frames, icon_size);
+        return FALSE;
+    }
+
+    return TRUE;
+}
+
+static gdouble
+change(gdouble before, gdouble after)
+{
+    return before > 0.0 ? (after - before) * 100.0 / before : 0.0;
+}
+
+static void
+report(const gchar* name, BenchResult* result)
+{
+    BenchResult* base;
+
+    g_print("%s\t%d\t%.4f\t%.1f\t%.2f\n", name, result->frames,
+            result->ms, result->allocs, result->surfaces);
+
+    if (!baseline) {
+        return;
+    }
+    base = (BenchResult*) g_hash_table_lookup(baseline, name);
+    if (!base) {
+        g_printerr("%-32s new\n", name);
+        return;
+    }
+    if (base->frames != result->frames) {
+        g_printerr("%-32s %d frames in the baseline, not compared\n",
+                   name, base->frames);
+        return;
+    }
+
+    gboolean slower = change(base->ms, result->ms) > threshold ||
+                      change(base->allocs, result->allocs) > threshold ||
+                      result->surfaces > base->surfaces;
+    g_printerr("%-32s %+7.1f%% time %+7.1f%% allocs %+6.2f surfaces%s\n",
+               name, change(base->ms, result->ms),
+               change(base->allocs, result->allocs),
+               result->surfaces - base->surfaces,
+               slower ? "  REGRESSION" : "");
+    regressed |= slower;
+}
+
+static gboolean
+selected(const gchar* name)
+{
+    return !filter || strstr(name, filter) != NULL;
+}
+
+/* effects */
+
+typedef struct {
+    AwnEffects* fx;
+    AwnEffect   effect;
+    gboolean    ended;
+} EffectCase;
+
+static void
+_effect_ended(AwnEffects* fx, AwnEffect effect, EffectCase* ec)
+{
+    ec->ended = TRUE;
+}
+
+static void
+effect_frame(gint frame, gpointer data)
+{
+    EffectCase* ec = (EffectCase*) data;
+
+    /* opening, closing & co. end by themselves, keep them running */
+    if (frame == 0 || ec->ended) {
+        ec->ended = FALSE;
+        awn_effects_start_ex(ec->fx, ec->effect, 0, FALSE, TRUE);
+    }
+}
+
+static void
+bench_effect(AwnEffect effect, guint bundle)
+{
+    gchar* name;
+    GtkWidget* window, *icon;
+    EffectCase ec;
+    BenchResult result;
+
+    if (effect == AWN_EFFECT_DESATURATE) {
+        name = g_strdup_printf("effect/%s", effect_names[effect]);
+    } else {
+        name = g_strdup_printf("effect/%s/%s", effect_names[effect],
+                               bundle_names[bundle]);
+    }
+    if (!selected(name)) {
+        g_free(name);
+        return;
+    }
+
+    window = bench_window_new(icon_size * 2, icon_size * 3);
+    icon = bench_icon_new();
+    gtk_container_add(GTK_CONTAINER(window), icon);
+    bench_window_show(window);
+
+    ec.fx = awn_overlayable_get_effects(AWN_OVERLAYABLE(icon));
+    ec.effect = effect;
+    ec.ended = FALSE;
+    if (effect != AWN_EFFECT_DESATURATE) {
+        g_object_set(ec.fx, "effects", bundle << ((effect - 1) * 4), NULL);
+    }
+    g_signal_connect(ec.fx, "animation-end", G_CALLBACK(_effect_ended), &ec);
+
+    result = run_frames(window, effect_frame, &ec);
+    report(name, &result);
+
+    g_signal_handlers_disconnect_by_func(ec.fx, (gpointer) _effect_ended, &ec);
+    awn_effects_stop(ec.fx, effect);
+    gtk_widget_destroy(window);
+    g_free(name);
+}
+
+/* backgrounds */
+
+typedef struct {
+    AwnBackground* bg;
+    GtkWidget*     window;
+    gboolean       cached;
+} BackgroundCase;
+
+static gboolean
+_background_expose(GtkWidget* widget, GdkEventExpose* event,
+                   BackgroundCase* bc)
+{
+    GdkRectangle area = { 0, 0, widget->allocation.width,
+                          widget->allocation.height };
+    cairo_t* cr = gdk_cairo_create(widget->window);
+
+    cairo_set_operator(cr, CAIRO_OPERATOR_CLEAR);
+    cairo_paint(cr);
+    cairo_set_operator(cr, CAIRO_OPERATOR_OVER);
+    awn_background_draw(bc->bg, cr, GTK_POS_BOTTOM, &area);
+    cairo_destroy(cr);
+
+    return TRUE;
+}
+
+static void
+background_frame(gint frame, gpointer data)
+{
+    BackgroundCase* bc = (BackgroundCase*) data;
+
+    /* the whole style, unless only the blit of its helper surface is
+     * measured */
+    if (!bc->cached) {
+        awn_background_invalidate(bc->bg);
+    }
+    gtk_widget_queue_draw(bc->window);
+}
+
+static void
+bench_background(const BenchStyle* style, DesktopAgnosticConfigClient* client,
+                 GtkWidget* panel, gboolean cached)
+{
+    gchar* name = g_strdup_printf("background/%s%s", style->name,
+                                  cached ? "/cached" : "");
+    BackgroundCase bc;
+    BenchResult result;
+
+    if (!selected(name)) {
+        g_free(name);
+        return;
+    }
+
+    bc.bg = AWN_BACKGROUND(g_object_new(style->get_type(),
+                                        "client", client,
+                                        "panel", panel,
+                                        NULL));
+    bc.cached = cached;
+    bc.window = bench_window_new(icon_size * 16, icon_size * 2);
+    g_signal_connect(bc.window, "expose-event",
+                     G_CALLBACK(_background_expose), &bc);
+    bench_window_show(bc.window);
+
+    result = run_frames(bc.window, background_frame, &bc);
+    report(name, &result);
+
+    gtk_widget_destroy(bc.window);
+    g_object_unref(bc.bg);
+    g_free(name);
+}
+
+/* overlays */
+
+typedef struct {
+    BenchOverlay type;
+    GtkWidget*   icon;
+    AwnOverlay*  overlay;
+} OverlayCase;
+
+static void
+overlay_frame(gint frame, gpointer data)
+{
+    OverlayCase* oc = (OverlayCase*) data;
+
+    switch (oc->type) {
+    case OVERLAY_TEXT: {
+        gchar* text = g_strdup_printf("%d", frame);
+        g_object_set(oc->overlay, "text", text, NULL);
+        g_free(text);
+        break;
+    }
+    case OVERLAY_PROGRESS_CIRCLE:
+        g_object_set(oc->overlay, "percent-complete",
+                     (gdouble)(frame % 101), NULL);
+        break;
+    default:
+        break;
+    }
+    /* the throbber animates by itself, the rest is redrawn like on hover */
+    if (oc->type != OVERLAY_THROBBER) {
+        gtk_widget_queue_draw(oc->icon);
+    }
+}
+
+static AwnOverlay*
+bench_overlay_new(BenchOverlay type, const gchar* image_file)
+{
+    GdkPixbuf* pixbuf;
+    AwnOverlay* overlay = NULL;
+
+    switch (type) {
+    case OVERLAY_TEXT:
+        overlay = AWN_OVERLAY(awn_overlay_text_new());
+        break;
+    case OVERLAY_PROGRESS_CIRCLE:
+        overlay = AWN_OVERLAY(awn_overlay_progress_circle_new());
+        break;
+    case OVERLAY_THROBBER:
+        overlay = AWN_OVERLAY(awn_overlay_throbber_new());
+        break;
+    case OVERLAY_PIXBUF:
+        pixbuf = bench_pixbuf_new();
+        overlay = AWN_OVERLAY(awn_overlay_pixbuf_new_with_pixbuf(pixbuf));
+        g_object_unref(pixbuf);
+        break;
+    case OVERLAY_PIXBUF_FILE:
+        overlay = AWN_OVERLAY(awn_overlay_pixbuf_file_new((gchar*) image_file));
+        break;
+    case OVERLAY_THEMED_ICON:
+        overlay = AWN_OVERLAY(awn_overlay_themed_icon_new("image-missing"));
+        break;
+    }
+
+    return overlay;
+}
+
+static void
+bench_overlay(BenchOverlay type, const gchar* image_file)
+{
+    gchar* name = g_strdup_printf("overlay/%s", overlay_names[type]);
+    GtkWidget* window;
+    OverlayCase oc;
+    BenchResult result;
+
+    if (!selected(name)) {
+        g_free(name);
+        return;
+    }
+
+    window = bench_window_new(icon_size * 2, icon_size * 2);
+    oc.type = type;
+    oc.icon = bench_icon_new();
+    oc.overlay = bench_overlay_new(type, image_file);
+    awn_overlayable_add_overlay(AWN_OVERLAYABLE(oc.icon), oc.overlay);
+    gtk_container_add(GTK_CONTAINER(window), oc.icon);
+    bench_window_show(window);
+
+    result = run_frames(window, overlay_frame, &oc);
+    report(name, &result);
+
+    gtk_widget_destroy(window);
+    g_free(name);
+}
+
+/* private XDG directories, set up before anything asks for them */
+static gchar*
+bench_home_new(void)
+{
+    gchar* home = g_build_filename(g_get_tmp_dir(),
+                                   "awn-render-benchmark-XXXXXX", NULL);
+    gchar* dir;
+
+    if (!mkdtemp(home)) {
+        g_free(home);
+        return NULL;
+    }
+
+    dir = g_build_filename(home, "config", NULL);
+    g_mkdir(dir, 0700);
+    g_setenv("XDG_CONFIG_HOME", dir, TRUE);
+    g_free(dir);
+    dir = g_build_filename(home, "cache", NULL);
+    g_mkdir(dir, 0700);
+    g_setenv("XDG_CACHE_HOME", dir, TRUE);
+    g_free(dir);
+
+    return home;
+}
+
+static void
+remove_tree(const gchar* path)
+{
+    GDir* dir = g_dir_open(path, 0, NULL);
+
+    if (dir) {
+        const gchar* name;
+        while ((name = g_dir_read_name(dir))) {
+            gchar* child = g_build_filename(path, name, NULL);
+            remove_tree(child);
+            g_free(child);
+        }
+        g_dir_close(dir);
+        g_rmdir(path);
+    } else {
+        g_unlink(path);
+    }
+}
+
+gint
+main(gint argc, gchar* argv[])
+{
+    GOptionContext* context;
+    DesktopAgnosticConfigClient* client;
+    GtkWidget* panel;
+    GdkPixbuf* pixbuf;
+    GError* error = NULL;
+    gchar* image_file;
+    gchar* home;
+    guint asset_hits, asset_misses;
+
+    home = bench_home_new();
+    if (!home) {
+        g_printerr("Can't create a scratch directory\n");
+        return EXIT_FAILURE;
+    }
+
+    context = g_option_context_new("- render benchmark");
+    g_option_context_add_main_entries(context, entries, NULL);
+    g_option_context_add_group(context, gtk_get_option_group(TRUE));
+    if (!g_option_context_parse(context, &argc, &argv, &error)) {
+        g_printerr("%s\n", error->message);
+        g_error_free(error);
+        remove_tree(home);
+        return EXIT_FAILURE;
+    }
+    g_option_context_free(context);
+    frames = MAX(frames, 1);
+    icon_size = CLAMP(icon_size, 8, 256);
+
+    if (compare_file && !load_baseline(compare_file)) {
+        remove_tree(home);
+        return EXIT_FAILURE;
+    }
+
+    desktop_agnostic_vfs_init(&error);
+    if (error) {
+        g_critical("Error initializing VFS subsystem: %s", error->message);
+        g_error_free(error);
+        remove_tree(home);
+        return EXIT_FAILURE;
+    }
+
+    panel = awn_panel_new_with_panel_id(BENCH_PANEL_ID);
+    g_return_val_if_fail(panel, EXIT_FAILURE);
+    gtk_widget_realize(panel);
+    client = awn_config_get_default(BENCH_PANEL_ID, NULL);
+
+    image_file = g_build_filename(home, "awn-render-benchmark.png", NULL);
+    pixbuf = bench_pixbuf_new();
+    gdk_pixbuf_save(pixbuf, image_file, "png", NULL, NULL);
+    g_object_unref(pixbuf);
+
+    g_print("# frames=%d size=%d\n", frames, icon_size);
+    g_print("# case\tframes\tms/frame\tallocs/frame\tsurfaces/frame\n");
+
+    for (gint effect = AWN_EFFECT_OPENING; effect < AWN_EFFECT_DESATURATE;
+            effect++) {
+        for (guint bundle = 0; bundle < G_N_ELEMENTS(bundle_names); bundle++) {
+            bench_effect((AwnEffect) effect, bundle);
+        }
+    }
+    bench_effect(AWN_EFFECT_DESATURATE, 0);
+
+    for (guint s = 0; s < G_N_ELEMENTS(styles); s++) {
+        bench_background(&styles[s], client, panel, FALSE);
+        bench_background(&styles[s], client, panel, TRUE);
+    }
+
+    for (guint o = 0; o < G_N_ELEMENTS(overlay_names); o++) {
+        bench_overlay((BenchOverlay) o, image_file);
+    }
+
+    awn_effects_get_asset_stats(&asset_hits, &asset_misses);
+    g_print("# effect assets: %u hits, %u built\n", asset_hits, asset_misses);
+
+    g_free(image_file);
+    gtk_widget_destroy(panel);
+    awn_config_free();
+
+    desktop_agnostic_vfs_shutdown(NULL);
+
+    remove_tree(home);
+    g_free(home);
+
+    if (baseline) {
+        g_hash_table_destroy(baseline);
+    }
+
+    return regressed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,258 @@
+/*
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301  USA.
+ */
+
+/*
+ * Checks the coalescing of config updates: many changes queued for one
+ * object within a main loop iteration result in a single update, objects
+ * finalized before the update don't get it, changes queued while
+ * updating are delivered in the next iteration, and a transaction only
+ * holds back the updates of its own client. Also checks the transactional
+ * writes: values set inside a transaction are only written when the
+ * outermost one ends, once per key with the last value, and a failing
+ * write is reported by awn_config_end_update().
+ * The clients use the in-memory config backend under a scratch
+ * XDG_CONFIG_HOME, the user's configuration isn't touched.
+ */
+#include <stdlib.h>
+#include <unistd.h>
+#include <glib/gstdio.h>
+#include <gtk/gtk.h>
+#include <libawn/libawn.h>
+
+#include "test-check.h"
+
+#define OBJECTS 40
+#define KEYS 20
+#define TEST_PANEL_ID 97
+
+static guint updates = 0;
+static guint notifies = 0;
+static DesktopAgnosticConfigClient* client = NULL;
+
+static gchar*
+scratch_home_new(void)
+{
+    gchar* home = g_build_filename(g_get_tmp_dir(),
+                                   "test-awn-config-update-XXXXXX", NULL);
+    gchar* dir;
+
+    if (!mkdtemp(home)) {
+        g_free(home);
+        return NULL;
+    }
+
+    dir = g_build_filename(home, "libdesktop-agnostic", NULL);
+    g_mkdir(dir, 0700);
+    g_free(dir);
+    dir = g_build_filename(home, "libdesktop-agnostic", "desktop-agnostic.ini",
+                           NULL);
+    g_file_set_contents(dir, "[DEFAULT]\nconfig = memory\n", -1, NULL);
+    g_free(dir);
+    g_setenv("XDG_CONFIG_HOME", home, TRUE);
+
+    return home;
+}
+
+static void
+remove_tree(const gchar* path)
+{
+    GDir* dir = g_dir_open(path, 0, NULL);
+
+    if (dir) {
+        const gchar* name;
+        while ((name = g_dir_read_name(dir))) {
+            gchar* child = g_build_filename(path, name, NULL);
+            remove_tree(child);
+            g_free(child);
+        }
+        g_dir_close(dir);
+        g_rmdir(path);
+    } else {
+        g_unlink(path);
+    }
+}
+
+static void
+on_size_notify(const gchar* group, const gchar* key, GValue* value,
+               gpointer user_data)
+{
+    notifies++;
+}
+
+static void
+set_size(gint size)
+{
+    GValue value = { 0, };
+
+    g_value_init(&value, G_TYPE_INT);
+    g_value_set_int(&value, size);
+    awn_config_set_value(client, "panel", "size", &value, NULL);
+    g_value_unset(&value);
+}
+
+static gint
+get_size(void)
+{
+    return desktop_agnostic_config_client_get_int(client, "panel", "size",
+            NULL);
+}
+
+static gboolean
+check_writes(void)
+{
+    GValue value = { 0, };
+    GError* error = NULL;
+    gboolean ok = TRUE;
+
+    desktop_agnostic_config_client_notify_add(client, "panel", "size",
+            on_size_notify, NULL, NULL);
+
+    set_size(30);
+    ok &= check("write outside a transaction", get_size() == 30);
+
+    notifies = 0;
+    awn_config_begin_update(client);
+    set_size(40);
+    set_size(50);
+    ok &= check("writes wait for the transaction", get_size() == 30);
+    awn_config_end_update(client, &error);
+    ok &= check("last value per key wins",
+                error == NULL && get_size() == 50);
+    ok &= check("one write per key", notifies == 1);
+
+    awn_config_begin_update(client);
+    awn_config_begin_update(client);
+    set_size(60);
+    awn_config_end_update(client, NULL);
+    ok &= check("inner transaction doesn't write", get_size() == 50);
+    awn_config_end_update(client, NULL);
+    ok &= check("outermost transaction writes", get_size() == 60);
+
+    /* a string for an integer key can't be written */
+    awn_config_begin_update(client);
+    g_value_init(&value, G_TYPE_STRING);
+    g_value_set_string(&value, "large");
+    awn_config_set_value(client, "panel", "offset", &value, NULL);
+    g_value_unset(&value);
+    set_size(70);
+    awn_config_end_update(client, &error);
+    ok &= check("failed write is reported", error != NULL);
+    ok &= check("other writes still happen", get_size() == 70);
+    g_clear_error(&error);
+
+    return ok;
+}
+
+static void
+on_update(GObject* object)
+{
+    updates++;
+}
+
+static void
+on_update_requeue(GObject* object)
+{
+    updates++;
+    awn_config_queue_update(client, object, on_update);
+}
+
+static void
+iterate(void)
+{
+    while (g_main_context_iteration(NULL, FALSE));
+}
+
+gint
+main(gint argc, gchar** argv)
+{
+    GObject* objects[OBJECTS];
+    DesktopAgnosticConfigClient* other = NULL;
+    guint queued, delivered;
+    GError* error = NULL;
+    gchar* home;
+    gboolean ok = TRUE;
+
+    g_type_init();
+
+    home = scratch_home_new();
+    if (!home) {
+        g_printerr("Can't create a scratch directory\n");
+        return EXIT_FAILURE;
+    }
+
+    client = awn_config_get_default(TEST_PANEL_ID, &error);
+    if (client) {
+        other = awn_config_get_default(TEST_PANEL_ID + 1, &error);
+    }
+    if (error) {
+        g_printerr("Could not get the config clients: %s\n", error->message);
+        g_error_free(error);
+        remove_tree(home);
+        return EXIT_FAILURE;
+    }
+
+    ok &= check_writes();
+
+    for (gint i = 0; i < OBJECTS; i++) {
+        objects[i] = (GObject*)g_object_new(G_TYPE_OBJECT, NULL);
+    }
+
+    for (gint key = 0; key < KEYS; key++) {
+        for (gint i = 0; i < OBJECTS; i++) {
+            awn_config_queue_update(client, objects[i], on_update);
+        }
+    }
+    ok &= check("nothing delivered synchronously", updates == 0);
+    iterate();
+    ok &= check("one update per object", updates == OBJECTS);
+    awn_config_get_update_stats(&queued, &delivered);
+    ok &= check("stats", queued == OBJECTS * KEYS && delivered == OBJECTS);
+
+    updates = 0;
+    awn_config_queue_update(client, objects[0], on_update);
+    awn_config_queue_update(client, objects[1], on_update);
+    g_object_unref(objects[1]);
+    iterate();
+    ok &= check("finalized object is skipped", updates == 1);
+
+    updates = 0;
+    awn_config_queue_update(client, objects[0], on_update_requeue);
+    g_main_context_iteration(NULL, FALSE);
+    ok &= check("requeued update waits", updates == 1);
+    iterate();
+    ok &= check("requeued update delivered", updates == 2);
+
+    updates = 0;
+    awn_config_begin_update(other);
+    awn_config_queue_update(client, objects[0], on_update);
+    awn_config_queue_update(other, objects[2], on_update);
+    iterate();
+    ok &= check("other transaction doesn't hold back", updates == 1);
+    awn_config_end_update(other, NULL);
+    iterate();
+    ok &= check("update delivered after the transaction", updates == 2);
+
+    for (gint i = 0; i < OBJECTS; i++) {
+        if (i != 1) {
+            g_object_unref(objects[i]);
+        }
+    }
+    awn_config_free();
+    remove_tree(home);
+    g_free(home);
+
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
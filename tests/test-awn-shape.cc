@@ -0,0 +1,200 @@
+/*
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301  USA.
+ */
+
+/*
+ * Checks the window shape helpers: regions built from a painted mask have to
+ * match the mask pixel by pixel, regions built from a path have to match the
+ * path, outline regions have to be close to the old filled and stroked
+ * dialog mask and cover its straight edges,
+ * and setting the same shape twice mustn't reach the X server.
+ * Prints the time spent building a panel-sized shape both ways.
+ */
+#include <math.h>
+#include <stdlib.h>
+#include <gtk/gtk.h>
+#include <libawn/libawn.h>
+#include <libawn/awn-shape.h>
+
+#include "test-check.h"
+
+#define WIDTH 1280
+#define HEIGHT 100
+#define ITERATIONS 200
+
+static void
+paint_shape(cairo_t* cr)
+{
+    awn_cairo_rounded_rect(cr, 40, 20, WIDTH - 80, HEIGHT - 20, 15, ROUND_TOP);
+    cairo_rectangle(cr, 300, 0, 48, 20);
+}
+
+static void
+paint_outline(cairo_t* cr)
+{
+    cairo_translate(cr, WIDTH, 0.0);
+    cairo_rotate(cr, M_PI * 0.5);
+    awn_cairo_rounded_rect(cr, 10, 10, HEIGHT - 20, WIDTH - 20, 12, ROUND_ALL);
+}
+
+static gboolean
+region_matches_mask(GdkRegion* region, cairo_surface_t* mask)
+{
+    const guchar* data = cairo_image_surface_get_data(mask);
+    gint stride = cairo_image_surface_get_stride(mask);
+
+    for (gint y = 0; y < HEIGHT; y++) {
+        const guint32* row = (const guint32*)(data + y * stride);
+        for (gint x = 0; x < WIDTH; x++) {
+#if G_BYTE_ORDER == G_LITTLE_ENDIAN
+            gboolean set = (row[x >> 5] >> (x & 31)) & 1;
+#else
+            gboolean set = (row[x >> 5] >> (31 - (x & 31))) & 1;
+#endif
+            if (set != gdk_region_point_in(region, x, y)) {
+                return FALSE;
+            }
+        }
+    }
+
+    return TRUE;
+}
+
+gint
+main(gint argc, gchar** argv)
+{
+    cairo_surface_t* mask;
+    cairo_t* cr;
+    GdkRegion* region, *path_region;
+    GdkRectangle rect = { 10, 10, 30, 40 };
+    GdkRectangle* rects;
+    gint n_rects;
+    GtkWidget* window;
+    GTimer* timer;
+    gboolean ok = TRUE;
+
+    gtk_init(&argc, &argv);
+
+    mask = awn_shape_mask_new(WIDTH, HEIGHT);
+    cr = cairo_create(mask);
+    paint_shape(cr);
+    cairo_fill(cr);
+    cairo_destroy(cr);
+
+    region = awn_shape_region_from_mask(mask);
+    ok &= check("mask region matches mask", region_matches_mask(region, mask));
+    gdk_region_get_rectangles(region, &rects, &n_rects);
+    g_print("mask region has %d rectangles\n", n_rects);
+    g_free(rects);
+
+    cr = cairo_create(mask);
+    paint_shape(cr);
+    path_region = awn_shape_region_from_path(cr);
+    cairo_destroy(cr);
+    gdk_region_xor(path_region, region);
+    gdk_region_get_rectangles(path_region, &rects, &n_rects);
+    ok &= check("path region close to mask region", n_rects < 40);
+    g_free(rects);
+    gdk_region_destroy(path_region);
+
+    /* the dialog's mask used to be painted like this */
+    cairo_surface_destroy(mask);
+    mask = awn_shape_mask_new(WIDTH, HEIGHT);
+    cr = cairo_create(mask);
+    cairo_translate(cr, 0.5, 0.5);
+    paint_outline(cr);
+    cairo_fill_preserve(cr);
+    cairo_set_line_width(cr, 1.0);
+    cairo_stroke(cr);
+    cairo_destroy(cr);
+    gdk_region_destroy(region);
+    region = awn_shape_region_from_mask(mask);
+    cr = cairo_create(mask);
+    paint_outline(cr);
+    path_region = awn_shape_region_from_outline(cr);
+    cairo_destroy(cr);
+    /* the rotated outline spans the whole window, border included */
+    ok &= check("outline region covers the border",
+                gdk_region_point_in(path_region, WIDTH / 2, 10) &&
+                gdk_region_point_in(path_region, WIDTH / 2, HEIGHT - 10) &&
+                gdk_region_point_in(path_region, 10, HEIGHT / 2) &&
+                gdk_region_point_in(path_region, WIDTH - 10, HEIGHT / 2) &&
+                !gdk_region_point_in(path_region, WIDTH / 2, 9) &&
+                !gdk_region_point_in(path_region, WIDTH / 2, HEIGHT - 9));
+    gdk_region_xor(path_region, region);
+    gdk_region_get_rectangles(path_region, &rects, &n_rects);
+    ok &= check("outline region close to old dialog mask", n_rects < 40);
+    g_free(rects);
+    gdk_region_destroy(path_region);
+
+    cr = cairo_create(mask);
+    cairo_translate(cr, 5, 5);
+    cairo_rectangle(cr, rect.x - 5, rect.y - 5, rect.width, rect.height);
+    path_region = awn_shape_region_from_path(cr);
+    cairo_destroy(cr);
+    gdk_region_get_rectangles(path_region, &rects, &n_rects);
+    ok &= check("rectangle path is one rectangle",
+                n_rects == 1 && rects[0].x == rect.x && rects[0].y == rect.y &&
+                rects[0].width == rect.width && rects[0].height == rect.height);
+    g_free(rects);
+    gdk_region_destroy(path_region);
+
+    window = gtk_window_new(GTK_WINDOW_POPUP);
+    gtk_window_set_default_size(GTK_WINDOW(window), WIDTH, HEIGHT);
+    gtk_widget_realize(window);
+    ok &= check("first shape is applied",
+                awn_shape_apply(window->window, TRUE, region));
+    ok &= check("same shape is skipped",
+                !awn_shape_apply(window->window, TRUE, region));
+    ok &= check("unset shape is applied",
+                awn_shape_apply(window->window, TRUE, NULL));
+    ok &= check("unset shape again is skipped",
+                !awn_shape_apply(window->window, TRUE, NULL));
+    gtk_widget_destroy(window);
+
+    timer = g_timer_new();
+    for (gint i = 0; i < ITERATIONS; i++) {
+        GdkRegion* r;
+        cr = cairo_create(mask);
+        cairo_set_operator(cr, CAIRO_OPERATOR_CLEAR);
+        cairo_paint(cr);
+        cairo_set_operator(cr, CAIRO_OPERATOR_SOURCE);
+        paint_shape(cr);
+        cairo_fill(cr);
+        cairo_destroy(cr);
+        r = awn_shape_region_from_mask(mask);
+        gdk_region_destroy(r);
+    }
+    g_print("from mask: %.3f ms per shape\n",
+            g_timer_elapsed(timer, NULL) * 1000.0 / ITERATIONS);
+
+    g_timer_start(timer);
+    for (gint i = 0; i < ITERATIONS; i++) {
+        GdkRegion* r;
+        cr = cairo_create(mask);
+        paint_shape(cr);
+        r = awn_shape_region_from_path(cr);
+        cairo_destroy(cr);
+        gdk_region_destroy(r);
+    }
+    g_print("from path: %.3f ms per shape\n",
+            g_timer_elapsed(timer, NULL) * 1000.0 / ITERATIONS);
+    g_timer_destroy(timer);
+
+    gdk_region_destroy(region);
+    cairo_surface_destroy(mask);
+
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,214 @@
+/*
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301  USA.
+ */
+
+/*
+ * Compares the memory and X resource usage of the shared tooltip pool with
+ * the old one-tooltip-window-per-icon behaviour (which is still what you get
+ * after calling awn_icon_get_tooltip). Checks that the pooled window is
+ * reused: the X window count stays flat while icons come and go.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <gtk/gtk.h>
+#include <gdk/gdkx.h>
+#include <libawn/libawn.h>
+#include <libawn/awn-tooltip-pool.h>
+
+#include "test-check.h"
+
+#define NUM_ICONS 50
+#define NUM_EXTRA 20
+
+static glong
+get_rss_kb(void)
+{
+    glong size = 0, resident = 0;
+    FILE* f = fopen("/proc/self/statm", "r");
+
+    if (f) {
+        if (fscanf(f, "%ld %ld", &size, &resident) != 2) {
+            resident = 0;
+        }
+        fclose(f);
+    }
+
+    return resident * (sysconf(_SC_PAGESIZE) / 1024);
+}
+
+static guint
+count_realized_toplevels(void)
+{
+    GList* windows = gtk_window_list_toplevels();
+    GList* iter;
+    guint count = 0;
+
+    for (iter = windows; iter; iter = iter->next) {
+        if (AWN_IS_TOOLTIP(iter->data) &&
+                gtk_widget_get_realized(GTK_WIDGET(iter->data))) {
+            count++;
+        }
+    }
+
+    g_list_free(windows);
+    return count;
+}
+
+static guint
+count_x_windows(void)
+{
+    Window root, parent;
+    Window* children = NULL;
+    guint n_children = 0;
+
+    XQueryTree(GDK_DISPLAY_XDISPLAY(gdk_display_get_default()),
+               GDK_ROOT_WINDOW(), &root, &parent, &children, &n_children);
+
+    if (children) {
+        XFree(children);
+    }
+
+    return n_children;
+}
+
+static void
+hover_icon(GtkWidget* icon)
+{
+    GdkEvent* event = gdk_event_new(GDK_ENTER_NOTIFY);
+    gboolean ret;
+
+    event->crossing.window = (GdkWindow*)g_object_ref(gtk_widget_get_window(icon));
+    g_signal_emit_by_name(icon, "enter-notify-event", event, &ret);
+
+    event->type = GDK_LEAVE_NOTIFY;
+    g_signal_emit_by_name(icon, "leave-notify-event", event, &ret);
+
+    gdk_event_free(event);
+}
+
+static void
+iterate(void)
+{
+    while (gtk_events_pending()) {
+        gtk_main_iteration();
+    }
+}
+
+static GtkWidget*
+add_icon(GtkWidget* box, gint i)
+{
+    gchar* text = g_strdup_printf("Icon number %d", i);
+    GtkWidget* icon = awn_icon_new();
+
+    awn_icon_set_tooltip_text(AWN_ICON(icon), text);
+    gtk_widget_set_size_request(icon, 16, 16);
+    gtk_box_pack_start(GTK_BOX(box), icon, FALSE, FALSE, 0);
+    gtk_widget_show(icon);
+    g_free(text);
+
+    return icon;
+}
+
+static void
+report(const gchar* label, glong rss_base, guint x_base)
+{
+    iterate();
+
+    printf("%-10s tooltip windows: %3u  X windows: +%3u  RSS: +%ld kB\n",
+           label, count_realized_toplevels(),
+           count_x_windows() - x_base, get_rss_kb() - rss_base);
+}
+
+gint
+main(gint argc, gchar** argv)
+{
+    GtkWidget* window, *hbox;
+    GtkWidget* icons[NUM_ICONS];
+    GtkWidget* extra[NUM_EXTRA];
+    glong rss_base;
+    guint x_base, x_pooled;
+    gboolean ok = TRUE;
+    gint i;
+
+    gtk_init(&argc, &argv);
+
+    window = gtk_window_new(GTK_WINDOW_TOPLEVEL);
+    hbox = gtk_hbox_new(FALSE, 0);
+    gtk_container_add(GTK_CONTAINER(window), hbox);
+    gtk_widget_show_all(window);
+
+    rss_base = get_rss_kb();
+    x_base = count_x_windows();
+
+    for (i = 0; i < NUM_ICONS; i++) {
+        icons[i] = add_icon(hbox, i);
+    }
+
+    /* the pooled tooltip is created on the first hover */
+    for (i = 0; i < NUM_ICONS; i++) {
+        hover_icon(icons[i]);
+    }
+    if (awn_tooltip_pool_get_shared()) {
+        gtk_widget_realize(GTK_WIDGET(awn_tooltip_pool_get_shared()));
+    }
+
+    printf("%d icons, %u pooled targets\n", NUM_ICONS,
+           awn_tooltip_pool_get_n_targets());
+    report("pooled", rss_base, x_base);
+    ok &= check("one tooltip window for all icons",
+                count_realized_toplevels() == 1);
+    ok &= check("every icon is a pool target",
+                awn_tooltip_pool_get_n_targets() == NUM_ICONS);
+
+    /* icons coming and going reuse the pooled window */
+    x_pooled = count_x_windows();
+    for (i = 0; i < NUM_EXTRA; i++) {
+        extra[i] = add_icon(hbox, NUM_ICONS + i);
+    }
+    iterate();
+    for (i = 0; i < NUM_EXTRA; i++) {
+        hover_icon(extra[i]);
+    }
+    iterate();
+    ok &= check("added icons create no X windows",
+                count_x_windows() == x_pooled);
+    for (i = 0; i < NUM_EXTRA; i++) {
+        gtk_widget_destroy(extra[i]);
+    }
+    iterate();
+    ok &= check("removed icons leave the pool",
+                awn_tooltip_pool_get_n_targets() == NUM_ICONS);
+    ok &= check("removed icons keep the X windows",
+                count_x_windows() == x_pooled);
+    hover_icon(icons[0]);
+    iterate();
+    ok &= check("pooled window still in use",
+                count_realized_toplevels() == 1 &&
+                count_x_windows() == x_pooled);
+
+    /* asking for the tooltip gives every icon its own window again,
+     * realize them as if each one had been shown once */
+    for (i = 0; i < NUM_ICONS; i++) {
+        gtk_widget_realize(GTK_WIDGET(awn_icon_get_tooltip(AWN_ICON(icons[i]))));
+    }
+
+    report("dedicated", rss_base, x_base);
+    ok &= check("dedicated tooltips leave the pool",
+                awn_tooltip_pool_get_n_targets() == 0);
+
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,114 @@
+/*
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301  USA.
+ */
+
+/*
+ * Checks the frame tracing ring buffer: nothing is recorded while tracing
+ * is disabled, the buffer keeps only the newest spans, and the export
+ * contains the spans and counters. Prints the cost of a trace point with
+ * tracing disabled and enabled.
+ */
+#include <stdlib.h>
+#include <string.h>
+#include <glib.h>
+#include <libawn/awn-trace.h>
+
+#include "test-check.h"
+
+#define ITERATIONS 1000000
+
+static guint
+count(const gchar* haystack, const gchar* needle)
+{
+    guint n = 0;
+
+    for (const gchar* p = strstr(haystack, needle); p; p = strstr(p + 1, needle)) {
+        n++;
+    }
+
+    return n;
+}
+
+static void
+trace_point(void)
+{
+    gint64 start = awn_trace_begin();
+    awn_trace_count(AWN_TRACE_SURFACES_CREATED);
+    awn_trace_end(AWN_TRACE_EXPOSE, start);
+}
+
+static gdouble
+time_trace_points(void)
+{
+    GTimer* timer = g_timer_new();
+    gdouble elapsed;
+
+    for (gint i = 0; i < ITERATIONS; i++) {
+        trace_point();
+    }
+    elapsed = g_timer_elapsed(timer, NULL);
+    g_timer_destroy(timer);
+
+    return elapsed * 1e9 / ITERATIONS;
+}
+
+gint
+main(gint argc, gchar** argv)
+{
+    gchar* json;
+    gdouble disabled, enabled;
+    gboolean ok = TRUE;
+
+    trace_point();
+    json = awn_trace_to_json();
+    ok &= check("nothing recorded while disabled",
+                count(json, "\"ph\":\"X\"") == 0);
+    g_free(json);
+
+    awn_trace_set_enabled(TRUE);
+    trace_point();
+    trace_point();
+    awn_trace_set_enabled(FALSE);
+    trace_point();
+    json = awn_trace_to_json();
+    ok &= check("spans recorded while enabled",
+                count(json, "\"name\":\"expose\"") == 2);
+    ok &= check("counters at the end of an expose",
+                strstr(json, "\"name\":\"surfaces-created\"") != NULL &&
+                strstr(json, "\"value\":2}") != NULL);
+    g_free(json);
+
+    awn_trace_set_enabled(TRUE);
+    for (gint i = 0; i < AWN_TRACE_RING_SIZE + 10; i++) {
+        gint64 start = awn_trace_begin();
+        awn_trace_end(AWN_TRACE_MASK_UPDATE, start);
+    }
+    json = awn_trace_to_json();
+    ok &= check("enabling again clears the old spans",
+                count(json, "\"name\":\"expose\"") == 0);
+    ok &= check("ring keeps the newest spans",
+                count(json, "\"ph\":\"X\"") == AWN_TRACE_RING_SIZE);
+    g_free(json);
+    awn_trace_set_enabled(FALSE);
+
+    disabled = time_trace_points();
+    awn_trace_set_enabled(TRUE);
+    enabled = time_trace_points();
+    awn_trace_set_enabled(FALSE);
+    g_print("trace point, disabled: %.2f ns\n", disabled);
+    g_print("trace point, enabled: %.2f ns\n", enabled);
+
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
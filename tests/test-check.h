@@ -0,0 +1,35 @@
+/*
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301  USA.
+ */
+
+/* Result reporting shared by the self-checking test programs. */
+
+#ifndef __TEST_CHECK_H__
+#define __TEST_CHECK_H__
+
+#include <glib.h>
+
+/*
+ * Prints the outcome of one check and returns it, the results are and-ed
+ * together into the exit status that make check looks at.
+ */
+static inline gboolean
+check(const gchar* what, gboolean result)
+{
+    g_print("%-40s %s\n", what, result ? "ok" : "FAILED");
+    return result;
+}
+
+#endif
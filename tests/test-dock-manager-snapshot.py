@@ -0,0 +1,153 @@
+#!/usr/bin/env python
+
+#  This program is free software; you can redistribute it and/or modify
+#  it under the terms of the GNU General Public License as published by
+#  the Free Software Foundation; either version 2 of the License, or
+#  (at your option) any later version.
+#
+#  This program is distributed in the hope that it will be useful,
+#  but WITHOUT ANY WARRANTY; without even the implied warranty of
+#  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+#  GNU General Public License for more details.
+#
+#  You should have received a copy of the GNU General Public License
+#  along with this program; if not, write to the Free Software
+#  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301  USA.
+
+# Checks DockManager.AwnGetSnapshot and AwnGetChangesSince against the
+# per-item calls and compares the time a client needs to refresh its view of
+# the dock both ways. The dock is started on a private session bus, so this
+# doesn't interfere with the running one.
+#
+# Usage: test-dock-manager-snapshot.py [path/to/avant-window-navigator]
+#                                      [windows] [refreshes]
+
+import os
+import subprocess
+import sys
+import time
+
+import dbus
+import dbus.mainloop.glib
+import gobject
+import gtk
+
+from test_check import check
+import test_check
+
+DOCKMANAGER_BUS = 'net.launchpad.DockManager'
+DOCKMANAGER_PATH = '/net/launchpad/DockManager'
+DOCKMANAGER_IFACE = 'net.launchpad.DockManager'
+DOCKITEM_IFACE = 'net.launchpad.DockItem'
+PROPERTIES_IFACE = 'org.freedesktop.DBus.Properties'
+
+dock = sys.argv[1] if len(sys.argv) > 1 else 'avant-window-navigator'
+n_windows = int(sys.argv[2]) if len(sys.argv) > 2 else 20
+refreshes = int(sys.argv[3]) if len(sys.argv) > 3 else 100
+
+def refresh_per_item(bus, manager):
+    items = {}
+    for path in manager.GetItems(dbus_interface=DOCKMANAGER_IFACE):
+        obj = bus.get_object(DOCKMANAGER_BUS, path)
+        items[path] = obj.GetAll(DOCKITEM_IFACE,
+                                 dbus_interface=PROPERTIES_IFACE)
+    return items
+
+
+def refresh_snapshot(manager):
+    epoch, generation, items = manager.AwnGetSnapshot(
+        dbus_interface=DOCKMANAGER_IFACE)
+    return epoch, generation, dict(items)
+
+
+def timed(func, *args):
+    start = time.time()
+    for i in xrange(refreshes):
+        func(*args)
+    return (time.time() - start) * 1000.0 / refreshes
+
+
+def run(bus):
+    manager = bus.get_object(DOCKMANAGER_BUS, DOCKMANAGER_PATH)
+    caps = manager.GetCapabilities(dbus_interface=DOCKMANAGER_IFACE)
+    check('x-awn-snapshot capability', 'x-awn-snapshot' in caps)
+
+    epoch, generation, items = refresh_snapshot(manager)
+    paths = manager.GetItems(dbus_interface=DOCKMANAGER_IFACE)
+    check('snapshot lists every item', set(items) == set(paths))
+    ours = manager.GetItemsByPid(os.getpid(),
+                                 dbus_interface=DOCKMANAGER_IFACE)
+    check('our windows are in one item', len(ours) == 1)
+    path = ours[0]
+    check('pids and xids of our item',
+          os.getpid() in items[path]['pids'] and
+          len(items[path]['xids']) == n_windows)
+
+    ep, gen, full, changed, removed = manager.AwnGetChangesSince(
+        epoch, generation, dbus_interface=DOCKMANAGER_IFACE)
+    check('nothing changed yet',
+          ep == epoch and not full and not changed and not removed)
+
+    item = dbus.Interface(bus.get_object(DOCKMANAGER_BUS, path),
+                          DOCKITEM_IFACE)
+    item.UpdateDockItem({'badge': '42', 'progress': dbus.Int32(50)})
+    ep, gen, full, changed, removed = manager.AwnGetChangesSince(
+        epoch, generation, dbus_interface=DOCKMANAGER_IFACE)
+    changed = dict(changed)
+    check('delta has only the updated item',
+          not full and changed.keys() == [path] and gen > generation)
+    check('delta carries the hints',
+          changed[path].get('badge') == '42' and
+          changed[path].get('progress') == 50)
+
+    ep, gen, full, changed, removed = manager.AwnGetChangesSince(
+        epoch, 0, dbus_interface=DOCKMANAGER_IFACE)
+    check('unknown generation gets everything',
+          full and set(dict(changed)) == set(paths))
+
+    ep, gen, full, changed, removed = manager.AwnGetChangesSince(
+        epoch + 'x', gen, dbus_interface=DOCKMANAGER_IFACE)
+    check('other epoch gets everything',
+          ep == epoch and full and set(dict(changed)) == set(paths))
+
+    per_item = timed(refresh_per_item, bus, manager)
+    snapshot = timed(refresh_snapshot, manager)
+    print 'refresh, item by item:   %.3f ms (%d items)' % \
+        (per_item, len(paths))
+    print 'refresh, snapshot:       %.3f ms' % snapshot
+    gtk.main_quit()
+    return False
+
+
+def main():
+    daemon = subprocess.Popen(['dbus-daemon', '--session', '--nofork',
+                               '--print-address'], stdout=subprocess.PIPE)
+    address = daemon.stdout.readline().strip()
+    os.environ['DBUS_SESSION_BUS_ADDRESS'] = address
+
+    awn = subprocess.Popen([dock])
+    try:
+        dbus.mainloop.glib.DBusGMainLoop(set_as_default=True)
+        bus = dbus.SessionBus()
+
+        # the taskmanager groups our windows in one item
+        windows = []
+        for i in xrange(n_windows):
+            window = gtk.Window()
+            window.set_title('DockManager snapshot test %d' % i)
+            window.show_all()
+            windows.append(window)
+
+        # give the taskmanager time to pick the windows up
+        gobject.timeout_add(3000, run, bus)
+        gtk.main()
+    finally:
+        awn.terminate()
+        awn.wait()
+        daemon.terminate()
+        daemon.wait()
+
+    test_check.exit()
+
+if __name__ == '__main__':
+    main()
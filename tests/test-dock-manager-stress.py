@@ -0,0 +1,177 @@
+#!/usr/bin/env python
+
+#  This program is free software; you can redistribute it and/or modify
+#  it under the terms of the GNU General Public License as published by
+#  the Free Software Foundation; either version 2 of the License, or
+#  (at your option) any later version.
+#
+#  This program is distributed in the hope that it will be useful,
+#  but WITHOUT ANY WARRANTY; without even the implied warranty of
+#  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+#  GNU General Public License for more details.
+#
+#  You should have received a copy of the GNU General Public License
+#  along with this program; if not, write to the Free Software
+#  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301  USA.
+
+# Floods the taskmanager with DockItem.UpdateDockItem calls (progress and
+# message hints) and reports the achieved rate and the CPU time used by the
+# dock. Fails if an update is refused or lost, or if a reply takes longer
+# than max-latency seconds. The dock is started on a private session bus,
+# so this doesn't interfere with the running one.
+#
+# Usage: test-dock-manager-stress.py [path/to/avant-window-navigator]
+#                                    [updates/s] [seconds] [max-latency]
+
+import os
+import subprocess
+import sys
+import time
+
+import dbus
+import dbus.mainloop.glib
+import gobject
+import gtk
+
+from test_check import check
+import test_check
+
+DOCKMANAGER_BUS = 'net.launchpad.DockManager'
+DOCKMANAGER_PATH = '/net/launchpad/DockManager'
+DOCKMANAGER_IFACE = 'net.launchpad.DockManager'
+DOCKITEM_IFACE = 'net.launchpad.DockItem'
+
+dock = sys.argv[1] if len(sys.argv) > 1 else 'avant-window-navigator'
+rate = int(sys.argv[2]) if len(sys.argv) > 2 else 10000
+duration = int(sys.argv[3]) if len(sys.argv) > 3 else 10
+max_latency = float(sys.argv[4]) if len(sys.argv) > 4 else 1.0
+
+# slices of the main loop the updates are sent in
+TICK = 10
+# 500ms apart
+FIND_ITEM_TRIES = 20
+
+
+def cpu_time(pid):
+    stat = open('/proc/%d/stat' % pid).read()
+    fields = stat[stat.rindex(')') + 2:].split()
+    # utime + stime
+    return (int(fields[11]) + int(fields[12])) / \
+        float(os.sysconf('SC_CLK_TCK'))
+
+
+class Stress:
+
+    def __init__(self, bus, dock_pid):
+        self.bus = bus
+        self.dock_pid = dock_pid
+        self.item = None
+        self.sent = 0
+        self.replies = 0
+        self.errors = 0
+        self.latency = 0.0
+        self.timed_out = False
+        self.lookups = 0
+
+    def find_item(self):
+        self.lookups += 1
+        if self.lookups > FIND_ITEM_TRIES:
+            check('dock item for our window', False)
+            gtk.main_quit()
+            return False
+        try:
+            manager = self.bus.get_object(DOCKMANAGER_BUS, DOCKMANAGER_PATH)
+            paths = manager.GetItemsByPid(os.getpid(),
+                                          dbus_interface=DOCKMANAGER_IFACE)
+        except dbus.DBusException:
+            return True
+        if not paths:
+            return True
+
+        obj = self.bus.get_object(DOCKMANAGER_BUS, paths[0])
+        self.item = dbus.Interface(obj, DOCKITEM_IFACE)
+        self.start = time.time()
+        self.start_cpu = cpu_time(self.dock_pid)
+        gobject.timeout_add(TICK, self.send)
+        return False
+
+    def reply(self, sent):
+        self.replies += 1
+        self.latency = max(self.latency, time.time() - sent)
+
+    def error(self, e):
+        self.errors += 1
+
+    def give_up(self):
+        self.timed_out = True
+        return False
+
+    def send(self):
+        elapsed = time.time() - self.start
+        if elapsed >= duration:
+            self.finish(elapsed)
+            return False
+
+        # keep the total in line with the requested rate
+        while self.sent < elapsed * rate:
+            hints = {'progress': dbus.Int32(self.sent % 101),
+                     'message': str(self.sent)}
+            now = time.time()
+            self.item.UpdateDockItem(hints,
+                                     reply_handler=lambda s=now: self.reply(s),
+                                     error_handler=self.error)
+            self.sent += 1
+        return True
+
+    def finish(self, elapsed):
+        # wait for the outstanding replies, a lost one would block forever
+        gobject.timeout_add(int(max(max_latency, 1.0) * 10000),
+                            self.give_up)
+        while self.replies + self.errors < self.sent and not self.timed_out:
+            gtk.main_iteration()
+        total = time.time() - self.start
+        cpu = cpu_time(self.dock_pid) - self.start_cpu
+
+        print 'sent:     %d updates in %.2fs (%.0f/s)' % \
+            (self.sent, elapsed, self.sent / elapsed)
+        print 'replied:  %d (%d errors) after %.2fs' % \
+            (self.replies, self.errors, total)
+        print 'dock cpu: %.2fs (%.1f%%)' % (cpu, 100.0 * cpu / total)
+        print 'latency:  %.3fs at most' % self.latency
+
+        check('every update replied', self.replies + self.errors == self.sent)
+        check('no update refused', self.errors == 0)
+        check('reply latency below %.2fs' % max_latency,
+              self.latency <= max_latency)
+        gtk.main_quit()
+
+
+def main():
+    daemon = subprocess.Popen(['dbus-daemon', '--session', '--nofork',
+                               '--print-address'], stdout=subprocess.PIPE)
+    address = daemon.stdout.readline().strip()
+    os.environ['DBUS_SESSION_BUS_ADDRESS'] = address
+
+    awn = subprocess.Popen([dock])
+    try:
+        dbus.mainloop.glib.DBusGMainLoop(set_as_default=True)
+        bus = dbus.SessionBus()
+
+        # the taskmanager needs a window of ours to create the item for
+        window = gtk.Window()
+        window.set_title('DockManager stress test')
+        window.show_all()
+
+        stress = Stress(bus, awn.pid)
+        gobject.timeout_add(500, stress.find_item)
+        gtk.main()
+    finally:
+        awn.terminate()
+        awn.wait()
+        daemon.terminate()
+        daemon.wait()
+
+    test_check.exit()
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,199 @@
+/*
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301  USA.
+ *
+ */
+
+/*
+ * Checks the taskmanager's compiled context menu templates: the shipped
+ * menus have to compile, a template is only compiled again after its file
+ * changed, and then pops up a menu built from a template many times, once
+ * compiling the xml for every popup (as the taskmanager used to) and once
+ * from the cache, printing the average latency until the menu is mapped.
+ * Needs an X server, eg.
+ *   xvfb-run ./test-task-menu-template
+ */
+
+#include <stdlib.h>
+#include <glib/gstdio.h>
+#include <gtk/gtk.h>
+#include <libdesktop-agnostic/vfs.h>
+
+#include "applets/taskmanager/task-menu-template.h"
+#include "test-check.h"
+
+#define POPUPS 200
+
+static void
+build_menu(GtkWidget* menu, const GPtrArray* ops)
+{
+    for (guint i = 0; i < ops->len; i++) {
+        const TaskMenuOp* op = (const TaskMenuOp*) g_ptr_array_index(ops, i);
+        GtkWidget* item;
+
+        if (op->type == INTERNAL_SEPARATOR) {
+            item = gtk_separator_menu_item_new();
+        } else {
+            item = gtk_image_menu_item_new_with_label(op->label ? op->label :
+                                                      op->text ? op->text : "item");
+            if (op->icon) {
+                gtk_image_menu_item_set_image(GTK_IMAGE_MENU_ITEM(item),
+                                              gtk_image_new_from_icon_name(op->icon, GTK_ICON_SIZE_MENU));
+            }
+        }
+        if (op->children) {
+            GtkWidget* submenu = gtk_menu_new();
+            build_menu(submenu, op->children);
+            gtk_menu_item_set_submenu(GTK_MENU_ITEM(item), submenu);
+        }
+        gtk_widget_show_all(item);
+        gtk_menu_shell_append(GTK_MENU_SHELL(menu), item);
+    }
+}
+
+/* pops up a menu built from @filename, returns the time until it's mapped (s) */
+static gdouble
+popup_menu(const gchar* filename, gboolean cached)
+{
+    GTimer* timer = g_timer_new();
+    const GPtrArray* ops;
+    GtkWidget* menu;
+    gdouble elapsed;
+
+    if (!cached) {
+        task_menu_template_invalidate(filename);
+    }
+    ops = task_menu_template_get(filename, NULL);
+    menu = gtk_menu_new();
+    build_menu(menu, ops);
+    gtk_menu_popup(GTK_MENU(menu), NULL, NULL, NULL, NULL, 3,
+                   gtk_get_current_event_time());
+    while (!GTK_WIDGET_MAPPED(menu) && g_timer_elapsed(timer, NULL) < 2.0) {
+        g_main_context_iteration(NULL, FALSE);
+    }
+    elapsed = GTK_WIDGET_MAPPED(menu) ? g_timer_elapsed(timer, NULL) : -1.0;
+    gtk_menu_popdown(GTK_MENU(menu));
+    gtk_widget_destroy(menu);
+    g_timer_destroy(timer);
+
+    return elapsed;
+}
+
+static gdouble
+popup_latency(const gchar* filename, gboolean cached)
+{
+    gdouble total = 0.0;
+
+    for (gint i = 0; i < POPUPS; i++) {
+        gdouble elapsed = popup_menu(filename, cached);
+        if (elapsed < 0.0) {
+            return -1.0;
+        }
+        total += elapsed;
+    }
+
+    return total / POPUPS;
+}
+
+/* waits until the template of @filename has @len items */
+static gboolean
+wait_for_length(const gchar* filename, guint len)
+{
+    GTimer* timer = g_timer_new();
+    const GPtrArray* ops = task_menu_template_get(filename, NULL);
+
+    while (ops->len != len && g_timer_elapsed(timer, NULL) < 5.0) {
+        g_main_context_iteration(NULL, FALSE);
+        g_usleep(10000);
+        ops = task_menu_template_get(filename, NULL);
+    }
+    g_timer_destroy(timer);
+
+    return ops->len == len;
+}
+
+gint
+main(gint argc, gchar** argv)
+{
+    const gchar* menus[] = {
+        "advanced.xml", "custom-example.xml", "minimal.xml",
+        "simple.xml", "standard.xml", NULL
+    };
+    const GPtrArray* ops;
+    const TaskMenuOp* op;
+    GError* error = NULL;
+    gchar* filename;
+    gchar* tmp_file;
+    gdouble uncached, cached;
+    gboolean ok = TRUE;
+
+    if (!gtk_init_check(&argc, &argv)) {
+        g_print("no X server, skipping\n");
+        return 77;
+    }
+    desktop_agnostic_vfs_init(&error);
+    if (error) {
+        g_print("VFS not available, skipping: %s\n", error->message);
+        g_error_free(error);
+        return 77;
+    }
+
+    for (const gchar** menu = menus; *menu; menu++) {
+        gchar* what = g_strdup_printf("%s compiles", *menu);
+        filename = g_build_filename(MENUDIR, *menu, NULL);
+        ops = task_menu_template_get(filename, NULL);
+        ok &= check(what, ops && ops->len > 0);
+        ok &= check("template is cached", task_menu_template_get(filename, NULL) == ops);
+        g_free(filename);
+        g_free(what);
+    }
+
+    filename = g_build_filename(MENUDIR, "custom-example.xml", NULL);
+    ops = task_menu_template_get(filename, NULL);
+    op = (const TaskMenuOp*) g_ptr_array_index(ops, 6);
+    ok &= check("submenu and its items",
+                op->type == SUBMENU && g_strcmp0(op->text, "Processes") == 0 &&
+                op->children->len == 5);
+    op = (const TaskMenuOp*) g_ptr_array_index(op->children, 0);
+    ok &= check("item label from element content",
+                op->type == EXTERNAL_COMMAND && g_strcmp0(op->label, "pmap") == 0);
+
+    ok &= check("missing file is an error",
+                task_menu_template_get("/nonexistent/menu.xml", NULL) == NULL);
+
+    tmp_file = g_build_filename(g_get_tmp_dir(), "test-task-menu-template.xml", NULL);
+    g_file_set_contents(tmp_file,
+                        "<menu><menuitem type=\"Internal-Launch\"/>"
+                        "<menuitem type=\"Internal-Separator\"/></menu>", -1, NULL);
+    ops = task_menu_template_get(tmp_file, NULL);
+    ok &= check("temporary menu compiles", ops && ops->len == 2);
+    g_file_set_contents(tmp_file,
+                        "<menu><menuitem type=\"Internal-Launch\"/></menu>", -1, NULL);
+    ok &= check("changed file is compiled again",
+                wait_for_length(tmp_file, 1));
+    g_unlink(tmp_file);
+    task_menu_template_invalidate(tmp_file);
+    g_free(tmp_file);
+
+    uncached = popup_latency(filename, FALSE);
+    cached = popup_latency(filename, TRUE);
+    ok &= check("menu pops up", uncached >= 0.0 && cached >= 0.0);
+    g_print("popup, compiling the xml: %.3f ms\n", uncached * 1000.0);
+    g_print("popup, from the template: %.3f ms\n", cached * 1000.0);
+    g_free(filename);
+
+    task_menu_template_invalidate(NULL);
+
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,432 @@
+/*
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301  USA.
+ *
+ */
+
+/*
+ * Benchmark of the taskmanager's launcher list refresh and regrouping,
+ * driven through the "launcher-paths" and "grouping" properties of a real
+ * TaskManager.  For a growing number of fake applications it writes a
+ * .desktop file for every other one, opens a few windows for each (unmapped,
+ * with the application's WM_CLASS and a fake _NET_WM_PID) and publishes them
+ * in _NET_CLIENT_LIST itself, so it has to run on an X server without a
+ * window manager (Xvfb will do) and with a session bus.  It times turning
+ * grouping on and setting the launcher list in reverse and in shuffled
+ * order, checks that the windows of an application end up in one icon and
+ * that the launchers follow the list order, and prints the time per icon
+ * so the scaling is visible.
+ * The config uses the in-memory backend under a scratch XDG_CONFIG_HOME.
+ */
+
+#include <stdlib.h>
+#include <unistd.h>
+#include <glib/gstdio.h>
+#include <gtk/gtk.h>
+#include <libwnck/libwnck.h>
+
+#include "task-manager.h"
+
+#include "test-check.h"
+
+#define APPS_MAX 240
+#define WINDOWS_PER_APP 3
+#define FAKE_PID_BASE 400000
+#define WAIT_SECONDS 30.0
+#define TEST_PANEL_ID 97
+
+static gchar*
+scratch_home_new(void)
+{
+    gchar* home = g_build_filename(g_get_tmp_dir(),
+                                   "test-task-regroup-XXXXXX", NULL);
+    gchar* dir;
+
+    if (!mkdtemp(home)) {
+        g_free(home);
+        return NULL;
+    }
+
+    dir = g_build_filename(home, "libdesktop-agnostic", NULL);
+    g_mkdir(dir, 0700);
+    g_free(dir);
+    dir = g_build_filename(home, "libdesktop-agnostic", "desktop-agnostic.ini",
+                           NULL);
+    g_file_set_contents(dir, "[DEFAULT]\nconfig = memory\n", -1, NULL);
+    g_free(dir);
+    g_setenv("XDG_CONFIG_HOME", home, TRUE);
+
+    return home;
+}
+
+static void
+remove_tree(const gchar* path)
+{
+    GDir* dir = g_dir_open(path, 0, NULL);
+
+    if (dir) {
+        const gchar* name;
+        while ((name = g_dir_read_name(dir))) {
+            gchar* child = g_build_filename(path, name, NULL);
+            remove_tree(child);
+            g_free(child);
+        }
+        g_dir_close(dir);
+        g_rmdir(path);
+    } else {
+        g_unlink(path);
+    }
+}
+
+static gboolean
+window_manager_running(void)
+{
+    GdkAtom type;
+    gint format, length;
+    guchar* data = NULL;
+    gboolean found;
+
+    found = gdk_property_get(gdk_get_default_root_window(),
+                             gdk_atom_intern_static_string("_NET_SUPPORTING_WM_CHECK"),
+                             GDK_NONE, 0, 1, FALSE,
+                             &type, &format, &length, &data);
+    g_free(data);
+
+    return found;
+}
+
+static gchar*
+desktop_file_new(const gchar* home, guint app)
+{
+    gchar* path = g_strdup_printf("%s/bench-app-%u.desktop", home, app);
+    gchar* contents = g_strdup_printf("[Desktop Entry]\n"
+                                      "Type=Application\n"
+                                      "Name=Bench App %u\n"
+                                      "Exec=bench-app-%u\n"
+                                      "StartupWMClass=bench-app-%u\n",
+                                      app, app, app);
+
+    g_file_set_contents(path, contents, -1, NULL);
+    g_free(contents);
+
+    return path;
+}
+
+static GtkWidget*
+fake_window_new(guint app)
+{
+    GtkWidget* window = gtk_window_new(GTK_WINDOW_TOPLEVEL);
+    gchar* name = g_strdup_printf("bench-app-%u", app);
+    gulong pid = FAKE_PID_BASE + app;
+
+    gtk_window_set_title(GTK_WINDOW(window), name);
+    gtk_window_set_wmclass(GTK_WINDOW(window), name, name);
+    gtk_widget_realize(window);
+    /* GTK+ sets our own pid on realize */
+    gdk_property_change(window->window,
+                        gdk_atom_intern_static_string("_NET_WM_PID"),
+                        gdk_atom_intern_static_string("CARDINAL"), 32,
+                        GDK_PROP_MODE_REPLACE, (const guchar*)&pid, 1);
+    g_free(name);
+
+    return window;
+}
+
+/* what a window manager would do for the windows */
+static void
+publish_client_list(GPtrArray* windows)
+{
+    gulong* xids = g_new(gulong, windows->len + 1);
+
+    for (guint i = 0; i < windows->len; i++) {
+        GtkWidget* window = GTK_WIDGET(g_ptr_array_index(windows, i));
+        xids[i] = GDK_WINDOW_XID(window->window);
+    }
+    gdk_property_change(gdk_get_default_root_window(),
+                        gdk_atom_intern_static_string("_NET_CLIENT_LIST"),
+                        gdk_atom_intern_static_string("WINDOW"), 32,
+                        GDK_PROP_MODE_REPLACE, (const guchar*)xids,
+                        windows->len);
+    gdk_property_change(gdk_get_default_root_window(),
+                        gdk_atom_intern_static_string("_NET_CLIENT_LIST_STACKING"),
+                        gdk_atom_intern_static_string("WINDOW"), 32,
+                        GDK_PROP_MODE_REPLACE, (const guchar*)xids,
+                        windows->len);
+    gdk_flush();
+    g_free(xids);
+}
+
+static guint
+count_windows(TaskManager* manager)
+{
+    guint count = 0;
+
+    for (const GSList* i = task_manager_get_icons(manager); i; i = i->next) {
+        for (GSList* j = task_icon_get_items(TASK_ICON(i->data)); j; j = j->next) {
+            if (TASK_IS_WINDOW(j->data)) {
+                count++;
+            }
+        }
+    }
+
+    return count;
+}
+
+static gboolean
+wait_for_windows(TaskManager* manager, guint wanted)
+{
+    GTimer* timer = g_timer_new();
+    gboolean done;
+
+    while (!(done = count_windows(manager) == wanted) &&
+            g_timer_elapsed(timer, NULL) < WAIT_SECONDS) {
+        if (!g_main_context_iteration(NULL, FALSE)) {
+            g_usleep(1000);
+        }
+    }
+    g_timer_destroy(timer);
+
+    return done;
+}
+
+static void
+drain_events(void)
+{
+    while (g_main_context_iteration(NULL, FALSE)) {
+    }
+}
+
+/* every application's windows are in a single icon */
+static gboolean
+apps_grouped(TaskManager* manager, guint apps)
+{
+    TaskIcon** icon_of_app = g_new0(TaskIcon*, apps);
+    gboolean result = TRUE;
+
+    for (const GSList* i = task_manager_get_icons(manager); i && result; i = i->next) {
+        for (GSList* j = task_icon_get_items(TASK_ICON(i->data)); j; j = j->next) {
+            guint app;
+
+            if (!TASK_IS_WINDOW(j->data)) {
+                continue;
+            }
+            app = task_window_get_pid(TASK_WINDOW(j->data)) - FAKE_PID_BASE;
+            if (app >= apps) {
+                continue;
+            }
+            if (icon_of_app[app] && icon_of_app[app] != i->data) {
+                result = FALSE;
+                break;
+            }
+            icon_of_app[app] = TASK_ICON(i->data);
+        }
+    }
+    g_free(icon_of_app);
+
+    return result;
+}
+
+/* the icons start with the launchers of the list, in list order */
+static gboolean
+launchers_in_order(TaskManager* manager, GValueArray* list)
+{
+    const GSList* icons = task_manager_get_icons(manager);
+
+    for (guint idx = 0; idx < list->n_values; idx++, icons = icons->next) {
+        const TaskItem* launcher;
+
+        if (!icons) {
+            return FALSE;
+        }
+        launcher = task_icon_get_launcher(TASK_ICON(icons->data));
+        if (!launcher ||
+                g_strcmp0(task_launcher_get_desktop_path(TASK_LAUNCHER(launcher)),
+                          g_value_get_string(g_value_array_get_nth(list, idx))) != 0) {
+            return FALSE;
+        }
+    }
+
+    return TRUE;
+}
+
+static GValueArray*
+launcher_list_new(GPtrArray* paths, guint count)
+{
+    GValueArray* list = g_value_array_new(count);
+    GValue value = { 0, };
+
+    g_value_init(&value, G_TYPE_STRING);
+    for (guint i = 0; i < count; i++) {
+        g_value_set_string(&value, (const gchar*)g_ptr_array_index(paths, i));
+        g_value_array_append(list, &value);
+    }
+    g_value_unset(&value);
+
+    return list;
+}
+
+static gdouble
+set_launchers(TaskManager* manager, GValueArray* list)
+{
+    GTimer* timer;
+    gdouble elapsed;
+
+    drain_events();
+    timer = g_timer_new();
+    g_object_set(manager, "launcher-paths", list, NULL);
+    elapsed = g_timer_elapsed(timer, NULL);
+    g_timer_destroy(timer);
+
+    return elapsed;
+}
+
+static gboolean
+run(TaskManager* manager, const gchar* home, guint apps)
+{
+    GPtrArray* paths = g_ptr_array_new();
+    GPtrArray* windows = g_ptr_array_new();
+    GValueArray* list;
+    GRand* rand = g_rand_new_with_seed(apps);
+    GTimer* timer;
+    gdouble add, regroup, reverse, shuffle;
+    guint icons;
+    gboolean ok = TRUE;
+
+    /* launchers for every other application, the rest is grouped by window */
+    for (guint app = 0; app < apps; app += 2) {
+        g_ptr_array_add(paths, desktop_file_new(home, app));
+    }
+
+    g_object_set(manager, "grouping", FALSE, NULL);
+    list = launcher_list_new(paths, paths->len);
+    add = set_launchers(manager, list);
+    g_value_array_free(list);
+
+    for (guint app = 0; app < apps; app++) {
+        for (guint w = 0; w < WINDOWS_PER_APP; w++) {
+            g_ptr_array_add(windows, fake_window_new(app));
+        }
+    }
+    publish_client_list(windows);
+    ok &= check("windows show up", wait_for_windows(manager, windows->len));
+    icons = g_slist_length((GSList*)task_manager_get_icons(manager));
+
+    drain_events();
+    timer = g_timer_new();
+    g_object_set(manager, "grouping", TRUE, NULL);
+    regroup = g_timer_elapsed(timer, NULL);
+    ok &= check("windows grouped by application", apps_grouped(manager, apps));
+
+    /* the launcher list reversed */
+    list = g_value_array_new(paths->len);
+    for (guint i = paths->len; i > 0; i--) {
+        GValue value = { 0, };
+        g_value_init(&value, G_TYPE_STRING);
+        g_value_set_string(&value, (const gchar*)g_ptr_array_index(paths, i - 1));
+        g_value_array_append(list, &value);
+        g_value_unset(&value);
+    }
+    reverse = set_launchers(manager, list);
+    ok &= check("launchers in reversed order", launchers_in_order(manager, list));
+    g_value_array_free(list);
+
+    /* and shuffled */
+    for (guint i = paths->len - 1; i > 0; i--) {
+        guint j = g_rand_int_range(rand, 0, i + 1);
+        gpointer tmp = g_ptr_array_index(paths, i);
+        g_ptr_array_index(paths, i) = g_ptr_array_index(paths, j);
+        g_ptr_array_index(paths, j) = tmp;
+    }
+    list = launcher_list_new(paths, paths->len);
+    shuffle = set_launchers(manager, list);
+    ok &= check("launchers in shuffled order", launchers_in_order(manager, list));
+    g_value_array_free(list);
+
+    g_print("%4u launchers %4u windows %4u icons: add %8.3f ms, "
+            "regroup %8.3f ms (%.1f us/icon), reverse %8.3f ms, "
+            "shuffle %8.3f ms (%.1f us/icon)\n",
+            paths->len, windows->len, icons, add * 1000.0,
+            regroup * 1000.0, regroup * 1e6 / icons, reverse * 1000.0,
+            shuffle * 1000.0, shuffle * 1e6 / icons);
+
+    /* close everything again for the next round */
+    list = g_value_array_new(0);
+    set_launchers(manager, list);
+    g_value_array_free(list);
+    for (guint i = 0; i < windows->len; i++) {
+        gtk_widget_destroy(GTK_WIDGET(g_ptr_array_index(windows, i)));
+    }
+    g_ptr_array_set_size(windows, 0);
+    publish_client_list(windows);
+    ok &= check("windows go away", wait_for_windows(manager, 0));
+
+    for (guint i = 0; i < paths->len; i++) {
+        g_unlink((const gchar*)g_ptr_array_index(paths, i));
+        g_free(g_ptr_array_index(paths, i));
+    }
+    g_ptr_array_free(paths, TRUE);
+    g_ptr_array_free(windows, TRUE);
+    g_timer_destroy(timer);
+    g_rand_free(rand);
+
+    return ok;
+}
+
+gint
+main(gint argc, gchar** argv)
+{
+    AwnApplet* manager;
+    GError* error = NULL;
+    gchar* home;
+    gboolean ok = TRUE;
+
+    if (!gtk_init_check(&argc, &argv)) {
+        g_print("no X server, skipping\n");
+        return 77;
+    }
+    if (window_manager_running()) {
+        g_print("a window manager is running, skipping\n");
+        return 77;
+    }
+    if (!g_getenv("DBUS_SESSION_BUS_ADDRESS")) {
+        g_print("no session bus, skipping\n");
+        return 77;
+    }
+    desktop_agnostic_vfs_init(&error);
+    if (error) {
+        g_print("VFS not available, skipping: %s\n", error->message);
+        g_error_free(error);
+        return 77;
+    }
+    home = scratch_home_new();
+    if (!home) {
+        g_print("no scratch directory, skipping\n");
+        return 77;
+    }
+
+    manager = task_manager_new("taskmanager", "test-task-regroup", TEST_PANEL_ID);
+    g_object_set(manager,
+                 "show_all_windows", TRUE,
+                 "match_strength", 99,
+                 NULL);
+
+    for (guint apps = APPS_MAX / 4; apps <= APPS_MAX; apps *= 2) {
+        ok &= run(TASK_MANAGER(manager), home, apps);
+    }
+
+    remove_tree(home);
+    g_free(home);
+
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,168 @@
+/*
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301  USA.
+ *
+ */
+
+/*
+ * Synthetic benchmark of the taskmanager's icon reordering: a box with
+ * hundreds of icons is brought into a new order (as after an edit of the
+ * launcher list) once moving every icon to its index, like the taskmanager
+ * used to, and once with awn_utils_reorder_box_children().  Checks that both
+ * end up in the wanted order and prints the moves and time taken.
+ */
+
+#include <stdlib.h>
+#include <gtk/gtk.h>
+
+#include <libawn/awn-utils.h>
+
+#include "test-check.h"
+
+#define ICONS 600
+
+static gboolean
+in_order(GtkWidget* box, GPtrArray* order)
+{
+    GList* children = gtk_container_get_children(GTK_CONTAINER(box));
+    gboolean result = TRUE;
+    guint i = 0;
+
+    for (GList* l = children; l; l = l->next, i++) {
+        if (i >= order->len || l->data != g_ptr_array_index(order, i)) {
+            result = FALSE;
+            break;
+        }
+    }
+    g_list_free(children);
+
+    return result && i == order->len;
+}
+
+static guint
+reorder_every_icon(GtkBox* box, GPtrArray* order)
+{
+    for (guint i = 0; i < order->len; i++) {
+        gtk_box_reorder_child(box, GTK_WIDGET(g_ptr_array_index(order, i)), i);
+    }
+    return order->len;
+}
+
+static gboolean
+run(const gchar* name, GtkWidget* box, GPtrArray* order)
+{
+    GList* children = gtk_container_get_children(GTK_CONTAINER(box));
+    GTimer* timer = g_timer_new();
+    gdouble every, minimal;
+    guint moved;
+    gboolean ok = TRUE;
+
+    reorder_every_icon(GTK_BOX(box), order);
+    every = g_timer_elapsed(timer, NULL);
+    ok &= in_order(box, order);
+
+    /* back to where we started */
+    for (GList* l = children; l; l = l->next) {
+        gtk_box_reorder_child(GTK_BOX(box), GTK_WIDGET(l->data), -1);
+    }
+    g_list_free(children);
+
+    g_timer_start(timer);
+    moved = awn_utils_reorder_box_children(GTK_BOX(box), order);
+    minimal = g_timer_elapsed(timer, NULL);
+    ok &= in_order(box, order);
+    g_timer_destroy(timer);
+
+    g_print("%-16s every icon: %u moves %.3f ms, minimal: %u moves %.3f ms\n",
+            name, order->len, every * 1000.0, moved, minimal * 1000.0);
+
+    return check(name, ok);
+}
+
+static GPtrArray*
+current_order(GtkWidget* box)
+{
+    GList* children = gtk_container_get_children(GTK_CONTAINER(box));
+    GPtrArray* order = g_ptr_array_sized_new(ICONS);
+
+    for (GList* l = children; l; l = l->next) {
+        g_ptr_array_add(order, l->data);
+    }
+    g_list_free(children);
+
+    return order;
+}
+
+gint
+main(gint argc, gchar** argv)
+{
+    GtkWidget* box;
+    GPtrArray* order;
+    GRand* rand;
+    gpointer tmp;
+    gboolean ok = TRUE;
+
+    if (!gtk_init_check(&argc, &argv)) {
+        g_print("no X server, skipping\n");
+        return 77;
+    }
+
+    box = gtk_hbox_new(FALSE, 0);
+    for (gint i = 0; i < ICONS; i++) {
+        gtk_container_add(GTK_CONTAINER(box), gtk_event_box_new());
+    }
+    rand = g_rand_new_with_seed(42);
+
+    order = current_order(box);
+    ok &= run("unchanged", box, order);
+    g_ptr_array_free(order, TRUE);
+
+    /* a launcher dragged to the front of the list */
+    order = current_order(box);
+    tmp = g_ptr_array_index(order, ICONS - 1);
+    for (gint i = ICONS - 1; i > 0; i--) {
+        g_ptr_array_index(order, i) = g_ptr_array_index(order, i - 1);
+    }
+    g_ptr_array_index(order, 0) = tmp;
+    ok &= run("one moved", box, order);
+    g_ptr_array_free(order, TRUE);
+
+    /* a few launchers swapped */
+    order = current_order(box);
+    for (gint i = 0; i < 10; i++) {
+        gint a = g_rand_int_range(rand, 0, ICONS);
+        gint b = g_rand_int_range(rand, 0, ICONS);
+        tmp = g_ptr_array_index(order, a);
+        g_ptr_array_index(order, a) = g_ptr_array_index(order, b);
+        g_ptr_array_index(order, b) = tmp;
+    }
+    ok &= run("ten swapped", box, order);
+    g_ptr_array_free(order, TRUE);
+
+    /* a completely new order */
+    order = current_order(box);
+    for (gint i = ICONS - 1; i > 0; i--) {
+        gint j = g_rand_int_range(rand, 0, i + 1);
+        tmp = g_ptr_array_index(order, i);
+        g_ptr_array_index(order, i) = g_ptr_array_index(order, j);
+        g_ptr_array_index(order, j) = tmp;
+    }
+    ok &= run("shuffled", box, order);
+    g_ptr_array_free(order, TRUE);
+
+    g_rand_free(rand);
+    gtk_widget_destroy(box);
+
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
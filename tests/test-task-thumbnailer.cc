@@ -0,0 +1,175 @@
+/*
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301  USA.
+ *
+ */
+
+/*
+ * Checks the taskmanager's thumbnail engine: a window is painted red, then
+ * its right half blue, then (while the thumbnail isn't visible) green.  The
+ * thumbnail has to follow the damage, a hidden thumbnail must not be updated
+ * until it's shown again.
+ * Needs an X server with Composite and Damage, eg.
+ *   xvfb-run -s "-screen 0 640x480x24 +extension Composite" ./test-task-thumbnailer
+ * Exits with 77 (skipped) if the extensions are missing.
+ */
+
+#include <stdlib.h>
+#include <gtk/gtk.h>
+#include <gdk/gdkx.h>
+
+#include "applets/taskmanager/task-thumbnailer.h"
+#include "test-check.h"
+
+#define WIN_WIDTH 200
+#define WIN_HEIGHT 100
+
+static gdouble left_color[3] = { 1.0, 0.0, 0.0 };
+static gdouble right_color[3] = { 1.0, 0.0, 0.0 };
+static gint changes = 0;
+
+static gboolean
+expose(GtkWidget* widget, GdkEventExpose* event, gpointer null)
+{
+    cairo_t* cr = gdk_cairo_create(widget->window);
+
+    cairo_rectangle(cr, 0, 0, WIN_WIDTH / 2, WIN_HEIGHT);
+    cairo_set_source_rgb(cr, left_color[0], left_color[1], left_color[2]);
+    cairo_fill(cr);
+    cairo_rectangle(cr, WIN_WIDTH / 2, 0, WIN_WIDTH / 2, WIN_HEIGHT);
+    cairo_set_source_rgb(cr, right_color[0], right_color[1], right_color[2]);
+    cairo_fill(cr);
+    cairo_destroy(cr);
+
+    return TRUE;
+}
+
+static void
+thumbnail_changed(TaskThumbnailer* thumbnailer, gulong xid, gpointer null)
+{
+    changes++;
+}
+
+/* waits for the next thumbnail-changed, returns the time it took (s) */
+static gdouble
+wait_for_change(gdouble timeout)
+{
+    GTimer* timer = g_timer_new();
+    gint before = changes;
+    gdouble elapsed;
+
+    while (changes == before && g_timer_elapsed(timer, NULL) < timeout) {
+        g_main_context_iteration(NULL, FALSE);
+        g_usleep(1000);
+    }
+    elapsed = changes == before ? -1.0 : g_timer_elapsed(timer, NULL);
+    g_timer_destroy(timer);
+
+    return elapsed;
+}
+
+static guint32
+get_pixel(TaskThumbnailer* thumbnailer, gulong xid, gint x, gint y)
+{
+    cairo_surface_t* image;
+    cairo_t* cr;
+    guint32 pixel;
+
+    image = cairo_image_surface_create(CAIRO_FORMAT_RGB24, 1, 1);
+    cr = cairo_create(image);
+    cairo_set_source_surface(cr, task_thumbnailer_get_thumbnail(thumbnailer, xid),
+                             -x, -y);
+    cairo_paint(cr);
+    cairo_destroy(cr);
+    cairo_surface_flush(image);
+    pixel = *(guint32*)cairo_image_surface_get_data(image) & 0xffffff;
+    cairo_surface_destroy(image);
+
+    return pixel;
+}
+
+gint
+main(gint argc, gchar** argv)
+{
+    TaskThumbnailer* thumbnailer;
+    GtkWidget* window;
+    gulong xid;
+    gdouble elapsed;
+    gboolean ok = TRUE;
+
+    gtk_init(&argc, &argv);
+
+    thumbnailer = task_thumbnailer_get_default();
+    if (!task_thumbnailer_is_supported(thumbnailer)) {
+        g_print("Composite or Damage extension missing, skipping\n");
+        return 77;
+    }
+    g_signal_connect(thumbnailer, "thumbnail-changed",
+                     G_CALLBACK(thumbnail_changed), NULL);
+
+    window = gtk_window_new(GTK_WINDOW_TOPLEVEL);
+    gtk_widget_set_app_paintable(window, TRUE);
+    gtk_window_set_default_size(GTK_WINDOW(window), WIN_WIDTH, WIN_HEIGHT);
+    g_signal_connect(window, "expose-event", G_CALLBACK(expose), NULL);
+    gtk_widget_show(window);
+    gdk_display_sync(gdk_display_get_default());
+    while (gtk_events_pending()) {
+        gtk_main_iteration();
+    }
+
+    xid = GDK_WINDOW_XID(window->window);
+    task_thumbnailer_watch(thumbnailer, xid);
+    task_thumbnailer_set_size(thumbnailer, xid, WIN_WIDTH / 4, WIN_HEIGHT / 4);
+    task_thumbnailer_set_visible(thumbnailer, xid, TRUE);
+
+    ok &= check("initial thumbnail", wait_for_change(2.0) >= 0.0);
+    ok &= check("initial thumbnail is red",
+                get_pixel(thumbnailer, xid, 10, 12) == 0xff0000 &&
+                get_pixel(thumbnailer, xid, 40, 12) == 0xff0000);
+
+    /* damage the right half only */
+    right_color[0] = 0.0;
+    right_color[2] = 1.0;
+    gtk_widget_queue_draw_area(window, WIN_WIDTH / 2, 0,
+                               WIN_WIDTH / 2, WIN_HEIGHT);
+    ok &= check("damage is picked up", wait_for_change(2.0) >= 0.0);
+    ok &= check("left half still red",
+                get_pixel(thumbnailer, xid, 10, 12) == 0xff0000);
+    ok &= check("right half now blue",
+                get_pixel(thumbnailer, xid, 40, 12) == 0x0000ff);
+
+    /* not on screen: not followed */
+    task_thumbnailer_set_visible(thumbnailer, xid, FALSE);
+    left_color[0] = 0.0;
+    left_color[1] = 1.0;
+    gtk_widget_queue_draw(window);
+    ok &= check("hidden thumbnail isn't updated", wait_for_change(1.0) < 0.0);
+    ok &= check("hidden thumbnail is kept",
+                get_pixel(thumbnailer, xid, 10, 12) == 0xff0000);
+
+    task_thumbnailer_set_visible(thumbnailer, xid, TRUE);
+    elapsed = wait_for_change(2.0);
+    g_print("update after showing it again: %.3fs\n", elapsed);
+    ok &= check("shown again, updated", elapsed >= 0.0);
+    ok &= check("left half now green",
+                get_pixel(thumbnailer, xid, 10, 12) == 0x00ff00);
+
+    task_thumbnailer_unwatch(thumbnailer, xid);
+    ok &= check("released after unwatch",
+                task_thumbnailer_get_thumbnail(thumbnailer, xid) == NULL);
+
+    gtk_widget_destroy(window);
+
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
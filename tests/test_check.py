@@ -0,0 +1,31 @@
+#  This program is free software; you can redistribute it and/or modify
+#  it under the terms of the GNU General Public License as published by
+#  the Free Software Foundation; either version 2 of the License, or
+#  (at your option) any later version.
+#
+#  This program is distributed in the hope that it will be useful,
+#  but WITHOUT ANY WARRANTY; without even the implied warranty of
+#  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+#  GNU General Public License for more details.
+#
+#  You should have received a copy of the GNU General Public License
+#  along with this program; if not, write to the Free Software
+#  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301  USA.
+
+# Result reporting shared by the self-checking test scripts, the Python
+# counterpart of test-check.h.
+
+import sys
+
+failed = False
+
+
+def check(what, result):
+    global failed
+    print '%-40s %s' % (what, 'ok' if result else 'FAILED')
+    failed |= not result
+    return result
+
+
+def exit():
+    sys.exit(1 if failed else 0)